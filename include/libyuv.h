@@ -17,8 +17,12 @@
 #include "libyuv/convert.h"
 #include "libyuv/cpu_id.h"
 #include "libyuv/format_conversion.h"
+#include "libyuv/parallel.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/rotate.h"
 #include "libyuv/scale.h"
+#include "libyuv/scale_16.h"
+#include "libyuv/scale_argb.h"
+#include "libyuv/scale_uv.h"
 
 #endif  // LIBYUV_INCLUDE_LIBYUV_H_
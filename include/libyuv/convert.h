@@ -13,6 +13,7 @@
 
 #include "libyuv/basic_types.h"
 #include "libyuv/rotate.h"
+#include "libyuv/scale.h"
 
 namespace libyuv {
 
@@ -124,6 +125,27 @@ int ConvertToI420(const uint8* src_frame, size_t src_size,
                   RotationMode rotation,
                   uint32 format);
 
+// Convert camera sample to I420 with cropping, scaling, rotation and
+// vertical flip.  The crop is unpacked a few rows at a time and each strip
+// is scaled and rotated while it is still in the cache.
+// "crop_width" / "crop_height" is size of the area to crop to.
+// "dst_width" / "dst_height" is size to scale the crop to.
+//    Scaling is pre-rotation, so for 90 or 270 the I420 planes are
+//    dst_height pixels wide and dst_width high.
+// "filtering" is as for I420Scale.
+// Other parameters are as for ConvertToI420.
+int ConvertToI420Scale(const uint8* src_frame, size_t src_size,
+                       uint8* dst_y, int dst_stride_y,
+                       uint8* dst_u, int dst_stride_u,
+                       uint8* dst_v, int dst_stride_v,
+                       int crop_x, int crop_y,
+                       int src_width, int src_height,
+                       int crop_width, int crop_height,
+                       int dst_width, int dst_height,
+                       RotationMode rotation,
+                       FilterMode filtering,
+                       uint32 format);
+
 }  // namespace libyuv
 
 #endif // INCLUDE_LIBYUV_CONVERT_H_
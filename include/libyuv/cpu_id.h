@@ -23,6 +23,11 @@ static const int kCpuHasNEON = 4;
 // Internal flag to indicate cpuid is initialized.
 static const int kCpuInitialized = 8;
 
+// These flags are only valid on x86 processors.  For Pentium III class
+// processors that have MMX and SSE but not SSE2.
+static const int kCpuHasMMX = 16;
+static const int kCpuHasSSE = 32;
+
 // Detect CPU has SSE2 etc.
 bool TestCpuFlag(int flag);
 
@@ -32,6 +37,16 @@ bool TestCpuFlag(int flag);
 // 0 to disable all cpu specific optimizations.
 void MaskCpuFlags(int enable_flags);
 
+// Planes that are copied or transposed into a destination larger than
+// this many bytes are written with non-temporal stores, which bypass the
+// cache so a large frame does not evict the source or the data of other
+// threads.  Only copies to 16 byte aligned rows and transposes to 64 byte
+// aligned rows are streamed.  The default is 256 KB, the L2 cache of a
+// Pentium III.  0 streams every plane.  A size larger than any frame
+// disables streaming.
+void SetNonTemporalThreshold(int bytes);
+int GetNonTemporalThreshold();
+
 }  // namespace libyuv
 
 #endif  // INCLUDE_LIBYUV_CPU_ID_H_
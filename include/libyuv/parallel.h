@@ -0,0 +1,40 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef INCLUDE_LIBYUV_PARALLEL_H_
+#define INCLUDE_LIBYUV_PARALLEL_H_
+
+#include "libyuv/basic_types.h"
+
+namespace libyuv {
+
+// Maximum number of threads used by the built-in executor.
+static const int kMaxParallelThreads = 16;
+
+// Performs job number 'index' of a parallel operation.
+typedef void (*ParallelJob)(void* job_opaque, int index);
+
+// Runs job(job_opaque, i) for every i in [0, count) and returns when all of
+// them have completed.  Jobs are independent of each other, so they may be
+// run concurrently and in any order.
+// Callers can supply their own executor to run jobs on an existing pool.
+typedef void (*ParallelExecutor)(void* executor_opaque,
+                                 ParallelJob job, void* job_opaque,
+                                 int count);
+
+// Built-in executor.  Runs the jobs on up to 'num_threads' threads, including
+// the calling thread.  Falls back to running them serially when threads are
+// not available on the platform.
+void RunParallelJobs(ParallelJob job, void* job_opaque, int count,
+                     int num_threads);
+
+}  // namespace libyuv
+
+#endif  // INCLUDE_LIBYUV_PARALLEL_H_
@@ -25,6 +25,8 @@ int I420Copy(const uint8* src_y, int src_stride_y,
              int width, int height);
 
 // I420 mirror
+// Negative height mirrors and flips the image, which rotates it by 180
+// degrees.  src and dst may be the same frame to mirror it in place.
 int I420Mirror(const uint8* src_y, int src_stride_y,
                const uint8* src_u, int src_stride_u,
                const uint8* src_v, int src_stride_v,
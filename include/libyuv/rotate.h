@@ -12,6 +12,7 @@
 #define INCLUDE_LIBYUV_ROTATE_H_
 
 #include "libyuv/basic_types.h"
+#include "libyuv/parallel.h"
 
 namespace libyuv {
 
@@ -29,6 +30,8 @@ enum RotationMode {
 };
 
 // Rotate I420 frame
+// kRotate180 may be done in place, with the same src and dst frame and a
+// positive height.
 int I420Rotate(const uint8* src_y, int src_stride_y,
                const uint8* src_u, int src_stride_u,
                const uint8* src_v, int src_stride_v,
@@ -47,6 +50,75 @@ int NV12ToI420Rotate(const uint8* src_y, int src_stride_y,
                      int width, int height,
                      RotationMode mode);
 
+// Rotate NV12 frame, keeping the UV plane interleaved.
+// Negative height means invert the image.
+// kRotate180 may be done in place, with the same src and dst frame and a
+// positive height.
+// Returns 0 if successful.
+int NV12Rotate(const uint8* src_y, int src_stride_y,
+               const uint8* src_uv, int src_stride_uv,
+               uint8* dst_y, int dst_stride_y,
+               uint8* dst_uv, int dst_stride_uv,
+               int width, int height,
+               RotationMode mode);
+
+// Rotate ARGB frame
+// Negative height means invert the image.
+// kRotate180 may be done in place, with the same src and dst frame and a
+// positive height.
+// Returns 0 if successful.
+int ARGBRotate(const uint8* src_argb, int src_stride_argb,
+               uint8* dst_argb, int dst_stride_argb,
+               int width, int height,
+               RotationMode mode);
+
+// Convert I420 to ARGB and rotate, without an intermediate rotated I420
+// frame.  The output is bit exact with I420Rotate followed by I420ToARGB.
+// Negative height means invert the image.
+// Returns 0 if successful.
+int I420ToARGBRotate(const uint8* src_y, int src_stride_y,
+                     const uint8* src_u, int src_stride_u,
+                     const uint8* src_v, int src_stride_v,
+                     uint8* dst_argb, int dst_stride_argb,
+                     int width, int height,
+                     RotationMode mode);
+
+// Same as I420ToARGBRotate, but converts to RGB565.
+int I420ToRGB565Rotate(const uint8* src_y, int src_stride_y,
+                       const uint8* src_u, int src_stride_u,
+                       const uint8* src_v, int src_stride_v,
+                       uint8* dst_rgb565, int dst_stride_rgb565,
+                       int width, int height,
+                       RotationMode mode);
+
+// Same as I420Rotate, but each plane is split into horizontal bands of
+// source rows which are rotated in parallel.  The output is bit exact with
+// I420Rotate.
+// "num_threads" is the number of bands per plane, up to kMaxParallelThreads.
+// "executor" runs the bands.  If NULL, the built-in executor is used with
+//   "num_threads" threads.
+// Returns 0 if successful.
+int I420RotateParallel(const uint8* src_y, int src_stride_y,
+                       const uint8* src_u, int src_stride_u,
+                       const uint8* src_v, int src_stride_v,
+                       uint8* dst_y, int dst_stride_y,
+                       uint8* dst_u, int dst_stride_u,
+                       uint8* dst_v, int dst_stride_v,
+                       int width, int height,
+                       RotationMode mode, int num_threads,
+                       ParallelExecutor executor, void* executor_opaque);
+
+// Same as NV12ToI420Rotate, rotating bands of the Y and UV planes in
+// parallel.
+int NV12ToI420RotateParallel(const uint8* src_y, int src_stride_y,
+                             const uint8* src_uv, int src_stride_uv,
+                             uint8* dst_y, int dst_stride_y,
+                             uint8* dst_u, int dst_stride_u,
+                             uint8* dst_v, int dst_stride_v,
+                             int width, int height,
+                             RotationMode mode, int num_threads,
+                             ParallelExecutor executor, void* executor_opaque);
+
 }  // namespace libyuv
 
 #endif  // INCLUDE_LIBYUV_ROTATE_H_
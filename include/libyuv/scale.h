@@ -12,6 +12,7 @@
 #define INCLUDE_LIBYUV_SCALE_H_
 
 #include "libyuv/basic_types.h"
+#include "libyuv/parallel.h"
 
 namespace libyuv {
 
@@ -19,7 +20,9 @@ namespace libyuv {
 enum FilterMode {
   kFilterNone = 0,  // Point sample; Fastest
   kFilterBilinear = 1,  // Faster than box, but lower quality scaling down.
-  kFilterBox = 2  // Highest quality
+  kFilterBox = 2,  // Higher quality scaling down.
+  kFilterBicubic = 3,  // Sharper than bilinear, scaling up or down.
+  kFilterLanczos = 4  // Highest quality; Lanczos3.
 };
 
 // Scales a YUV 4:2:0 image from the src width and height to the
@@ -30,6 +33,11 @@ enum FilterMode {
 // quality image, at the expense of speed.
 // If filtering is kFilterBox, averaging is used to produce ever better
 // quality image, at further expense of speed.
+// If filtering is kFilterBicubic or kFilterLanczos, a separable polyphase
+// filter is used.  The filter coefficients for each geometry are computed
+// once and cached.  Scaling down by more than 4x with kFilterBicubic, or
+// 8/3x with kFilterLanczos, would need more than 16 taps, and uses
+// kFilterBox instead.
 // Returns 0 if successful.
 
 int I420Scale(const uint8* src_y, int src_stride_y,
@@ -42,6 +50,192 @@ int I420Scale(const uint8* src_y, int src_stride_y,
               int dst_width, int dst_height,
               FilterMode filtering);
 
+// Scales a single plane, as I420Scale does for each of its planes.
+void ScalePlane(const uint8* src, int src_stride,
+                int src_width, int src_height,
+                uint8* dst, int dst_stride,
+                int dst_width, int dst_height,
+                FilterMode filtering);
+
+// Scales a rectangle of the src image to the dst width and height.
+// The rectangle has its top left corner at (crop_x, crop_y) and is
+// crop_width by crop_height luma pixels, all in 16.16 fixed point, so it
+// may start and end between pixels.  A rectangle that moves smoothly from
+// frame to frame, as when zooming, then scales smoothly too.
+// A rectangle on whole pixels is scaled exactly, and as fast, as I420Scale
+// of the cropped image, whose chroma is (crop_width + 1) / 2 by
+// (crop_height + 1) / 2 from (crop_x / 2, crop_y / 2).  Otherwise bilinear
+// or box filtering is used, and kFilterBicubic and kFilterLanczos behave as
+// kFilterBox.
+// Returns 0 if successful, or -1 if the rectangle is not inside the image.
+int I420ScaleRect(const uint8* src_y, int src_stride_y,
+                  const uint8* src_u, int src_stride_u,
+                  const uint8* src_v, int src_stride_v,
+                  int src_width, int src_height,
+                  int crop_x, int crop_y, int crop_width, int crop_height,
+                  uint8* dst_y, int dst_stride_y,
+                  uint8* dst_u, int dst_stride_u,
+                  uint8* dst_v, int dst_stride_v,
+                  int dst_width, int dst_height,
+                  FilterMode filtering);
+
+// Scales a rectangle of a single plane, as I420ScaleRect does for luma.
+int ScalePlaneRect(const uint8* src, int src_stride,
+                   int src_width, int src_height,
+                   int crop_x, int crop_y, int crop_width, int crop_height,
+                   uint8* dst, int dst_stride,
+                   int dst_width, int dst_height,
+                   FilterMode filtering);
+
+// Scales a YUV 4:2:0 image and converts it to ARGB in a single pass.
+// A strip of scaled rows small enough to stay in the L1 cache is converted
+// before the next strip is scaled, so no scaled I420 frame is written.
+// The output is bit exact with I420Scale into 16 byte aligned planes
+// followed by I420ToARGB.
+// Negative src_height inverts the source, and negative dst_height inverts
+// the output.
+// Returns 0 if successful.
+int I420ScaleToARGB(const uint8* src_y, int src_stride_y,
+                    const uint8* src_u, int src_stride_u,
+                    const uint8* src_v, int src_stride_v,
+                    int src_width, int src_height,
+                    uint8* dst_argb, int dst_stride_argb,
+                    int dst_width, int dst_height,
+                    FilterMode filtering);
+
+// Same as I420ScaleToARGB, but converts to RGB565.
+int I420ScaleToRGB565(const uint8* src_y, int src_stride_y,
+                      const uint8* src_u, int src_stride_u,
+                      const uint8* src_v, int src_stride_v,
+                      int src_width, int src_height,
+                      uint8* dst_rgb565, int dst_stride_rgb565,
+                      int dst_width, int dst_height,
+                      FilterMode filtering);
+
+// Same as I420Scale, but each plane is split into horizontal bands of
+// output rows which are scaled in parallel.  The output is bit exact with
+// I420Scale.
+// "num_threads" is the number of bands per plane, up to kMaxParallelThreads.
+// "executor" runs the bands.  If NULL, the built-in executor is used with
+//   "num_threads" threads.
+// Returns 0 if successful.
+int I420ScaleParallel(const uint8* src_y, int src_stride_y,
+                      const uint8* src_u, int src_stride_u,
+                      const uint8* src_v, int src_stride_v,
+                      int src_width, int src_height,
+                      uint8* dst_y, int dst_stride_y,
+                      uint8* dst_u, int dst_stride_u,
+                      uint8* dst_v, int dst_stride_v,
+                      int dst_width, int dst_height,
+                      FilterMode filtering, int num_threads,
+                      ParallelExecutor executor, void* executor_opaque);
+
+// A ScalePlan holds everything I420Scale works out from the geometry of a
+// frame: the scaling method and row functions for each plane, the filter
+// coefficients and the row buffers.  Creating a plan once and executing it
+// for each frame of a fixed size avoids that setup on every frame.
+struct ScalePlan;
+
+// Creates a plan for scaling frames with the given sizes and strides.
+// Negative src_height means invert the image.
+// Returns NULL if the arguments are invalid.
+ScalePlan* ScalePlanCreate(int src_width, int src_height,
+                           int src_stride_y, int src_stride_u,
+                           int src_stride_v,
+                           int dst_width, int dst_height,
+                           int dst_stride_y, int dst_stride_u,
+                           int dst_stride_v,
+                           FilterMode filtering);
+
+// Scales one frame.  The output is bit exact with I420Scale.  The fastest
+// row functions are used when every plane is 16 byte aligned.
+// A plan owns its row buffers, so it may only execute on one thread at a
+// time.
+// Returns 0 if successful.
+int ScalePlanExecute(ScalePlan* plan,
+                     const uint8* src_y, const uint8* src_u,
+                     const uint8* src_v,
+                     uint8* dst_y, uint8* dst_u, uint8* dst_v);
+
+void ScalePlanDestroy(ScalePlan* plan);
+
+// A ScaleStream scales I420 frames that arrive a slice of rows at a time,
+// as from a capture device.  Each output row is scaled as soon as the
+// source rows it reads have been pushed, so scaling overlaps with capture
+// instead of waiting for the whole frame.  Only the source rows still read
+// by later output rows are kept, in a small buffer for each plane.
+struct ScaleStream;
+
+// Creates a stream for frames with the given sizes and dst strides.
+// Negative heights are not supported.
+// Returns NULL if the arguments are invalid.
+ScaleStream* ScaleStreamCreate(int src_width, int src_height,
+                               int dst_width, int dst_height,
+                               int dst_stride_y, int dst_stride_u,
+                               int dst_stride_v,
+                               FilterMode filtering);
+
+// Pushes the next "num_rows" rows of the source frame.  src_u and src_v
+// point to the (num_rows + 1) / 2 chroma rows of the slice, so every slice
+// but the last one of a frame has an even number of rows.
+// dst_y, dst_u and dst_v point to the output frame.  Each output row is
+// written once, by the push that completes its source rows, so they may
+// instead point to a window that moves down the frame, as described for
+// ScaleStreamWindowRows.  The output is bit exact with I420Scale of 16
+// byte aligned planes.
+// Returns the number of output rows that are complete in all planes, which
+// is dst_height after the last slice of the frame.  The next push then
+// starts a new frame.  Returns -1 if the arguments are invalid.
+int ScaleStreamPush(ScaleStream* stream,
+                    const uint8* src_y, int src_stride_y,
+                    const uint8* src_u, int src_stride_u,
+                    const uint8* src_v, int src_stride_v,
+                    int num_rows,
+                    uint8* dst_y, uint8* dst_u, uint8* dst_v);
+
+// Returns the most output rows a push of up to "num_rows" source rows
+// writes, counted from the first row not reported complete before it.
+// Rows complete in one push may be consumed and overwritten before the
+// next, so the output can be scaled into a window of this many rows: each
+// push passes dst pointers offset back by the first row the window holds.
+// Returns -1 if the arguments are invalid.
+int ScaleStreamWindowRows(const ScaleStream* stream, int num_rows);
+
+void ScaleStreamDestroy(ScaleStream* stream);
+
+static const int kMaxPyramidLevels = 8;
+
+// An output of I420ScalePyramid.
+struct ScalePyramidLevel {
+  uint8* dst_y;
+  int dst_stride_y;
+  uint8* dst_u;
+  int dst_stride_u;
+  uint8* dst_v;
+  int dst_stride_v;
+  int dst_width;
+  int dst_height;
+};
+
+// Scales a YUV 4:2:0 image to several sizes at once, as for the layers of
+// a simulcast stream.  The source is read once, a strip of rows at a time
+// that is scaled into every level while it is in the cache, instead of
+// once for each size as with separate I420Scale calls.
+// A level that is a larger level divided by 2, 4 or 8 in both dimensions,
+// for its chroma size as well as its luma size, is scaled from the
+// smallest such level rather than the source, and is bit exact with
+// I420Scale of that level.  Other levels are bit exact with I420Scale of
+// the source.
+// "levels" may be in any order, up to kMaxPyramidLevels.
+// Negative src_height means invert the image.
+// Returns 0 if successful.
+int I420ScalePyramid(const uint8* src_y, int src_stride_y,
+                     const uint8* src_u, int src_stride_u,
+                     const uint8* src_v, int src_stride_v,
+                     int src_width, int src_height,
+                     const ScalePyramidLevel* levels, int num_levels,
+                     FilterMode filtering);
+
 // Legacy API
 // If dst_height_offset is non-zero, the image is offset by that many pixels
 // and stretched to (dst_height - dst_height_offset * 2) pixels high,
@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef INCLUDE_LIBYUV_SCALE_16_H_
+#define INCLUDE_LIBYUV_SCALE_16_H_
+
+#include "libyuv/basic_types.h"
+#include "libyuv/scale.h"  // For FilterMode
+
+namespace libyuv {
+
+// Scales a plane of 16 bit samples, such as 10 or 12 bit video stored in
+// the low bits of each uint16, without reducing it to 8 bits.
+// Strides are in samples, not bytes.
+// Filtering is as for ScalePlane, except that kFilterBicubic and
+// kFilterLanczos behave as kFilterBox.
+void ScalePlane_16(const uint16* src, int src_stride,
+                   int src_width, int src_height,
+                   uint16* dst, int dst_stride,
+                   int dst_width, int dst_height,
+                   FilterMode filtering);
+
+// Scales a YUV 4:2:0 image of 16 bit samples, as ScalePlane_16 does for
+// each of its planes.
+// Negative src_height means invert the image.
+// Returns 0 if successful.
+int I420Scale_16(const uint16* src_y, int src_stride_y,
+                 const uint16* src_u, int src_stride_u,
+                 const uint16* src_v, int src_stride_v,
+                 int src_width, int src_height,
+                 uint16* dst_y, int dst_stride_y,
+                 uint16* dst_u, int dst_stride_u,
+                 uint16* dst_v, int dst_stride_v,
+                 int dst_width, int dst_height,
+                 FilterMode filtering);
+
+}  // namespace libyuv
+
+#endif  // INCLUDE_LIBYUV_SCALE_16_H_
@@ -0,0 +1,35 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef INCLUDE_LIBYUV_SCALE_ARGB_H_
+#define INCLUDE_LIBYUV_SCALE_ARGB_H_
+
+#include "libyuv/basic_types.h"
+#include "libyuv/scale.h"  // For FilterMode
+
+namespace libyuv {
+
+// Scales an ARGB image from the src width and height to the dst width and
+// height.
+// If filtering is kFilterNone, a simple nearest-neighbor algorithm is used.
+// If filtering is kFilterBilinear, bilinear interpolation is used.
+// If filtering is kFilterBox or higher, scaling down by 2 or more averages
+// a box of pixels; other sizes use bilinear interpolation.
+// Negative src_height means invert the image.
+// Returns 0 if successful.
+int ARGBScale(const uint8* src_argb, int src_stride_argb,
+              int src_width, int src_height,
+              uint8* dst_argb, int dst_stride_argb,
+              int dst_width, int dst_height,
+              FilterMode filtering);
+
+}  // namespace libyuv
+
+#endif  // INCLUDE_LIBYUV_SCALE_ARGB_H_
@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef INCLUDE_LIBYUV_SCALE_UV_H_
+#define INCLUDE_LIBYUV_SCALE_UV_H_
+
+#include "libyuv/basic_types.h"
+#include "libyuv/scale.h"  // For FilterMode
+
+namespace libyuv {
+
+// Scales an NV12 image from the src width and height to the dst width and
+// height.  The UV plane holds interleaved U and V at half resolution, and is
+// scaled as 2 byte pixels without first splitting it into U and V.
+// Filtering is as for ARGBScale: kFilterBicubic and kFilterLanczos behave as
+// kFilterBox, for both the Y and the UV plane.
+// Negative src_height means invert the image.
+// Returns 0 if successful.
+int NV12Scale(const uint8* src_y, int src_stride_y,
+              const uint8* src_uv, int src_stride_uv,
+              int src_width, int src_height,
+              uint8* dst_y, int dst_stride_y,
+              uint8* dst_uv, int dst_stride_uv,
+              int dst_width, int dst_height,
+              FilterMode filtering);
+
+// Same as NV12Scale, but writes I420.  Each scaled row of UV is split into
+// U and V as it is stored, so the chroma is not read back from memory.
+int NV12ToI420Scale(const uint8* src_y, int src_stride_y,
+                    const uint8* src_uv, int src_stride_uv,
+                    int src_width, int src_height,
+                    uint8* dst_y, int dst_stride_y,
+                    uint8* dst_u, int dst_stride_u,
+                    uint8* dst_v, int dst_stride_v,
+                    int dst_width, int dst_height,
+                    FilterMode filtering);
+
+}  // namespace libyuv
+
+#endif  // INCLUDE_LIBYUV_SCALE_UV_H_
@@ -25,12 +25,17 @@
         # includes
         'include/libyuv/basic_types.h',
         'include/libyuv/convert.h',
+        'include/libyuv/parallel.h',
         'include/libyuv/scale.h',
+        'include/libyuv/scale_16.h',
+        'include/libyuv/scale_argb.h',
+        'include/libyuv/scale_uv.h',
         'include/libyuv/planar_functions.h',
 
         # headers
         'source/conversion_tables.h',
         'source/cpu_id.h',
+        'source/parallel_priv.h',
         'source/rotate.h',
         'source/rotate_priv.h',
         'source/row.h',
@@ -41,14 +46,26 @@
         'source/convert.cc',
         'source/cpu_id.cc',
         'source/format_conversion.cc',
+        'source/parallel.cc',
         'source/planar_functions.cc',
         'source/rotate.cc',
+        'source/row_any.cc',
         'source/row_common.cc',
         'source/row_table.cc',
         'source/scale.cc',
+        'source/scale_16.cc',
+        'source/scale_argb.cc',
+        'source/scale_uv.cc',
         'source/video_common.cc',
       ],
       'conditions': [
+        ['OS=="linux" or OS=="mac"', {
+          'link_settings': {
+            'libraries': [
+              '-lpthread',
+            ],
+          },
+        }],
         ['OS=="win"', {
          'sources': [
            'source/row_win.cc',
@@ -23,7 +23,12 @@
 
          # sources
          'unit_test/compare_test.cc',
+         'unit_test/convert_test.cc',
+         'unit_test/planar_test.cc',
          'unit_test/rotate_test.cc',
+         'unit_test/scale_16_test.cc',
+         'unit_test/scale_argb_test.cc',
+         'unit_test/scale_uv_test.cc',
          'unit_test/scale_test.cc',
          'unit_test/unit_test.cc',
       ],
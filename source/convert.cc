@@ -10,6 +10,8 @@
 
 #include "libyuv/convert.h"
 
+#include <string.h>
+
 //#define SCALEOPT //Currently for windows only. June 2010
 
 #ifdef SCALEOPT
@@ -22,6 +24,8 @@
 #include "libyuv/format_conversion.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/rotate.h"
+#include "libyuv/scale.h"
+#include "rotate_priv.h"
 #include "row.h"
 #include "video_common.h"
 
@@ -926,87 +930,77 @@ int RAWToI420(const uint8* src_frame, int src_stride_frame,
   return 0;
 }
 
-// Convert camera sample to I420 with cropping, rotation and vertical flip.
-// src_width is used for source stride computation
-// src_height is used to compute location of planes, and indicate inversion
-int ConvertToI420(const uint8* sample, size_t sample_size,
-                  uint8* y, int y_stride,
-                  uint8* u, int u_stride,
-                  uint8* v, int v_stride,
-                  int crop_x, int crop_y,
-                  int src_width, int src_height,
-                  int dst_width, int dst_height,
-                  RotationMode rotation,
-                  uint32 format) {
-  if (y == NULL || u == NULL || v == NULL || sample == NULL) {
-    return -1;
-  }
+// Unpacks rows "row" to "row" + abs(height) - 1 of a camera sample, from
+// column crop_x, to I420.  Negative height means the sample is inverted,
+// as for ConvertToI420.
+static int UnpackRowsToI420(const uint8* sample, uint32 format,
+                            int src_width, int abs_src_height,
+                            int crop_x, int row,
+                            uint8* y, int y_stride,
+                            uint8* u, int u_stride,
+                            uint8* v, int v_stride,
+                            int width, int height) {
   int aligned_src_width = (src_width + 1) & ~1;
   const uint8* src;
   const uint8* src_uv;
-  int abs_src_height = (src_height < 0) ? -src_height : src_height;
-  int inv_dst_height = (dst_height < 0) ? -dst_height : dst_height;
-  if (src_height < 0) {
-    inv_dst_height = -inv_dst_height;
-  }
 
   switch (format) {
     // Single plane formats
     case FOURCC_YUY2:
-      src = sample + (aligned_src_width * crop_y + crop_x) * 2 ;
+      src = sample + (aligned_src_width * row + crop_x) * 2 ;
       YUY2ToI420(src, aligned_src_width * 2,
                  y, y_stride,
                  u, u_stride,
                  v, v_stride,
-                 dst_width, inv_dst_height);
+                 width, height);
       break;
     case FOURCC_UYVY:
-      src = sample + (aligned_src_width * crop_y + crop_x) * 2;
+      src = sample + (aligned_src_width * row + crop_x) * 2;
       UYVYToI420(src, aligned_src_width * 2,
                  y, y_stride,
                  u, u_stride,
                  v, v_stride,
-                 dst_width, inv_dst_height);
+                 width, height);
       break;
     case FOURCC_24BG:
-      src = sample + (src_width * crop_y + crop_x) * 3;
+      src = sample + (src_width * row + crop_x) * 3;
       RGB24ToI420(src, src_width * 3,
                   y, y_stride,
                   u, u_stride,
                   v, v_stride,
-                  dst_width, inv_dst_height);
+                  width, height);
       break;
     case FOURCC_RAW:
-      src = sample + (src_width * crop_y + crop_x) * 3;
+      src = sample + (src_width * row + crop_x) * 3;
       RAWToI420(src, src_width * 3,
                 y, y_stride,
                 u, u_stride,
                 v, v_stride,
-                dst_width, inv_dst_height);
+                width, height);
       break;
     case FOURCC_ARGB:
-      src = sample + (src_width * crop_y + crop_x) * 4;
+      src = sample + (src_width * row + crop_x) * 4;
       ARGBToI420(src, src_width * 4,
                  y, y_stride,
                  u, u_stride,
                  v, v_stride,
-                 dst_width, inv_dst_height);
+                 width, height);
       break;
     case FOURCC_BGRA:
-      src = sample + (src_width * crop_y + crop_x) * 4;
+      src = sample + (src_width * row + crop_x) * 4;
       BGRAToI420(src, src_width * 4,
                  y, y_stride,
                  u, u_stride,
                  v, v_stride,
-                 dst_width, inv_dst_height);
+                 width, height);
       break;
     case FOURCC_ABGR:
-      src = sample + (src_width * crop_y + crop_x) * 4;
+      src = sample + (src_width * row + crop_x) * 4;
       ABGRToI420(src, src_width * 4,
                  y, y_stride,
                  u, u_stride,
                  v, v_stride,
-                 dst_width, inv_dst_height);
+                 width, height);
       break;
     case FOURCC_BGGR:
     case FOURCC_RGGB:
@@ -1014,73 +1008,73 @@ int ConvertToI420(const uint8* sample, size_t sample_size,
     case FOURCC_GBRG:
       // TODO(fbarchard): We could support cropping by odd numbers by
       // adjusting fourcc.
-      src = sample + (src_width * crop_y + crop_x);
+      src = sample + (src_width * row + crop_x);
       BayerRGBToI420(src, src_width, format,
                      y, y_stride, u, u_stride, v, v_stride,
-                     dst_width, inv_dst_height);
+                     width, height);
       break;
     // Biplanar formats
     case FOURCC_M420:
-      src = sample + (src_width * crop_y) * 12 / 8 + crop_x;
+      src = sample + (src_width * row) * 12 / 8 + crop_x;
       M420ToI420(src, src_width,
                  y, y_stride,
                  u, u_stride,
                  v, v_stride,
-                 dst_width, inv_dst_height);
+                 width, height);
       break;
 #if 0
     case FOURCC_NV12:
-      src = sample + (src_width * crop_y + crop_x);
-      src_uv = sample + aligned_src_width * (src_height + crop_y / 2) + crop_x;
+      src = sample + (src_width * row + crop_x);
+      src_uv = sample + aligned_src_width * (abs_src_height + row / 2) + crop_x;
       NV12ToI420Rotate(src, src_width,
                        src_uv, aligned_src_width,
                        y, y_stride,
                        u, u_stride,
                        v, v_stride,
-                       dst_width, inv_dst_height, rotation);
+                       width, height, rotation);
       break;
     case FOURCC_NV21:
-      src = sample + (src_width * crop_y + crop_x);
-      src_uv = sample + aligned_src_width * (src_height + crop_y / 2) + crop_x;
+      src = sample + (src_width * row + crop_x);
+      src_uv = sample + aligned_src_width * (abs_src_height + row / 2) + crop_x;
       // Call NV12 but with u and v parameters swapped.
       NV12ToI420Rotate(src, src_width,
                        src_uv, aligned_src_width,
                        y, y_stride,
                        u, u_stride,
                        v, v_stride,
-                       dst_width, inv_dst_height, rotation);
+                       width, height, rotation);
       break;
 #endif
     case FOURCC_Q420:
-      src = sample + (src_width + aligned_src_width * 2) * crop_y + crop_x;
-      src_uv = sample + (src_width + aligned_src_width * 2) * crop_y +
+      src = sample + (src_width + aligned_src_width * 2) * row + crop_x;
+      src_uv = sample + (src_width + aligned_src_width * 2) * row +
                src_width + crop_x * 2;
       Q420ToI420(src, src_width * 3,
                  src_uv, src_width * 3,
                  y, y_stride,
                  u, u_stride,
                  v, v_stride,
-                 dst_width, inv_dst_height);
+                 width, height);
       break;
 #if 0
     // Triplanar formats
     case FOURCC_I420:
     case FOURCC_YV12: {
-      const uint8* src_y = sample + (src_width * crop_y + crop_x);
+      const uint8* src_y = sample + (src_width * row + crop_x);
       const uint8* src_u;
       const uint8* src_v;
       int halfwidth = (src_width + 1) / 2;
       int halfheight = (abs_src_height + 1) / 2;
       if (format == FOURCC_I420) {
         src_u = sample + src_width * abs_src_height +
-            (halfwidth * crop_y + crop_x) / 2;
+            (halfwidth * row + crop_x) / 2;
         src_v = sample + src_width * abs_src_height +
-            halfwidth * (halfheight + crop_y / 2) + crop_x / 2;
+            halfwidth * (halfheight + row / 2) + crop_x / 2;
       } else {
         src_v = sample + src_width * abs_src_height +
-            (halfwidth * crop_y + crop_x) / 2;
+            (halfwidth * row + crop_x) / 2;
         src_u = sample + src_width * abs_src_height +
-            halfwidth * (halfheight + crop_y / 2) + crop_x / 2;
+            halfwidth * (halfheight + row / 2) + crop_x / 2;
       }
       I420Rotate(src_y, src_width,
                  src_u, halfwidth,
@@ -1088,7 +1082,7 @@ int ConvertToI420(const uint8* sample, size_t sample_size,
                  y, y_stride,
                  u, u_stride,
                  v, v_stride,
-                 dst_width, inv_dst_height, rotation);
+                 width, height, rotation);
       break;
     }
 #endif
@@ -1100,4 +1094,247 @@ int ConvertToI420(const uint8* sample, size_t sample_size,
   return 0;
 }
 
+// Rotates rows y_begin to y_end - 1 of a plane that is "height" rows high
+// into their place in the rotated plane.
+static void RotatePlaneRows(const uint8* src, int src_stride,
+                            uint8* dst, int dst_stride,
+                            int width, int height,
+                            int y_begin, int y_end,
+                            RotationMode mode) {
+  src += src_stride * y_begin;
+  switch (mode) {
+    case kRotate90:
+      RotatePlane90(src, src_stride, dst + height - y_end, dst_stride,
+                    width, y_end - y_begin);
+      break;
+    case kRotate270:
+      RotatePlane270(src, src_stride, dst + y_begin, dst_stride,
+                     width, y_end - y_begin);
+      break;
+    default:
+      RotatePlane180(src, src_stride,
+                     dst + dst_stride * (height - y_end), dst_stride,
+                     width, y_end - y_begin);
+      break;
+  }
+}
+
+// Rotates rows y_begin to y_end - 1 of an I420 frame, and the chroma rows
+// they use.  y_begin is even.
+static void RotateI420Rows(const uint8* src_y, int src_stride_y,
+                           const uint8* src_u, int src_stride_u,
+                           const uint8* src_v, int src_stride_v,
+                           uint8* dst_y, int dst_stride_y,
+                           uint8* dst_u, int dst_stride_u,
+                           uint8* dst_v, int dst_stride_v,
+                           int width, int height,
+                           int y_begin, int y_end,
+                           RotationMode mode) {
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (height + 1) >> 1;
+  RotatePlaneRows(src_y, src_stride_y, dst_y, dst_stride_y,
+                  width, height, y_begin, y_end, mode);
+  RotatePlaneRows(src_u, src_stride_u, dst_u, dst_stride_u,
+                  halfwidth, halfheight, y_begin >> 1, (y_end + 1) >> 1, mode);
+  RotatePlaneRows(src_v, src_stride_v, dst_v, dst_stride_v,
+                  halfwidth, halfheight, y_begin >> 1, (y_end + 1) >> 1, mode);
+}
+
+// Bytes of unpacked Y, U and V rows that ConvertToI420Scale keeps between
+// unpacking and scaling or rotation.  The size of a 16 KB L1 data cache.
+static const int kConvertStripSize = 16384;
+
+int ConvertToI420Scale(const uint8* sample, size_t sample_size,
+                       uint8* y, int y_stride,
+                       uint8* u, int u_stride,
+                       uint8* v, int v_stride,
+                       int crop_x, int crop_y,
+                       int src_width, int src_height,
+                       int crop_width, int crop_height,
+                       int dst_width, int dst_height,
+                       RotationMode rotation,
+                       FilterMode filtering,
+                       uint32 format) {
+  if (y == NULL || u == NULL || v == NULL || sample == NULL ||
+      crop_width <= 0 || crop_height <= 0 ||
+      dst_width <= 0 || dst_height <= 0) {
+    return -1;
+  }
+  if (rotation != kRotate0 && rotation != kRotate90 &&
+      rotation != kRotate180 && rotation != kRotate270) {
+    return -1;
+  }
+  const int abs_src_height = (src_height < 0) ? -src_height : src_height;
+  const bool invert = src_height < 0;
+  const bool scale = (dst_width != crop_width || dst_height != crop_height);
+  if (rotation == kRotate0 && !scale) {
+    return UnpackRowsToI420(sample, format, src_width, abs_src_height,
+                            crop_x, crop_y, y, y_stride, u, u_stride,
+                            v, v_stride, crop_width,
+                            invert ? -crop_height : crop_height);
+  }
+
+  // The crop is unpacked a strip of rows at a time.  Each strip is scaled,
+  // or rotated into place, while it is in the cache.  Strips are a
+  // multiple of 8 rows so they start on a chroma row and rotate with the
+  // 8 row transpose.  An inverted crop with
+  // an odd height pairs rows for chroma from the other end, so it is
+  // unpacked in one strip.
+  const int halfcrop_width = (crop_width + 1) >> 1;
+  const int strip_stride_y = (crop_width + 15) & ~15;
+  const int strip_stride_uv = (halfcrop_width + 15) & ~15;
+  int strip_rows = (kConvertStripSize /
+                    (strip_stride_y + strip_stride_uv)) & ~7;
+  if (strip_rows < 8) {
+    strip_rows = 8;
+  }
+  if (strip_rows > crop_height || (invert && (crop_height & 1))) {
+    strip_rows = (crop_height + 1) & ~1;
+  }
+  const int strip_size_y = strip_stride_y * strip_rows;
+  const int strip_size_uv = strip_stride_uv * (strip_rows >> 1);
+  uint8* strip_mem = new uint8[strip_size_y + strip_size_uv * 2 + 15];
+  uint8* strip_y = ALIGNP(strip_mem, 16);
+  uint8* strip_u = strip_y + strip_size_y;
+  uint8* strip_v = strip_u + strip_size_uv;
+
+  // When scaling and rotating, the scaled rows are rotated a band of 8
+  // rows, the rows the transpose does at a time, as soon as the band is
+  // complete.  They are scaled into a window of one band plus the rows a
+  // strip may scale past the last complete band, which starts at output
+  // row window_y.
+  const int halfdst_width = (dst_width + 1) >> 1;
+  const int scaled_stride_y = (dst_width + 15) & ~15;
+  const int scaled_stride_uv = (halfdst_width + 15) & ~15;
+  uint8* scaled_mem = NULL;
+  uint8* scaled_y = y;
+  uint8* scaled_u = u;
+  uint8* scaled_v = v;
+  int window_rows = 0;
+  int window_y = 0;
+  ScaleStream* stream = NULL;
+  if (scale) {
+    if (rotation != kRotate0) {
+      stream = ScaleStreamCreate(crop_width, crop_height,
+                                 dst_width, dst_height,
+                                 scaled_stride_y, scaled_stride_uv,
+                                 scaled_stride_uv, filtering);
+      window_rows = ScaleStreamWindowRows(stream, strip_rows) + 8;
+      if (window_rows > dst_height) {
+        window_rows = dst_height;
+      }
+      const int window_size_uv = scaled_stride_uv * ((window_rows + 1) >> 1);
+      scaled_mem = new uint8[scaled_stride_y * window_rows +
+                             window_size_uv * 2 + 15];
+      scaled_y = ALIGNP(scaled_mem, 16);
+      scaled_u = scaled_y + scaled_stride_y * window_rows;
+      scaled_v = scaled_u + window_size_uv;
+    } else {
+      stream = ScaleStreamCreate(crop_width, crop_height,
+                                 dst_width, dst_height,
+                                 y_stride, u_stride, v_stride, filtering);
+    }
+  }
+
+  int result = 0;
+  int rotated_rows = 0;
+  for (int row = 0; row < crop_height && result == 0; row += strip_rows) {
+    const int rows = (crop_height - row < strip_rows) ?
+                     crop_height - row : strip_rows;
+    // An inverted sample is read from the bottom of the crop up.
+    if (invert) {
+      result = UnpackRowsToI420(sample, format, src_width, abs_src_height,
+                                crop_x, crop_y + crop_height - row - rows,
+                                strip_y, strip_stride_y,
+                                strip_u, strip_stride_uv,
+                                strip_v, strip_stride_uv,
+                                crop_width, -rows);
+    } else {
+      result = UnpackRowsToI420(sample, format, src_width, abs_src_height,
+                                crop_x, crop_y + row,
+                                strip_y, strip_stride_y,
+                                strip_u, strip_stride_uv,
+                                strip_v, strip_stride_uv,
+                                crop_width, rows);
+    }
+    if (result != 0) {
+      break;
+    }
+    if (!scale) {
+      // Rotate the strip into place.  The strip buffer holds rows
+      // "row" onwards, so it is passed offset back to row 0.
+      RotateI420Rows(strip_y - strip_stride_y * row, strip_stride_y,
+                     strip_u - strip_stride_uv * (row >> 1), strip_stride_uv,
+                     strip_v - strip_stride_uv * (row >> 1), strip_stride_uv,
+                     y, y_stride, u, u_stride, v, v_stride,
+                     crop_width, crop_height, row, row + rows, rotation);
+      continue;
+    }
+    if (rotated_rows > window_y) {
+      // Move the rows not yet rotated to the start of the window.
+      const int shift = rotated_rows - window_y;
+      const int window_rows_uv = (window_rows + 1) >> 1;
+      memmove(scaled_y, scaled_y + shift * scaled_stride_y,
+              (window_rows - shift) * scaled_stride_y);
+      memmove(scaled_u, scaled_u + (shift >> 1) * scaled_stride_uv,
+              (window_rows_uv - (shift >> 1)) * scaled_stride_uv);
+      memmove(scaled_v, scaled_v + (shift >> 1) * scaled_stride_uv,
+              (window_rows_uv - (shift >> 1)) * scaled_stride_uv);
+      window_y = rotated_rows;
+    }
+    // The window is passed offset back to row 0.
+    uint8* frame_y = scaled_y - scaled_stride_y * window_y;
+    uint8* frame_u = scaled_u - scaled_stride_uv * (window_y >> 1);
+    uint8* frame_v = scaled_v - scaled_stride_uv * (window_y >> 1);
+    int done = ScaleStreamPush(stream, strip_y, strip_stride_y,
+                               strip_u, strip_stride_uv,
+                               strip_v, strip_stride_uv, rows,
+                               frame_y, frame_u, frame_v);
+    if (done < 0) {
+      result = -1;
+      break;
+    }
+    if (rotation != kRotate0) {
+      // Rotate the complete rows in bands of 8 until the last.
+      if (done < dst_height) {
+        done &= ~7;
+      }
+      if (done > rotated_rows) {
+        RotateI420Rows(frame_y, scaled_stride_y,
+                       frame_u, scaled_stride_uv,
+                       frame_v, scaled_stride_uv,
+                       y, y_stride, u, u_stride, v, v_stride,
+                       dst_width, dst_height, rotated_rows, done, rotation);
+        rotated_rows = done;
+      }
+    }
+  }
+
+  ScaleStreamDestroy(stream);
+  delete[] scaled_mem;
+  delete[] strip_mem;
+  return result;
+}
+
+// Convert camera sample to I420 with cropping, rotation and vertical flip.
+// src_width is used for source stride computation
+// src_height is used to compute location of planes, and indicate inversion
+int ConvertToI420(const uint8* sample, size_t sample_size,
+                  uint8* y, int y_stride,
+                  uint8* u, int u_stride,
+                  uint8* v, int v_stride,
+                  int crop_x, int crop_y,
+                  int src_width, int src_height,
+                  int dst_width, int dst_height,
+                  RotationMode rotation,
+                  uint32 format) {
+  const int abs_dst_height = (dst_height < 0) ? -dst_height : dst_height;
+  return ConvertToI420Scale(sample, sample_size,
+                            y, y_stride, u, u_stride, v, v_stride,
+                            crop_x, crop_y, src_width, src_height,
+                            dst_width, abs_dst_height,
+                            dst_width, abs_dst_height,
+                            rotation, kFilterNone, format);
+}
+
 } // namespace libyuv
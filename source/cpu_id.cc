@@ -50,7 +50,9 @@ static void InitCpuFlags() {
 #ifdef CPU_X86
   int cpu_info[4];
   x__cpuid(cpu_info, 1);
-  cpu_info_ = (cpu_info[3] & 0x04000000 ? kCpuHasSSE2 : 0) |
+  cpu_info_ = (cpu_info[3] & 0x00800000 ? kCpuHasMMX : 0) |
+              (cpu_info[3] & 0x02000000 ? kCpuHasSSE : 0) |
+              (cpu_info[3] & 0x04000000 ? kCpuHasSSE2 : 0) |
               (cpu_info[2] & 0x00000200 ? kCpuHasSSSE3 : 0) |
               kCpuInitialized;
 #elif defined(__ANDROID__) && defined(__ARM_NEON__)
@@ -79,4 +81,14 @@ bool TestCpuFlag(int flag) {
   return (cpu_info_ & flag) ? true : false;
 }
 
+static int non_temporal_threshold_ = 256 * 1024;
+
+void SetNonTemporalThreshold(int bytes) {
+  non_temporal_threshold_ = bytes;
+}
+
+int GetNonTemporalThreshold() {
+  return non_temporal_threshold_;
+}
+
 }  // namespace libyuv
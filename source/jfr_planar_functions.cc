@@ -1,8 +1,12 @@
-//FIXME: Undefine these
-#define RGB565_w 2
-#define ARGB1555_w 2
-#define ARGB4444_w 2
-#define ARGB_w 4
+// MMX converts the largest multiple of 32 pixels of each row and C the rest.
+#if defined(HAS_FASTCONVERTYUVTOARGBROW_MMX)
+#define FastConvertYUVTo___Row(name, width) \
+    (!TestCpuFlag(kCpuHasMMX) ? FastConvertYUVTo ## name ## Row_C : \
+     ((width) % 32 == 0) ? FastConvertYUVTo ## name ## Row_MMX : \
+     FastConvertYUVTo ## name ## Row_Any_MMX)
+#else
+#define FastConvertYUVTo___Row(name, width) FastConvertYUVTo ## name ## Row_C
+#endif
 
 #define I420To___(name) \
   int I420To ## name ## _(const uint8* src_y, int src_stride_y, \
@@ -21,12 +25,7 @@
                                             const uint8* v_buf, \
                                             uint8* rgb_buf, \
                                             int width); \
-    /* FIXME: Consider requirements for speedup */ \
-    if (width % name ## _w == 0) { \
-      FastConvertYUVTo ## name ## Row = FastConvertYUVTo ## name ## Row_MMX; \
-    } else { \
-      /* FIXME: FastConvertYUVTo ## name ## Row = FastConvertYUVTo ## name ## Row_C; */ \
-    } \
+    FastConvertYUVTo ## name ## Row = FastConvertYUVTo___Row(name, width); \
     for (int y = 0; y < height; ++y) { \
       FastConvertYUVTo ## name ## Row(src_y, src_u, src_v, dst_rgb, width); \
       dst_rgb += dst_stride_rgb; \
@@ -37,8 +36,7 @@
       } \
     } \
     /* MMX used for FastConvertYUVTo___Row requires an emms instruction. */ \
-    /* FIXME: Only clear in MMX path */ \
-    asm("emms"); \
+    EMMS(); \
     return 0; \
   }
 
@@ -48,3 +46,4 @@ I420To___(ARGB4444)
 I420To___(ARGB)
 
 #undef I420To___
+#undef FastConvertYUVTo___Row
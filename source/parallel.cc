@@ -0,0 +1,148 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "libyuv/parallel.h"
+
+#include "parallel_priv.h"
+
+#if defined(WIN32)
+#include <windows.h>
+#endif
+
+#if !defined(LIBYUV_DISABLE_THREADS)
+#if defined(WIN32)
+#define HAS_THREADS_WIN32
+#elif defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#define HAS_THREADS_PTHREAD
+#endif
+#endif
+
+namespace libyuv {
+
+// Each worker runs every 'step'th job starting at 'first'.  The static
+// partitioning avoids any locking between the workers.
+struct ParallelWorker {
+  ParallelJob job;
+  void* job_opaque;
+  int first;
+  int step;
+  int count;
+};
+
+static void RunWorker(const ParallelWorker* worker) {
+  for (int i = worker->first; i < worker->count; i += worker->step) {
+    worker->job(worker->job_opaque, i);
+  }
+}
+
+#if defined(HAS_THREADS_WIN32)
+static DWORD WINAPI WorkerThread(LPVOID opaque) {
+  RunWorker(static_cast<const ParallelWorker*>(opaque));
+  return 0;
+}
+#elif defined(HAS_THREADS_PTHREAD)
+static void* WorkerThread(void* opaque) {
+  RunWorker(static_cast<const ParallelWorker*>(opaque));
+  return NULL;
+}
+#endif
+
+void RunParallelJobs(ParallelJob job, void* job_opaque, int count,
+                     int num_threads) {
+  if (num_threads > count) {
+    num_threads = count;
+  }
+  if (num_threads > kMaxParallelThreads) {
+    num_threads = kMaxParallelThreads;
+  }
+#if !defined(HAS_THREADS_WIN32) && !defined(HAS_THREADS_PTHREAD)
+  num_threads = 1;
+#endif
+  if (num_threads <= 1) {
+    for (int i = 0; i < count; ++i) {
+      job(job_opaque, i);
+    }
+    return;
+  }
+
+  ParallelWorker workers[kMaxParallelThreads];
+  for (int t = 0; t < num_threads; ++t) {
+    workers[t].job = job;
+    workers[t].job_opaque = job_opaque;
+    workers[t].first = t;
+    workers[t].step = num_threads;
+    workers[t].count = count;
+  }
+
+  // Worker 0 runs on the calling thread.  If a thread can not be created,
+  // its share of the jobs is run on the calling thread instead.
+#if defined(HAS_THREADS_WIN32)
+  HANDLE threads[kMaxParallelThreads];
+  for (int t = 1; t < num_threads; ++t) {
+    threads[t] = CreateThread(NULL, 0, WorkerThread, &workers[t], 0, NULL);
+  }
+  RunWorker(&workers[0]);
+  for (int t = 1; t < num_threads; ++t) {
+    if (threads[t]) {
+      WaitForSingleObject(threads[t], INFINITE);
+      CloseHandle(threads[t]);
+    } else {
+      RunWorker(&workers[t]);
+    }
+  }
+#elif defined(HAS_THREADS_PTHREAD)
+  pthread_t threads[kMaxParallelThreads];
+  bool started[kMaxParallelThreads];
+  for (int t = 1; t < num_threads; ++t) {
+    started[t] = pthread_create(&threads[t], NULL, WorkerThread,
+                                &workers[t]) == 0;
+  }
+  RunWorker(&workers[0]);
+  for (int t = 1; t < num_threads; ++t) {
+    if (started[t]) {
+      pthread_join(threads[t], NULL);
+    } else {
+      RunWorker(&workers[t]);
+    }
+  }
+#endif
+}
+
+void* AtomicCompareExchangePointer(void* volatile* ptr, void* exchange,
+                                   void* comparand) {
+#if defined(WIN32)
+  return InterlockedCompareExchangePointer(ptr, exchange, comparand);
+#elif defined(__GNUC__)
+  return __sync_val_compare_and_swap(ptr, comparand, exchange);
+#else
+  void* value = *ptr;
+  if (value == comparand) {
+    *ptr = exchange;
+  }
+  return value;
+#endif
+}
+
+void* AtomicLoadAcquirePointer(void* volatile* ptr) {
+  void* value = *ptr;
+#if defined(WIN32)
+  MemoryBarrier();
+#elif defined(__i386__) || defined(__x86_64__)
+  // x86 does not reorder loads with later loads, so only the compiler
+  // needs to be stopped from doing so.
+  asm volatile ("" : : : "memory");
+#elif defined(__GNUC__)
+  __sync_synchronize();
+#endif
+  return value;
+}
+
+}  // namespace libyuv
@@ -0,0 +1,30 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef SOURCE_PARALLEL_PRIV_H_
+#define SOURCE_PARALLEL_PRIV_H_
+
+#include "libyuv/basic_types.h"
+
+namespace libyuv {
+
+// Sets *ptr to "exchange" if it equals "comparand", as one atomic operation.
+// Returns the previous value of *ptr.  Used to publish data that is shared
+// between threads.
+void* AtomicCompareExchangePointer(void* volatile* ptr, void* exchange,
+                                   void* comparand);
+
+// Reads *ptr with acquire semantics, so data published through
+// AtomicCompareExchangePointer is visible once the pointer is.
+void* AtomicLoadAcquirePointer(void* volatile* ptr);
+
+}  // namespace libyuv
+
+#endif  // SOURCE_PARALLEL_PRIV_H_
@@ -39,107 +39,42 @@ static void SplitUV_NEON(const uint8* src_uv,
   );
 }
 
-#elif (defined(WIN32) || defined(__x86_64__) || defined(__i386__)) \
-    && !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
-
-#if defined(WIN32) && !defined(COVERAGE_ENABLED)
-#define HAS_SPLITUV_SSE2
-__declspec(naked)
-static void SplitUV_SSE2(const uint8* src_uv,
-                         uint8* dst_u, uint8* dst_v, int pix) {
-  __asm {
-    push       edi
-    mov        eax, [esp + 4 + 4]    // src_uv
-    mov        edx, [esp + 4 + 8]    // dst_u
-    mov        edi, [esp + 4 + 12]   // dst_v
-    mov        ecx, [esp + 4 + 16]   // pix
-    pcmpeqb    xmm5, xmm5            // generate mask 0x00ff00ff
-    psrlw      xmm5, 8
-
-  convertloop:
-    movdqa     xmm0, [eax]
-    movdqa     xmm1, [eax + 16]
-    lea        eax,  [eax + 32]
-    movdqa     xmm2, xmm0
-    movdqa     xmm3, xmm1
-    pand       xmm0, xmm5   // even bytes
-    pand       xmm1, xmm5
-    packuswb   xmm0, xmm1
-    movdqa     [edx], xmm0
-    lea        edx, [edx + 16]
-    psrlw      xmm2, 8      // odd bytes
-    psrlw      xmm3, 8
-    packuswb   xmm2, xmm3
-    movdqa     [edi], xmm2
-    lea        edi, [edi + 16]
-    sub        ecx, 16
-    ja         convertloop
-    pop        edi
-    ret
+// Any width.  The NEON version splits multiples of 16 pixels and C the rest.
+static void SplitUV_Any_NEON(const uint8* src_uv,
+                             uint8* dst_u, uint8* dst_v, int pix) {
+  int n = pix & ~15;
+  if (n > 0) {
+    SplitUV_NEON(src_uv, dst_u, dst_v, n);
   }
-}
-
-#elif (defined(__x86_64__) || defined(__i386__)) && \
-    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
-#define HAS_SPLITUV_SSE2
-static void SplitUV_SSE2(const uint8* src_uv,
-                         uint8* dst_u, uint8* dst_v, int pix) {
- asm volatile (
-  "pcmpeqb    %%xmm5,%%xmm5                    \n"
-  "psrlw      $0x8,%%xmm5                      \n"
-"1:                                            \n"
-  "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     0x10(%0),%%xmm1                  \n"
-  "lea        0x20(%0),%0                      \n"
-  "movdqa     %%xmm0,%%xmm2                    \n"
-  "movdqa     %%xmm1,%%xmm3                    \n"
-  "pand       %%xmm5,%%xmm0                    \n"
-  "pand       %%xmm5,%%xmm1                    \n"
-  "packuswb   %%xmm1,%%xmm0                    \n"
-  "movdqa     %%xmm0,(%1)                      \n"
-  "lea        0x10(%1),%1                      \n"
-  "psrlw      $0x8,%%xmm2                      \n"
-  "psrlw      $0x8,%%xmm3                      \n"
-  "packuswb   %%xmm3,%%xmm2                    \n"
-  "movdqa     %%xmm2,(%2)                      \n"
-  "lea        0x10(%2),%2                      \n"
-  "sub        $0x10,%3                         \n"
-  "ja         1b                               \n"
-  : "+r"(src_uv),     // %0
-    "+r"(dst_u),      // %1
-    "+r"(dst_v),      // %2
-    "+r"(pix)         // %3
-  :
-  : "memory", "cc"
-#if defined(__SSE2__)
-    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm5"
-#endif
-);
-}
-#endif
-#endif
-
-static void SplitUV_C(const uint8* src_uv,
-                      uint8* dst_u, uint8* dst_v, int pix) {
-  // Copy a row of UV.
-  for (int x = 0; x < pix; ++x) {
-    dst_u[0] = src_uv[0];
-    dst_v[0] = src_uv[1];
-    src_uv += 2;
-    dst_u += 1;
-    dst_v += 1;
+  if (n < pix) {
+    SplitUV_C(src_uv + n * 2, dst_u + n, dst_v + n, pix - n);
   }
 }
+#endif
 
+// Copies a plane.  A plane larger than the non-temporal threshold is
+// written with streaming stores, so it does not evict the source and the
+// rest of the working set from the cache, if its rows are 16 byte aligned.
 static void I420CopyPlane(const uint8* src_y, int src_stride_y,
                           uint8* dst_y, int dst_stride_y,
                           int width, int height) {
-  // Copy plane
+  CopyRowFunc CopyRow = GetCopyRow_NT(width * height, dst_y, dst_stride_y,
+                                      16);
+  if (!CopyRow) {
+    for (int y = 0; y < height; ++y) {
+      memcpy(dst_y, src_y, width);
+      src_y += src_stride_y;
+      dst_y += dst_stride_y;
+    }
+    return;
+  }
   for (int y = 0; y < height; ++y) {
-    memcpy(dst_y, src_y, width);
+    CopyRow(src_y, dst_y, width);
     src_y += src_stride_y;
     dst_y += dst_stride_y;
   }
+  SFENCE();
+  EMMS();
 }
 
 // Copy I420 with optional flipping
@@ -176,6 +111,56 @@ int I420Copy(const uint8* src_y, int src_stride_y,
   return 0;
 }
 
+// Mirrors a plane from left to right.  Negative height flips it upside
+// down as well, which is a rotation by 180 degrees, in one pass.  When src
+// and dst are the same plane the rows are reversed in place.
+static void MirrorPlane(const uint8* src, int src_stride,
+                        uint8* dst, int dst_stride,
+                        int width, int height) {
+  void (*ReverseLine)(const uint8* src, uint8* dst, int width);
+#if defined(HAS_REVERSELINE_SSSE3)
+  if (TestCpuFlag(kCpuHasSSSE3)) {
+    ReverseLine = ReverseLine_Any_SSSE3;
+  } else
+#endif
+#if defined(HAS_REVERSELINE_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2)) {
+    ReverseLine = ReverseLine_Any_SSE2;
+  } else
+#endif
+#if defined(HAS_REVERSELINE_SSE)
+  if (TestCpuFlag(kCpuHasSSE)) {
+    ReverseLine = ReverseLine_Any_SSE;
+  } else
+#endif
+  {
+    ReverseLine = ReverseLine_C;
+  }
+
+  const bool flip = height < 0;
+  if (flip) {
+    height = -height;
+  }
+  if (src != dst || src_stride != dst_stride) {
+    if (flip) {
+      src += src_stride * (height - 1);
+      src_stride = -src_stride;
+    }
+    for (int y = 0; y < height; ++y) {
+      ReverseLine(src, dst, width);
+      src += src_stride;
+      dst += dst_stride;
+    }
+  } else {
+    ReverseRowsInPlace(dst, dst_stride, width, height, 1, flip, ReverseLine);
+  }
+#if defined(HAS_REVERSELINE_SSE)
+  if (ReverseLine == ReverseLine_Any_SSE) {
+    EMMS();
+  }
+#endif
+}
+
 int I420Mirror(const uint8* src_y, int src_stride_y,
                const uint8* src_u, int src_stride_u,
                const uint8* src_v, int src_stride_v,
@@ -184,52 +169,20 @@ int I420Mirror(const uint8* src_y, int src_stride_y,
                uint8* dst_v, int dst_stride_v,
                int width, int height) {
   if (src_y == NULL || src_u == NULL || src_v == NULL ||
-      dst_y == NULL || dst_u == NULL || dst_v == NULL)
+      dst_y == NULL || dst_u == NULL || dst_v == NULL ||
+      width <= 0 || height == 0)
     return -1;
 
-  // Only accepts positive dimensions
-  if (height < 0 || width < 0 ||  src_stride_y < 0 || src_stride_u < 0 ||
-      src_stride_v < 0 || dst_stride_y < 0 || dst_stride_u < 0 ||
-      dst_stride_v < 0)
-    return -1;
-
-  int indO = 0;
-  int indS  = 0;
-  int wind, hind;
-  uint8 tmp_val;
-  // Will swap two values per iteration
-  const int half_width = (width + 1) >> 1;
-
-  // Y
-  for (wind = 0; wind < half_width; ++wind) {
-   for (hind = 0; hind < height; ++hind) {
-     indO = hind * src_stride_y + wind;
-     indS = hind * dst_stride_y + (width - wind - 1);
-     tmp_val = src_y[indO];
-     dst_y[indO] = src_y[indS];
-     dst_y[indS] = tmp_val;
-    }
+  const int halfwidth = (width + 1) >> 1;
+  int halfheight = (height + 1) >> 1;
+  // Negative height means mirror and flip the image.
+  if (height < 0) {
+    halfheight = -((-height + 1) >> 1);
   }
 
-  const int half_height = (height + 1) >> 1;
-  const int half_uv_width = (width + 1) >> 1;
-
-  for (wind = 0; wind < half_uv_width; ++wind) {
-   for (hind = 0; hind < half_height; ++hind) {
-     // U
-     indO = hind * dst_stride_u + wind;
-     indS = hind * dst_stride_u + (half_uv_width - wind - 1);
-     tmp_val = src_u[indO];
-     dst_u[indO] = src_u[indS];
-     dst_u[indS] = tmp_val;
-     // V
-     indO = hind * dst_stride_v + wind;
-     indS = hind * dst_stride_v + (half_uv_width - wind - 1);
-     tmp_val = src_v[indO];
-     dst_v[indO] = src_v[indS];
-     dst_v[indS] = tmp_val;
-   }
-  }
+  MirrorPlane(src_y, src_stride_y, dst_y, dst_stride_y, width, height);
+  MirrorPlane(src_u, src_stride_u, dst_u, dst_stride_u, halfwidth, halfheight);
+  MirrorPlane(src_v, src_stride_v, dst_v, dst_stride_v, halfwidth, halfheight);
   return 0;
 }
 
@@ -298,21 +251,44 @@ static void SetRow8_C(uint8* dst, uint32 v8, int count) {
   memset(dst, v8, count);
 }
 
+// Any width.  The SIMD version sets multiples of 16 bytes and C the rest.
+#define SETROWANY(NAMEANY, SETROW_SIMD)                                        \
+    static void NAMEANY(uint8* dst, uint32 v32, int count) {                   \
+      int n = count & ~15;                                                     \
+      if (n > 0) {                                                             \
+        SETROW_SIMD(dst, v32, n);                                              \
+      }                                                                        \
+      if (n < count) {                                                         \
+        SetRow8_C(dst + n, v32, count - n);                                    \
+      }                                                                        \
+    }
+
+#if defined(HAS_SETROW_NEON)
+SETROWANY(SetRow32_Any_NEON, SetRow32_NEON)
+#elif defined(HAS_SETROW_SSE2)
+SETROWANY(SetRow32_Any_SSE2, SetRow32_SSE2)
+#endif
+#undef SETROWANY
+
 static void I420SetPlane(uint8* dst_y, int dst_stride_y,
                          int width, int height,
                          int value) {
   void (*SetRow)(uint8* dst, uint32 value, int pix);
 #if defined(HAS_SETROW_NEON)
   if (TestCpuFlag(kCpuHasNEON) &&
-      (width % 16 == 0) &&
       IS_ALIGNED(dst_y, 16) && (dst_stride_y % 16 == 0)) {
-    SetRow = SetRow32_NEON;
+    SetRow = SetRow32_Any_NEON;
+    if (width % 16 == 0) {
+      SetRow = SetRow32_NEON;
+    }
   } else
 #elif defined(HAS_SETROW_SSE2)
   if (TestCpuFlag(kCpuHasSSE2) &&
-      (width % 16 == 0) &&
       IS_ALIGNED(dst_y, 16) && (dst_stride_y % 16 == 0)) {
-    SetRow = SetRow32_SSE2;
+    SetRow = SetRow32_Any_SSE2;
+    if (width % 16 == 0) {
+      SetRow = SetRow32_SSE2;
+    }
   } else
 #endif
   {
@@ -465,19 +441,23 @@ static int X420ToI420(const uint8* src_y,
   void (*SplitUV)(const uint8* src_uv, uint8* dst_u, uint8* dst_v, int pix);
 #if defined(HAS_SPLITUV_NEON)
   if (TestCpuFlag(kCpuHasNEON) &&
-      (halfwidth % 16 == 0) &&
       IS_ALIGNED(src_uv, 16) && (src_stride_uv % 16 == 0) &&
       IS_ALIGNED(dst_u, 16) && (dst_stride_u % 16 == 0) &&
       IS_ALIGNED(dst_v, 16) && (dst_stride_v % 16 == 0)) {
-    SplitUV = SplitUV_NEON;
+    SplitUV = SplitUV_Any_NEON;
+    if (halfwidth % 16 == 0) {
+      SplitUV = SplitUV_NEON;
+    }
   } else
 #elif defined(HAS_SPLITUV_SSE2)
   if (TestCpuFlag(kCpuHasSSE2) &&
-      (halfwidth % 16 == 0) &&
       IS_ALIGNED(src_uv, 16) && (src_stride_uv % 16 == 0) &&
       IS_ALIGNED(dst_u, 16) && (dst_stride_u % 16 == 0) &&
       IS_ALIGNED(dst_v, 16) && (dst_stride_v % 16 == 0)) {
-    SplitUV = SplitUV_SSE2;
+    SplitUV = SplitUV_Any_SSE2;
+    if (halfwidth % 16 == 0) {
+      SplitUV = SplitUV_SSE2;
+    }
   } else
 #endif
   {
@@ -653,6 +633,22 @@ static void SplitYUY2_C(const uint8* src_yuy2,
   }
 }
 
+#if defined(HAS_SPLITYUY2_SSE2)
+// Any width.  SSE2 splits multiples of 16 pixels and C the rest.
+static void SplitYUY2_Any_SSE2(const uint8* src_yuy2,
+                               uint8* dst_y, uint8* dst_u, uint8* dst_v,
+                               int pix) {
+  int n = pix & ~15;
+  if (n > 0) {
+    SplitYUY2_SSE2(src_yuy2, dst_y, dst_u, dst_v, n);
+  }
+  if (n < pix) {
+    SplitYUY2_C(src_yuy2 + n * 2, dst_y + n, dst_u + (n >> 1),
+                dst_v + (n >> 1), pix - n);
+  }
+}
+#endif
+
 // Convert Q420 to I420.
 // Format is rows of YY/YUYV
 int Q420ToI420(const uint8* src_y, int src_stride_y,
@@ -676,12 +672,14 @@ int Q420ToI420(const uint8* src_y, int src_stride_y,
                     uint8* dst_y, uint8* dst_u, uint8* dst_v, int pix);
 #if defined(HAS_SPLITYUY2_SSE2)
   if (TestCpuFlag(kCpuHasSSE2) &&
-      (width % 16 == 0) &&
       IS_ALIGNED(src_yuy2, 16) && (src_stride_yuy2 % 16 == 0) &&
       IS_ALIGNED(dst_y, 16) && (dst_stride_y % 16 == 0) &&
       IS_ALIGNED(dst_u, 8) && (dst_stride_u % 8 == 0) &&
       IS_ALIGNED(dst_v, 8) && (dst_stride_v % 8 == 0)) {
-    SplitYUY2 = SplitYUY2_SSE2;
+    SplitYUY2 = SplitYUY2_Any_SSE2;
+    if (width % 16 == 0) {
+      SplitYUY2 = SplitYUY2_SSE2;
+    }
   } else
 #endif
   {
@@ -1019,6 +1017,42 @@ void UYVYToI420RowY_C(const uint8* src_uyvy,
   }
 }
 
+// Any width.  SSE2 converts multiples of 16 pixels and C the rest.
+#define YUY2ANY(NAMEANY, TOYROW_SIMD, TOYROW_C)                               \
+    static void NAMEANY(const uint8* src_yuy2, uint8* dst_y, int pix) {        \
+      int n = pix & ~15;                                                       \
+      if (n > 0) {                                                             \
+        TOYROW_SIMD(src_yuy2, dst_y, n);                                       \
+      }                                                                        \
+      if (n < pix) {                                                           \
+        TOYROW_C(src_yuy2 + n * 2, dst_y + n, pix - n);                        \
+      }                                                                        \
+    }
+
+#define UV422ANY(NAMEANY, TOUVROW_SIMD, TOUVROW_C)                             \
+    static void NAMEANY(const uint8* src_yuy2, int src_stride_yuy2,            \
+                        uint8* dst_u, uint8* dst_v, int pix) {                 \
+      int n = pix & ~15;                                                       \
+      if (n > 0) {                                                             \
+        TOUVROW_SIMD(src_yuy2, src_stride_yuy2, dst_u, dst_v, n);              \
+      }                                                                        \
+      if (n < pix) {                                                           \
+        TOUVROW_C(src_yuy2 + n * 2, src_stride_yuy2,                           \
+                  dst_u + (n >> 1), dst_v + (n >> 1), pix - n);                \
+      }                                                                        \
+    }
+
+#if defined(HAS_YUY2TOI420ROW_SSE2)
+YUY2ANY(YUY2ToI420RowY_Any_SSE2, YUY2ToI420RowY_SSE2, YUY2ToI420RowY_C)
+UV422ANY(YUY2ToI420RowUV_Any_SSE2, YUY2ToI420RowUV_SSE2, YUY2ToI420RowUV_C)
+#endif
+#if defined(HAS_UYVYTOI420ROW_SSE2)
+YUY2ANY(UYVYToI420RowY_Any_SSE2, UYVYToI420RowY_SSE2, UYVYToI420RowY_C)
+UV422ANY(UYVYToI420RowUV_Any_SSE2, UYVYToI420RowUV_SSE2, UYVYToI420RowUV_C)
+#endif
+#undef YUY2ANY
+#undef UV422ANY
+
 // Convert YUY2 to I420.
 int YUY2ToI420(const uint8* src_yuy2, int src_stride_yuy2,
                uint8* dst_y, int dst_stride_y,
@@ -1037,13 +1071,16 @@ int YUY2ToI420(const uint8* src_yuy2, int src_stride_yuy2,
                          uint8* dst_y, int pix);
 #if defined(HAS_YUY2TOI420ROW_SSE2)
   if (TestCpuFlag(kCpuHasSSE2) &&
-      (width % 16 == 0) &&
       IS_ALIGNED(src_yuy2, 16) && (src_stride_yuy2 % 16 == 0) &&
       IS_ALIGNED(dst_y, 16) && (dst_stride_y % 16 == 0) &&
       IS_ALIGNED(dst_u, 8) && (dst_stride_u % 8 == 0) &&
       IS_ALIGNED(dst_v, 8) && (dst_stride_v % 8 == 0)) {
-    YUY2ToI420RowY = YUY2ToI420RowY_SSE2;
-    YUY2ToI420RowUV = YUY2ToI420RowUV_SSE2;
+    YUY2ToI420RowY = YUY2ToI420RowY_Any_SSE2;
+    YUY2ToI420RowUV = YUY2ToI420RowUV_Any_SSE2;
+    if (width % 16 == 0) {
+      YUY2ToI420RowY = YUY2ToI420RowY_SSE2;
+      YUY2ToI420RowUV = YUY2ToI420RowUV_SSE2;
+    }
   } else
 #endif
   {
@@ -1084,13 +1121,16 @@ int UYVYToI420(const uint8* src_uyvy, int src_stride_uyvy,
                          uint8* dst_y, int pix);
 #if defined(HAS_UYVYTOI420ROW_SSE2)
   if (TestCpuFlag(kCpuHasSSE2) &&
-      (width % 16 == 0) &&
       IS_ALIGNED(src_uyvy, 16) && (src_stride_uyvy % 16 == 0) &&
       IS_ALIGNED(dst_y, 16) && (dst_stride_y % 16 == 0) &&
       IS_ALIGNED(dst_u, 8) && (dst_stride_u % 8 == 0) &&
       IS_ALIGNED(dst_v, 8) && (dst_stride_v % 8 == 0)) {
-    UYVYToI420RowY = UYVYToI420RowY_SSE2;
-    UYVYToI420RowUV = UYVYToI420RowUV_SSE2;
+    UYVYToI420RowY = UYVYToI420RowY_Any_SSE2;
+    UYVYToI420RowUV = UYVYToI420RowUV_Any_SSE2;
+    if (width % 16 == 0) {
+      UYVYToI420RowY = UYVYToI420RowY_SSE2;
+      UYVYToI420RowUV = UYVYToI420RowUV_SSE2;
+    }
   } else
 #endif
   {
@@ -1152,8 +1192,11 @@ int I420ToARGB(const uint8* src_y, int src_stride_y,
   } else
 #endif
 #if defined(HAS_FASTCONVERTYUVTOARGBROW_MMX)
-  if (width % 2 == 0) {
-    FastConvertYUVToARGBRow = FastConvertYUVToARGBRow_MMX;
+  if (TestCpuFlag(kCpuHasMMX)) {
+    FastConvertYUVToARGBRow = FastConvertYUVToARGBRow_Any_MMX;
+    if (width % 32 == 0) {
+      FastConvertYUVToARGBRow = FastConvertYUVToARGBRow_MMX;
+    }
   } else
 #endif
   {
@@ -1206,8 +1249,11 @@ int I420ToBGRA(const uint8* src_y, int src_stride_y,
   } else
 #endif
 #if defined(HAS_FASTCONVERTYUVTOBGRAROW_MMX)
-  if (width % 2 == 0) {
-    FastConvertYUVToBGRARow = FastConvertYUVToBGRARow_MMX;
+  if (TestCpuFlag(kCpuHasMMX)) {
+    FastConvertYUVToBGRARow = FastConvertYUVToBGRARow_Any_MMX;
+    if (width % 2 == 0) {
+      FastConvertYUVToBGRARow = FastConvertYUVToBGRARow_MMX;
+    }
   } else
 #endif
   {
@@ -1257,8 +1303,11 @@ int I420ToABGR(const uint8* src_y, int src_stride_y,
   } else
 #endif
 #if defined(HAS_FASTCONVERTYUVTOABGRROW_MMX)
-  if (width % 2 == 0) {
-    FastConvertYUVToABGRRow = FastConvertYUVToABGRRow_MMX;
+  if (TestCpuFlag(kCpuHasMMX)) {
+    FastConvertYUVToABGRRow = FastConvertYUVToABGRRow_Any_MMX;
+    if (width % 2 == 0) {
+      FastConvertYUVToABGRRow = FastConvertYUVToABGRRow_MMX;
+    }
   } else
 #endif
   {
@@ -1308,8 +1357,11 @@ int I422ToARGB(const uint8* src_y, int src_stride_y,
   } else
 #endif
 #if defined(HAS_FASTCONVERTYUVTOARGBROW_MMX)
-  if (width % 2 == 0) {
-    FastConvertYUVToARGBRow = FastConvertYUVToARGBRow_MMX;
+  if (TestCpuFlag(kCpuHasMMX)) {
+    FastConvertYUVToARGBRow = FastConvertYUVToARGBRow_Any_MMX;
+    if (width % 32 == 0) {
+      FastConvertYUVToARGBRow = FastConvertYUVToARGBRow_MMX;
+    }
   } else
 #endif
   {
@@ -1396,8 +1448,11 @@ int I400ToARGB_Reference(const uint8* src_y, int src_stride_y,
   } else
 #endif
 #if defined(HAS_FASTCONVERTYUVTOARGBROW_MMX)
-  if (width % 2 == 0) {
-    FastConvertYToARGBRow = FastConvertYToARGBRow_MMX;
+  if (TestCpuFlag(kCpuHasMMX)) {
+    FastConvertYToARGBRow = FastConvertYToARGBRow_Any_MMX;
+    if (width % 2 == 0) {
+      FastConvertYToARGBRow = FastConvertYToARGBRow_MMX;
+    }
   } else
 #endif
   {
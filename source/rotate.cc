@@ -10,22 +10,23 @@
 
 #include "libyuv/rotate.h"
 
+#include <string.h>
+
 #include "libyuv/cpu_id.h"
 #include "libyuv/planar_functions.h"
 #include "rotate_priv.h"
+#include "row.h"
 
 namespace libyuv {
 
 #if (defined(WIN32) || defined(__x86_64__) || defined(__i386__)) \
     && !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+#undef TALIGN16  // row.h only has the GCC version.
 #if defined(_MSC_VER)
 #define TALIGN16(t, var) static __declspec(align(16)) t _ ## var
 #else
 #define TALIGN16(t, var) t var __attribute__((aligned(16)))
 #endif
-// Shuffle table for reversing the bytes.
-extern "C" TALIGN16(const uint8, kShuffleReverse[16]) =
-  { 15u, 14u, 13u, 12u, 11u, 10u, 9u, 8u, 7u, 6u, 5u, 4u, 3u, 2u, 1u, 0u };
 // Shuffle table for reversing the bytes of UV channels.
 extern "C" TALIGN16(const uint8, kShuffleReverseUV[16]) =
   { 14u, 12u, 10u, 8u, 6u, 4u, 2u, 0u, 15u, 13u, 11u, 9u, 7u, 5u, 3u, 1u };
@@ -747,6 +748,185 @@ static void TransposeUVWx8_SSE2(const uint8* src, int src_stride,
 #endif
 #endif
 
+// MMX versions for processors without SSSE3.  An 8x8 block is transposed
+// with three rounds of unpacks.  Rows 4 to 7 are unpacked after the first
+// half of the block is finished to stay within the 8 MMX registers.  The
+// loads and stores are movq, so src and dst need not be aligned.
+#if defined(WIN32) && !defined(COVERAGE_ENABLED)
+#define HAS_TRANSPOSE_WX8_MMX
+__declspec(naked)
+static void TransposeWx8_MMX(const uint8* src, int src_stride,
+                             uint8* dst, int dst_stride, int width) {
+__asm {
+    push      edi
+    push      esi
+    push      ebp
+    mov       eax, [esp + 12 + 4]   // src
+    mov       edi, [esp + 12 + 8]   // src_stride
+    mov       edx, [esp + 12 + 12]  // dst
+    mov       esi, [esp + 12 + 16]  // dst_stride
+    mov       ecx, [esp + 12 + 20]  // width
+ convertloop :
+    // First and second round of bit swap for rows 0 to 3.
+    lea       ebp, [eax + 8]
+    movq      mm0, [eax]
+    movq      mm4, mm0
+    punpcklbw mm0, [eax + edi]
+    punpckhbw mm4, [eax + edi]
+    lea       eax, [eax + 2 * edi]
+    movq      mm1, [eax]
+    movq      mm5, mm1
+    punpcklbw mm1, [eax + edi]
+    punpckhbw mm5, [eax + edi]
+    lea       eax, [eax + 2 * edi]
+    movq      mm2, mm0
+    punpcklwd mm0, mm1
+    punpckhwd mm2, mm1
+    movq      mm3, mm4
+    punpcklwd mm4, mm5
+    punpckhwd mm3, mm5
+    // Rows 4 to 7 for columns 0 to 3.
+    movq      mm1, [eax]
+    movq      mm7, mm1
+    punpcklbw mm1, [eax + edi]
+    punpckhbw mm7, [eax + edi]
+    lea       eax, [eax + 2 * edi]
+    movq      mm5, [eax]
+    punpcklbw mm5, [eax + edi]
+    movq      mm6, mm1
+    punpcklwd mm1, mm5
+    punpckhwd mm6, mm5
+    // Third round of bit swap.
+    // Write columns 0 to 3 to the destination pointer.
+    movq      mm5, mm0
+    punpckldq mm0, mm1
+    punpckhdq mm5, mm1
+    movq      [edx], mm0
+    movq      [edx + esi], mm5
+    lea       edx, [edx + 2 * esi]
+    movq      mm5, mm2
+    punpckldq mm2, mm6
+    punpckhdq mm5, mm6
+    movq      [edx], mm2
+    movq      [edx + esi], mm5
+    lea       edx, [edx + 2 * esi]
+    // Rows 4 to 7 for columns 4 to 7.
+    movq      mm1, [eax]
+    punpckhbw mm1, [eax + edi]
+    mov       eax, ebp
+    movq      mm6, mm7
+    punpcklwd mm7, mm1
+    punpckhwd mm6, mm1
+    // Write columns 4 to 7.
+    movq      mm5, mm4
+    punpckldq mm4, mm7
+    punpckhdq mm5, mm7
+    movq      [edx], mm4
+    movq      [edx + esi], mm5
+    lea       edx, [edx + 2 * esi]
+    movq      mm0, mm3
+    punpckldq mm3, mm6
+    punpckhdq mm0, mm6
+    movq      [edx], mm3
+    movq      [edx + esi], mm0
+    lea       edx, [edx + 2 * esi]
+    sub       ecx, 8
+    ja        convertloop
+
+    pop       ebp
+    pop       esi
+    pop       edi
+    ret
+  }
+}
+
+#elif (defined(__i386__) || defined(__x86_64__)) && \
+    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+#define HAS_TRANSPOSE_WX8_MMX
+static void TransposeWx8_MMX(const uint8* src, int src_stride,
+                             uint8* dst, int dst_stride, int width) {
+  asm volatile (
+  // First and second round of bit swap for rows 0 to 3.
+"1:                                            \n"
+  "movq       (%0),%%mm0                       \n"
+  "movq       %%mm0,%%mm4                      \n"
+  "punpcklbw  (%0,%3),%%mm0                    \n"
+  "punpckhbw  (%0,%3),%%mm4                    \n"
+  "lea        (%0,%3,2),%0                     \n"
+  "movq       (%0),%%mm1                       \n"
+  "movq       %%mm1,%%mm5                      \n"
+  "punpcklbw  (%0,%3),%%mm1                    \n"
+  "punpckhbw  (%0,%3),%%mm5                    \n"
+  "lea        (%0,%3,2),%0                     \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "punpcklwd  %%mm1,%%mm0                      \n"
+  "punpckhwd  %%mm1,%%mm2                      \n"
+  "movq       %%mm4,%%mm3                      \n"
+  "punpcklwd  %%mm5,%%mm4                      \n"
+  "punpckhwd  %%mm5,%%mm3                      \n"
+  // Rows 4 to 7 for columns 0 to 3.
+  "movq       (%0),%%mm1                       \n"
+  "movq       %%mm1,%%mm7                      \n"
+  "punpcklbw  (%0,%3),%%mm1                    \n"
+  "punpckhbw  (%0,%3),%%mm7                    \n"
+  "lea        (%0,%3,2),%0                     \n"
+  "movq       (%0),%%mm5                       \n"
+  "punpcklbw  (%0,%3),%%mm5                    \n"
+  "movq       %%mm1,%%mm6                      \n"
+  "punpcklwd  %%mm5,%%mm1                      \n"
+  "punpckhwd  %%mm5,%%mm6                      \n"
+  // Third round of bit swap.
+  // Write columns 0 to 3 to the destination pointer.
+  "movq       %%mm0,%%mm5                      \n"
+  "punpckldq  %%mm1,%%mm0                      \n"
+  "punpckhdq  %%mm1,%%mm5                      \n"
+  "movq       %%mm0,(%1)                       \n"
+  "movq       %%mm5,(%1,%4)                    \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "movq       %%mm2,%%mm5                      \n"
+  "punpckldq  %%mm6,%%mm2                      \n"
+  "punpckhdq  %%mm6,%%mm5                      \n"
+  "movq       %%mm2,(%1)                       \n"
+  "movq       %%mm5,(%1,%4)                    \n"
+  "lea        (%1,%4,2),%1                     \n"
+  // Rows 4 to 7 for columns 4 to 7.
+  "movq       (%0),%%mm1                       \n"
+  "punpckhbw  (%0,%3),%%mm1                    \n"
+  "neg        %3                               \n"
+  "lea        0x8(%0,%3,4),%0                  \n"
+  "lea        (%0,%3,2),%0                     \n"
+  "neg        %3                               \n"
+  "movq       %%mm7,%%mm6                      \n"
+  "punpcklwd  %%mm1,%%mm7                      \n"
+  "punpckhwd  %%mm1,%%mm6                      \n"
+  // Write columns 4 to 7.
+  "movq       %%mm4,%%mm5                      \n"
+  "punpckldq  %%mm7,%%mm4                      \n"
+  "punpckhdq  %%mm7,%%mm5                      \n"
+  "movq       %%mm4,(%1)                       \n"
+  "movq       %%mm5,(%1,%4)                    \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "movq       %%mm3,%%mm0                      \n"
+  "punpckldq  %%mm6,%%mm3                      \n"
+  "punpckhdq  %%mm6,%%mm0                      \n"
+  "movq       %%mm3,(%1)                       \n"
+  "movq       %%mm0,(%1,%4)                    \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),    // %0
+    "+r"(dst),    // %1
+    "+r"(width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(static_cast<intptr_t>(dst_stride))   // %4
+  : "memory", "cc"
+#if defined(__MMX__)
+    , "mm0", "mm1", "mm2", "mm3", "mm4", "mm5", "mm6", "mm7"
+#endif
+);
+}
+#endif
+
 static void TransposeWx8_C(const uint8* src, int src_stride,
                            uint8* dst, int dst_stride,
                            int w) {
@@ -774,10 +954,91 @@ static void TransposeWxH_C(const uint8* src, int src_stride,
       dst[i * dst_stride + j] = src[j * src_stride + i];
 }
 
+// Any width wrappers for pixels of BPP bytes.  The SIMD versions do a
+// multiple of MASK + 1 pixels and C does the rest.  Transposing puts the
+// rest in the last dst rows; reversing puts the last pixels of src first
+// in dst.
+#define TANY(NAMEANY, TRANSPOSE_SIMD, TRANSPOSE_C, BPP, MASK)                  \
+    static void NAMEANY(const uint8* src, int src_stride,                     \
+                        uint8* dst, int dst_stride, int width) {              \
+      int n = width & ~MASK;                                                   \
+      if (n > 0) {                                                             \
+        TRANSPOSE_SIMD(src, src_stride, dst, dst_stride, n);                   \
+      }                                                                        \
+      if (n < width) {                                                         \
+        TRANSPOSE_C(src + n * BPP, src_stride,                                 \
+                    dst + n * dst_stride, dst_stride, width - n);              \
+      }                                                                        \
+    }
+
+#define RANY(NAMEANY, REVERSE_SIMD, REVERSE_C, BPP, MASK)                      \
+    static void NAMEANY(const uint8* src, uint8* dst, int width) {            \
+      int n = width & ~MASK;                                                   \
+      if (n > 0) {                                                             \
+        REVERSE_SIMD(src + (width - n) * BPP, dst, n);                         \
+      }                                                                        \
+      if (n < width) {                                                         \
+        REVERSE_C(src, dst + n * BPP, width - n);                              \
+      }                                                                        \
+    }
+
+#if defined(HAS_TRANSPOSE_WX8_SSSE3)
+TANY(TransposeWx8_Any_SSSE3, TransposeWx8_SSSE3, TransposeWx8_C, 1, 7)
+#endif
+#if defined(HAS_TRANSPOSE_WX8_MMX)
+TANY(TransposeWx8_Any_MMX, TransposeWx8_MMX, TransposeWx8_C, 1, 7)
+#endif
+
+// Transposes a plane of 'bpp' byte pixels in tiles of tile_rows by
+// tile_cols pixels.  Walking strips across the whole width writes a pixel
+// column to every destination row, which on wide frames evicts each
+// destination cache line before the next strip fills the rest of it.
+// Within a tile the source and destination rows that are touched fit in
+// the L1 cache.  TransposeStrip transposes strip_rows source rows, and
+// TransposeWxH the rows left below the last whole strip.
+static void TransposeTiles(const uint8* src, int src_stride,
+                           uint8* dst, int dst_stride,
+                           int width, int height, int bpp,
+                           int strip_rows, int tile_rows, int tile_cols,
+                           rotate_wx8_func TransposeStrip,
+                           rotate_wxh_func TransposeWxH) {
+  const int strip_height = height - height % strip_rows;
+  int x, y, i;
+  for (y = 0; y < strip_height; y += tile_rows) {
+    const int rows = (strip_height - y < tile_rows) ?
+                     strip_height - y : tile_rows;
+    for (x = 0; x < width; x += tile_cols) {
+      const int cols = (width - x < tile_cols) ? width - x : tile_cols;
+      const uint8* tile_src = src + y * src_stride + x * bpp;
+      uint8* tile_dst = dst + x * dst_stride + y * bpp;
+      for (i = 0; i < rows; i += strip_rows) {
+        TransposeStrip(tile_src, src_stride, tile_dst, dst_stride, cols);
+        tile_src += strip_rows * src_stride;  // go down strip_rows rows
+        tile_dst += strip_rows * bpp;         // move over strip_rows columns
+      }
+    }
+  }
+  TransposeWxH(src + strip_height * src_stride, src_stride,
+               dst + strip_height * bpp, dst_stride,
+               width, height - strip_height);
+}
+
+// The plane is transposed in tiles of kTransposeTileRows by
+// kTransposeTileCols source pixels.
+// A destination larger than the non-temporal threshold is written with
+// streaming stores.  The transpose kernels write only 8 bytes to each
+// destination row, too few to fill a write combining buffer, so each tile
+// is transposed into a cached tile buffer and its rows are streamed out
+// whole.  A tile row is a full 64 byte cache line only when dst and
+// dst_stride are 64 byte aligned; partial lines make streaming stores
+// slower than cached ones, so other destinations are written in place.
+static const int kTransposeTileRows = 64;
+static const int kTransposeTileCols = 64;
+
 void TransposePlane(const uint8* src, int src_stride,
                     uint8* dst, int dst_stride,
                     int width, int height) {
-  int i = height;
+  int x, y, i;
   rotate_wx8_func TransposeWx8;
   rotate_wxh_func TransposeWxH;
 
@@ -797,11 +1058,14 @@ void TransposePlane(const uint8* src, int src_stride,
   } else
 #endif
 #if defined(HAS_TRANSPOSE_WX8_SSSE3)
-  if (TestCpuFlag(kCpuHasSSSE3) &&
-      (width % 8 == 0) &&
-      IS_ALIGNED(src, 8) && (src_stride % 8 == 0) &&
-      IS_ALIGNED(dst, 8) && (dst_stride % 8 == 0)) {
-    TransposeWx8 = TransposeWx8_SSSE3;
+  if (TestCpuFlag(kCpuHasSSSE3)) {
+    TransposeWx8 = TransposeWx8_Any_SSSE3;
+    TransposeWxH = TransposeWxH_C;
+  } else
+#endif
+#if defined(HAS_TRANSPOSE_WX8_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    TransposeWx8 = TransposeWx8_Any_MMX;
     TransposeWxH = TransposeWxH_C;
   } else
 #endif
@@ -810,16 +1074,50 @@ void TransposePlane(const uint8* src, int src_stride,
     TransposeWxH = TransposeWxH_C;
   }
 
-  // work across the source in 8x8 tiles
-  while (i >= 8) {
-    TransposeWx8(src, src_stride, dst, dst_stride, width);
+  CopyRowFunc CopyRow = GetCopyRow_NT(width * height, dst, dst_stride, 64);
 
-    src += 8 * src_stride;    // go down 8 rows
-    dst += 8;                 // move over 8 columns
-    i   -= 8;
+  // Whole tiles are streamed.  The rows left over write partial cache
+  // lines, and are transposed in place below.
+  int streamed_rows = 0;
+  if (CopyRow) {
+    uint8 tile_mem[kTransposeTileCols * kTransposeTileRows + 15];
+    uint8* tile = ALIGNP(tile_mem, 16);
+    streamed_rows = height - height % kTransposeTileRows;
+    for (y = 0; y < streamed_rows; y += kTransposeTileRows) {
+      for (x = 0; x < width; x += kTransposeTileCols) {
+        const int tile_cols = (width - x < kTransposeTileCols) ?
+                              width - x : kTransposeTileCols;
+        const uint8* tile_src = src + y * src_stride + x;
+        for (i = 0; i < kTransposeTileRows; i += 8) {
+          TransposeWx8(tile_src, src_stride, tile + i, kTransposeTileRows,
+                       tile_cols);
+          tile_src += 8 * src_stride;
+        }
+        uint8* tile_dst = dst + x * dst_stride + y;
+        for (i = 0; i < tile_cols; ++i) {
+          CopyRow(tile + i * kTransposeTileRows, tile_dst, kTransposeTileRows);
+          tile_dst += dst_stride;
+        }
+      }
+    }
+    SFENCE();
   }
 
-  TransposeWxH(src, src_stride, dst, dst_stride, width, i);
+  TransposeTiles(src + streamed_rows * src_stride, src_stride,
+                 dst + streamed_rows, dst_stride,
+                 width, height - streamed_rows, 1,
+                 8, kTransposeTileRows, kTransposeTileCols,
+                 TransposeWx8, TransposeWxH);
+#if defined(HAS_TRANSPOSE_WX8_MMX)
+  if (TransposeWx8 == TransposeWx8_Any_MMX) {
+    EMMS();
+  }
+#endif
+#if defined(HAS_COPYROW_NT_SSE)
+  if (CopyRow == CopyRow_NT_Any_SSE) {
+    EMMS();
+  }
+#endif
 }
 
 void RotatePlane90(const uint8* src, int src_stride,
@@ -846,65 +1144,6 @@ void RotatePlane270(const uint8* src, int src_stride,
   TransposePlane(src, src_stride, dst, dst_stride, width, height);
 }
 
-static void ReverseLine_C(const uint8* src, uint8* dst, int width) {
-  int i;
-  src += width - 1;
-  for (i = 0; i < width; ++i) {
-    dst[i] = src[0];
-    --src;
-  }
-}
-
-#if defined(WIN32) && !defined(COVERAGE_ENABLED)
-#define HAS_REVERSE_LINE_SSSE3
-__declspec(naked)
-static void ReverseLine_SSSE3(const uint8* src, uint8* dst, int width) {
-__asm {
-    mov       eax, [esp + 4]   // src
-    mov       edx, [esp + 8]   // dst
-    mov       ecx, [esp + 12]  // width
-    movdqa    xmm5, _kShuffleReverse
-    lea       eax, [eax + ecx - 16]
- convertloop :
-    movdqa    xmm0, [eax]
-    lea       eax, [eax - 16]
-    pshufb    xmm0, xmm5
-    movdqa    [edx], xmm0
-    lea       edx, [edx + 16]
-    sub       ecx, 16
-    ja        convertloop
-    ret
-  }
-}
-
-#elif (defined(__i386__) || defined(__x86_64__)) && \
-    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
-#define HAS_REVERSE_LINE_SSSE3
-static void ReverseLine_SSSE3(const uint8* src, uint8* dst, int width) {
-  intptr_t temp_width = static_cast<intptr_t>(width);
-  asm volatile (
-  "movdqa     (%3),%%xmm5                      \n"
-  "lea        -0x10(%0,%2,1),%0                \n"
-"1:                                            \n"
-  "movdqa     (%0),%%xmm0                      \n"
-  "lea        -0x10(%0),%0                     \n"
-  "pshufb     %%xmm5,%%xmm0                    \n"
-  "movdqa     %%xmm0,(%1)                      \n"
-  "lea        0x10(%1),%1                      \n"
-  "sub        $0x10,%2                         \n"
-  "ja         1b                               \n"
-  : "+r"(src),  // %0
-    "+r"(dst),  // %1
-    "+r"(temp_width)  // %2
-  : "r"(kShuffleReverse)  // %3
-  : "memory", "cc"
-#if defined(__SSE2__)
-    , "xmm0", "xmm5"
-#endif
-);
-}
-#endif
-
 void RotatePlane180(const uint8* src, int src_stride,
                     uint8* dst, int dst_stride,
                     int width, int height) {
@@ -916,25 +1155,41 @@ void RotatePlane180(const uint8* src, int src_stride,
     ReverseLine = ReverseLine_NEON;
   } else
 #endif
-#if defined(HAS_REVERSE_LINE_SSSE3)
-  if (TestCpuFlag(kCpuHasSSSE3) &&
-      (width % 16 == 0) &&
-      IS_ALIGNED(src, 16) && (src_stride % 16 == 0) &&
-      IS_ALIGNED(dst, 16) && (dst_stride % 16 == 0)) {
-    ReverseLine = ReverseLine_SSSE3;
+#if defined(HAS_REVERSELINE_SSSE3)
+  if (TestCpuFlag(kCpuHasSSSE3)) {
+    ReverseLine = ReverseLine_Any_SSSE3;
+  } else
+#endif
+#if defined(HAS_REVERSELINE_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2)) {
+    ReverseLine = ReverseLine_Any_SSE2;
+  } else
+#endif
+#if defined(HAS_REVERSELINE_SSE)
+  if (TestCpuFlag(kCpuHasSSE)) {
+    ReverseLine = ReverseLine_Any_SSE;
   } else
 #endif
   {
     ReverseLine = ReverseLine_C;
   }
-  // Rotate by 180 is a mirror and vertical flip
-  src += src_stride * (height - 1);
+  if (src == dst && src_stride == dst_stride) {
+    ReverseRowsInPlace(dst, dst_stride, width, height, 1, true, ReverseLine);
+  } else {
+    // Rotate by 180 is a mirror and vertical flip
+    src += src_stride * (height - 1);
 
-  for (i = 0; i < height; ++i) {
-    ReverseLine(src, dst, width);
-    src -= src_stride;
-    dst += dst_stride;
+    for (i = 0; i < height; ++i) {
+      ReverseLine(src, dst, width);
+      src -= src_stride;
+      dst += dst_stride;
+    }
   }
+#if defined(HAS_REVERSELINE_SSE)
+  if (ReverseLine == ReverseLine_Any_SSE) {
+    EMMS();
+  }
+#endif
 }
 
 static void TransposeUVWx8_C(const uint8* src, int src_stride,
@@ -1299,4 +1554,1339 @@ int NV12ToI420Rotate(const uint8* src_y, int src_stride_y,
   return -1;
 }
 
+
+// ARGB rotation.  Pixels are transposed in strips of 4 rows, with 4x4
+// blocks of pixels for SSE2 and 2x4 blocks for MMX.  Loads and stores are
+// unaligned.
+#if defined(WIN32) && !defined(COVERAGE_ENABLED)
+#define HAS_TRANSPOSE_ARGBWX4_SSE2
+__declspec(naked)
+static void TransposeARGBWx4_SSE2(const uint8* src, int src_stride,
+                                  uint8* dst, int dst_stride, int width) {
+__asm {
+    push      edi
+    push      esi
+    push      ebp
+    mov       eax, [esp + 12 + 4]   // src
+    mov       edi, [esp + 12 + 8]   // src_stride
+    mov       edx, [esp + 12 + 12]  // dst
+    mov       esi, [esp + 12 + 16]  // dst_stride
+    mov       ecx, [esp + 12 + 20]  // width
+ convertloop :
+    lea       ebp, [eax + 16]
+    movdqu    xmm0, [eax]
+    movdqu    xmm1, [eax + edi]
+    lea       eax, [eax + 2 * edi]
+    movdqu    xmm2, [eax]
+    movdqu    xmm3, [eax + edi]
+    mov       eax, ebp
+    movdqa    xmm4, xmm0
+    punpckldq xmm0, xmm1
+    punpckhdq xmm4, xmm1
+    movdqa    xmm5, xmm2
+    punpckldq xmm2, xmm3
+    punpckhdq xmm5, xmm3
+    movdqa    xmm1, xmm0
+    punpcklqdq xmm0, xmm2
+    punpckhqdq xmm1, xmm2
+    movdqa    xmm3, xmm4
+    punpcklqdq xmm4, xmm5
+    punpckhqdq xmm3, xmm5
+    movdqu    [edx], xmm0
+    movdqu    [edx + esi], xmm1
+    lea       edx, [edx + 2 * esi]
+    movdqu    [edx], xmm4
+    movdqu    [edx + esi], xmm3
+    lea       edx, [edx + 2 * esi]
+    sub       ecx, 4
+    ja        convertloop
+
+    pop       ebp
+    pop       esi
+    pop       edi
+    ret
+  }
+}
+
+#define HAS_TRANSPOSE_ARGBWX4_MMX
+__declspec(naked)
+static void TransposeARGBWx4_MMX(const uint8* src, int src_stride,
+                                 uint8* dst, int dst_stride, int width) {
+__asm {
+    push      edi
+    push      esi
+    push      ebp
+    mov       eax, [esp + 12 + 4]   // src
+    mov       edi, [esp + 12 + 8]   // src_stride
+    mov       edx, [esp + 12 + 12]  // dst
+    mov       esi, [esp + 12 + 16]  // dst_stride
+    mov       ecx, [esp + 12 + 20]  // width
+ convertloop :
+    lea       ebp, [eax + 8]
+    movq      mm0, [eax]
+    movq      mm1, [eax + edi]
+    lea       eax, [eax + 2 * edi]
+    movq      mm2, [eax]
+    movq      mm3, [eax + edi]
+    mov       eax, ebp
+    movq      mm4, mm0
+    punpckldq mm0, mm1
+    punpckhdq mm4, mm1
+    movq      mm5, mm2
+    punpckldq mm2, mm3
+    punpckhdq mm5, mm3
+    movq      [edx], mm0
+    movq      [edx + 8], mm2
+    movq      [edx + esi], mm4
+    movq      [edx + esi + 8], mm5
+    lea       edx, [edx + 2 * esi]
+    sub       ecx, 2
+    ja        convertloop
+
+    pop       ebp
+    pop       esi
+    pop       edi
+    ret
+  }
+}
+
+#define HAS_ARGBREVERSEROW_SSE2
+__declspec(naked)
+static void ARGBReverseRow_SSE2(const uint8* src, uint8* dst, int width) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // width
+    lea       eax, [eax + ecx * 4 - 16]
+ convertloop :
+    movdqu    xmm0, [eax]
+    lea       eax, [eax - 16]
+    pshufd    xmm0, xmm0, 0x1b
+    movdqu    [edx], xmm0
+    lea       edx, [edx + 16]
+    sub       ecx, 4
+    ja        convertloop
+    ret
+  }
+}
+
+#define HAS_ARGBREVERSEROW_MMX
+__declspec(naked)
+static void ARGBReverseRow_MMX(const uint8* src, uint8* dst, int width) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // width
+    lea       eax, [eax + ecx * 4 - 8]
+ convertloop :
+    movq      mm0, [eax]
+    lea       eax, [eax - 8]
+    movq      mm1, mm0
+    psrlq     mm0, 32
+    psllq     mm1, 32
+    por       mm0, mm1
+    movq      [edx], mm0
+    lea       edx, [edx + 8]
+    sub       ecx, 2
+    ja        convertloop
+    ret
+  }
+}
+
+#elif (defined(__i386__) || defined(__x86_64__)) && \
+    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+#define HAS_TRANSPOSE_ARGBWX4_SSE2
+static void TransposeARGBWx4_SSE2(const uint8* src, int src_stride,
+                                  uint8* dst, int dst_stride, int width) {
+  asm volatile (
+"1:                                            \n"
+  "movdqu     (%0),%%xmm0                      \n"
+  "movdqu     (%0,%3),%%xmm1                   \n"
+  "lea        (%0,%3,2),%0                     \n"
+  "movdqu     (%0),%%xmm2                      \n"
+  "movdqu     (%0,%3),%%xmm3                   \n"
+  "neg        %3                               \n"
+  "lea        0x10(%0,%3,2),%0                 \n"
+  "neg        %3                               \n"
+  "movdqa     %%xmm0,%%xmm4                    \n"
+  "punpckldq  %%xmm1,%%xmm0                    \n"
+  "punpckhdq  %%xmm1,%%xmm4                    \n"
+  "movdqa     %%xmm2,%%xmm5                    \n"
+  "punpckldq  %%xmm3,%%xmm2                    \n"
+  "punpckhdq  %%xmm3,%%xmm5                    \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "punpcklqdq %%xmm2,%%xmm0                    \n"
+  "punpckhqdq %%xmm2,%%xmm1                    \n"
+  "movdqa     %%xmm4,%%xmm3                    \n"
+  "punpcklqdq %%xmm5,%%xmm4                    \n"
+  "punpckhqdq %%xmm5,%%xmm3                    \n"
+  "movdqu     %%xmm0,(%1)                      \n"
+  "movdqu     %%xmm1,(%1,%4)                   \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "movdqu     %%xmm4,(%1)                      \n"
+  "movdqu     %%xmm3,(%1,%4)                   \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),    // %0
+    "+r"(dst),    // %1
+    "+r"(width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(static_cast<intptr_t>(dst_stride))   // %4
+  : "memory", "cc"
+#if defined(__SSE2__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5"
+#endif
+);
+}
+
+#define HAS_TRANSPOSE_ARGBWX4_MMX
+static void TransposeARGBWx4_MMX(const uint8* src, int src_stride,
+                                 uint8* dst, int dst_stride, int width) {
+  asm volatile (
+"1:                                            \n"
+  "movq       (%0),%%mm0                       \n"
+  "movq       (%0,%3),%%mm1                    \n"
+  "lea        (%0,%3,2),%0                     \n"
+  "movq       (%0),%%mm2                       \n"
+  "movq       (%0,%3),%%mm3                    \n"
+  "neg        %3                               \n"
+  "lea        0x8(%0,%3,2),%0                  \n"
+  "neg        %3                               \n"
+  "movq       %%mm0,%%mm4                      \n"
+  "punpckldq  %%mm1,%%mm0                      \n"
+  "punpckhdq  %%mm1,%%mm4                      \n"
+  "movq       %%mm2,%%mm5                      \n"
+  "punpckldq  %%mm3,%%mm2                      \n"
+  "punpckhdq  %%mm3,%%mm5                      \n"
+  "movq       %%mm0,(%1)                       \n"
+  "movq       %%mm2,0x8(%1)                    \n"
+  "movq       %%mm4,(%1,%4)                    \n"
+  "movq       %%mm5,0x8(%1,%4)                 \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "sub        $0x2,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),    // %0
+    "+r"(dst),    // %1
+    "+r"(width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(static_cast<intptr_t>(dst_stride))   // %4
+  : "memory", "cc"
+#if defined(__MMX__)
+    , "mm0", "mm1", "mm2", "mm3", "mm4", "mm5"
+#endif
+);
+}
+
+#define HAS_ARGBREVERSEROW_SSE2
+static void ARGBReverseRow_SSE2(const uint8* src, uint8* dst, int width) {
+  intptr_t temp_width = static_cast<intptr_t>(width);
+  asm volatile (
+  "lea        -0x10(%0,%2,4),%0                \n"
+"1:                                            \n"
+  "movdqu     (%0),%%xmm0                      \n"
+  "lea        -0x10(%0),%0                     \n"
+  "pshufd     $0x1b,%%xmm0,%%xmm0              \n"
+  "movdqu     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),  // %0
+    "+r"(dst),  // %1
+    "+r"(temp_width)  // %2
+  :
+  : "memory", "cc"
+#if defined(__SSE2__)
+    , "xmm0"
+#endif
+);
+}
+
+#define HAS_ARGBREVERSEROW_MMX
+static void ARGBReverseRow_MMX(const uint8* src, uint8* dst, int width) {
+  intptr_t temp_width = static_cast<intptr_t>(width);
+  asm volatile (
+  "lea        -0x8(%0,%2,4),%0                 \n"
+"1:                                            \n"
+  "movq       (%0),%%mm0                       \n"
+  "lea        -0x8(%0),%0                      \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "psrlq      $0x20,%%mm0                      \n"
+  "psllq      $0x20,%%mm1                      \n"
+  "por        %%mm1,%%mm0                      \n"
+  "movq       %%mm0,(%1)                       \n"
+  "lea        0x8(%1),%1                       \n"
+  "sub        $0x2,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),  // %0
+    "+r"(dst),  // %1
+    "+r"(temp_width)  // %2
+  :
+  : "memory", "cc"
+#if defined(__MMX__)
+    , "mm0", "mm1"
+#endif
+);
+}
+#endif
+
+static void TransposeARGBWx4_C(const uint8* src, int src_stride,
+                               uint8* dst, int dst_stride,
+                               int w) {
+  int i;
+  for (i = 0; i < w; ++i) {
+    uint32* d = reinterpret_cast<uint32*>(dst);
+    d[0] = *reinterpret_cast<const uint32*>(src + 0 * src_stride);
+    d[1] = *reinterpret_cast<const uint32*>(src + 1 * src_stride);
+    d[2] = *reinterpret_cast<const uint32*>(src + 2 * src_stride);
+    d[3] = *reinterpret_cast<const uint32*>(src + 3 * src_stride);
+    src += 4;
+    dst += dst_stride;
+  }
+}
+
+static void TransposeARGBWxH_C(const uint8* src, int src_stride,
+                               uint8* dst, int dst_stride,
+                               int width, int height) {
+  int i, j;
+  for (i = 0; i < width; ++i)
+    for (j = 0; j < height; ++j)
+      *reinterpret_cast<uint32*>(dst + i * dst_stride + j * 4) =
+          *reinterpret_cast<const uint32*>(src + j * src_stride + i * 4);
+}
+
+static void ARGBReverseRow_C(const uint8* src, uint8* dst, int width) {
+  const uint32* src32 = reinterpret_cast<const uint32*>(src);
+  uint32* dst32 = reinterpret_cast<uint32*>(dst);
+  int i;
+  src32 += width - 1;
+  for (i = 0; i < width; ++i) {
+    dst32[i] = src32[0];
+    --src32;
+  }
+}
+
+#if defined(HAS_TRANSPOSE_ARGBWX4_SSE2)
+TANY(TransposeARGBWx4_Any_SSE2, TransposeARGBWx4_SSE2, TransposeARGBWx4_C,
+     4, 3)
+#endif
+#if defined(HAS_TRANSPOSE_ARGBWX4_MMX)
+TANY(TransposeARGBWx4_Any_MMX, TransposeARGBWx4_MMX, TransposeARGBWx4_C,
+     4, 1)
+#endif
+#if defined(HAS_ARGBREVERSEROW_SSE2)
+RANY(ARGBReverseRow_Any_SSE2, ARGBReverseRow_SSE2, ARGBReverseRow_C, 4, 3)
+#endif
+#if defined(HAS_ARGBREVERSEROW_MMX)
+RANY(ARGBReverseRow_Any_MMX, ARGBReverseRow_MMX, ARGBReverseRow_C, 4, 1)
+#endif
+
+// ARGB tiles are 32x32 pixels, the same number of bytes per row and fewer
+// rows than the 64x64 tiles of TransposePlane.
+static const int kTransposeARGBTileRows = 32;
+static const int kTransposeARGBTileCols = 32;
+
+static void TransposeARGB(const uint8* src, int src_stride,
+                          uint8* dst, int dst_stride,
+                          int width, int height) {
+  rotate_wx8_func TransposeWx4;
+
+#if defined(HAS_TRANSPOSE_ARGBWX4_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2)) {
+    TransposeWx4 = TransposeARGBWx4_Any_SSE2;
+  } else
+#endif
+#if defined(HAS_TRANSPOSE_ARGBWX4_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    TransposeWx4 = TransposeARGBWx4_Any_MMX;
+  } else
+#endif
+  {
+    TransposeWx4 = TransposeARGBWx4_C;
+  }
+
+  TransposeTiles(src, src_stride, dst, dst_stride, width, height, 4,
+                 4, kTransposeARGBTileRows, kTransposeARGBTileCols,
+                 TransposeWx4, TransposeARGBWxH_C);
+#if defined(HAS_TRANSPOSE_ARGBWX4_MMX)
+  if (TransposeWx4 == TransposeARGBWx4_Any_MMX) {
+    EMMS();
+  }
+#endif
+}
+
+static void ARGBRotate180(const uint8* src, int src_stride,
+                          uint8* dst, int dst_stride,
+                          int width, int height) {
+  int i;
+  reverse_func ARGBReverseRow;
+
+#if defined(HAS_ARGBREVERSEROW_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2)) {
+    ARGBReverseRow = ARGBReverseRow_Any_SSE2;
+  } else
+#endif
+#if defined(HAS_ARGBREVERSEROW_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    ARGBReverseRow = ARGBReverseRow_Any_MMX;
+  } else
+#endif
+  {
+    ARGBReverseRow = ARGBReverseRow_C;
+  }
+  if (src == dst && src_stride == dst_stride) {
+    ReverseRowsInPlace(dst, dst_stride, width, height, 4, true, ARGBReverseRow);
+  } else {
+    // Rotate by 180 is a mirror and vertical flip
+    src += src_stride * (height - 1);
+
+    for (i = 0; i < height; ++i) {
+      ARGBReverseRow(src, dst, width);
+      src -= src_stride;
+      dst += dst_stride;
+    }
+  }
+#if defined(HAS_ARGBREVERSEROW_MMX)
+  if (ARGBReverseRow == ARGBReverseRow_Any_MMX) {
+    EMMS();
+  }
+#endif
+}
+
+int ARGBRotate(const uint8* src_argb, int src_stride_argb,
+               uint8* dst_argb, int dst_stride_argb,
+               int width, int height,
+               RotationMode mode) {
+  int i;
+  if (!src_argb || !dst_argb || width <= 0 || height == 0) {
+    return -1;
+  }
+  // Negative height means invert the image.
+  if (height < 0) {
+    height = -height;
+    src_argb = src_argb + (height - 1) * src_stride_argb;
+    src_stride_argb = -src_stride_argb;
+  }
+
+  switch (mode) {
+    case kRotate0:
+      // copy frame
+      for (i = 0; i < height; ++i) {
+        memcpy(dst_argb, src_argb, width * 4);
+        src_argb += src_stride_argb;
+        dst_argb += dst_stride_argb;
+      }
+      return 0;
+    case kRotate90:
+      // Rotate by 90 is a transpose with the source read
+      // from bottom to top.
+      TransposeARGB(src_argb + src_stride_argb * (height - 1),
+                    -src_stride_argb, dst_argb, dst_stride_argb,
+                    width, height);
+      return 0;
+    case kRotate270:
+      // Rotate by 270 is a transpose with the destination written
+      // from bottom to top.
+      TransposeARGB(src_argb, src_stride_argb,
+                    dst_argb + dst_stride_argb * (width - 1),
+                    -dst_stride_argb, width, height);
+      return 0;
+    case kRotate180:
+      ARGBRotate180(src_argb, src_stride_argb,
+                    dst_argb, dst_stride_argb,
+                    width, height);
+      return 0;
+    default:
+      break;
+  }
+  return -1;
+}
+
+// NV12 UV plane rotation.  A U and V pair is handled as one 16 bit pixel,
+// so the plane is rotated without deinterleaving.  Pixels are transposed
+// in strips of 4 rows, with 8x4 blocks of pixels for SSE2 and 4x4 blocks
+// for MMX.  Loads and stores are unaligned.
+#if defined(WIN32) && !defined(COVERAGE_ENABLED)
+#define HAS_TRANSPOSEWX4_16_SSE2
+__declspec(naked)
+static void TransposeWx4_16_SSE2(const uint8* src, int src_stride,
+                                 uint8* dst, int dst_stride, int width) {
+__asm {
+    push      edi
+    push      esi
+    push      ebp
+    mov       eax, [esp + 12 + 4]   // src
+    mov       edi, [esp + 12 + 8]   // src_stride
+    mov       edx, [esp + 12 + 12]  // dst
+    mov       esi, [esp + 12 + 16]  // dst_stride
+    mov       ecx, [esp + 12 + 20]  // width
+ convertloop :
+    lea       ebp, [eax + 16]
+    movdqu    xmm0, [eax]
+    movdqu    xmm1, [eax + edi]
+    lea       eax, [eax + 2 * edi]
+    movdqu    xmm2, [eax]
+    movdqu    xmm3, [eax + edi]
+    mov       eax, ebp
+    movdqa    xmm4, xmm0
+    punpcklwd xmm0, xmm1
+    punpckhwd xmm4, xmm1
+    movdqa    xmm5, xmm2
+    punpcklwd xmm2, xmm3
+    punpckhwd xmm5, xmm3
+    movdqa    xmm1, xmm0
+    punpckldq xmm0, xmm2
+    punpckhdq xmm1, xmm2
+    movdqa    xmm3, xmm4
+    punpckldq xmm4, xmm5
+    punpckhdq xmm3, xmm5
+    movlpd    qword ptr [edx], xmm0
+    movhpd    qword ptr [edx + esi], xmm0
+    lea       edx, [edx + 2 * esi]
+    movlpd    qword ptr [edx], xmm1
+    movhpd    qword ptr [edx + esi], xmm1
+    lea       edx, [edx + 2 * esi]
+    movlpd    qword ptr [edx], xmm4
+    movhpd    qword ptr [edx + esi], xmm4
+    lea       edx, [edx + 2 * esi]
+    movlpd    qword ptr [edx], xmm3
+    movhpd    qword ptr [edx + esi], xmm3
+    lea       edx, [edx + 2 * esi]
+    sub       ecx, 8
+    ja        convertloop
+
+    pop       ebp
+    pop       esi
+    pop       edi
+    ret
+  }
+}
+
+#define HAS_TRANSPOSEWX4_16_MMX
+__declspec(naked)
+static void TransposeWx4_16_MMX(const uint8* src, int src_stride,
+                                uint8* dst, int dst_stride, int width) {
+__asm {
+    push      edi
+    push      esi
+    push      ebp
+    mov       eax, [esp + 12 + 4]   // src
+    mov       edi, [esp + 12 + 8]   // src_stride
+    mov       edx, [esp + 12 + 12]  // dst
+    mov       esi, [esp + 12 + 16]  // dst_stride
+    mov       ecx, [esp + 12 + 20]  // width
+ convertloop :
+    lea       ebp, [eax + 8]
+    movq      mm0, [eax]
+    movq      mm1, [eax + edi]
+    lea       eax, [eax + 2 * edi]
+    movq      mm2, [eax]
+    movq      mm3, [eax + edi]
+    mov       eax, ebp
+    movq      mm4, mm0
+    punpcklwd mm0, mm1
+    punpckhwd mm4, mm1
+    movq      mm5, mm2
+    punpcklwd mm2, mm3
+    punpckhwd mm5, mm3
+    movq      mm1, mm0
+    punpckldq mm0, mm2
+    punpckhdq mm1, mm2
+    movq      mm3, mm4
+    punpckldq mm4, mm5
+    punpckhdq mm3, mm5
+    movq      [edx], mm0
+    movq      [edx + esi], mm1
+    lea       edx, [edx + 2 * esi]
+    movq      [edx], mm4
+    movq      [edx + esi], mm3
+    lea       edx, [edx + 2 * esi]
+    sub       ecx, 4
+    ja        convertloop
+
+    pop       ebp
+    pop       esi
+    pop       edi
+    ret
+  }
+}
+
+#define HAS_REVERSEROW_16_SSE2
+__declspec(naked)
+static void ReverseRow_16_SSE2(const uint8* src, uint8* dst, int width) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // width
+    lea       eax, [eax + ecx * 2 - 16]
+ convertloop :
+    movdqu    xmm0, [eax]
+    lea       eax, [eax - 16]
+    pshuflw   xmm0, xmm0, 0x1b
+    pshufhw   xmm0, xmm0, 0x1b
+    pshufd    xmm0, xmm0, 0x4e
+    movdqu    [edx], xmm0
+    lea       edx, [edx + 16]
+    sub       ecx, 8
+    ja        convertloop
+    ret
+  }
+}
+
+#define HAS_REVERSEROW_16_MMX
+__declspec(naked)
+static void ReverseRow_16_MMX(const uint8* src, uint8* dst, int width) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // width
+    lea       eax, [eax + ecx * 2 - 8]
+ convertloop :
+    movq      mm0, [eax]
+    lea       eax, [eax - 8]
+    movq      mm1, mm0
+    psrlq     mm0, 32
+    psllq     mm1, 32
+    por       mm0, mm1
+    movq      mm1, mm0
+    psrld     mm0, 16
+    pslld     mm1, 16
+    por       mm0, mm1
+    movq      [edx], mm0
+    lea       edx, [edx + 8]
+    sub       ecx, 4
+    ja        convertloop
+    ret
+  }
+}
+
+#elif (defined(__i386__) || defined(__x86_64__)) && \
+    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+#define HAS_TRANSPOSEWX4_16_SSE2
+static void TransposeWx4_16_SSE2(const uint8* src, int src_stride,
+                                 uint8* dst, int dst_stride, int width) {
+  asm volatile (
+"1:                                            \n"
+  "movdqu     (%0),%%xmm0                      \n"
+  "movdqu     (%0,%3),%%xmm1                   \n"
+  "lea        (%0,%3,2),%0                     \n"
+  "movdqu     (%0),%%xmm2                      \n"
+  "movdqu     (%0,%3),%%xmm3                   \n"
+  "neg        %3                               \n"
+  "lea        0x10(%0,%3,2),%0                 \n"
+  "neg        %3                               \n"
+  "movdqa     %%xmm0,%%xmm4                    \n"
+  "punpcklwd  %%xmm1,%%xmm0                    \n"
+  "punpckhwd  %%xmm1,%%xmm4                    \n"
+  "movdqa     %%xmm2,%%xmm5                    \n"
+  "punpcklwd  %%xmm3,%%xmm2                    \n"
+  "punpckhwd  %%xmm3,%%xmm5                    \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "punpckldq  %%xmm2,%%xmm0                    \n"
+  "punpckhdq  %%xmm2,%%xmm1                    \n"
+  "movdqa     %%xmm4,%%xmm3                    \n"
+  "punpckldq  %%xmm5,%%xmm4                    \n"
+  "punpckhdq  %%xmm5,%%xmm3                    \n"
+  "movlpd     %%xmm0,(%1)                      \n"
+  "movhpd     %%xmm0,(%1,%4)                   \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "movlpd     %%xmm1,(%1)                      \n"
+  "movhpd     %%xmm1,(%1,%4)                   \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "movlpd     %%xmm4,(%1)                      \n"
+  "movhpd     %%xmm4,(%1,%4)                   \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "movlpd     %%xmm3,(%1)                      \n"
+  "movhpd     %%xmm3,(%1,%4)                   \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),    // %0
+    "+r"(dst),    // %1
+    "+r"(width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(static_cast<intptr_t>(dst_stride))   // %4
+  : "memory", "cc"
+#if defined(__SSE2__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5"
+#endif
+);
+}
+
+#define HAS_TRANSPOSEWX4_16_MMX
+static void TransposeWx4_16_MMX(const uint8* src, int src_stride,
+                                uint8* dst, int dst_stride, int width) {
+  asm volatile (
+"1:                                            \n"
+  "movq       (%0),%%mm0                       \n"
+  "movq       (%0,%3),%%mm1                    \n"
+  "lea        (%0,%3,2),%0                     \n"
+  "movq       (%0),%%mm2                       \n"
+  "movq       (%0,%3),%%mm3                    \n"
+  "neg        %3                               \n"
+  "lea        0x8(%0,%3,2),%0                  \n"
+  "neg        %3                               \n"
+  "movq       %%mm0,%%mm4                      \n"
+  "punpcklwd  %%mm1,%%mm0                      \n"
+  "punpckhwd  %%mm1,%%mm4                      \n"
+  "movq       %%mm2,%%mm5                      \n"
+  "punpcklwd  %%mm3,%%mm2                      \n"
+  "punpckhwd  %%mm3,%%mm5                      \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "punpckldq  %%mm2,%%mm0                      \n"
+  "punpckhdq  %%mm2,%%mm1                      \n"
+  "movq       %%mm4,%%mm3                      \n"
+  "punpckldq  %%mm5,%%mm4                      \n"
+  "punpckhdq  %%mm5,%%mm3                      \n"
+  "movq       %%mm0,(%1)                       \n"
+  "movq       %%mm1,(%1,%4)                    \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "movq       %%mm4,(%1)                       \n"
+  "movq       %%mm3,(%1,%4)                    \n"
+  "lea        (%1,%4,2),%1                     \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),    // %0
+    "+r"(dst),    // %1
+    "+r"(width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(static_cast<intptr_t>(dst_stride))   // %4
+  : "memory", "cc"
+#if defined(__MMX__)
+    , "mm0", "mm1", "mm2", "mm3", "mm4", "mm5"
+#endif
+);
+}
+
+#define HAS_REVERSEROW_16_SSE2
+static void ReverseRow_16_SSE2(const uint8* src, uint8* dst, int width) {
+  intptr_t temp_width = static_cast<intptr_t>(width);
+  asm volatile (
+  "lea        -0x10(%0,%2,2),%0                \n"
+"1:                                            \n"
+  "movdqu     (%0),%%xmm0                      \n"
+  "lea        -0x10(%0),%0                     \n"
+  "pshuflw    $0x1b,%%xmm0,%%xmm0              \n"
+  "pshufhw    $0x1b,%%xmm0,%%xmm0              \n"
+  "pshufd     $0x4e,%%xmm0,%%xmm0              \n"
+  "movdqu     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),  // %0
+    "+r"(dst),  // %1
+    "+r"(temp_width)  // %2
+  :
+  : "memory", "cc"
+#if defined(__SSE2__)
+    , "xmm0"
+#endif
+);
+}
+
+#define HAS_REVERSEROW_16_MMX
+static void ReverseRow_16_MMX(const uint8* src, uint8* dst, int width) {
+  intptr_t temp_width = static_cast<intptr_t>(width);
+  asm volatile (
+  "lea        -0x8(%0,%2,2),%0                 \n"
+"1:                                            \n"
+  "movq       (%0),%%mm0                       \n"
+  "lea        -0x8(%0),%0                      \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "psrlq      $0x20,%%mm0                      \n"
+  "psllq      $0x20,%%mm1                      \n"
+  "por        %%mm1,%%mm0                      \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "psrld      $0x10,%%mm0                      \n"
+  "pslld      $0x10,%%mm1                      \n"
+  "por        %%mm1,%%mm0                      \n"
+  "movq       %%mm0,(%1)                       \n"
+  "lea        0x8(%1),%1                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),  // %0
+    "+r"(dst),  // %1
+    "+r"(temp_width)  // %2
+  :
+  : "memory", "cc"
+#if defined(__MMX__)
+    , "mm0", "mm1"
+#endif
+);
+}
+#endif
+
+static void TransposeWx4_16_C(const uint8* src, int src_stride,
+                              uint8* dst, int dst_stride,
+                              int w) {
+  int i;
+  for (i = 0; i < w; ++i) {
+    uint16* d = reinterpret_cast<uint16*>(dst);
+    d[0] = *reinterpret_cast<const uint16*>(src + 0 * src_stride);
+    d[1] = *reinterpret_cast<const uint16*>(src + 1 * src_stride);
+    d[2] = *reinterpret_cast<const uint16*>(src + 2 * src_stride);
+    d[3] = *reinterpret_cast<const uint16*>(src + 3 * src_stride);
+    src += 2;
+    dst += dst_stride;
+  }
+}
+
+static void TransposeWxH_16_C(const uint8* src, int src_stride,
+                              uint8* dst, int dst_stride,
+                              int width, int height) {
+  int i, j;
+  for (i = 0; i < width; ++i)
+    for (j = 0; j < height; ++j)
+      *reinterpret_cast<uint16*>(dst + i * dst_stride + j * 2) =
+          *reinterpret_cast<const uint16*>(src + j * src_stride + i * 2);
+}
+
+static void ReverseRow_16_C(const uint8* src, uint8* dst, int width) {
+  const uint16* src16 = reinterpret_cast<const uint16*>(src);
+  uint16* dst16 = reinterpret_cast<uint16*>(dst);
+  int i;
+  src16 += width - 1;
+  for (i = 0; i < width; ++i) {
+    dst16[i] = src16[0];
+    --src16;
+  }
+}
+
+#if defined(HAS_TRANSPOSEWX4_16_SSE2)
+TANY(TransposeWx4_16_Any_SSE2, TransposeWx4_16_SSE2, TransposeWx4_16_C,
+     2, 7)
+#endif
+#if defined(HAS_TRANSPOSEWX4_16_MMX)
+TANY(TransposeWx4_16_Any_MMX, TransposeWx4_16_MMX, TransposeWx4_16_C,
+     2, 3)
+#endif
+#if defined(HAS_REVERSEROW_16_SSE2)
+RANY(ReverseRow_16_Any_SSE2, ReverseRow_16_SSE2, ReverseRow_16_C, 2, 7)
+#endif
+#if defined(HAS_REVERSEROW_16_MMX)
+RANY(ReverseRow_16_Any_MMX, ReverseRow_16_MMX, ReverseRow_16_C, 2, 3)
+#endif
+#undef TANY
+#undef RANY
+
+// Tiles of 16 bit pixels are 32 rows by 64 pixels, 128 bytes of each row
+// as for ARGB.
+static const int kTranspose16TileRows = 32;
+static const int kTranspose16TileCols = 64;
+
+static void Transpose_16(const uint8* src, int src_stride,
+                         uint8* dst, int dst_stride,
+                         int width, int height) {
+  rotate_wx8_func TransposeWx4;
+
+#if defined(HAS_TRANSPOSEWX4_16_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2)) {
+    TransposeWx4 = TransposeWx4_16_Any_SSE2;
+  } else
+#endif
+#if defined(HAS_TRANSPOSEWX4_16_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    TransposeWx4 = TransposeWx4_16_Any_MMX;
+  } else
+#endif
+  {
+    TransposeWx4 = TransposeWx4_16_C;
+  }
+
+  TransposeTiles(src, src_stride, dst, dst_stride, width, height, 2,
+                 4, kTranspose16TileRows, kTranspose16TileCols,
+                 TransposeWx4, TransposeWxH_16_C);
+#if defined(HAS_TRANSPOSEWX4_16_MMX)
+  if (TransposeWx4 == TransposeWx4_16_Any_MMX) {
+    EMMS();
+  }
+#endif
+}
+
+static void Rotate180_16(const uint8* src, int src_stride,
+                         uint8* dst, int dst_stride,
+                         int width, int height) {
+  int i;
+  reverse_func ReverseRow;
+
+#if defined(HAS_REVERSEROW_16_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2)) {
+    ReverseRow = ReverseRow_16_Any_SSE2;
+  } else
+#endif
+#if defined(HAS_REVERSEROW_16_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    ReverseRow = ReverseRow_16_Any_MMX;
+  } else
+#endif
+  {
+    ReverseRow = ReverseRow_16_C;
+  }
+  if (src == dst && src_stride == dst_stride) {
+    ReverseRowsInPlace(dst, dst_stride, width, height, 2, true, ReverseRow);
+  } else {
+    // Rotate by 180 is a mirror and vertical flip
+    src += src_stride * (height - 1);
+
+    for (i = 0; i < height; ++i) {
+      ReverseRow(src, dst, width);
+      src -= src_stride;
+      dst += dst_stride;
+    }
+  }
+#if defined(HAS_REVERSEROW_16_MMX)
+  if (ReverseRow == ReverseRow_16_Any_MMX) {
+    EMMS();
+  }
+#endif
+}
+
+int NV12Rotate(const uint8* src_y, int src_stride_y,
+               const uint8* src_uv, int src_stride_uv,
+               uint8* dst_y, int dst_stride_y,
+               uint8* dst_uv, int dst_stride_uv,
+               int width, int height,
+               RotationMode mode) {
+  int i;
+  if (!src_y || !src_uv || !dst_y || !dst_uv || width <= 0 || height == 0) {
+    return -1;
+  }
+  int halfwidth = (width + 1) >> 1;
+  int halfheight = (height + 1) >> 1;
+
+  // Negative height means invert the image.
+  if (height < 0) {
+    height = -height;
+    halfheight = (height + 1) >> 1;
+    src_y = src_y + (height - 1) * src_stride_y;
+    src_uv = src_uv + (halfheight - 1) * src_stride_uv;
+    src_stride_y = -src_stride_y;
+    src_stride_uv = -src_stride_uv;
+  }
+
+  switch (mode) {
+    case kRotate0:
+      // copy frame
+      for (i = 0; i < height; ++i) {
+        memcpy(dst_y, src_y, width);
+        src_y += src_stride_y;
+        dst_y += dst_stride_y;
+      }
+      for (i = 0; i < halfheight; ++i) {
+        memcpy(dst_uv, src_uv, halfwidth * 2);
+        src_uv += src_stride_uv;
+        dst_uv += dst_stride_uv;
+      }
+      return 0;
+    case kRotate90:
+      RotatePlane90(src_y, src_stride_y,
+                    dst_y, dst_stride_y,
+                    width, height);
+      Transpose_16(src_uv + src_stride_uv * (halfheight - 1),
+                   -src_stride_uv, dst_uv, dst_stride_uv,
+                   halfwidth, halfheight);
+      return 0;
+    case kRotate270:
+      RotatePlane270(src_y, src_stride_y,
+                     dst_y, dst_stride_y,
+                     width, height);
+      Transpose_16(src_uv, src_stride_uv,
+                   dst_uv + dst_stride_uv * (halfwidth - 1),
+                   -dst_stride_uv, halfwidth, halfheight);
+      return 0;
+    case kRotate180:
+      RotatePlane180(src_y, src_stride_y,
+                     dst_y, dst_stride_y,
+                     width, height);
+      Rotate180_16(src_uv, src_stride_uv,
+                   dst_uv, dst_stride_uv,
+                   halfwidth, halfheight);
+      return 0;
+    default:
+      break;
+  }
+  return -1;
+}
+
+typedef void (*YUVToRGBRowFunc)(const uint8* y_buf, const uint8* u_buf,
+                                const uint8* v_buf, uint8* rgb_buf,
+                                int width);
+
+// Converts I420 to RGB rotated, without writing a rotated I420 frame.
+// For 90 and 270, the 8 source columns that become the next 8 rows of
+// the output are rotated into row buffers, with the 4 chroma columns
+// they use, and converted from there.  The buffers hold 8 rows of the
+// output width, so they stay in the L1 cache.  For 180 each row is
+// reversed into a row buffer.  The planes are rotated the same way as
+// I420Rotate, so the output is bit exact with I420Rotate followed by the
+// conversion.
+static int I420ToRGBRotate(const uint8* src_y, int src_stride_y,
+                           const uint8* src_u, int src_stride_u,
+                           const uint8* src_v, int src_stride_v,
+                           uint8* dst_rgb, int dst_stride_rgb,
+                           int width, int height,
+                           RotationMode mode,
+                           YUVToRGBRowFunc ConvertRow) {
+  if (!src_y || !src_u || !src_v || !dst_rgb || width <= 0 || height == 0) {
+    return -1;
+  }
+  if (mode != kRotate0 && mode != kRotate90 &&
+      mode != kRotate180 && mode != kRotate270) {
+    return -1;
+  }
+  // Negative height means invert the image.
+  if (height < 0) {
+    height = -height;
+    int halfheight = (height + 1) >> 1;
+    src_y = src_y + (height - 1) * src_stride_y;
+    src_u = src_u + (halfheight - 1) * src_stride_u;
+    src_v = src_v + (halfheight - 1) * src_stride_v;
+    src_stride_y = -src_stride_y;
+    src_stride_u = -src_stride_u;
+    src_stride_v = -src_stride_v;
+  }
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (height + 1) >> 1;
+  int i;
+
+  if (mode == kRotate0) {
+    for (i = 0; i < height; ++i) {
+      ConvertRow(src_y, src_u, src_v, dst_rgb, width);
+      dst_rgb += dst_stride_rgb;
+      src_y += src_stride_y;
+      if (i & 1) {
+        src_u += src_stride_u;
+        src_v += src_stride_v;
+      }
+    }
+    // MMX used for ConvertRow requires an emms instruction.
+    EMMS();
+    return 0;
+  }
+
+  if (mode == kRotate180) {
+    const int stride_y = (width + 15) & ~15;
+    const int stride_uv = (halfwidth + 15) & ~15;
+    uint8* rows_mem = new uint8[stride_y + stride_uv * 2 + 15];
+    uint8* row_y = ALIGNP(rows_mem, 16);
+    uint8* row_u = row_y + stride_y;
+    uint8* row_v = row_u + stride_uv;
+    src_y += src_stride_y * (height - 1);
+    src_u += src_stride_u * (halfheight - 1);
+    src_v += src_stride_v * (halfheight - 1);
+    for (i = 0; i < height; ++i) {
+      RotatePlane180(src_y, 0, row_y, 0, width, 1);
+      if (!(i & 1)) {
+        RotatePlane180(src_u, 0, row_u, 0, halfwidth, 1);
+        RotatePlane180(src_v, 0, row_v, 0, halfwidth, 1);
+        src_u -= src_stride_u;
+        src_v -= src_stride_v;
+      }
+      ConvertRow(row_y, row_u, row_v, dst_rgb, width);
+      dst_rgb += dst_stride_rgb;
+      src_y -= src_stride_y;
+    }
+    EMMS();
+    delete[] rows_mem;
+    return 0;
+  }
+
+  // 90 and 270.  The output is height pixels wide and width rows high.
+  const int stride_y = (height + 15) & ~15;
+  const int stride_uv = (halfheight + 15) & ~15;
+  uint8* rows_mem = new uint8[stride_y * 8 + stride_uv * 4 * 2 + 15];
+  uint8* rows_y = ALIGNP(rows_mem, 16);
+  uint8* rows_u = rows_y + stride_y * 8;
+  uint8* rows_v = rows_u + stride_uv * 4;
+  int y;
+  for (y = 0; y < width; y += 8) {
+    // Output rows y to y + n - 1 use uv_n rotated chroma rows from
+    // uv_begin.
+    const int n = (width - y < 8) ? width - y : 8;
+    const int uv_begin = y >> 1;
+    const int uv_n = ((y + n + 1) >> 1) - uv_begin;
+    if (mode == kRotate90) {
+      // Output row y is source column y.
+      RotatePlane90(src_y + y, src_stride_y, rows_y, stride_y, n, height);
+      RotatePlane90(src_u + uv_begin, src_stride_u, rows_u, stride_uv,
+                    uv_n, halfheight);
+      RotatePlane90(src_v + uv_begin, src_stride_v, rows_v, stride_uv,
+                    uv_n, halfheight);
+    } else {
+      // Output row y is source column width - 1 - y.
+      RotatePlane270(src_y + width - y - n, src_stride_y,
+                     rows_y, stride_y, n, height);
+      RotatePlane270(src_u + halfwidth - uv_begin - uv_n, src_stride_u,
+                     rows_u, stride_uv, uv_n, halfheight);
+      RotatePlane270(src_v + halfwidth - uv_begin - uv_n, src_stride_v,
+                     rows_v, stride_uv, uv_n, halfheight);
+    }
+    for (i = 0; i < n; ++i) {
+      const int uv_row = ((y + i) >> 1) - uv_begin;
+      ConvertRow(rows_y + stride_y * i,
+                 rows_u + stride_uv * uv_row,
+                 rows_v + stride_uv * uv_row,
+                 dst_rgb, height);
+      dst_rgb += dst_stride_rgb;
+    }
+  }
+  EMMS();
+  delete[] rows_mem;
+  return 0;
+}
+
+int I420ToARGBRotate(const uint8* src_y, int src_stride_y,
+                     const uint8* src_u, int src_stride_u,
+                     const uint8* src_v, int src_stride_v,
+                     uint8* dst_argb, int dst_stride_argb,
+                     int width, int height,
+                     RotationMode mode) {
+  YUVToRGBRowFunc ConvertRow = FastConvertYUVToARGBRow_C;
+#if defined(HAS_FASTCONVERTYUVTOARGBROW_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    ConvertRow = FastConvertYUVToARGBRow_Any_MMX;
+  }
+#endif
+  return I420ToRGBRotate(src_y, src_stride_y, src_u, src_stride_u,
+                         src_v, src_stride_v, dst_argb, dst_stride_argb,
+                         width, height, mode, ConvertRow);
+}
+
+int I420ToRGB565Rotate(const uint8* src_y, int src_stride_y,
+                       const uint8* src_u, int src_stride_u,
+                       const uint8* src_v, int src_stride_v,
+                       uint8* dst_rgb565, int dst_stride_rgb565,
+                       int width, int height,
+                       RotationMode mode) {
+  YUVToRGBRowFunc ConvertRow = FastConvertYUVToRGB565Row_C;
+#if defined(HAS_FASTCONVERTYUVTOARGBROW_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    ConvertRow = FastConvertYUVToRGB565Row_Any_MMX;
+  }
+#endif
+  return I420ToRGBRotate(src_y, src_stride_y, src_u, src_stride_u,
+                         src_v, src_stride_v, dst_rgb565, dst_stride_rgb565,
+                         width, height, mode, ConvertRow);
+}
+
+// A band of source rows of one plane, rotated by RotateBandJob.  For an
+// interleaved UV plane the second channel is written to dst_b, otherwise
+// dst_b is NULL.
+struct RotateBand {
+  const uint8* src;
+  int src_stride;
+  uint8* dst_a;
+  int dst_stride_a;
+  uint8* dst_b;
+  int dst_stride_b;
+  int width;
+  int height;
+  RotationMode mode;
+};
+
+static void RotateBandJob(void* opaque, int index) {
+  const RotateBand* band = static_cast<const RotateBand*>(opaque) + index;
+  if (band->dst_b) {
+    switch (band->mode) {
+      case kRotate90:
+        RotateUV90(band->src, band->src_stride,
+                   band->dst_a, band->dst_stride_a,
+                   band->dst_b, band->dst_stride_b,
+                   band->width, band->height);
+        break;
+      case kRotate270:
+        RotateUV270(band->src, band->src_stride,
+                    band->dst_a, band->dst_stride_a,
+                    band->dst_b, band->dst_stride_b,
+                    band->width, band->height);
+        break;
+      default:
+        RotateUV180(band->src, band->src_stride,
+                    band->dst_a, band->dst_stride_a,
+                    band->dst_b, band->dst_stride_b,
+                    band->width, band->height);
+        break;
+    }
+  } else {
+    switch (band->mode) {
+      case kRotate90:
+        RotatePlane90(band->src, band->src_stride,
+                      band->dst_a, band->dst_stride_a,
+                      band->width, band->height);
+        break;
+      case kRotate270:
+        RotatePlane270(band->src, band->src_stride,
+                       band->dst_a, band->dst_stride_a,
+                       band->width, band->height);
+        break;
+      default:
+        RotatePlane180(band->src, band->src_stride,
+                       band->dst_a, band->dst_stride_a,
+                       band->width, band->height);
+        break;
+    }
+  }
+}
+
+// Returns the offset of the destination of a band of 'band_height' source
+// rows starting at row 'y'.  A band becomes a block of columns when
+// rotated by 90 or 270, and a band of rows when rotated by 180.
+static int RotateBandOffset(int y, int band_height, int height,
+                            int dst_stride, RotationMode mode) {
+  switch (mode) {
+    case kRotate90:
+      return height - y - band_height;
+    case kRotate270:
+      return y;
+    default:
+      return (height - y - band_height) * dst_stride;
+  }
+}
+
+// Splits the source rows of a plane into 'num_bands' horizontal bands.
+// Bands are a multiple of 8 rows so they are transposed in the same 8 row
+// strips as the whole plane.  Returns the number of bands added.
+static int AddRotateBands(const uint8* src, int src_stride,
+                          uint8* dst_a, int dst_stride_a,
+                          uint8* dst_b, int dst_stride_b,
+                          int width, int height,
+                          RotationMode mode, int num_bands,
+                          RotateBand* bands) {
+  int rows_per_band = ((height + num_bands - 1) / num_bands + 7) & ~7;
+  int count = 0;
+  for (int y = 0; y < height; y += rows_per_band) {
+    RotateBand* band = bands + count;
+    band->height = (y + rows_per_band < height) ? rows_per_band : height - y;
+    band->src = src + y * src_stride;
+    band->src_stride = src_stride;
+    band->dst_a = dst_a + RotateBandOffset(y, band->height, height,
+                                           dst_stride_a, mode);
+    band->dst_stride_a = dst_stride_a;
+    band->dst_b = dst_b ? dst_b + RotateBandOffset(y, band->height, height,
+                                                   dst_stride_b, mode) : NULL;
+    band->dst_stride_b = dst_stride_b;
+    band->width = width;
+    band->mode = mode;
+    ++count;
+  }
+  return count;
+}
+
+int I420RotateParallel(const uint8* src_y, int src_stride_y,
+                       const uint8* src_u, int src_stride_u,
+                       const uint8* src_v, int src_stride_v,
+                       uint8* dst_y, int dst_stride_y,
+                       uint8* dst_u, int dst_stride_u,
+                       uint8* dst_v, int dst_stride_v,
+                       int width, int height,
+                       RotationMode mode, int num_threads,
+                       ParallelExecutor executor, void* executor_opaque) {
+  if (!src_y || !src_u || !src_v || !dst_y || !dst_u || !dst_v ||
+      width <= 0 || height == 0 || num_threads <= 0) {
+    return -1;
+  }
+  if (mode == kRotate0) {
+    return I420Rotate(src_y, src_stride_y,
+                      src_u, src_stride_u,
+                      src_v, src_stride_v,
+                      dst_y, dst_stride_y,
+                      dst_u, dst_stride_u,
+                      dst_v, dst_stride_v,
+                      width, height, mode);
+  }
+  if (mode != kRotate90 && mode != kRotate180 && mode != kRotate270) {
+    return -1;
+  }
+  // Negative height means invert the image.
+  if (height < 0) {
+    height = -height;
+    int halfheight = (height + 1) >> 1;
+    src_y = src_y + (height - 1) * src_stride_y;
+    src_u = src_u + (halfheight - 1) * src_stride_u;
+    src_v = src_v + (halfheight - 1) * src_stride_v;
+    src_stride_y = -src_stride_y;
+    src_stride_u = -src_stride_u;
+    src_stride_v = -src_stride_v;
+  }
+  if (num_threads > kMaxParallelThreads) {
+    num_threads = kMaxParallelThreads;
+  }
+  int halfwidth = (width + 1) >> 1;
+  int halfheight = (height + 1) >> 1;
+
+  // Each plane is split into one band per thread.
+  RotateBand bands[kMaxParallelThreads * 3];
+  int count = 0;
+  count += AddRotateBands(src_y, src_stride_y, dst_y, dst_stride_y, NULL, 0,
+                          width, height, mode, num_threads, bands + count);
+  count += AddRotateBands(src_u, src_stride_u, dst_u, dst_stride_u, NULL, 0,
+                          halfwidth, halfheight, mode, num_threads,
+                          bands + count);
+  count += AddRotateBands(src_v, src_stride_v, dst_v, dst_stride_v, NULL, 0,
+                          halfwidth, halfheight, mode, num_threads,
+                          bands + count);
+  if (executor) {
+    executor(executor_opaque, RotateBandJob, bands, count);
+  } else {
+    RunParallelJobs(RotateBandJob, bands, count, num_threads);
+  }
+  return 0;
+}
+
+int NV12ToI420RotateParallel(const uint8* src_y, int src_stride_y,
+                             const uint8* src_uv, int src_stride_uv,
+                             uint8* dst_y, int dst_stride_y,
+                             uint8* dst_u, int dst_stride_u,
+                             uint8* dst_v, int dst_stride_v,
+                             int width, int height,
+                             RotationMode mode, int num_threads,
+                             ParallelExecutor executor,
+                             void* executor_opaque) {
+  if (!src_y || !src_uv || !dst_y || !dst_u || !dst_v ||
+      width <= 0 || height == 0 || num_threads <= 0) {
+    return -1;
+  }
+  if (mode == kRotate0) {
+    return NV12ToI420Rotate(src_y, src_stride_y,
+                            src_uv, src_stride_uv,
+                            dst_y, dst_stride_y,
+                            dst_u, dst_stride_u,
+                            dst_v, dst_stride_v,
+                            width, height, mode);
+  }
+  if (mode != kRotate90 && mode != kRotate180 && mode != kRotate270) {
+    return -1;
+  }
+  // Negative height means invert the image.
+  if (height < 0) {
+    height = -height;
+    int halfheight = (height + 1) >> 1;
+    src_y = src_y + (height - 1) * src_stride_y;
+    src_uv = src_uv + (halfheight - 1) * src_stride_uv;
+    src_stride_y = -src_stride_y;
+    src_stride_uv = -src_stride_uv;
+  }
+  if (num_threads > kMaxParallelThreads) {
+    num_threads = kMaxParallelThreads;
+  }
+  int halfwidth = (width + 1) >> 1;
+  int halfheight = (height + 1) >> 1;
+
+  // Each plane is split into one band per thread.
+  RotateBand bands[kMaxParallelThreads * 2];
+  int count = 0;
+  count += AddRotateBands(src_y, src_stride_y, dst_y, dst_stride_y, NULL, 0,
+                          width, height, mode, num_threads, bands + count);
+  count += AddRotateBands(src_uv, src_stride_uv,
+                          dst_u, dst_stride_u, dst_v, dst_stride_v,
+                          halfwidth, halfheight, mode, num_threads,
+                          bands + count);
+  if (executor) {
+    executor(executor_opaque, RotateBandJob, bands, count);
+  } else {
+    RunParallelJobs(RotateBandJob, bands, count, num_threads);
+  }
+  return 0;
+}
+
 }  // namespace libyuv
@@ -21,6 +21,7 @@ RotatePlane90(const uint8* src, int src_stride,
               uint8* dst, int dst_stride,
               int width, int height);
 
+// src and dst may be the same plane.
 void
 RotatePlane180(const uint8* src, int src_stride,
                uint8* dst, int dst_stride,
@@ -62,6 +62,17 @@
 #define HAS_FASTCONVERTYUVTOABGRROW_MMX
 #endif
 
+// The following are available on Windows and GCC 32/64 bit
+#if (defined(WIN32) || defined(__x86_64__) || defined(__i386__)) && \
+    !defined(LIBYUV_DISABLE_ASM)
+#define HAS_REVERSELINE_SSSE3
+#define HAS_REVERSELINE_SSE2
+#define HAS_REVERSELINE_SSE
+#define HAS_COPYROW_NT_SSE2
+#define HAS_COPYROW_NT_SSE
+#define HAS_SPLITUV_SSE2
+#endif
+
 #if 0
 // The following are available on Windows
 #if defined(WIN32) && \
@@ -130,6 +141,63 @@ void I400ToARGBRow_SSE2(const uint8* src_y, uint8* dst_argb, int pix);
 #endif
 void I400ToARGBRow_C(const uint8* src_y, uint8* dst_argb, int pix);
 
+// Reverses the order of the bytes in a row.  src and dst must not overlap.
+void ReverseLine_C(const uint8* src, uint8* dst, int width);
+#ifdef HAS_REVERSELINE_SSSE3
+void ReverseLine_SSSE3(const uint8* src, uint8* dst, int width);
+void ReverseLine_Any_SSSE3(const uint8* src, uint8* dst, int width);
+#endif
+#ifdef HAS_REVERSELINE_SSE2
+void ReverseLine_SSE2(const uint8* src, uint8* dst, int width);
+void ReverseLine_Any_SSE2(const uint8* src, uint8* dst, int width);
+#endif
+#ifdef HAS_REVERSELINE_SSE
+void ReverseLine_SSE(const uint8* src, uint8* dst, int width);
+void ReverseLine_Any_SSE(const uint8* src, uint8* dst, int width);
+#endif
+
+// Splits a row of interleaved UV into a row of U and a row of V.
+// SplitUV_SSE2 needs all pointers 16 byte aligned and pix a multiple of 16.
+void SplitUV_C(const uint8* src_uv, uint8* dst_u, uint8* dst_v, int pix);
+#ifdef HAS_SPLITUV_SSE2
+void SplitUV_SSE2(const uint8* src_uv, uint8* dst_u, uint8* dst_v, int pix);
+void SplitUV_Any_SSE2(const uint8* src_uv, uint8* dst_u, uint8* dst_v,
+                      int pix);
+#endif
+
+// Reverses each row of a plane of 'bpp' byte pixels in place, through a
+// row buffer.  If flip is true the rows are also swapped top to bottom, in
+// pairs, which rotates the plane by 180 degrees.  ReverseRow reverses
+// 'width' pixels.
+void ReverseRowsInPlace(uint8* dst, int dst_stride, int width, int height,
+                        int bpp, bool flip,
+                        void (*ReverseRow)(const uint8* src, uint8* dst,
+                                           int width));
+
+// Copies a row with non-temporal stores, which bypass the cache.  The
+// caller calls SFENCE once the plane is written, and EMMS after the SSE
+// version.  CopyRow_NT_SSE2 needs dst 16 byte aligned and count a multiple
+// of 16.  CopyRow_NT_SSE needs count a multiple of 32.  The Any versions
+// take any dst and count.
+#ifdef HAS_COPYROW_NT_SSE2
+void CopyRow_NT_SSE2(const uint8* src, uint8* dst, int count);
+void CopyRow_NT_Any_SSE2(const uint8* src, uint8* dst, int count);
+#endif
+#ifdef HAS_COPYROW_NT_SSE
+void CopyRow_NT_SSE(const uint8* src, uint8* dst, int count);
+void CopyRow_NT_Any_SSE(const uint8* src, uint8* dst, int count);
+#endif
+
+// Chooses how to write a plane of plane_size bytes at dst.  Returns the
+// Any version of a non-temporal copy if the plane is larger than
+// GetNonTemporalThreshold(), dst and dst_stride are multiples of align,
+// and the CPU has streaming stores.  Otherwise returns NULL, and the plane
+// is written through the cache.  Partial blocks make streaming stores
+// slower than cached ones, hence the alignment.
+typedef void (*CopyRowFunc)(const uint8* src, uint8* dst, int count);
+CopyRowFunc GetCopyRow_NT(int plane_size, const uint8* dst, int dst_stride,
+                          int align);
+
 //#if defined(_MSC_VER)
 //#define SIMD_ALIGNED(var) __declspec(align(16)) var
 //#define TALIGN16(t, var) static __declspec(align(16)) t _ ## var
@@ -168,6 +236,24 @@ void FastConvertYUV444ToARGBRow_C(const uint8* y_buf,
                                   uint8* rgb_buf,
                                   int width);
 
+void FastConvertYUVToRGB565Row_C(const uint8* y_buf,
+                                 const uint8* u_buf,
+                                 const uint8* v_buf,
+                                 uint8* rgb_buf,
+                                 int width);
+
+void FastConvertYUVToARGB1555Row_C(const uint8* y_buf,
+                                   const uint8* u_buf,
+                                   const uint8* v_buf,
+                                   uint8* rgb_buf,
+                                   int width);
+
+void FastConvertYUVToARGB4444Row_C(const uint8* y_buf,
+                                   const uint8* u_buf,
+                                   const uint8* v_buf,
+                                   uint8* rgb_buf,
+                                   int width);
+
 void FastConvertYToARGBRow_C(const uint8* y_buf,
                              uint8* rgb_buf,
                              int width);
@@ -243,6 +329,26 @@ void FastConvertYUV444ToARGBRow_MMX(const uint8* y_buf,
 void FastConvertYToARGBRow_MMX(const uint8* y_buf,
                                uint8* rgb_buf,
                                int width);
+
+// Any width.  The MMX row functions convert the largest multiple of the
+// pixels they handle per loop, and the C versions the rest.
+#define FastConvertYUVTo___Row_Any_MMX(name) \
+  void FastConvertYUVTo ## name ## Row_Any_MMX(const uint8* y_buf, \
+                                               const uint8* u_buf, \
+                                               const uint8* v_buf, \
+                                               uint8* rgb_buf, \
+                                               int width); \
+
+FastConvertYUVTo___Row_Any_MMX(ARGB)
+FastConvertYUVTo___Row_Any_MMX(RGB565)
+FastConvertYUVTo___Row_Any_MMX(ARGB1555)
+FastConvertYUVTo___Row_Any_MMX(ARGB4444)
+FastConvertYUVTo___Row_Any_MMX(BGRA)
+FastConvertYUVTo___Row_Any_MMX(ABGR)
+
+void FastConvertYToARGBRow_Any_MMX(const uint8* y_buf,
+                                   uint8* rgb_buf,
+                                   int width);
 #endif
 
 #ifdef HAS_FASTCONVERTYUVTOARGBROW_SSSE3
@@ -314,6 +420,17 @@ void FastConvertYToARGBRow_SSE2(const uint8* y_buf,
 #define EMMS()
 #endif
 
+// Orders non-temporal stores before the stores that follow.
+#if defined(HAS_COPYROW_NT_SSE)
+#if defined(_MSC_VER)
+#define SFENCE() __asm sfence
+#else
+#define SFENCE() asm volatile("sfence" : : : "memory")
+#endif
+#else
+#define SFENCE()
+#endif
+
 
 }  // extern "C"
 
@@ -0,0 +1,171 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "row.h"
+
+#include <string.h>
+
+#include "libyuv/basic_types.h"
+#include "libyuv/cpu_id.h"
+
+extern "C" {
+
+// Any width wrappers.  The SIMD row functions only handle a multiple of
+// the pixels they convert per loop, and write whole loops.  The wrappers
+// convert the largest such multiple with SIMD and the rest with C, so
+// the SIMD version is used for most of a row of any width.
+
+// YUV to RGB does a multiple of MASK + 1 pixels with SIMD and the
+// remainder with C.  MASK + 1 is even, so the remainder starts on a
+// chroma sample.
+#define YANY(NAMEANY, I420TORGB_SIMD, I420TORGB_C, BPP, MASK)                 \
+    void NAMEANY(const uint8* y_buf,                                           \
+                 const uint8* u_buf,                                           \
+                 const uint8* v_buf,                                           \
+                 uint8* rgb_buf,                                               \
+                 int width) {                                                  \
+      int n = width & ~MASK;                                                   \
+      if (n > 0) {                                                             \
+        I420TORGB_SIMD(y_buf, u_buf, v_buf, rgb_buf, n);                       \
+      }                                                                        \
+      if (n < width) {                                                         \
+        I420TORGB_C(y_buf + n, u_buf + (n >> 1), v_buf + (n >> 1),             \
+                    rgb_buf + n * BPP, width - n);                             \
+      }                                                                        \
+    }
+
+#ifdef HAS_FASTCONVERTYUVTOARGBROW_MMX
+// The jfr.h row functions convert 32 pixels per loop.
+YANY(FastConvertYUVToARGBRow_Any_MMX, FastConvertYUVToARGBRow_MMX,
+     FastConvertYUVToARGBRow_C, 4, 31)
+YANY(FastConvertYUVToRGB565Row_Any_MMX, FastConvertYUVToRGB565Row_MMX,
+     FastConvertYUVToRGB565Row_C, 2, 31)
+YANY(FastConvertYUVToARGB1555Row_Any_MMX, FastConvertYUVToARGB1555Row_MMX,
+     FastConvertYUVToARGB1555Row_C, 2, 31)
+YANY(FastConvertYUVToARGB4444Row_Any_MMX, FastConvertYUVToARGB4444Row_MMX,
+     FastConvertYUVToARGB4444Row_C, 2, 31)
+YANY(FastConvertYUVToBGRARow_Any_MMX, FastConvertYUVToBGRARow_MMX,
+     FastConvertYUVToBGRARow_C, 4, 1)
+YANY(FastConvertYUVToABGRRow_Any_MMX, FastConvertYUVToABGRRow_MMX,
+     FastConvertYUVToABGRRow_C, 4, 1)
+
+void FastConvertYToARGBRow_Any_MMX(const uint8* y_buf,
+                                   uint8* rgb_buf,
+                                   int width) {
+  int n = width & ~1;
+  if (n > 0) {
+    FastConvertYToARGBRow_MMX(y_buf, rgb_buf, n);
+  }
+  if (n < width) {
+    FastConvertYToARGBRow_C(y_buf + n, rgb_buf + n * 4, width - n);
+  }
+}
+#endif
+
+#undef YANY
+
+// Reversing does the last MASK + 1 multiple of pixels of src with SIMD,
+// to the start of dst, and the first pixels of src with C.
+#define RANY(NAMEANY, REVERSE_SIMD, MASK)                                      \
+    void NAMEANY(const uint8* src, uint8* dst, int width) {                    \
+      int n = width & ~MASK;                                                   \
+      if (n > 0) {                                                             \
+        REVERSE_SIMD(src + (width - n), dst, n);                               \
+      }                                                                        \
+      if (n < width) {                                                         \
+        ReverseLine_C(src, dst + n, width - n);                                \
+      }                                                                        \
+    }
+
+#ifdef HAS_REVERSELINE_SSSE3
+RANY(ReverseLine_Any_SSSE3, ReverseLine_SSSE3, 15)
+#endif
+#ifdef HAS_REVERSELINE_SSE2
+RANY(ReverseLine_Any_SSE2, ReverseLine_SSE2, 15)
+#endif
+#ifdef HAS_REVERSELINE_SSE
+RANY(ReverseLine_Any_SSE, ReverseLine_SSE, 7)
+#endif
+
+#undef RANY
+
+// Any width.  The SIMD version splits multiples of 16 pixels and C the rest.
+#define SPLITUVANY(NAMEANY, SPLITUV_SIMD)                                      \
+    void NAMEANY(const uint8* src_uv, uint8* dst_u, uint8* dst_v, int pix) {   \
+      int n = pix & ~15;                                                       \
+      if (n > 0) {                                                             \
+        SPLITUV_SIMD(src_uv, dst_u, dst_v, n);                                 \
+      }                                                                        \
+      if (n < pix) {                                                           \
+        SplitUV_C(src_uv + n * 2, dst_u + n, dst_v + n, pix - n);              \
+      }                                                                        \
+    }
+
+#ifdef HAS_SPLITUV_SSE2
+SPLITUVANY(SplitUV_Any_SSE2, SplitUV_SSE2)
+#endif
+
+#undef SPLITUVANY
+
+// Non-temporal copies stream whole loops and copy the rest with memcpy.
+// movntdq stores to aligned addresses, so the SSE2 version also copies the
+// bytes before the first 16 byte aligned dst address with memcpy.
+#ifdef HAS_COPYROW_NT_SSE2
+void CopyRow_NT_Any_SSE2(const uint8* src, uint8* dst, int count) {
+  int head = static_cast<int>(-reinterpret_cast<intptr_t>(dst) & 15);
+  if (head > count) {
+    head = count;
+  }
+  if (head > 0) {
+    memcpy(dst, src, head);
+  }
+  int n = (count - head) & ~15;
+  if (n > 0) {
+    CopyRow_NT_SSE2(src + head, dst + head, n);
+  }
+  n += head;
+  if (n < count) {
+    memcpy(dst + n, src + n, count - n);
+  }
+}
+#endif
+
+#ifdef HAS_COPYROW_NT_SSE
+void CopyRow_NT_Any_SSE(const uint8* src, uint8* dst, int count) {
+  int n = count & ~31;
+  if (n > 0) {
+    CopyRow_NT_SSE(src, dst, n);
+  }
+  if (n < count) {
+    memcpy(dst + n, src + n, count - n);
+  }
+}
+#endif
+
+CopyRowFunc GetCopyRow_NT(int plane_size, const uint8* dst, int dst_stride,
+                          int align) {
+  if (plane_size <= libyuv::GetNonTemporalThreshold() ||
+      !IS_ALIGNED(dst, align) || (dst_stride % align != 0)) {
+    return NULL;
+  }
+#if defined(HAS_COPYROW_NT_SSE2)
+  if (libyuv::TestCpuFlag(libyuv::kCpuHasSSE2)) {
+    return CopyRow_NT_Any_SSE2;
+  }
+#endif
+#if defined(HAS_COPYROW_NT_SSE)
+  if (libyuv::TestCpuFlag(libyuv::kCpuHasSSE)) {
+    return CopyRow_NT_Any_SSE;
+  }
+#endif
+  return NULL;
+}
+
+}  // extern "C"
@@ -10,6 +10,8 @@
 
 #include "row.h"
 
+#include <string.h>  // For memcpy
+
 #include "libyuv/basic_types.h"
 
 extern "C" {
@@ -208,6 +210,51 @@ void RAWToUVRow_SSSE3(const uint8* src_argb, int src_stride_argb,
 #endif
 #endif
 
+void ReverseLine_C(const uint8* src, uint8* dst, int width) {
+  src += width - 1;
+  for (int i = 0; i < width; ++i) {
+    dst[i] = src[0];
+    --src;
+  }
+}
+
+void SplitUV_C(const uint8* src_uv, uint8* dst_u, uint8* dst_v, int pix) {
+  // Copy a row of UV.
+  for (int x = 0; x < pix; ++x) {
+    dst_u[0] = src_uv[0];
+    dst_v[0] = src_uv[1];
+    src_uv += 2;
+    dst_u += 1;
+    dst_v += 1;
+  }
+}
+
+void ReverseRowsInPlace(uint8* dst, int dst_stride, int width, int height,
+                        int bpp, bool flip,
+                        void (*ReverseRow)(const uint8* src, uint8* dst,
+                                           int width)) {
+  uint8* row_mem = new uint8[width * bpp + 15];
+  uint8* row = ALIGNP(row_mem, 16);
+  if (flip) {
+    uint8* bottom = dst + dst_stride * (height - 1);
+    for (int y = 0; y < height / 2; ++y) {
+      ReverseRow(dst, row, width);
+      ReverseRow(bottom, dst, width);
+      memcpy(bottom, row, width * bpp);
+      dst += dst_stride;
+      bottom -= dst_stride;
+    }
+    // The middle row of an odd height is only reversed.
+    height &= 1;
+  }
+  for (int y = 0; y < height; ++y) {
+    ReverseRow(dst, row, width);
+    memcpy(dst, row, width * bpp);
+    dst += dst_stride;
+  }
+  delete[] row_mem;
+}
+
 void I400ToARGBRow_C(const uint8* src_y, uint8* dst_argb, int pix) {
   // Copy a Y to RGB.
   for (int x = 0; x < pix; ++x) {
@@ -327,6 +374,59 @@ void FastConvertYUV444ToARGBRow_C(const uint8* y_buf,
   }
 }
 
+// Same as FastConvertYUVToARGBRow_C, with each pixel packed to RGB565.
+void FastConvertYUVToRGB565Row_C(const uint8* y_buf,
+                                 const uint8* u_buf,
+                                 const uint8* v_buf,
+                                 uint8* rgb_buf,
+                                 int width) {
+  uint16* dst = reinterpret_cast<uint16*>(rgb_buf);
+  uint32 argb;
+  for (int x = 0; x < width; ++x) {
+    YuvPixel(y_buf[x], u_buf[x >> 1], v_buf[x >> 1],
+             reinterpret_cast<uint8*>(&argb), 24, 16, 8, 0);
+    dst[x] = static_cast<uint16>(((argb >> 8) & 0xf800) |
+                                 ((argb >> 5) & 0x07e0) |
+                                 ((argb >> 3) & 0x001f));
+  }
+}
+
+// Same as FastConvertYUVToARGBRow_C, with each pixel packed to ARGB1555.
+void FastConvertYUVToARGB1555Row_C(const uint8* y_buf,
+                                   const uint8* u_buf,
+                                   const uint8* v_buf,
+                                   uint8* rgb_buf,
+                                   int width) {
+  uint16* dst = reinterpret_cast<uint16*>(rgb_buf);
+  uint32 argb;
+  for (int x = 0; x < width; ++x) {
+    YuvPixel(y_buf[x], u_buf[x >> 1], v_buf[x >> 1],
+             reinterpret_cast<uint8*>(&argb), 24, 16, 8, 0);
+    dst[x] = static_cast<uint16>(((argb >> 16) & 0x8000) |
+                                 ((argb >> 9) & 0x7c00) |
+                                 ((argb >> 6) & 0x03e0) |
+                                 ((argb >> 3) & 0x001f));
+  }
+}
+
+// Same as FastConvertYUVToARGBRow_C, with each pixel packed to ARGB4444.
+void FastConvertYUVToARGB4444Row_C(const uint8* y_buf,
+                                   const uint8* u_buf,
+                                   const uint8* v_buf,
+                                   uint8* rgb_buf,
+                                   int width) {
+  uint16* dst = reinterpret_cast<uint16*>(rgb_buf);
+  uint32 argb;
+  for (int x = 0; x < width; ++x) {
+    YuvPixel(y_buf[x], u_buf[x >> 1], v_buf[x >> 1],
+             reinterpret_cast<uint8*>(&argb), 24, 16, 8, 0);
+    dst[x] = static_cast<uint16>(((argb >> 16) & 0xf000) |
+                                 ((argb >> 12) & 0x0f00) |
+                                 ((argb >> 8) & 0x00f0) |
+                                 ((argb >> 4) & 0x000f));
+  }
+}
+
 void FastConvertYToARGBRow_C(const uint8* y_buf,
                              uint8* rgb_buf,
                              int width) {
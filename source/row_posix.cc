@@ -744,4 +744,184 @@ void BGRAToUVRow_SSSE3(const uint8* src_argb, int src_stride_argb,
 }
 #endif
 
+#ifdef HAS_REVERSELINE_SSSE3
+// Shuffle table for reversing the bytes.
+static const uvec8 kShuffleReverse = {
+  15u, 14u, 13u, 12u, 11u, 10u, 9u, 8u, 7u, 6u, 5u, 4u, 3u, 2u, 1u, 0u
+};
+
+void ReverseLine_SSSE3(const uint8* src, uint8* dst, int width) {
+  intptr_t temp_width = static_cast<intptr_t>(width);
+  asm volatile (
+  "movdqa     %3,%%xmm5                        \n"
+  "lea        -0x10(%0,%2,1),%0                \n"
+"1:                                            \n"
+  "movdqu     (%0),%%xmm0                      \n"
+  "lea        -0x10(%0),%0                     \n"
+  "pshufb     %%xmm5,%%xmm0                    \n"
+  "movdqu     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x10,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src),  // %0
+    "+r"(dst),  // %1
+    "+r"(temp_width)  // %2
+  : "m"(kShuffleReverse)  // %3
+  : "memory", "cc"
+#if defined(__SSE2__)
+    , "xmm0", "xmm5"
+#endif
+);
+}
+#endif
+
+#ifdef HAS_REVERSELINE_SSE2
+// Swaps the bytes of each word, then reverses the words.
+void ReverseLine_SSE2(const uint8* src, uint8* dst, int width) {
+  intptr_t temp_width = static_cast<intptr_t>(width);
+  asm volatile (
+  "lea        -0x10(%0,%2,1),%0                \n"
+"1:                                            \n"
+  "movdqu     (%0),%%xmm0                      \n"
+  "lea        -0x10(%0),%0                     \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "psllw      $0x8,%%xmm0                      \n"
+  "psrlw      $0x8,%%xmm1                      \n"
+  "por        %%xmm1,%%xmm0                    \n"
+  "pshuflw    $0x1b,%%xmm0,%%xmm0              \n"
+  "pshufhw    $0x1b,%%xmm0,%%xmm0              \n"
+  "pshufd     $0x4e,%%xmm0,%%xmm0              \n"
+  "movdqu     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x10,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src),  // %0
+    "+r"(dst),  // %1
+    "+r"(temp_width)  // %2
+  :
+  : "memory", "cc"
+#if defined(__SSE2__)
+    , "xmm0", "xmm1"
+#endif
+);
+}
+#endif
+
+#ifdef HAS_REVERSELINE_SSE
+// MMX with the SSE pshufw.  The caller calls EMMS.
+void ReverseLine_SSE(const uint8* src, uint8* dst, int width) {
+  intptr_t temp_width = static_cast<intptr_t>(width);
+  asm volatile (
+  "lea        -0x8(%0,%2,1),%0                 \n"
+"1:                                            \n"
+  "movq       (%0),%%mm0                       \n"
+  "lea        -0x8(%0),%0                      \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "psllw      $0x8,%%mm0                       \n"
+  "psrlw      $0x8,%%mm1                       \n"
+  "por        %%mm1,%%mm0                      \n"
+  "pshufw     $0x1b,%%mm0,%%mm0                \n"
+  "movq       %%mm0,(%1)                       \n"
+  "lea        0x8(%1),%1                       \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src),  // %0
+    "+r"(dst),  // %1
+    "+r"(temp_width)  // %2
+  :
+  : "memory", "cc"
+#if defined(__MMX__)
+    , "mm0", "mm1"
+#endif
+);
+}
+#endif
+
+#ifdef HAS_COPYROW_NT_SSE2
+void CopyRow_NT_SSE2(const uint8* src, uint8* dst, int count) {
+  asm volatile (
+"1:                                            \n"
+  "movdqu     (%0),%%xmm0                      \n"
+  "lea        0x10(%0),%0                      \n"
+  "movntdq    %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x10,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src),    // %0
+    "+r"(dst),    // %1
+    "+r"(count)   // %2
+  :
+  : "memory", "cc"
+#if defined(__SSE2__)
+    , "xmm0"
+#endif
+);
+}
+#endif
+
+#ifdef HAS_COPYROW_NT_SSE
+void CopyRow_NT_SSE(const uint8* src, uint8* dst, int count) {
+  asm volatile (
+"1:                                            \n"
+  "movq       (%0),%%mm0                       \n"
+  "movq       0x8(%0),%%mm1                    \n"
+  "movq       0x10(%0),%%mm2                   \n"
+  "movq       0x18(%0),%%mm3                   \n"
+  "lea        0x20(%0),%0                      \n"
+  "movntq     %%mm0,(%1)                       \n"
+  "movntq     %%mm1,0x8(%1)                    \n"
+  "movntq     %%mm2,0x10(%1)                   \n"
+  "movntq     %%mm3,0x18(%1)                   \n"
+  "lea        0x20(%1),%1                      \n"
+  "sub        $0x20,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src),    // %0
+    "+r"(dst),    // %1
+    "+r"(count)   // %2
+  :
+  : "memory", "cc"
+#if defined(__MMX__)
+    , "mm0", "mm1", "mm2", "mm3"
+#endif
+);
+}
+#endif
+
+#ifdef HAS_SPLITUV_SSE2
+// Even bytes of UV go to dst_u and odd bytes to dst_v, 16 pixels per loop.
+void SplitUV_SSE2(const uint8* src_uv, uint8* dst_u, uint8* dst_v, int pix) {
+  asm volatile (
+  "pcmpeqb    %%xmm5,%%xmm5                    \n"
+  "psrlw      $0x8,%%xmm5                      \n"
+"1:                                            \n"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "movdqa     %%xmm1,%%xmm3                    \n"
+  "pand       %%xmm5,%%xmm0                    \n"
+  "pand       %%xmm5,%%xmm1                    \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "psrlw      $0x8,%%xmm2                      \n"
+  "psrlw      $0x8,%%xmm3                      \n"
+  "packuswb   %%xmm3,%%xmm2                    \n"
+  "movdqa     %%xmm2,(%2)                      \n"
+  "lea        0x10(%2),%2                      \n"
+  "sub        $0x10,%3                         \n"
+  "ja         1b                               \n"
+  : "+r"(src_uv),     // %0
+    "+r"(dst_u),      // %1
+    "+r"(dst_v),      // %2
+    "+r"(pix)         // %3
+  :
+  : "memory", "cc"
+#if defined(__SSE2__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm5"
+#endif
+);
+}
+#endif
+
 }  // extern "C"
@@ -1009,7 +1009,166 @@ void FastConvertYToARGBRow_SSE2(const uint8* y_buf,
 #endif
 #endif
 
-}  // extern "C"
+#ifdef HAS_REVERSELINE_SSSE3
+// Shuffle table for reversing the bytes.
+SIMD_ALIGNED(const uint8 kShuffleReverse[16]) = {
+  15u, 14u, 13u, 12u, 11u, 10u, 9u, 8u, 7u, 6u, 5u, 4u, 3u, 2u, 1u, 0u
+};
+
+__declspec(naked)
+void ReverseLine_SSSE3(const uint8* src, uint8* dst, int width) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // width
+    movdqa    xmm5, kShuffleReverse
+    lea       eax, [eax + ecx - 16]
+ convertloop :
+    movdqu    xmm0, [eax]
+    lea       eax, [eax - 16]
+    pshufb    xmm0, xmm5
+    movdqu    [edx], xmm0
+    lea       edx, [edx + 16]
+    sub       ecx, 16
+    ja        convertloop
+    ret
+  }
+}
+#endif
+
+#ifdef HAS_REVERSELINE_SSE2
+// Swaps the bytes of each word, then reverses the words.
+__declspec(naked)
+void ReverseLine_SSE2(const uint8* src, uint8* dst, int width) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // width
+    lea       eax, [eax + ecx - 16]
+ convertloop :
+    movdqu    xmm0, [eax]
+    lea       eax, [eax - 16]
+    movdqa    xmm1, xmm0
+    psllw     xmm0, 8
+    psrlw     xmm1, 8
+    por       xmm0, xmm1
+    pshuflw   xmm0, xmm0, 0x1b
+    pshufhw   xmm0, xmm0, 0x1b
+    pshufd    xmm0, xmm0, 0x4e
+    movdqu    [edx], xmm0
+    lea       edx, [edx + 16]
+    sub       ecx, 16
+    ja        convertloop
+    ret
+  }
+}
+#endif
+
+#ifdef HAS_REVERSELINE_SSE
+// MMX with the SSE pshufw.  The caller calls EMMS.
+__declspec(naked)
+void ReverseLine_SSE(const uint8* src, uint8* dst, int width) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // width
+    lea       eax, [eax + ecx - 8]
+ convertloop :
+    movq      mm0, [eax]
+    lea       eax, [eax - 8]
+    movq      mm1, mm0
+    psllw     mm0, 8
+    psrlw     mm1, 8
+    por       mm0, mm1
+    pshufw    mm0, mm0, 0x1b
+    movq      [edx], mm0
+    lea       edx, [edx + 8]
+    sub       ecx, 8
+    ja        convertloop
+    ret
+  }
+}
+#endif
+
+#ifdef HAS_COPYROW_NT_SSE2
+__declspec(naked)
+void CopyRow_NT_SSE2(const uint8* src, uint8* dst, int count) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // count
+ convertloop :
+    movdqu    xmm0, [eax]
+    lea       eax, [eax + 16]
+    movntdq   [edx], xmm0
+    lea       edx, [edx + 16]
+    sub       ecx, 16
+    ja        convertloop
+    ret
+  }
+}
+#endif
 
+#ifdef HAS_COPYROW_NT_SSE
+__declspec(naked)
+void CopyRow_NT_SSE(const uint8* src, uint8* dst, int count) {
+__asm {
+    mov       eax, [esp + 4]   // src
+    mov       edx, [esp + 8]   // dst
+    mov       ecx, [esp + 12]  // count
+ convertloop :
+    movq      mm0, [eax]
+    movq      mm1, [eax + 8]
+    movq      mm2, [eax + 16]
+    movq      mm3, [eax + 24]
+    lea       eax, [eax + 32]
+    movntq    [edx], mm0
+    movntq    [edx + 8], mm1
+    movntq    [edx + 16], mm2
+    movntq    [edx + 24], mm3
+    lea       edx, [edx + 32]
+    sub       ecx, 32
+    ja        convertloop
+    ret
+  }
+}
+#endif
 
+#ifdef HAS_SPLITUV_SSE2
+// Even bytes of UV go to dst_u and odd bytes to dst_v, 16 pixels per loop.
+__declspec(naked)
+void SplitUV_SSE2(const uint8* src_uv, uint8* dst_u, uint8* dst_v, int pix) {
+  __asm {
+    push       edi
+    mov        eax, [esp + 4 + 4]    // src_uv
+    mov        edx, [esp + 4 + 8]    // dst_u
+    mov        edi, [esp + 4 + 12]   // dst_v
+    mov        ecx, [esp + 4 + 16]   // pix
+    pcmpeqb    xmm5, xmm5            // generate mask 0x00ff00ff
+    psrlw      xmm5, 8
+
+  convertloop:
+    movdqa     xmm0, [eax]
+    movdqa     xmm1, [eax + 16]
+    lea        eax,  [eax + 32]
+    movdqa     xmm2, xmm0
+    movdqa     xmm3, xmm1
+    pand       xmm0, xmm5   // even bytes
+    pand       xmm1, xmm5
+    packuswb   xmm0, xmm1
+    movdqa     [edx], xmm0
+    lea        edx, [edx + 16]
+    psrlw      xmm2, 8      // odd bytes
+    psrlw      xmm3, 8
+    packuswb   xmm2, xmm3
+    movdqa     [edi], xmm2
+    lea        edi, [edi + 16]
+    sub        ecx, 16
+    ja         convertloop
+    pop        edi
+    ret
+  }
+}
+#endif
 
+}  // extern "C"
@@ -11,9 +11,12 @@
 #include "libyuv/scale.h"
 
 #include <assert.h>
+#include <math.h>
 #include <string.h>
 
 #include "libyuv/cpu_id.h"
+#include "parallel_priv.h"
+#include "row.h"
 
 #if defined(_MSC_VER)
 #define ALIGN16(var) __declspec(align(16)) var
@@ -40,6 +43,18 @@ void SetUseReferenceImpl(bool use) {
   use_reference_impl_ = use;
 }
 
+// Polyphase filter coefficients are fixed point with kFilterBits of
+// fraction.
+static const int kFilterBits = 14;
+
+// One output pixel or row of a polyphase filter: the index of the first
+// source pixel or row it reads, which may be outside the source, and its
+// coefficients.
+struct ScaleFilterPos {
+  intptr_t offset;
+  const int16* coeffs;
+};
+
 /**
  * NEON downscalers with interpolation.
  *
@@ -505,6 +520,7 @@ static void ScaleRowDown38_2_Int_NEON(const uint8* src_ptr, int src_stride,
 // Constants for SSE2 code
 #elif (defined(WIN32) || defined(__i386__) || defined(__x86_64__)) && \
     !defined(COVERAGE_ENABLED) && !TARGET_IPHONE_SIMULATOR
+#undef TALIGN16  // row.h declares variables without the underscore.
 #if defined(_MSC_VER)
 #define TALIGN16(t, var) __declspec(align(16)) t _ ## var
 #elif defined(OSX)
@@ -586,6 +602,39 @@ extern "C" TALIGN16(const uint8, shufab2[16]) =
 // Scaling values for boxes of 3x2 and 2x2
 extern "C" TALIGN16(const uint16, scaleab2[8]) =
   { 65536 / 3, 65536 / 3, 65536 / 2, 65536 / 3, 65536 / 3, 65536 / 2, 0, 0 };
+
+// Shuffles and coefficients, in 64ths, for a 3/2 upscale.
+extern "C" TALIGN16(const uint8, up32[4][16]) = {
+  // Offsets for source bytes 0 to 5 for pixels 0 to 7.
+  { 0, 1, 0, 1, 1, 2, 2, 3, 2, 3, 3, 4, 4, 5, 4, 5 },
+  // Offsets for source bytes 5 to 8 for pixels 8 to 11.
+  { 5, 6, 6, 7, 6, 7, 7, 8, 128, 128, 128, 128, 128, 128, 128, 128 },
+  // Coefficients for pixels 0 to 7.
+  { 64, 0, 21, 43, 43, 21, 64, 0, 21, 43, 43, 21, 64, 0, 21, 43 },
+  // Coefficients for pixels 8 to 11.
+  { 43, 21, 64, 0, 21, 43, 43, 21, 0, 0, 0, 0, 0, 0, 0, 0 }
+};
+
+// Shuffle and coefficients, in 64ths, for a 4/3 upscale.
+extern "C" TALIGN16(const uint8, up43[2][16]) = {
+  // Offsets for source bytes 0 to 6 for 8 pixels.
+  { 0, 1, 0, 1, 1, 2, 2, 3, 3, 4, 3, 4, 4, 5, 5, 6 },
+  // Coefficients for 8 pixels.
+  { 64, 0, 16, 48, 32, 32, 48, 16, 64, 0, 16, 48, 32, 32, 48, 16 }
+};
+
+// Masks for the MMX 3/4 point sampler, which keeps bytes 0,1,3,4,5,7 of 8.
+extern "C" TALIGN16(const uint8, mask34[16]) =
+  { 255, 255, 0, 0, 0, 255, 0, 0, 0, 0, 255, 255, 255, 0, 0, 0 };
+
+// Masks for the MMX 3/8 point sampler, which keeps bytes 0,3,6 of 8.
+extern "C" TALIGN16(const uint8, mask38[16]) =
+  { 255, 0, 255, 0, 0, 0, 0, 0, 0, 255, 0, 0, 0, 0, 0, 0 };
+
+// Scaling values for the MMX 3/8 box filter, which sums 3x3 and 2x3 boxes
+// of 3 rows, then 3x2 and 2x2 boxes of 2 rows.
+extern "C" TALIGN16(const uint16, scale38[8]) =
+  { 65536 / 9, 65536 / 9, 65536 / 6, 0, 65536 / 6, 65536 / 6, 65536 / 4, 0 };
 #endif
 
 #if defined(WIN32) && !defined(COVERAGE_ENABLED)
@@ -855,6 +904,661 @@ static void ScaleRowDown8Int_SSE2(const uint8* src_ptr, int src_stride,
   }
 }
 
+// MMX versions of the row functions above for processors with SSE but not
+// SSE2.  pavgb, pavgw and psadbw are SSE instructions.
+// Reads 16 pixels, throws half away and writes 8 pixels.
+// No alignment requirement.
+#define HAS_SCALEROWDOWN2_SSE
+__declspec(naked)
+static void ScaleRowDown2_SSE(const uint8* src_ptr, int src_stride,
+                              uint8* dst_ptr, int dst_width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+                                     // src_stride ignored
+    mov        edx, [esp + 12]       // dst_ptr
+    mov        ecx, [esp + 16]       // dst_width
+    pcmpeqb    mm5, mm5              // generate mask 0x00ff00ff
+    psrlw      mm5, 8
+
+  wloop:
+    movq       mm0, [eax]
+    movq       mm1, [eax + 8]
+    lea        eax,  [eax + 16]
+    pand       mm0, mm5
+    pand       mm1, mm5
+    packuswb   mm0, mm1
+    movq       [edx], mm0
+    lea        edx, [edx + 8]
+    sub        ecx, 8
+    ja         wloop
+
+    emms
+    ret
+  }
+}
+
+// Blends 16x2 rectangle to 8x1.
+__declspec(naked)
+static void ScaleRowDown2Int_SSE(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  __asm {
+    push       esi
+    mov        eax, [esp + 4 + 4]    // src_ptr
+    mov        esi, [esp + 4 + 8]    // src_stride
+    mov        edx, [esp + 4 + 12]   // dst_ptr
+    mov        ecx, [esp + 4 + 16]   // dst_width
+    pcmpeqb    mm5, mm5              // generate mask 0x00ff00ff
+    psrlw      mm5, 8
+
+  wloop:
+    movq       mm0, [eax]
+    movq       mm1, [eax + 8]
+    movq       mm2, [eax + esi]
+    movq       mm3, [eax + esi + 8]
+    lea        eax,  [eax + 16]
+    pavgb      mm0, mm2              // average rows
+    pavgb      mm1, mm3
+
+    movq       mm2, mm0              // average columns (16 to 8 pixels)
+    psrlw      mm0, 8
+    movq       mm3, mm1
+    psrlw      mm1, 8
+    pand       mm2, mm5
+    pand       mm3, mm5
+    pavgw      mm0, mm2
+    pavgw      mm1, mm3
+    packuswb   mm0, mm1
+
+    movq       [edx], mm0
+    lea        edx, [edx + 8]
+    sub        ecx, 8
+    ja         wloop
+
+    emms
+    pop        esi
+    ret
+  }
+}
+
+#define HAS_SCALEROWDOWN4_SSE
+// Point samples 16 pixels to 4 pixels.
+__declspec(naked)
+static void ScaleRowDown4_SSE(const uint8* src_ptr, int src_stride,
+                              uint8* dst_ptr, int dst_width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+                                     // src_stride ignored
+    mov        edx, [esp + 12]       // dst_ptr
+    mov        ecx, [esp + 16]       // dst_width
+    pcmpeqb    mm5, mm5              // generate mask 0x000000ff
+    psrld      mm5, 24
+
+  wloop:
+    movq       mm0, [eax]
+    movq       mm1, [eax + 8]
+    lea        eax,  [eax + 16]
+    pand       mm0, mm5
+    pand       mm1, mm5
+    packuswb   mm0, mm1
+    packuswb   mm0, mm0
+    movd       dword ptr [edx], mm0
+    lea        edx, [edx + 4]
+    sub        ecx, 4
+    ja         wloop
+
+    emms
+    ret
+  }
+}
+
+// Blends 16x4 rectangle to 4x1.
+__declspec(naked)
+static void ScaleRowDown4Int_SSE(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  __asm {
+    pushad
+    mov        esi, [esp + 32 + 4]   // src_ptr
+    mov        ebx, [esp + 32 + 8]   // src_stride
+    mov        edi, [esp + 32 + 12]  // dst_ptr
+    mov        ecx, [esp + 32 + 16]  // dst_width
+    pcmpeqb    mm7, mm7              // generate mask 0x00ff00ff
+    psrlw      mm7, 8
+    lea        edx, [ebx + ebx * 2]  // src_stride * 3
+
+  wloop:
+    movq       mm0, [esi]
+    movq       mm1, [esi + 8]
+    movq       mm2, [esi + ebx]
+    movq       mm3, [esi + ebx + 8]
+    pavgb      mm0, mm2              // average rows
+    pavgb      mm1, mm3
+    movq       mm2, [esi + ebx * 2]
+    movq       mm3, [esi + ebx * 2 + 8]
+    movq       mm4, [esi + edx]
+    movq       mm5, [esi + edx + 8]
+    lea        esi, [esi + 16]
+    pavgb      mm2, mm4
+    pavgb      mm0, mm2
+    pavgb      mm3, mm5
+    pavgb      mm1, mm3
+
+    movq       mm2, mm0              // average columns (16 to 8 pixels)
+    psrlw      mm0, 8
+    movq       mm3, mm1
+    psrlw      mm1, 8
+    pand       mm2, mm7
+    pand       mm3, mm7
+    pavgw      mm0, mm2
+    pavgw      mm1, mm3
+    packuswb   mm0, mm1
+
+    movq       mm2, mm0              // average columns (8 to 4 pixels)
+    psrlw      mm0, 8
+    pand       mm2, mm7
+    pavgw      mm0, mm2
+    packuswb   mm0, mm0
+
+    movd       dword ptr [edi], mm0
+    lea        edi, [edi + 4]
+    sub        ecx, 4
+    ja         wloop
+
+    emms
+    popad
+    ret
+  }
+}
+
+#define HAS_SCALEROWDOWN8_SSE
+// Point samples 32 pixels to 4 pixels.
+__declspec(naked)
+static void ScaleRowDown8_SSE(const uint8* src_ptr, int src_stride,
+                              uint8* dst_ptr, int dst_width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+                                     // src_stride ignored
+    mov        edx, [esp + 12]       // dst_ptr
+    mov        ecx, [esp + 16]       // dst_width
+    pcmpeqb    mm5, mm5              // generate mask isolating 1 src 8 bytes
+    psrlq      mm5, 56
+
+  wloop:
+    movq       mm0, [eax]
+    movq       mm1, [eax + 8]
+    movq       mm2, [eax + 16]
+    movq       mm3, [eax + 24]
+    lea        eax,  [eax + 32]
+    pand       mm0, mm5
+    pand       mm1, mm5
+    pand       mm2, mm5
+    pand       mm3, mm5
+    packssdw   mm0, mm1              // 32->16
+    packssdw   mm2, mm3
+    packssdw   mm0, mm2              // 16->8
+    packuswb   mm0, mm0              // 8->4
+    movd       dword ptr [edx], mm0
+    lea        edx, [edx + 4]
+    sub        ecx, 4
+    ja         wloop
+
+    emms
+    ret
+  }
+}
+
+// Averages 32x8 rectangle to 4x1.  psadbw sums each 8 pixels of a row, so
+// the 64 pixels of each box are summed exactly and rounded once.
+__declspec(naked)
+static void ScaleRowDown8Int_SSE(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  __asm {
+    push       esi
+    push       ebx
+    mov        esi, [esp + 8 + 4]    // src_ptr
+    mov        ebx, [esp + 8 + 8]    // src_stride
+    mov        edx, [esp + 8 + 12]   // dst_ptr
+    mov        ecx, [esp + 8 + 16]   // dst_width
+    pxor       mm7, mm7
+    pcmpeqb    mm6, mm6              // generate rounding 0x0020
+    psrlw      mm6, 15
+    psllw      mm6, 5
+
+  wloop:
+    mov        eax, esi
+    movq       mm0, [eax]            // sum 8 pixels of each row
+    movq       mm1, [eax + 8]
+    movq       mm2, [eax + 16]
+    movq       mm3, [eax + 24]
+    psadbw     mm0, mm7
+    psadbw     mm1, mm7
+    psadbw     mm2, mm7
+    psadbw     mm3, mm7
+    add        eax, ebx              // next row
+    movq       mm4, [eax]
+    psadbw     mm4, mm7
+    paddw      mm0, mm4
+    movq       mm4, [eax + 8]
+    psadbw     mm4, mm7
+    paddw      mm1, mm4
+    movq       mm4, [eax + 16]
+    psadbw     mm4, mm7
+    paddw      mm2, mm4
+    movq       mm4, [eax + 24]
+    psadbw     mm4, mm7
+    paddw      mm3, mm4
+    add        eax, ebx
+    movq       mm4, [eax]
+    psadbw     mm4, mm7
+    paddw      mm0, mm4
+    movq       mm4, [eax + 8]
+    psadbw     mm4, mm7
+    paddw      mm1, mm4
+    movq       mm4, [eax + 16]
+    psadbw     mm4, mm7
+    paddw      mm2, mm4
+    movq       mm4, [eax + 24]
+    psadbw     mm4, mm7
+    paddw      mm3, mm4
+    add        eax, ebx
+    movq       mm4, [eax]
+    psadbw     mm4, mm7
+    paddw      mm0, mm4
+    movq       mm4, [eax + 8]
+    psadbw     mm4, mm7
+    paddw      mm1, mm4
+    movq       mm4, [eax + 16]
+    psadbw     mm4, mm7
+    paddw      mm2, mm4
+    movq       mm4, [eax + 24]
+    psadbw     mm4, mm7
+    paddw      mm3, mm4
+    add        eax, ebx
+    movq       mm4, [eax]
+    psadbw     mm4, mm7
+    paddw      mm0, mm4
+    movq       mm4, [eax + 8]
+    psadbw     mm4, mm7
+    paddw      mm1, mm4
+    movq       mm4, [eax + 16]
+    psadbw     mm4, mm7
+    paddw      mm2, mm4
+    movq       mm4, [eax + 24]
+    psadbw     mm4, mm7
+    paddw      mm3, mm4
+    add        eax, ebx
+    movq       mm4, [eax]
+    psadbw     mm4, mm7
+    paddw      mm0, mm4
+    movq       mm4, [eax + 8]
+    psadbw     mm4, mm7
+    paddw      mm1, mm4
+    movq       mm4, [eax + 16]
+    psadbw     mm4, mm7
+    paddw      mm2, mm4
+    movq       mm4, [eax + 24]
+    psadbw     mm4, mm7
+    paddw      mm3, mm4
+    add        eax, ebx
+    movq       mm4, [eax]
+    psadbw     mm4, mm7
+    paddw      mm0, mm4
+    movq       mm4, [eax + 8]
+    psadbw     mm4, mm7
+    paddw      mm1, mm4
+    movq       mm4, [eax + 16]
+    psadbw     mm4, mm7
+    paddw      mm2, mm4
+    movq       mm4, [eax + 24]
+    psadbw     mm4, mm7
+    paddw      mm3, mm4
+    add        eax, ebx
+    movq       mm4, [eax]
+    psadbw     mm4, mm7
+    paddw      mm0, mm4
+    movq       mm4, [eax + 8]
+    psadbw     mm4, mm7
+    paddw      mm1, mm4
+    movq       mm4, [eax + 16]
+    psadbw     mm4, mm7
+    paddw      mm2, mm4
+    movq       mm4, [eax + 24]
+    psadbw     mm4, mm7
+    paddw      mm3, mm4
+
+    punpcklwd  mm0, mm1              // 4 sums of 64 pixels
+    punpcklwd  mm2, mm3
+    punpckldq  mm0, mm2
+    paddw      mm0, mm6
+    psrlw      mm0, 6
+    packuswb   mm0, mm0
+    movd       dword ptr [edx], mm0
+
+    lea        esi, [esi + 32]
+    lea        edx, [edx + 4]
+    sub        ecx, 4
+    ja         wloop
+
+    emms
+    pop        ebx
+    pop        esi
+    ret
+  }
+}
+
+#define HAS_SCALEROWDOWN34_SSE
+// Point samples 8 pixels to 6 pixels.  pshufw copies word 3 next to word 0
+// and masks keep bytes 0,1 and 7; the rest come from the source shifted by
+// one byte.  The 6 pixels are stored as 2 overlapping dwords.
+__declspec(naked)
+static void ScaleRowDown34_SSE(const uint8* src_ptr, int src_stride,
+                               uint8* dst_ptr, int dst_width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+                                     // src_stride ignored
+    mov        edx, [esp + 12]       // dst_ptr
+    mov        ecx, [esp + 16]       // dst_width
+    movq       mm6, qword ptr _mask34
+    movq       mm7, qword ptr [_mask34 + 8]
+
+  wloop:
+    movq       mm0, [eax]
+    lea        eax, [eax + 8]
+    movq       mm1, mm0
+    pshufw     mm0, mm0, 0xf0
+    psrlq      mm1, 8
+    pand       mm0, mm6
+    pand       mm1, mm7
+    por        mm0, mm1
+    movd       dword ptr [edx], mm0
+    psrlq      mm0, 16
+    movd       dword ptr [edx + 2], mm0
+    lea        edx, [edx + 6]
+    sub        ecx, 6
+    ja         wloop
+
+    emms
+    ret
+  }
+}
+
+#define HAS_SCALEROWDOWN38_SSE
+// Point samples 16 pixels to 6 pixels, 3 from each 8.  pshufw moves byte 6
+// to byte 2 and the source shifted by 2 bytes supplies byte 3.
+__declspec(naked)
+static void ScaleRowDown38_SSE(const uint8* src_ptr, int src_stride,
+                               uint8* dst_ptr, int dst_width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+                                     // src_stride ignored
+    mov        edx, [esp + 12]       // dst_ptr
+    mov        ecx, [esp + 16]       // dst_width
+    movq       mm6, qword ptr _mask38
+    movq       mm7, qword ptr [_mask38 + 8]
+
+  wloop:
+    movq       mm0, [eax]
+    movq       mm2, [eax + 8]
+    lea        eax, [eax + 16]
+    movq       mm1, mm0
+    movq       mm3, mm2
+    pshufw     mm0, mm0, 0x0c
+    pshufw     mm2, mm2, 0x0c
+    psrlq      mm1, 16
+    psrlq      mm3, 16
+    pand       mm0, mm6
+    pand       mm2, mm6
+    pand       mm1, mm7
+    pand       mm3, mm7
+    por        mm0, mm1
+    por        mm2, mm3
+    psllq      mm2, 24
+    por        mm0, mm2
+    movd       dword ptr [edx], mm0
+    psrlq      mm0, 16
+    movd       dword ptr [edx + 2], mm0
+    lea        edx, [edx + 6]
+    sub        ecx, 6
+    ja         wloop
+
+    emms
+    ret
+  }
+}
+
+// Box filters 16x3 to 6x1.  Each 8 columns are summed as words, the sums of
+// columns 0-2, 3-5 and 6-7 are gathered with pshufw into words 0, 1 and 2,
+// and pmulhuw divides them exactly as ScaleRowDown38_3_Int_C does.
+__declspec(naked)
+static void ScaleRowDown38_3_Int_SSE(const uint8* src_ptr, int src_stride,
+                                     uint8* dst_ptr, int dst_width) {
+  __asm {
+    pushad
+    mov        esi, [esp + 32 + 4]   // src_ptr
+    mov        ebx, [esp + 32 + 8]   // src_stride
+    mov        edi, [esp + 32 + 12]  // dst_ptr
+    mov        ecx, [esp + 32 + 16]  // dst_width
+    pxor       mm7, mm7
+    movq       mm6, qword ptr _scale38
+
+  wloop:
+    movq       mm0, [esi]
+    movq       mm2, [esi + ebx]
+    movq       mm1, mm0
+    movq       mm3, mm2
+    punpcklbw  mm0, mm7
+    punpckhbw  mm1, mm7
+    punpcklbw  mm2, mm7
+    punpckhbw  mm3, mm7
+    paddw      mm0, mm2
+    paddw      mm1, mm3
+    movq       mm2, [esi + ebx * 2]
+    movq       mm3, mm2
+    punpcklbw  mm2, mm7
+    punpckhbw  mm3, mm7
+    paddw      mm0, mm2
+    paddw      mm1, mm3
+    movq       mm2, mm0              // sum columns 0-2 and 3
+    psrlq      mm2, 16
+    movq       mm3, mm0
+    psrlq      mm3, 32
+    paddw      mm0, mm2
+    paddw      mm0, mm3
+    movq       mm2, mm1              // sum columns 4-5 and 6-7
+    psrlq      mm2, 16
+    paddw      mm1, mm2
+    pshufw     mm0, mm0, 0xc0        // gather sums into words 0, 1, 2
+    psrlq      mm0, 32
+    pshufw     mm1, mm1, 0x08
+    psllq      mm1, 16
+    paddw      mm0, mm1
+    pmulhuw    mm0, mm6
+    packuswb   mm0, mm7
+    movq       mm4, mm0
+    movq       mm0, [esi + 8]
+    movq       mm2, [esi + ebx + 8]
+    movq       mm1, mm0
+    movq       mm3, mm2
+    punpcklbw  mm0, mm7
+    punpckhbw  mm1, mm7
+    punpcklbw  mm2, mm7
+    punpckhbw  mm3, mm7
+    paddw      mm0, mm2
+    paddw      mm1, mm3
+    movq       mm2, [esi + ebx * 2 + 8]
+    movq       mm3, mm2
+    punpcklbw  mm2, mm7
+    punpckhbw  mm3, mm7
+    paddw      mm0, mm2
+    paddw      mm1, mm3
+    movq       mm2, mm0              // sum columns 0-2 and 3
+    psrlq      mm2, 16
+    movq       mm3, mm0
+    psrlq      mm3, 32
+    paddw      mm0, mm2
+    paddw      mm0, mm3
+    movq       mm2, mm1              // sum columns 4-5 and 6-7
+    psrlq      mm2, 16
+    paddw      mm1, mm2
+    pshufw     mm0, mm0, 0xc0        // gather sums into words 0, 1, 2
+    psrlq      mm0, 32
+    pshufw     mm1, mm1, 0x08
+    psllq      mm1, 16
+    paddw      mm0, mm1
+    pmulhuw    mm0, mm6
+    packuswb   mm0, mm7
+    lea        esi, [esi + 16]
+    psllq      mm0, 24
+    por        mm0, mm4
+    movd       dword ptr [edi], mm0  // store 6 pixels as 2 dwords
+    psrlq      mm0, 16
+    movd       dword ptr [edi + 2], mm0
+    lea        edi, [edi + 6]
+    sub        ecx, 6
+    ja         wloop
+
+    emms
+    popad
+    ret
+  }
+}
+
+// Box filters 16x2 to 6x1.  Same as ScaleRowDown38_2_Int_C.
+__declspec(naked)
+static void ScaleRowDown38_2_Int_SSE(const uint8* src_ptr, int src_stride,
+                                     uint8* dst_ptr, int dst_width) {
+  __asm {
+    pushad
+    mov        esi, [esp + 32 + 4]   // src_ptr
+    mov        ebx, [esp + 32 + 8]   // src_stride
+    mov        edi, [esp + 32 + 12]  // dst_ptr
+    mov        ecx, [esp + 32 + 16]  // dst_width
+    pxor       mm7, mm7
+    movq       mm6, qword ptr [_scale38 + 8]
+
+  wloop:
+    movq       mm0, [esi]
+    movq       mm2, [esi + ebx]
+    movq       mm1, mm0
+    movq       mm3, mm2
+    punpcklbw  mm0, mm7
+    punpckhbw  mm1, mm7
+    punpcklbw  mm2, mm7
+    punpckhbw  mm3, mm7
+    paddw      mm0, mm2
+    paddw      mm1, mm3
+    movq       mm2, mm0              // sum columns 0-2 and 3
+    psrlq      mm2, 16
+    movq       mm3, mm0
+    psrlq      mm3, 32
+    paddw      mm0, mm2
+    paddw      mm0, mm3
+    movq       mm2, mm1              // sum columns 4-5 and 6-7
+    psrlq      mm2, 16
+    paddw      mm1, mm2
+    pshufw     mm0, mm0, 0xc0        // gather sums into words 0, 1, 2
+    psrlq      mm0, 32
+    pshufw     mm1, mm1, 0x08
+    psllq      mm1, 16
+    paddw      mm0, mm1
+    pmulhuw    mm0, mm6
+    packuswb   mm0, mm7
+    movq       mm4, mm0
+    movq       mm0, [esi + 8]
+    movq       mm2, [esi + ebx + 8]
+    movq       mm1, mm0
+    movq       mm3, mm2
+    punpcklbw  mm0, mm7
+    punpckhbw  mm1, mm7
+    punpcklbw  mm2, mm7
+    punpckhbw  mm3, mm7
+    paddw      mm0, mm2
+    paddw      mm1, mm3
+    movq       mm2, mm0              // sum columns 0-2 and 3
+    psrlq      mm2, 16
+    movq       mm3, mm0
+    psrlq      mm3, 32
+    paddw      mm0, mm2
+    paddw      mm0, mm3
+    movq       mm2, mm1              // sum columns 4-5 and 6-7
+    psrlq      mm2, 16
+    paddw      mm1, mm2
+    pshufw     mm0, mm0, 0xc0        // gather sums into words 0, 1, 2
+    psrlq      mm0, 32
+    pshufw     mm1, mm1, 0x08
+    psllq      mm1, 16
+    paddw      mm0, mm1
+    pmulhuw    mm0, mm6
+    packuswb   mm0, mm7
+    lea        esi, [esi + 16]
+    psllq      mm0, 24
+    por        mm0, mm4
+    movd       dword ptr [edi], mm0  // store 6 pixels as 2 dwords
+    psrlq      mm0, 16
+    movd       dword ptr [edi + 2], mm0
+    lea        edi, [edi + 6]
+    sub        ecx, 6
+    ja         wloop
+
+    emms
+    popad
+    ret
+  }
+}
+
+#define HAS_SCALEADDROWS_MMX
+// Reads 8xN bytes and produces 8 shorts at a time.
+__declspec(naked)
+static void ScaleAddRows_MMX(const uint8* src_ptr, int src_stride,
+                             uint16* dst_ptr, int src_width,
+                             int src_height) {
+  __asm {
+    pushad
+    mov        esi, [esp + 32 + 4]   // src_ptr
+    mov        edx, [esp + 32 + 8]   // src_stride
+    mov        edi, [esp + 32 + 12]  // dst_ptr
+    mov        ecx, [esp + 32 + 16]  // dst_width
+    mov        ebx, [esp + 32 + 20]  // height
+    pxor       mm5, mm5
+    dec        ebx
+
+  xloop:
+    // first row
+    movq       mm2, [esi]
+    lea        eax, [esi + edx]
+    movq       mm3, mm2
+    mov        ebp, ebx
+    punpcklbw  mm2, mm5
+    punpckhbw  mm3, mm5
+    test       ebp, ebp
+    je         ydone
+
+    // sum remaining rows
+  yloop:
+    movq       mm0, [eax]        // read 8 pixels
+    lea        eax, [eax + edx]  // advance to next row
+    movq       mm1, mm0
+    punpcklbw  mm0, mm5
+    punpckhbw  mm1, mm5
+    paddusw    mm2, mm0          // sum 8 words
+    paddusw    mm3, mm1
+    sub        ebp, 1
+    ja         yloop
+
+  ydone:
+    movq       [edi], mm2
+    movq       [edi + 8], mm3
+    lea        edi, [edi + 16]
+    lea        esi, [esi + 8]
+
+    sub        ecx, 8
+    ja         xloop
+
+    emms
+    popad
+    ret
+  }
+}
+
 #define HAS_SCALEROWDOWN34_SSSE3
 // Point samples 32 pixels to 24 pixels.
 // Produces three 8 byte values.  For each 8 bytes, 16 bytes are read.
@@ -1221,6 +1925,41 @@ static void ScaleAddRows_SSE2(const uint8* src_ptr, int src_stride,
   }
 }
 
+#define HAS_SCALEINTEGRATEROW_SSE2
+// Running sum of 4 shorts at a time: dst_ptr[x] is the sum of src_ptr[0]
+// to src_ptr[x].  Each 4 are summed by adding shifted copies, and then the
+// total of the previous 4 is added.
+__declspec(naked)
+static void ScaleIntegrateRow_SSE2(const uint16* src_ptr, uint32* dst_ptr,
+                                   int width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+    mov        edx, [esp + 8]        // dst_ptr
+    mov        ecx, [esp + 12]       // width
+    pxor       xmm5, xmm5
+    pxor       xmm4, xmm4            // total so far
+
+  wloop:
+    movq       xmm0, qword ptr [eax]
+    lea        eax, [eax + 8]
+    punpcklwd  xmm0, xmm5
+    movdqa     xmm1, xmm0
+    pslldq     xmm1, 4
+    paddd      xmm0, xmm1
+    movdqa     xmm1, xmm0
+    pslldq     xmm1, 8
+    paddd      xmm0, xmm1
+    paddd      xmm0, xmm4
+    pshufd     xmm4, xmm0, 0xff
+    movdqu     [edx], xmm0
+    lea        edx, [edx + 16]
+    sub        ecx, 4
+    ja         wloop
+
+    ret
+  }
+}
+
 // Bilinear row filtering combines 16x2 -> 16x1. SSE2 version.
 #define HAS_SCALEFILTERROWS_SSE2
 __declspec(naked)
@@ -1326,8 +2065,8 @@ static void ScaleFilterRows_SSSE3(uint8* dst_ptr, const uint8* src_ptr,
     mov        edx, [esp + 8 + 12]  // src_stride
     mov        ecx, [esp + 8 + 16]  // dst_width
     mov        eax, [esp + 8 + 20]  // source_y_fraction (0..255)
-    cmp        eax, 0
-    je         xloop1
+    cmp        eax, 2               // 0 and 1 are 0 in 7 bits
+    jb         xloop1
     cmp        eax, 128
     je         xloop2
 
@@ -1442,1177 +2181,3516 @@ static void ScaleFilterCols34_SSSE3(uint8* dst_ptr, const uint8* src_ptr,
   }
 }
 
-#elif (defined(__x86_64__) || defined(__i386__)) && \
-    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+// Bilinear column filtering.  The 16.16 positions are stepped in general
+// purpose registers, which gather each pair of source pixels and the
+// fraction into words.  The row is then filtered as
+//   a + ((b - a) * f >> 16)
+// which equals (a * (65536 - f) + b * f) >> 16 exactly.  pmulhw treats
+// fractions of 0x8000 and above as negative, so (b - a) is added back for
+// those.
+#define HAS_SCALEFILTERCOLS_SSE2
+__declspec(naked)
+static void ScaleFilterCols_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                 int dst_width, int x, int dx) {
+  __asm {
+    push       esi
+    push       edi
+    push       ebx
+    mov        edi, [esp + 12 + 4]    // dst_ptr
+    mov        esi, [esp + 12 + 8]    // src_ptr
+    mov        ecx, [esp + 12 + 12]    // dst_width
+    mov        ebx, [esp + 12 + 16]    // x
+    mov        edx, [esp + 12 + 20]    // dx
+    pcmpeqb    xmm7, xmm7
+    psrlw      xmm7, 8
 
-// GCC versions of row functions are verbatim conversions from Visual C.
-// Generated using gcc disassembly on Visual C object file:
-// objdump -D yuvscaler.obj >yuvscaler.txt
-#define HAS_SCALEROWDOWN2_SSE2
-static void ScaleRowDown2_SSE2(const uint8* src_ptr, int src_stride,
-                               uint8* dst_ptr, int dst_width) {
-  asm volatile (
-  "pcmpeqb    %%xmm5,%%xmm5                    \n"
-  "psrlw      $0x8,%%xmm5                      \n"
-"1:"
-  "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     0x10(%0),%%xmm1                  \n"
-  "lea        0x20(%0),%0                      \n"
-  "pand       %%xmm5,%%xmm0                    \n"
-  "pand       %%xmm5,%%xmm1                    \n"
-  "packuswb   %%xmm1,%%xmm0                    \n"
-  "movdqa     %%xmm0,(%1)                      \n"
-  "lea        0x10(%1),%1                      \n"
-  "sub        $0x10,%2                         \n"
-  "ja         1b                               \n"
-  : "+r"(src_ptr),    // %0
-    "+r"(dst_ptr),    // %1
-    "+r"(dst_width)   // %2
-  :
-  : "memory", "cc"
-);
+  wloop:
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]    // pixels x and x + 1
+    pinsrw     xmm0, eax, 0
+    pinsrw     xmm1, ebx, 0       // fraction
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     xmm0, eax, 1
+    pinsrw     xmm1, ebx, 1
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     xmm0, eax, 2
+    pinsrw     xmm1, ebx, 2
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     xmm0, eax, 3
+    pinsrw     xmm1, ebx, 3
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     xmm0, eax, 4
+    pinsrw     xmm1, ebx, 4
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     xmm0, eax, 5
+    pinsrw     xmm1, ebx, 5
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     xmm0, eax, 6
+    pinsrw     xmm1, ebx, 6
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     xmm0, eax, 7
+    pinsrw     xmm1, ebx, 7
+    add        ebx, edx
+    movdqa     xmm2, xmm0
+    pand       xmm0, xmm7         // a
+    psrlw      xmm2, 8            // b
+    psubw      xmm2, xmm0         // b - a
+    movdqa     xmm3, xmm1
+    psraw      xmm3, 15
+    pand       xmm3, xmm2
+    pmulhw     xmm2, xmm1
+    paddw      xmm2, xmm3
+    paddw      xmm2, xmm0
+    packuswb   xmm2, xmm2
+    movq       qword ptr [edi], xmm2
+    lea        edi, [edi + 8]
+    sub        ecx, 8
+    ja         wloop
+
+    pop        ebx
+    pop        edi
+    pop        esi
+    ret
+  }
 }
 
-static void ScaleRowDown2Int_SSE2(const uint8* src_ptr, int src_stride,
-                                  uint8* dst_ptr, int dst_width) {
-  asm volatile (
-  "pcmpeqb    %%xmm5,%%xmm5                    \n"
-  "psrlw      $0x8,%%xmm5                      \n"
-"1:"
-  "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     0x10(%0),%%xmm1                  \n"
-  "movdqa     (%0,%3,1),%%xmm2                 \n"
-  "movdqa     0x10(%0,%3,1),%%xmm3             \n"
-  "lea        0x20(%0),%0                      \n"
-  "pavgb      %%xmm2,%%xmm0                    \n"
-  "pavgb      %%xmm3,%%xmm1                    \n"
-  "movdqa     %%xmm0,%%xmm2                    \n"
-  "psrlw      $0x8,%%xmm0                      \n"
-  "movdqa     %%xmm1,%%xmm3                    \n"
-  "psrlw      $0x8,%%xmm1                      \n"
-  "pand       %%xmm5,%%xmm2                    \n"
-  "pand       %%xmm5,%%xmm3                    \n"
-  "pavgw      %%xmm2,%%xmm0                    \n"
-  "pavgw      %%xmm3,%%xmm1                    \n"
-  "packuswb   %%xmm1,%%xmm0                    \n"
-  "movdqa     %%xmm0,(%1)                      \n"
-  "lea        0x10(%1),%1                      \n"
-  "sub        $0x10,%2                         \n"
-  "ja         1b                               \n"
-  : "+r"(src_ptr),    // %0
-    "+r"(dst_ptr),    // %1
-    "+r"(dst_width)   // %2
-  : "r"(static_cast<intptr_t>(src_stride))   // %3
-  : "memory", "cc"
-);
+// Bilinear column filtering.  MMX version of ScaleFilterCols_SSE2 for
+// processors with SSE but not SSE2.  pinsrw is an SSE instruction.
+#define HAS_SCALEFILTERCOLS_SSE
+__declspec(naked)
+static void ScaleFilterCols_SSE(uint8* dst_ptr, const uint8* src_ptr,
+                                int dst_width, int x, int dx) {
+  __asm {
+    push       esi
+    push       edi
+    push       ebx
+    mov        edi, [esp + 12 + 4]    // dst_ptr
+    mov        esi, [esp + 12 + 8]    // src_ptr
+    mov        ecx, [esp + 12 + 12]    // dst_width
+    mov        ebx, [esp + 12 + 16]    // x
+    mov        edx, [esp + 12 + 20]    // dx
+    pcmpeqb    mm7, mm7
+    psrlw      mm7, 8
+
+  wloop:
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]    // pixels x and x + 1
+    pinsrw     mm0, eax, 0
+    pinsrw     mm1, ebx, 0        // fraction
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     mm0, eax, 1
+    pinsrw     mm1, ebx, 1
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     mm0, eax, 2
+    pinsrw     mm1, ebx, 2
+    add        ebx, edx
+    mov        eax, ebx
+    shr        eax, 16
+    movzx      eax, word ptr [esi + eax]
+    pinsrw     mm0, eax, 3
+    pinsrw     mm1, ebx, 3
+    add        ebx, edx
+    movq       mm2, mm0
+    pand       mm0, mm7           // a
+    psrlw      mm2, 8             // b
+    psubw      mm2, mm0           // b - a
+    movq       mm3, mm1
+    psraw      mm3, 15
+    pand       mm3, mm2
+    pmulhw     mm2, mm1
+    paddw      mm2, mm3
+    paddw      mm2, mm0
+    packuswb   mm2, mm2
+    movd       dword ptr [edi], mm2
+    lea        edi, [edi + 4]
+    sub        ecx, 4
+    ja         wloop
+
+    emms
+    pop        ebx
+    pop        edi
+    pop        esi
+    ret
+  }
 }
 
-#define HAS_SCALEROWDOWN4_SSE2
-static void ScaleRowDown4_SSE2(const uint8* src_ptr, int src_stride,
-                               uint8* dst_ptr, int dst_width) {
-  asm volatile (
-  "pcmpeqb    %%xmm5,%%xmm5                    \n"
-  "psrld      $0x18,%%xmm5                     \n"
-"1:"
-  "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     0x10(%0),%%xmm1                  \n"
-  "lea        0x20(%0),%0                      \n"
-  "pand       %%xmm5,%%xmm0                    \n"
-  "pand       %%xmm5,%%xmm1                    \n"
-  "packuswb   %%xmm1,%%xmm0                    \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movq       %%xmm0,(%1)                      \n"
-  "lea        0x8(%1),%1                       \n"
-  "sub        $0x8,%2                          \n"
-  "ja         1b                               \n"
-  : "+r"(src_ptr),    // %0
-    "+r"(dst_ptr),    // %1
-    "+r"(dst_width)   // %2
-  :
-  : "memory", "cc"
-);
+// Upscale a row by 2 by duplicating each pixel.
+// Alignment requirement: none.
+#define HAS_SCALECOLSUP2_SSE2
+__declspec(naked)
+static void ScaleColsUp2_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                              int dst_width) {
+  __asm {
+    mov        edx, [esp + 4]    // dst_ptr
+    mov        eax, [esp + 8]    // src_ptr
+    mov        ecx, [esp + 12]   // dst_width
+
+  wloop:
+    movdqu     xmm0, [eax]
+    lea        eax,  [eax + 16]
+    movdqa     xmm1, xmm0
+    punpcklbw  xmm0, xmm0
+    punpckhbw  xmm1, xmm1
+    movdqu     [edx], xmm0
+    movdqu     [edx + 16], xmm1
+    lea        edx,  [edx + 32]
+    sub        ecx, 32
+    ja         wloop
+    ret
+  }
 }
 
-static void ScaleRowDown4Int_SSE2(const uint8* src_ptr, int src_stride,
-                                  uint8* dst_ptr, int dst_width) {
-  intptr_t temp = 0;
-  asm volatile (
-  "pcmpeqb    %%xmm7,%%xmm7                    \n"
-  "psrlw      $0x8,%%xmm7                      \n"
-  "lea        (%4,%4,2),%3                     \n"
-"1:"
-  "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     0x10(%0),%%xmm1                  \n"
-  "movdqa     (%0,%4,1),%%xmm2                 \n"
-  "movdqa     0x10(%0,%4,1),%%xmm3             \n"
-  "pavgb      %%xmm2,%%xmm0                    \n"
-  "pavgb      %%xmm3,%%xmm1                    \n"
-  "movdqa     (%0,%4,2),%%xmm2                 \n"
-  "movdqa     0x10(%0,%4,2),%%xmm3             \n"
-  "movdqa     (%0,%3,1),%%xmm4                 \n"
-  "movdqa     0x10(%0,%3,1),%%xmm5             \n"
-  "lea        0x20(%0),%0                      \n"
-  "pavgb      %%xmm4,%%xmm2                    \n"
-  "pavgb      %%xmm2,%%xmm0                    \n"
-  "pavgb      %%xmm5,%%xmm3                    \n"
-  "pavgb      %%xmm3,%%xmm1                    \n"
-  "movdqa     %%xmm0,%%xmm2                    \n"
-  "psrlw      $0x8,%%xmm0                      \n"
-  "movdqa     %%xmm1,%%xmm3                    \n"
-  "psrlw      $0x8,%%xmm1                      \n"
-  "pand       %%xmm7,%%xmm2                    \n"
-  "pand       %%xmm7,%%xmm3                    \n"
-  "pavgw      %%xmm2,%%xmm0                    \n"
-  "pavgw      %%xmm3,%%xmm1                    \n"
-  "packuswb   %%xmm1,%%xmm0                    \n"
-  "movdqa     %%xmm0,%%xmm2                    \n"
-  "psrlw      $0x8,%%xmm0                      \n"
-  "pand       %%xmm7,%%xmm2                    \n"
-  "pavgw      %%xmm2,%%xmm0                    \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movq       %%xmm0,(%1)                      \n"
-  "lea        0x8(%1),%1                       \n"
-  "sub        $0x8,%2                          \n"
-  "ja         1b                               \n"
-  : "+r"(src_ptr),     // %0
-    "+r"(dst_ptr),     // %1
-    "+r"(dst_width),   // %2
-    "+r"(temp)         // %3
-  : "r"(static_cast<intptr_t>(src_stride))    // %4
-  : "memory", "cc"
-#if defined(__x86_64__)
-    , "xmm6", "xmm7"
-#endif
-);
+#define HAS_SCALECOLSUP2_MMX
+__declspec(naked)
+static void ScaleColsUp2_MMX(uint8* dst_ptr, const uint8* src_ptr,
+                             int dst_width) {
+  __asm {
+    mov        edx, [esp + 4]    // dst_ptr
+    mov        eax, [esp + 8]    // src_ptr
+    mov        ecx, [esp + 12]   // dst_width
+
+  wloop:
+    movq       mm0, [eax]
+    lea        eax,  [eax + 8]
+    movq       mm1, mm0
+    punpcklbw  mm0, mm0
+    punpckhbw  mm1, mm1
+    movq       [edx], mm0
+    movq       [edx + 8], mm1
+    lea        edx,  [edx + 16]
+    sub        ecx, 16
+    ja         wloop
+    emms
+    ret
+  }
 }
 
-#define HAS_SCALEROWDOWN8_SSE2
-static void ScaleRowDown8_SSE2(const uint8* src_ptr, int src_stride,
-                               uint8* dst_ptr, int dst_width) {
-  asm volatile (
-  "pcmpeqb    %%xmm5,%%xmm5                    \n"
-  "psrlq      $0x38,%%xmm5                     \n"
-"1:"
-  "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     0x10(%0),%%xmm1                  \n"
-  "lea        0x20(%0),%0                      \n"
-  "pand       %%xmm5,%%xmm0                    \n"
-  "pand       %%xmm5,%%xmm1                    \n"
-  "packuswb   %%xmm1,%%xmm0                    \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movd       %%xmm0,(%1)                      \n"
-  "lea        0x4(%1),%1                       \n"
-  "sub        $0x4,%2                          \n"
-  "ja         1b                               \n"
-  : "+r"(src_ptr),    // %0
-    "+r"(dst_ptr),    // %1
-    "+r"(dst_width)   // %2
-  :
-  : "memory", "cc"
-);
+// Bilinear upscale a row by 2.  Odd pixels are the average of their
+// neighbours, rounded down to match ScaleFilterCols_C.  pavgb rounds up, so
+// the low bit of a ^ b is subtracted.
+// Reads one pixel past the end of the source row.
+// Writes up to 31 pixels past dst_width.
+#define HAS_SCALEFILTERCOLSUP2_SSE2
+__declspec(naked)
+static void ScaleFilterColsUp2_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                    int dst_width, int, int) {
+  __asm {
+    mov        edx, [esp + 4]    // dst_ptr
+    mov        eax, [esp + 8]    // src_ptr
+    mov        ecx, [esp + 12]   // dst_width
+    pcmpeqb    xmm7, xmm7        // generate mask 0x01010101
+    psrlw      xmm7, 15
+    packuswb   xmm7, xmm7
+
+  wloop:
+    movdqu     xmm0, [eax]
+    movdqu     xmm1, [eax + 1]
+    lea        eax,  [eax + 16]
+    movdqa     xmm2, xmm0
+    pxor       xmm2, xmm1
+    pand       xmm2, xmm7
+    pavgb      xmm1, xmm0
+    psubb      xmm1, xmm2
+    movdqa     xmm3, xmm0
+    punpcklbw  xmm0, xmm1
+    punpckhbw  xmm3, xmm1
+    movdqu     [edx], xmm0
+    movdqu     [edx + 16], xmm3
+    lea        edx,  [edx + 32]
+    sub        ecx, 32
+    ja         wloop
+    ret
+  }
 }
 
-#if defined(__i386__)
-extern "C" void ScaleRowDown8Int_SSE2(const uint8* src_ptr, int src_stride,
-                                      uint8* dst_ptr, int dst_width);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleRowDown8Int_SSE2             \n"
-"_ScaleRowDown8Int_SSE2:                       \n"
-#else
-    ".global ScaleRowDown8Int_SSE2             \n"
-"ScaleRowDown8Int_SSE2:                        \n"
-#endif
-    "pusha                                     \n"
-    "mov    0x24(%esp),%esi                    \n"
-    "mov    0x28(%esp),%ebx                    \n"
-    "mov    0x2c(%esp),%edi                    \n"
-    "mov    0x30(%esp),%ecx                    \n"
-    "lea    (%ebx,%ebx,2),%edx                 \n"
-    "pxor   %xmm7,%xmm7                        \n"
+// MMX version of ScaleFilterColsUp2_SSE2.  pavgb is an SSE instruction.
+// Writes up to 15 pixels past dst_width.
+#define HAS_SCALEFILTERCOLSUP2_SSE
+__declspec(naked)
+static void ScaleFilterColsUp2_SSE(uint8* dst_ptr, const uint8* src_ptr,
+                                   int dst_width, int, int) {
+  __asm {
+    mov        edx, [esp + 4]    // dst_ptr
+    mov        eax, [esp + 8]    // src_ptr
+    mov        ecx, [esp + 12]   // dst_width
+    pcmpeqb    mm7, mm7          // generate mask 0x01010101
+    psrlw      mm7, 15
+    packuswb   mm7, mm7
 
-"1:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa 0x10(%esi),%xmm1                   \n"
-    "movdqa (%esi,%ebx,1),%xmm2                \n"
-    "movdqa 0x10(%esi,%ebx,1),%xmm3            \n"
-    "pavgb  %xmm2,%xmm0                        \n"
-    "pavgb  %xmm3,%xmm1                        \n"
-    "movdqa (%esi,%ebx,2),%xmm2                \n"
-    "movdqa 0x10(%esi,%ebx,2),%xmm3            \n"
-    "movdqa (%esi,%edx,1),%xmm4                \n"
-    "movdqa 0x10(%esi,%edx,1),%xmm5            \n"
-    "lea    (%esi,%ebx,4),%ebp                 \n"
-    "lea    0x20(%esi),%esi                    \n"
-    "pavgb  %xmm4,%xmm2                        \n"
-    "pavgb  %xmm5,%xmm3                        \n"
-    "pavgb  %xmm2,%xmm0                        \n"
-    "pavgb  %xmm3,%xmm1                        \n"
-    "movdqa 0x0(%ebp),%xmm2                    \n"
-    "movdqa 0x10(%ebp),%xmm3                   \n"
-    "movdqa 0x0(%ebp,%ebx,1),%xmm4             \n"
-    "movdqa 0x10(%ebp,%ebx,1),%xmm5            \n"
-    "pavgb  %xmm4,%xmm2                        \n"
-    "pavgb  %xmm5,%xmm3                        \n"
-    "movdqa 0x0(%ebp,%ebx,2),%xmm4             \n"
-    "movdqa 0x10(%ebp,%ebx,2),%xmm5            \n"
-    "movdqa 0x0(%ebp,%edx,1),%xmm6             \n"
-    "pavgb  %xmm6,%xmm4                        \n"
-    "movdqa 0x10(%ebp,%edx,1),%xmm6            \n"
-    "pavgb  %xmm6,%xmm5                        \n"
-    "pavgb  %xmm4,%xmm2                        \n"
-    "pavgb  %xmm5,%xmm3                        \n"
-    "pavgb  %xmm2,%xmm0                        \n"
-    "pavgb  %xmm3,%xmm1                        \n"
-    "psadbw %xmm7,%xmm0                        \n"
-    "psadbw %xmm7,%xmm1                        \n"
-    "pshufd $0xd8,%xmm0,%xmm0                  \n"
-    "pshufd $0x8d,%xmm1,%xmm1                  \n"
-    "por    %xmm1,%xmm0                        \n"
-    "psrlw  $0x3,%xmm0                         \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "movd   %xmm0,(%edi)                       \n"
-    "lea    0x4(%edi),%edi                     \n"
-    "sub    $0x4,%ecx                          \n"
-    "ja     1b                                 \n"
-    "popa                                      \n"
-    "ret                                       \n"
-);
+  wloop:
+    movq       mm0, [eax]
+    movq       mm1, [eax + 1]
+    lea        eax,  [eax + 8]
+    movq       mm2, mm0
+    pxor       mm2, mm1
+    pand       mm2, mm7
+    pavgb      mm1, mm0
+    psubb      mm1, mm2
+    movq       mm3, mm0
+    punpcklbw  mm0, mm1
+    punpckhbw  mm3, mm1
+    movq       [edx], mm0
+    movq       [edx + 8], mm3
+    lea        edx,  [edx + 16]
+    sub        ecx, 16
+    ja         wloop
+    emms
+    ret
+  }
+}
 
-// fpic is used for magiccam plugin
-#if !defined(__PIC__)
-#define HAS_SCALEROWDOWN34_SSSE3
-extern "C" void ScaleRowDown34_SSSE3(const uint8* src_ptr, int src_stride,
-                                     uint8* dst_ptr, int dst_width);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleRowDown34_SSSE3              \n"
-"_ScaleRowDown34_SSSE3:                        \n"
-#else
-    ".global ScaleRowDown34_SSSE3              \n"
-"ScaleRowDown34_SSSE3:                         \n"
-#endif
-    "pusha                                     \n"
-    "mov    0x24(%esp),%esi                    \n"
-    "mov    0x2c(%esp),%edi                    \n"
-    "mov    0x30(%esp),%ecx                    \n"
-    "movdqa _shuf0,%xmm3                       \n"
-    "movdqa _shuf1,%xmm4                       \n"
-    "movdqa _shuf2,%xmm5                       \n"
+// Bilinear upscale a row by 3/2.  8 source pixels make 12 destination
+// pixels, filtered with the coefficients in _up32.
+// Reads up to 16 pixels past the end of the source row.
+// Writes up to 15 pixels past dst_width.
+#define HAS_SCALEFILTERCOLSUP32_SSSE3
+__declspec(naked)
+static void ScaleFilterColsUp32_SSSE3(uint8* dst_ptr, const uint8* src_ptr,
+                                      int dst_width, int, int) {
+  __asm {
+    mov        edx, [esp + 4]    // dst_ptr
+    mov        eax, [esp + 8]    // src_ptr
+    mov        ecx, [esp + 12]   // dst_width
+    movdqa     xmm2, _up32
+    movdqa     xmm3, _up32 + 16
+    movdqa     xmm4, _up32 + 32
+    movdqa     xmm5, _up32 + 48
+    pcmpeqb    xmm6, xmm6        // generate rounding 32
+    psrlw      xmm6, 15
+    psllw      xmm6, 5
 
-"1:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa 0x10(%esi),%xmm2                   \n"
-    "lea    0x20(%esi),%esi                    \n"
-    "movdqa %xmm2,%xmm1                        \n"
-    "palignr $0x8,%xmm0,%xmm1                  \n"
-    "pshufb %xmm3,%xmm0                        \n"
-    "pshufb %xmm4,%xmm1                        \n"
-    "pshufb %xmm5,%xmm2                        \n"
-    "movq   %xmm0,(%edi)                       \n"
-    "movq   %xmm1,0x8(%edi)                    \n"
-    "movq   %xmm2,0x10(%edi)                   \n"
-    "lea    0x18(%edi),%edi                    \n"
-    "sub    $0x18,%ecx                         \n"
-    "ja     1b                                 \n"
-    "popa                                      \n"
-    "ret                                       \n"
-);
+  wloop:
+    movdqu     xmm0, [eax]
+    lea        eax,  [eax + 8]
+    movdqa     xmm1, xmm0
+    pshufb     xmm0, xmm2
+    pshufb     xmm1, xmm3
+    pmaddubsw  xmm0, xmm4
+    pmaddubsw  xmm1, xmm5
+    paddsw     xmm0, xmm6
+    paddsw     xmm1, xmm6
+    psrlw      xmm0, 6
+    psrlw      xmm1, 6
+    packuswb   xmm0, xmm1
+    movdqu     [edx], xmm0
+    lea        edx,  [edx + 12]
+    sub        ecx, 12
+    ja         wloop
+    ret
+  }
+}
 
-extern "C" void ScaleRowDown34_1_Int_SSSE3(const uint8* src_ptr, int src_stride,
-                                           uint8* dst_ptr, int dst_width);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleRowDown34_1_Int_SSSE3        \n"
-"_ScaleRowDown34_1_Int_SSSE3:                  \n"
-#else
-    ".global ScaleRowDown34_1_Int_SSSE3        \n"
-"ScaleRowDown34_1_Int_SSSE3:                   \n"
-#endif
-    "pusha                                     \n"
-    "mov    0x24(%esp),%esi                    \n"
-    "mov    0x28(%esp),%ebp                    \n"
-    "mov    0x2c(%esp),%edi                    \n"
-    "mov    0x30(%esp),%ecx                    \n"
-    "movdqa _shuf01,%xmm2                      \n"
-    "movdqa _shuf11,%xmm3                      \n"
-    "movdqa _shuf21,%xmm4                      \n"
-    "movdqa _madd01,%xmm5                      \n"
-    "movdqa _madd11,%xmm6                      \n"
-    "movdqa _round34,%xmm7                     \n"
+// Bilinear upscale a row by 4/3.  12 source pixels make 16 destination
+// pixels, filtered with the coefficients in _up43.
+// Reads up to 22 pixels past the end of the source row.
+// Writes up to 15 pixels past dst_width.
+#define HAS_SCALEFILTERCOLSUP43_SSSE3
+__declspec(naked)
+static void ScaleFilterColsUp43_SSSE3(uint8* dst_ptr, const uint8* src_ptr,
+                                      int dst_width, int, int) {
+  __asm {
+    mov        edx, [esp + 4]    // dst_ptr
+    mov        eax, [esp + 8]    // src_ptr
+    mov        ecx, [esp + 12]   // dst_width
+    movdqa     xmm2, _up43
+    movdqa     xmm4, _up43 + 16
+    pcmpeqb    xmm6, xmm6        // generate rounding 32
+    psrlw      xmm6, 15
+    psllw      xmm6, 5
 
-"1:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa (%esi,%ebp),%xmm1                  \n"
-    "pavgb  %xmm1,%xmm0                        \n"
-    "pshufb %xmm2,%xmm0                        \n"
-    "pmaddubsw %xmm5,%xmm0                     \n"
-    "paddsw %xmm7,%xmm0                        \n"
-    "psrlw  $0x2,%xmm0                         \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "movq   %xmm0,(%edi)                       \n"
-    "movdqu 0x8(%esi),%xmm0                    \n"
-    "movdqu 0x8(%esi,%ebp),%xmm1               \n"
-    "pavgb  %xmm1,%xmm0                        \n"
-    "pshufb %xmm3,%xmm0                        \n"
-    "pmaddubsw %xmm6,%xmm0                     \n"
-    "paddsw %xmm7,%xmm0                        \n"
-    "psrlw  $0x2,%xmm0                         \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "movq   %xmm0,0x8(%edi)                    \n"
-    "movdqa 0x10(%esi),%xmm0                   \n"
-    "movdqa 0x10(%esi,%ebp),%xmm1              \n"
-    "lea    0x20(%esi),%esi                    \n"
-    "pavgb  %xmm1,%xmm0                        \n"
-    "pshufb %xmm4,%xmm0                        \n"
-    "movdqa  _madd21,%xmm1                     \n"
-    "pmaddubsw %xmm1,%xmm0                     \n"
-    "paddsw %xmm7,%xmm0                        \n"
-    "psrlw  $0x2,%xmm0                         \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "movq   %xmm0,0x10(%edi)                   \n"
-    "lea    0x18(%edi),%edi                    \n"
-    "sub    $0x18,%ecx                         \n"
-    "ja     1b                                 \n"
+  wloop:
+    movdqu     xmm0, [eax]
+    movdqu     xmm1, [eax + 6]
+    lea        eax,  [eax + 12]
+    pshufb     xmm0, xmm2
+    pshufb     xmm1, xmm2
+    pmaddubsw  xmm0, xmm4
+    pmaddubsw  xmm1, xmm4
+    paddsw     xmm0, xmm6
+    paddsw     xmm1, xmm6
+    psrlw      xmm0, 6
+    psrlw      xmm1, 6
+    packuswb   xmm0, xmm1
+    movdqu     [edx], xmm0
+    lea        edx,  [edx + 16]
+    sub        ecx, 16
+    ja         wloop
+    ret
+  }
+}
 
-    "popa                                      \n"
-    "ret                                       \n"
-);
+// Blend 2 rows as (row0 * (256 - f) + row1 * f) >> 8.
+// Alignment requirement: src0_ptr and src1_ptr 16 byte aligned.
+#define HAS_SCALEBLENDROWS_SSE2
+__declspec(naked)
+static void ScaleBlendRows_SSE2(uint8* dst_ptr, const uint8* src0_ptr,
+                                const uint8* src1_ptr, int dst_width,
+                                int source_y_fraction) {
+  __asm {
+    push       esi
+    push       edi
+    mov        edi, [esp + 8 + 4]   // dst_ptr
+    mov        esi, [esp + 8 + 8]   // src0_ptr
+    mov        edx, [esp + 8 + 12]  // src1_ptr
+    mov        ecx, [esp + 8 + 16]  // dst_width
+    mov        eax, [esp + 8 + 20]  // source_y_fraction (0..255)
+    movd       xmm6, eax
+    punpcklwd  xmm6, xmm6
+    pshufd     xmm6, xmm6, 0
+    pcmpeqb    xmm5, xmm5        // generate 256 - source_y_fraction
+    psrlw      xmm5, 15
+    psllw      xmm5, 8
+    psubw      xmm5, xmm6
+    pxor       xmm7, xmm7
 
-extern "C" void ScaleRowDown34_0_Int_SSSE3(const uint8* src_ptr, int src_stride,
-                                           uint8* dst_ptr, int dst_width);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleRowDown34_0_Int_SSSE3        \n"
-"_ScaleRowDown34_0_Int_SSSE3:                  \n"
-#else
-    ".global ScaleRowDown34_0_Int_SSSE3        \n"
-"ScaleRowDown34_0_Int_SSSE3:                   \n"
-#endif
-    "pusha                                     \n"
-    "mov    0x24(%esp),%esi                    \n"
-    "mov    0x28(%esp),%ebp                    \n"
-    "mov    0x2c(%esp),%edi                    \n"
-    "mov    0x30(%esp),%ecx                    \n"
-    "movdqa _shuf01,%xmm2                      \n"
-    "movdqa _shuf11,%xmm3                      \n"
-    "movdqa _shuf21,%xmm4                      \n"
-    "movdqa _madd01,%xmm5                      \n"
-    "movdqa _madd11,%xmm6                      \n"
-    "movdqa _round34,%xmm7                     \n"
+  wloop:
+    movdqa     xmm0, [esi]
+    movdqa     xmm2, [edx]
+    lea        esi,  [esi + 16]
+    lea        edx,  [edx + 16]
+    movdqa     xmm1, xmm0
+    movdqa     xmm3, xmm2
+    punpcklbw  xmm0, xmm7
+    punpcklbw  xmm2, xmm7
+    punpckhbw  xmm1, xmm7
+    punpckhbw  xmm3, xmm7
+    pmullw     xmm0, xmm5
+    pmullw     xmm1, xmm5
+    pmullw     xmm2, xmm6
+    pmullw     xmm3, xmm6
+    paddw      xmm0, xmm2
+    paddw      xmm1, xmm3
+    psrlw      xmm0, 8
+    psrlw      xmm1, 8
+    packuswb   xmm0, xmm1
+    movdqu     [edi], xmm0
+    lea        edi,  [edi + 16]
+    sub        ecx, 16
+    ja         wloop
 
-"1:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa (%esi,%ebp,1),%xmm1                \n"
-    "pavgb  %xmm0,%xmm1                        \n"
-    "pavgb  %xmm1,%xmm0                        \n"
-    "pshufb %xmm2,%xmm0                        \n"
-    "pmaddubsw %xmm5,%xmm0                     \n"
-    "paddsw %xmm7,%xmm0                        \n"
-    "psrlw  $0x2,%xmm0                         \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "movq   %xmm0,(%edi)                       \n"
-    "movdqu 0x8(%esi),%xmm0                    \n"
-    "movdqu 0x8(%esi,%ebp,1),%xmm1             \n"
-    "pavgb  %xmm0,%xmm1                        \n"
-    "pavgb  %xmm1,%xmm0                        \n"
-    "pshufb %xmm3,%xmm0                        \n"
-    "pmaddubsw %xmm6,%xmm0                     \n"
-    "paddsw %xmm7,%xmm0                        \n"
-    "psrlw  $0x2,%xmm0                         \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "movq   %xmm0,0x8(%edi)                    \n"
-    "movdqa 0x10(%esi),%xmm0                   \n"
-    "movdqa 0x10(%esi,%ebp,1),%xmm1            \n"
-    "lea    0x20(%esi),%esi                    \n"
-    "pavgb  %xmm0,%xmm1                        \n"
-    "pavgb  %xmm1,%xmm0                        \n"
-    "pshufb %xmm4,%xmm0                        \n"
-    "movdqa  _madd21,%xmm1                     \n"
-    "pmaddubsw %xmm1,%xmm0                     \n"
-    "paddsw %xmm7,%xmm0                        \n"
-    "psrlw  $0x2,%xmm0                         \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "movq   %xmm0,0x10(%edi)                   \n"
-    "lea    0x18(%edi),%edi                    \n"
-    "sub    $0x18,%ecx                         \n"
-    "ja     1b                                 \n"
-    "popa                                      \n"
-    "ret                                       \n"
-);
+    pop        edi
+    pop        esi
+    ret
+  }
+}
 
-#define HAS_SCALEROWDOWN38_SSSE3
-extern "C" void ScaleRowDown38_SSSE3(const uint8* src_ptr, int src_stride,
-                                     uint8* dst_ptr, int dst_width);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleRowDown38_SSSE3              \n"
-"_ScaleRowDown38_SSSE3:                        \n"
-#else
-    ".global ScaleRowDown38_SSSE3              \n"
-"ScaleRowDown38_SSSE3:                         \n"
-#endif
-    "pusha                                     \n"
-    "mov    0x24(%esp),%esi                    \n"
-    "mov    0x28(%esp),%edx                    \n"
-    "mov    0x2c(%esp),%edi                    \n"
-    "mov    0x30(%esp),%ecx                    \n"
-    "movdqa _shuf38a ,%xmm4                    \n"
-    "movdqa _shuf38b ,%xmm5                    \n"
+#define HAS_SCALEBLENDROWS_MMX
+__declspec(naked)
+static void ScaleBlendRows_MMX(uint8* dst_ptr, const uint8* src0_ptr,
+                               const uint8* src1_ptr, int dst_width,
+                               int source_y_fraction) {
+  __asm {
+    push       esi
+    push       edi
+    mov        edi, [esp + 8 + 4]   // dst_ptr
+    mov        esi, [esp + 8 + 8]   // src0_ptr
+    mov        edx, [esp + 8 + 12]  // src1_ptr
+    mov        ecx, [esp + 8 + 16]  // dst_width
+    mov        eax, [esp + 8 + 20]  // source_y_fraction (0..255)
+    movd       mm6, eax
+    punpcklwd  mm6, mm6
+    punpckldq  mm6, mm6
+    pcmpeqb    mm5, mm5          // generate 256 - source_y_fraction
+    psrlw      mm5, 15
+    psllw      mm5, 8
+    psubw      mm5, mm6
+    pxor       mm7, mm7
 
-"1:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa 0x10(%esi),%xmm1                   \n"
-    "lea    0x20(%esi),%esi                    \n"
-    "pshufb %xmm4,%xmm0                        \n"
-    "pshufb %xmm5,%xmm1                        \n"
-    "paddusb %xmm1,%xmm0                       \n"
-    "movq   %xmm0,(%edi)                       \n"
-    "movhlps %xmm0,%xmm1                       \n"
-    "movd   %xmm1,0x8(%edi)                    \n"
-    "lea    0xc(%edi),%edi                     \n"
-    "sub    $0xc,%ecx                          \n"
-    "ja     1b                                 \n"
-    "popa                                      \n"
-    "ret                                       \n"
-);
+  wloop:
+    movq       mm0, [esi]
+    movq       mm2, [edx]
+    lea        esi,  [esi + 8]
+    lea        edx,  [edx + 8]
+    movq       mm1, mm0
+    movq       mm3, mm2
+    punpcklbw  mm0, mm7
+    punpcklbw  mm2, mm7
+    punpckhbw  mm1, mm7
+    punpckhbw  mm3, mm7
+    pmullw     mm0, mm5
+    pmullw     mm1, mm5
+    pmullw     mm2, mm6
+    pmullw     mm3, mm6
+    paddw      mm0, mm2
+    paddw      mm1, mm3
+    psrlw      mm0, 8
+    psrlw      mm1, 8
+    packuswb   mm0, mm1
+    movq       [edi], mm0
+    lea        edi,  [edi + 8]
+    sub        ecx, 8
+    ja         wloop
+    emms
 
-extern "C" void ScaleRowDown38_3_Int_SSSE3(const uint8* src_ptr, int src_stride,
-                                           uint8* dst_ptr, int dst_width);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleRowDown38_3_Int_SSSE3        \n"
-"_ScaleRowDown38_3_Int_SSSE3:                  \n"
-#else
-    ".global ScaleRowDown38_3_Int_SSSE3        \n"
-"ScaleRowDown38_3_Int_SSSE3:                   \n"
-#endif
-    "pusha                                     \n"
-    "mov    0x24(%esp),%esi                    \n"
-    "mov    0x28(%esp),%edx                    \n"
-    "mov    0x2c(%esp),%edi                    \n"
-    "mov    0x30(%esp),%ecx                    \n"
-    "movdqa _shufac0,%xmm4                     \n"
-    "movdqa _shufac3,%xmm5                     \n"
-    "movdqa _scaleac3,%xmm6                    \n"
-    "pxor   %xmm7,%xmm7                        \n"
+    pop        edi
+    pop        esi
+    ret
+  }
+}
 
-"1:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa (%esi,%edx,1),%xmm2                \n"
-    "movhlps %xmm0,%xmm1                       \n"
-    "movhlps %xmm2,%xmm3                       \n"
-    "punpcklbw %xmm7,%xmm0                     \n"
-    "punpcklbw %xmm7,%xmm1                     \n"
-    "punpcklbw %xmm7,%xmm2                     \n"
-    "punpcklbw %xmm7,%xmm3                     \n"
-    "paddusw %xmm2,%xmm0                       \n"
-    "paddusw %xmm3,%xmm1                       \n"
-    "movdqa (%esi,%edx,2),%xmm2                \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "movhlps %xmm2,%xmm3                       \n"
-    "punpcklbw %xmm7,%xmm2                     \n"
-    "punpcklbw %xmm7,%xmm3                     \n"
-    "paddusw %xmm2,%xmm0                       \n"
-    "paddusw %xmm3,%xmm1                       \n"
-    "movdqa %xmm0,%xmm2                        \n"
-    "psrldq $0x2,%xmm0                         \n"
-    "paddusw %xmm0,%xmm2                       \n"
-    "psrldq $0x2,%xmm0                         \n"
-    "paddusw %xmm0,%xmm2                       \n"
-    "pshufb %xmm4,%xmm2                        \n"
-    "movdqa %xmm1,%xmm3                        \n"
-    "psrldq $0x2,%xmm1                         \n"
-    "paddusw %xmm1,%xmm3                       \n"
-    "psrldq $0x2,%xmm1                         \n"
-    "paddusw %xmm1,%xmm3                       \n"
-    "pshufb %xmm5,%xmm3                        \n"
-    "paddusw %xmm3,%xmm2                       \n"
-    "pmulhuw %xmm6,%xmm2                       \n"
-    "packuswb %xmm2,%xmm2                      \n"
-    "movd   %xmm2,(%edi)                       \n"
-    "pextrw $0x2,%xmm2,%eax                    \n"
-    "mov    %ax,0x4(%edi)                      \n"
-    "lea    0x6(%edi),%edi                     \n"
-    "sub    $0x6,%ecx                          \n"
-    "ja     1b                                 \n"
-    "popa                                      \n"
-    "ret                                       \n"
-);
+// Accumulate 2 rows of a vertical polyphase filter into 32 bit sums.
+// coeffs holds the coefficient for src0_ptr in the low 16 bits and the
+// coefficient for src1_ptr in the high 16 bits.
+// Alignment requirement: dst_acc 16 byte aligned.
+#define HAS_SCALEACCUMROWS2_SSE2
+__declspec(naked)
+static void ScaleAccumRows2_SSE2(int32* dst_acc, const uint8* src0_ptr,
+                                 const uint8* src1_ptr, int src_width,
+                                 int coeffs) {
+  __asm {
+    push       esi
+    push       edi
+    mov        edi, [esp + 8 + 4]   // dst_acc
+    mov        esi, [esp + 8 + 8]   // src0_ptr
+    mov        edx, [esp + 8 + 12]  // src1_ptr
+    mov        ecx, [esp + 8 + 16]  // src_width
+    movd       xmm7, [esp + 8 + 20] // coeffs
+    pshufd     xmm7, xmm7, 0
+    pxor       xmm6, xmm6
 
-extern "C" void ScaleRowDown38_2_Int_SSSE3(const uint8* src_ptr, int src_stride,
-                                           uint8* dst_ptr, int dst_width);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleRowDown38_2_Int_SSSE3        \n"
-"_ScaleRowDown38_2_Int_SSSE3:                  \n"
-#else
-    ".global ScaleRowDown38_2_Int_SSSE3        \n"
-"ScaleRowDown38_2_Int_SSSE3:                   \n"
-#endif
-    "pusha                                     \n"
-    "mov    0x24(%esp),%esi                    \n"
-    "mov    0x28(%esp),%edx                    \n"
-    "mov    0x2c(%esp),%edi                    \n"
-    "mov    0x30(%esp),%ecx                    \n"
-    "movdqa _shufab0,%xmm4                     \n"
-    "movdqa _shufab1,%xmm5                     \n"
-    "movdqa _shufab2,%xmm6                     \n"
-    "movdqa _scaleab2,%xmm7                    \n"
+  wloop:
+    movq       xmm0, qword ptr [esi]
+    movq       xmm1, qword ptr [edx]
+    lea        esi,  [esi + 8]
+    lea        edx,  [edx + 8]
+    punpcklbw  xmm0, xmm1
+    movdqa     xmm1, xmm0
+    punpcklbw  xmm0, xmm6
+    punpckhbw  xmm1, xmm6
+    pmaddwd    xmm0, xmm7
+    pmaddwd    xmm1, xmm7
+    paddd      xmm0, [edi]
+    paddd      xmm1, [edi + 16]
+    movdqa     [edi], xmm0
+    movdqa     [edi + 16], xmm1
+    lea        edi,  [edi + 32]
+    sub        ecx, 8
+    ja         wloop
 
-"1:"
-    "movdqa (%esi),%xmm2                       \n"
-    "pavgb  (%esi,%edx,1),%xmm2                \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "movdqa %xmm2,%xmm0                        \n"
-    "pshufb %xmm4,%xmm0                        \n"
-    "movdqa %xmm2,%xmm1                        \n"
-    "pshufb %xmm5,%xmm1                        \n"
-    "paddusw %xmm1,%xmm0                       \n"
-    "pshufb %xmm6,%xmm2                        \n"
-    "paddusw %xmm2,%xmm0                       \n"
-    "pmulhuw %xmm7,%xmm0                       \n"
-    "packuswb %xmm0,%xmm0                      \n"
-    "movd   %xmm0,(%edi)                       \n"
-    "pextrw $0x2,%xmm0,%eax                    \n"
-    "mov    %ax,0x4(%edi)                      \n"
-    "lea    0x6(%edi),%edi                     \n"
-    "sub    $0x6,%ecx                          \n"
-    "ja     1b                                 \n"
-    "popa                                      \n"
-    "ret                                       \n"
-);
-#endif // __PIC__
+    pop        edi
+    pop        esi
+    ret
+  }
+}
 
-#define HAS_SCALEADDROWS_SSE2
-extern "C" void ScaleAddRows_SSE2(const uint8* src_ptr, int src_stride,
-                                  uint16* dst_ptr, int src_width,
-                                  int src_height);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleAddRows_SSE2                 \n"
-"_ScaleAddRows_SSE2:                           \n"
-#else
-    ".global ScaleAddRows_SSE2                 \n"
-"ScaleAddRows_SSE2:                            \n"
-#endif
-    "pusha                                     \n"
-    "mov    0x24(%esp),%esi                    \n"
-    "mov    0x28(%esp),%edx                    \n"
-    "mov    0x2c(%esp),%edi                    \n"
-    "mov    0x30(%esp),%ecx                    \n"
-    "mov    0x34(%esp),%ebx                    \n"
-    "pxor   %xmm5,%xmm5                        \n"
+#define HAS_SCALEACCUMROWS2_MMX
+__declspec(naked)
+static void ScaleAccumRows2_MMX(int32* dst_acc, const uint8* src0_ptr,
+                                const uint8* src1_ptr, int src_width,
+                                int coeffs) {
+  __asm {
+    push       esi
+    push       edi
+    mov        edi, [esp + 8 + 4]   // dst_acc
+    mov        esi, [esp + 8 + 8]   // src0_ptr
+    mov        edx, [esp + 8 + 12]  // src1_ptr
+    mov        ecx, [esp + 8 + 16]  // src_width
+    movd       mm7, [esp + 8 + 20]  // coeffs
+    punpckldq  mm7, mm7
+    pxor       mm6, mm6
 
-"1:"
-    "movdqa (%esi),%xmm2                       \n"
-    "lea    (%esi,%edx,1),%eax                 \n"
-    "movhlps %xmm2,%xmm3                       \n"
-    "lea    -0x1(%ebx),%ebp                    \n"
-    "punpcklbw %xmm5,%xmm2                     \n"
-    "punpcklbw %xmm5,%xmm3                     \n"
+  wloop:
+    movd       mm0, [esi]
+    movd       mm1, [edx]
+    lea        esi,  [esi + 4]
+    lea        edx,  [edx + 4]
+    punpcklbw  mm0, mm1
+    movq       mm1, mm0
+    punpcklbw  mm0, mm6
+    punpckhbw  mm1, mm6
+    pmaddwd    mm0, mm7
+    pmaddwd    mm1, mm7
+    paddd      mm0, [edi]
+    paddd      mm1, [edi + 8]
+    movq       [edi], mm0
+    movq       [edi + 8], mm1
+    lea        edi,  [edi + 16]
+    sub        ecx, 4
+    ja         wloop
+    emms
 
-"2:"
-    "movdqa (%eax),%xmm0                       \n"
-    "lea    (%eax,%edx,1),%eax                 \n"
-    "movhlps %xmm0,%xmm1                       \n"
-    "punpcklbw %xmm5,%xmm0                     \n"
-    "punpcklbw %xmm5,%xmm1                     \n"
-    "paddusw %xmm0,%xmm2                       \n"
-    "paddusw %xmm1,%xmm3                       \n"
-    "sub    $0x1,%ebp                          \n"
-    "ja     2b                                 \n"
+    pop        edi
+    pop        esi
+    ret
+  }
+}
 
-    "movdqa %xmm2,(%edi)                       \n"
-    "movdqa %xmm3,0x10(%edi)                   \n"
-    "lea    0x20(%edi),%edi                    \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "sub    $0x10,%ecx                         \n"
-    "ja     1b                                 \n"
-    "popa                                      \n"
-    "ret                                       \n"
-);
+// Shift 32 bit sums of a polyphase filter down to pixels.
+// Writes up to 7 pixels past width.
+// Alignment requirement: src_acc 16 byte aligned.
+#define HAS_SCALEPACKROW_SSE2
+__declspec(naked)
+static void ScalePackRow_SSE2(uint8* dst_ptr, const int32* src_acc,
+                              int width) {
+  __asm {
+    mov        edx, [esp + 4]       // dst_ptr
+    mov        eax, [esp + 8]       // src_acc
+    mov        ecx, [esp + 12]      // width
 
-// Bilinear row filtering combines 16x2 -> 16x1. SSE2 version
-#define HAS_SCALEFILTERROWS_SSE2
-extern "C" void ScaleFilterRows_SSE2(uint8* dst_ptr,
-                                     const uint8* src_ptr, int src_stride,
-                                     int dst_width, int source_y_fraction);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleFilterRows_SSE2              \n"
-"_ScaleFilterRows_SSE2:                        \n"
-#else
-    ".global ScaleFilterRows_SSE2              \n"
-"ScaleFilterRows_SSE2:                         \n"
-#endif
-    "push   %esi                               \n"
-    "push   %edi                               \n"
-    "mov    0xc(%esp),%edi                     \n"
-    "mov    0x10(%esp),%esi                    \n"
-    "mov    0x14(%esp),%edx                    \n"
-    "mov    0x18(%esp),%ecx                    \n"
-    "mov    0x1c(%esp),%eax                    \n"
-    "cmp    $0x0,%eax                          \n"
-    "je     2f                                 \n"
-    "cmp    $0x80,%eax                         \n"
-    "je     3f                                 \n"
-    "movd   %eax,%xmm6                         \n"
-    "punpcklwd %xmm6,%xmm6                     \n"
-    "pshufd $0x0,%xmm6,%xmm6                   \n"
-    "neg    %eax                               \n"
-    "add    $0x100,%eax                        \n"
-    "movd   %eax,%xmm5                         \n"
-    "punpcklwd %xmm5,%xmm5                     \n"
-    "pshufd $0x0,%xmm5,%xmm5                   \n"
-    "pxor   %xmm7,%xmm7                        \n"
+  wloop:
+    movdqa     xmm0, [eax]
+    movdqa     xmm1, [eax + 16]
+    lea        eax,  [eax + 32]
+    psrad      xmm0, 14
+    psrad      xmm1, 14
+    packssdw   xmm0, xmm1
+    packuswb   xmm0, xmm0
+    movq       qword ptr [edx], xmm0
+    lea        edx,  [edx + 8]
+    sub        ecx, 8
+    ja         wloop
 
-"1:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa (%esi,%edx,1),%xmm2                \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "movdqa %xmm0,%xmm1                        \n"
-    "movdqa %xmm2,%xmm3                        \n"
-    "punpcklbw %xmm7,%xmm0                     \n"
-    "punpcklbw %xmm7,%xmm2                     \n"
-    "punpckhbw %xmm7,%xmm1                     \n"
-    "punpckhbw %xmm7,%xmm3                     \n"
-    "pmullw %xmm5,%xmm0                        \n"
-    "pmullw %xmm5,%xmm1                        \n"
-    "pmullw %xmm6,%xmm2                        \n"
-    "pmullw %xmm6,%xmm3                        \n"
-    "paddusw %xmm2,%xmm0                       \n"
-    "paddusw %xmm3,%xmm1                       \n"
-    "psrlw  $0x8,%xmm0                         \n"
-    "psrlw  $0x8,%xmm1                         \n"
-    "packuswb %xmm1,%xmm0                      \n"
-    "movdqa %xmm0,(%edi)                       \n"
-    "lea    0x10(%edi),%edi                    \n"
-    "sub    $0x10,%ecx                         \n"
-    "ja     1b                                 \n"
-    "mov    -0x1(%edi),%al                     \n"
-    "mov    %al,(%edi)                         \n"
-    "pop    %edi                               \n"
-    "pop    %esi                               \n"
-    "ret                                       \n"
+    ret
+  }
+}
 
-"2:"
-    "movdqa (%esi),%xmm0                       \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "movdqa %xmm0,(%edi)                       \n"
-    "lea    0x10(%edi),%edi                    \n"
-    "sub    $0x10,%ecx                         \n"
-    "ja     2b                                 \n"
+// Writes up to 3 pixels past width.
+#define HAS_SCALEPACKROW_MMX
+__declspec(naked)
+static void ScalePackRow_MMX(uint8* dst_ptr, const int32* src_acc,
+                             int width) {
+  __asm {
+    mov        edx, [esp + 4]       // dst_ptr
+    mov        eax, [esp + 8]       // src_acc
+    mov        ecx, [esp + 12]      // width
 
-    "mov    -0x1(%edi),%al                     \n"
-    "mov    %al,(%edi)                         \n"
-    "pop    %edi                               \n"
-    "pop    %esi                               \n"
-    "ret                                       \n"
+  wloop:
+    movq       mm0, [eax]
+    movq       mm1, [eax + 8]
+    lea        eax,  [eax + 16]
+    psrad      mm0, 14
+    psrad      mm1, 14
+    packssdw   mm0, mm1
+    packuswb   mm0, mm0
+    movd       [edx], mm0
+    lea        edx,  [edx + 4]
+    sub        ecx, 4
+    ja         wloop
+    emms
 
-"3:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa (%esi,%edx,1),%xmm2                \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "pavgb  %xmm2,%xmm0                        \n"
-    "movdqa %xmm0,(%edi)                       \n"
-    "lea    0x10(%edi),%edi                    \n"
-    "sub    $0x10,%ecx                         \n"
-    "ja     3b                                 \n"
+    ret
+  }
+}
 
-    "mov    -0x1(%edi),%al                     \n"
-    "mov    %al,(%edi)                         \n"
-    "pop    %edi                               \n"
-    "pop    %esi                               \n"
-    "ret                                       \n"
-);
+// Horizontal polyphase filter with 8 taps, 4 pixels at a time.  Each pixel
+// is a pmaddwd of 8 source pixels with its coefficients, and the 4 sets of
+// partial sums are then transposed and added.
+// ScaleFilterPos is {offset, coeffs}, 8 bytes.
+#define HAS_SCALEFILTERCOLS8_SSE2
+__declspec(naked)
+static void ScaleFilterCols8_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                  int dst_width, const ScaleFilterPos* pos,
+                                  int) {
+  __asm {
+    push       ebx
+    push       esi
+    push       edi
+    mov        edi, [esp + 12 + 4]  // dst_ptr
+    mov        esi, [esp + 12 + 8]  // src_ptr
+    mov        ecx, [esp + 12 + 12] // dst_width
+    mov        edx, [esp + 12 + 16] // pos
+    pxor       xmm5, xmm5
+    pcmpeqb    xmm7, xmm7           // generate rounding 8192
+    psrld      xmm7, 31
+    pslld      xmm7, 13
 
-// Bilinear row filtering combines 16x2 -> 16x1. SSSE3 version
-#define HAS_SCALEFILTERROWS_SSSE3
-extern "C" void ScaleFilterRows_SSSE3(uint8* dst_ptr,
-                                      const uint8* src_ptr, int src_stride,
-                                      int dst_width, int source_y_fraction);
-  asm(
-    ".text                                     \n"
-#if defined(OSX)
-    ".globl _ScaleFilterRows_SSSE3             \n"
-"_ScaleFilterRows_SSSE3:                       \n"
-#else
-    ".global ScaleFilterRows_SSSE3             \n"
-"ScaleFilterRows_SSSE3:                        \n"
-#endif
-    "push   %esi                               \n"
-    "push   %edi                               \n"
-    "mov    0xc(%esp),%edi                     \n"
-    "mov    0x10(%esp),%esi                    \n"
-    "mov    0x14(%esp),%edx                    \n"
-    "mov    0x18(%esp),%ecx                    \n"
-    "mov    0x1c(%esp),%eax                    \n"
-    "cmp    $0x0,%eax                          \n"
-    "je     2f                                 \n"
-    "cmp    $0x80,%eax                         \n"
-    "je     3f                                 \n"
-    "shr    %eax                               \n"
-    "mov    %al,%ah                            \n"
-    "neg    %al                                \n"
-    "add    $0x80,%al                          \n"
-    "movd   %eax,%xmm5                         \n"
-    "punpcklwd %xmm5,%xmm5                     \n"
-    "pshufd $0x0,%xmm5,%xmm5                   \n"
+  wloop:
+    mov        eax, [edx]
+    mov        ebx, [edx + 4]
+    movq       xmm0, qword ptr [esi + eax]
+    punpcklbw  xmm0, xmm5
+    pmaddwd    xmm0, [ebx]
+    mov        eax, [edx + 8]
+    mov        ebx, [edx + 12]
+    movq       xmm1, qword ptr [esi + eax]
+    punpcklbw  xmm1, xmm5
+    pmaddwd    xmm1, [ebx]
+    mov        eax, [edx + 16]
+    mov        ebx, [edx + 20]
+    movq       xmm2, qword ptr [esi + eax]
+    punpcklbw  xmm2, xmm5
+    pmaddwd    xmm2, [ebx]
+    mov        eax, [edx + 24]
+    mov        ebx, [edx + 28]
+    movq       xmm3, qword ptr [esi + eax]
+    punpcklbw  xmm3, xmm5
+    pmaddwd    xmm3, [ebx]
+    lea        edx,  [edx + 32]
+    movdqa     xmm4, xmm0
+    punpckldq  xmm0, xmm1
+    punpckhdq  xmm4, xmm1
+    paddd      xmm0, xmm4
+    movdqa     xmm6, xmm2
+    punpckldq  xmm2, xmm3
+    punpckhdq  xmm6, xmm3
+    paddd      xmm2, xmm6
+    movdqa     xmm1, xmm0
+    punpcklqdq xmm0, xmm2
+    punpckhqdq xmm1, xmm2
+    paddd      xmm0, xmm1
+    paddd      xmm0, xmm7
+    psrad      xmm0, 14
+    packssdw   xmm0, xmm0
+    packuswb   xmm0, xmm0
+    movd       [edi], xmm0
+    lea        edi,  [edi + 4]
+    sub        ecx, 4
+    ja         wloop
 
-"1:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa (%esi,%edx,1),%xmm2                \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "movdqa %xmm0,%xmm1                        \n"
-    "punpcklbw %xmm2,%xmm0                     \n"
-    "punpckhbw %xmm2,%xmm1                     \n"
-    "pmaddubsw %xmm5,%xmm0                     \n"
-    "pmaddubsw %xmm5,%xmm1                     \n"
-    "psrlw  $0x7,%xmm0                         \n"
-    "psrlw  $0x7,%xmm1                         \n"
-    "packuswb %xmm1,%xmm0                      \n"
-    "movdqa %xmm0,(%edi)                       \n"
-    "lea    0x10(%edi),%edi                    \n"
-    "sub    $0x10,%ecx                         \n"
-    "ja     1b                                 \n"
-    "mov    -0x1(%edi),%al                     \n"
-    "mov    %al,(%edi)                         \n"
-    "pop    %edi                               \n"
-    "pop    %esi                               \n"
-    "ret                                       \n"
+    pop        edi
+    pop        esi
+    pop        ebx
+    ret
+  }
+}
 
-"2:"
-    "movdqa (%esi),%xmm0                       \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "movdqa %xmm0,(%edi)                       \n"
-    "lea    0x10(%edi),%edi                    \n"
-    "sub    $0x10,%ecx                         \n"
-    "ja     2b                                 \n"
-    "mov    -0x1(%edi),%al                     \n"
-    "mov    %al,(%edi)                         \n"
-    "pop    %edi                               \n"
-    "pop    %esi                               \n"
-    "ret                                       \n"
+// Horizontal polyphase filter with 16 taps, 4 pixels at a time.
+#define HAS_SCALEFILTERCOLS16_SSE2
+__declspec(naked)
+static void ScaleFilterCols16_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                   int dst_width, const ScaleFilterPos* pos,
+                                   int) {
+  __asm {
+    push       ebx
+    push       esi
+    push       edi
+    mov        edi, [esp + 12 + 4]  // dst_ptr
+    mov        esi, [esp + 12 + 8]  // src_ptr
+    mov        ecx, [esp + 12 + 12] // dst_width
+    mov        edx, [esp + 12 + 16] // pos
+    pxor       xmm5, xmm5
+    pcmpeqb    xmm7, xmm7           // generate rounding 8192
+    psrld      xmm7, 31
+    pslld      xmm7, 13
 
-"3:"
-    "movdqa (%esi),%xmm0                       \n"
-    "movdqa (%esi,%edx,1),%xmm2                \n"
-    "lea    0x10(%esi),%esi                    \n"
-    "pavgb  %xmm2,%xmm0                        \n"
-    "movdqa %xmm0,(%edi)                       \n"
-    "lea    0x10(%edi),%edi                    \n"
-    "sub    $0x10,%ecx                         \n"
-    "ja     3b                                 \n"
-    "mov    -0x1(%edi),%al                     \n"
-    "mov    %al,(%edi)                         \n"
-    "pop    %edi                               \n"
-    "pop    %esi                               \n"
-    "ret                                       \n"
+  wloop:
+    mov        eax, [edx]
+    mov        ebx, [edx + 4]
+    movq       xmm0, qword ptr [esi + eax]
+    movq       xmm6, qword ptr [esi + eax + 8]
+    punpcklbw  xmm0, xmm5
+    punpcklbw  xmm6, xmm5
+    pmaddwd    xmm0, [ebx]
+    pmaddwd    xmm6, [ebx + 16]
+    paddd      xmm0, xmm6
+    mov        eax, [edx + 8]
+    mov        ebx, [edx + 12]
+    movq       xmm1, qword ptr [esi + eax]
+    movq       xmm6, qword ptr [esi + eax + 8]
+    punpcklbw  xmm1, xmm5
+    punpcklbw  xmm6, xmm5
+    pmaddwd    xmm1, [ebx]
+    pmaddwd    xmm6, [ebx + 16]
+    paddd      xmm1, xmm6
+    mov        eax, [edx + 16]
+    mov        ebx, [edx + 20]
+    movq       xmm2, qword ptr [esi + eax]
+    movq       xmm6, qword ptr [esi + eax + 8]
+    punpcklbw  xmm2, xmm5
+    punpcklbw  xmm6, xmm5
+    pmaddwd    xmm2, [ebx]
+    pmaddwd    xmm6, [ebx + 16]
+    paddd      xmm2, xmm6
+    mov        eax, [edx + 24]
+    mov        ebx, [edx + 28]
+    movq       xmm3, qword ptr [esi + eax]
+    movq       xmm6, qword ptr [esi + eax + 8]
+    punpcklbw  xmm3, xmm5
+    punpcklbw  xmm6, xmm5
+    pmaddwd    xmm3, [ebx]
+    pmaddwd    xmm6, [ebx + 16]
+    paddd      xmm3, xmm6
+    lea        edx,  [edx + 32]
+    movdqa     xmm4, xmm0
+    punpckldq  xmm0, xmm1
+    punpckhdq  xmm4, xmm1
+    paddd      xmm0, xmm4
+    movdqa     xmm6, xmm2
+    punpckldq  xmm2, xmm3
+    punpckhdq  xmm6, xmm3
+    paddd      xmm2, xmm6
+    movdqa     xmm1, xmm0
+    punpcklqdq xmm0, xmm2
+    punpckhqdq xmm1, xmm2
+    paddd      xmm0, xmm1
+    paddd      xmm0, xmm7
+    psrad      xmm0, 14
+    packssdw   xmm0, xmm0
+    packuswb   xmm0, xmm0
+    movd       [edi], xmm0
+    lea        edi,  [edi + 4]
+    sub        ecx, 4
+    ja         wloop
+
+    pop        edi
+    pop        esi
+    pop        ebx
+    ret
+  }
+}
+
+// Horizontal polyphase filter with 8 taps, 2 pixels at a time.
+#define HAS_SCALEFILTERCOLS8_MMX
+__declspec(naked)
+static void ScaleFilterCols8_MMX(uint8* dst_ptr, const uint8* src_ptr,
+                                 int dst_width, const ScaleFilterPos* pos,
+                                 int) {
+  __asm {
+    push       ebx
+    push       esi
+    push       edi
+    mov        edi, [esp + 12 + 4]  // dst_ptr
+    mov        esi, [esp + 12 + 8]  // src_ptr
+    mov        ecx, [esp + 12 + 12] // dst_width
+    mov        edx, [esp + 12 + 16] // pos
+    pxor       mm5, mm5
+    pcmpeqb    mm7, mm7             // generate rounding 8192
+    psrld      mm7, 31
+    pslld      mm7, 13
+
+  wloop:
+    mov        eax, [edx]
+    mov        ebx, [edx + 4]
+    movq       mm0, [esi + eax]
+    movq       mm1, mm0
+    punpcklbw  mm0, mm5
+    punpckhbw  mm1, mm5
+    pmaddwd    mm0, [ebx]
+    pmaddwd    mm1, [ebx + 8]
+    paddd      mm0, mm1
+    mov        eax, [edx + 8]
+    mov        ebx, [edx + 12]
+    movq       mm2, [esi + eax]
+    movq       mm3, mm2
+    punpcklbw  mm2, mm5
+    punpckhbw  mm3, mm5
+    pmaddwd    mm2, [ebx]
+    pmaddwd    mm3, [ebx + 8]
+    paddd      mm2, mm3
+    lea        edx,  [edx + 16]
+    movq       mm1, mm0
+    punpckldq  mm0, mm2
+    punpckhdq  mm1, mm2
+    paddd      mm0, mm1
+    paddd      mm0, mm7
+    psrad      mm0, 14
+    packssdw   mm0, mm0
+    packuswb   mm0, mm0
+    movd       eax, mm0
+    mov        [edi], ax
+    lea        edi,  [edi + 2]
+    sub        ecx, 2
+    ja         wloop
+    emms
+
+    pop        edi
+    pop        esi
+    pop        ebx
+    ret
+  }
+}
+
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+
+// GCC versions of row functions are verbatim conversions from Visual C.
+// Generated using gcc disassembly on Visual C object file:
+// objdump -D yuvscaler.obj >yuvscaler.txt
+#define HAS_SCALEROWDOWN2_SSE2
+static void ScaleRowDown2_SSE2(const uint8* src_ptr, int src_stride,
+                               uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "pcmpeqb    %%xmm5,%%xmm5                    \n"
+  "psrlw      $0x8,%%xmm5                      \n"
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "pand       %%xmm5,%%xmm0                    \n"
+  "pand       %%xmm5,%%xmm1                    \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x10,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
+  : "memory", "cc"
 );
+}
 
-#elif defined(__x86_64__)
-static void ScaleRowDown8Int_SSE2(const uint8* src_ptr, int src_stride,
+static void ScaleRowDown2Int_SSE2(const uint8* src_ptr, int src_stride,
                                   uint8* dst_ptr, int dst_width) {
   asm volatile (
-  "lea        (%3,%3,2),%%r10                  \n"
-  "pxor       %%xmm7,%%xmm7                    \n"
+  "pcmpeqb    %%xmm5,%%xmm5                    \n"
+  "psrlw      $0x8,%%xmm5                      \n"
 "1:"
   "movdqa     (%0),%%xmm0                      \n"
   "movdqa     0x10(%0),%%xmm1                  \n"
   "movdqa     (%0,%3,1),%%xmm2                 \n"
   "movdqa     0x10(%0,%3,1),%%xmm3             \n"
-  "pavgb      %%xmm2,%%xmm0                    \n"
-  "pavgb      %%xmm3,%%xmm1                    \n"
-  "movdqa     (%0,%3,2),%%xmm2                 \n"
-  "movdqa     0x10(%0,%3,2),%%xmm3             \n"
-  "movdqa     (%0,%%r10,1),%%xmm4              \n"
-  "movdqa     0x10(%0,%%r10,1),%%xmm5          \n"
-  "lea        (%0,%3,4),%%r11                  \n"
   "lea        0x20(%0),%0                      \n"
-  "pavgb      %%xmm4,%%xmm2                    \n"
-  "pavgb      %%xmm5,%%xmm3                    \n"
-  "pavgb      %%xmm2,%%xmm0                    \n"
-  "pavgb      %%xmm3,%%xmm1                    \n"
-  "movdqa     0x0(%%r11),%%xmm2                \n"
-  "movdqa     0x10(%%r11),%%xmm3               \n"
-  "movdqa     0x0(%%r11,%3,1),%%xmm4           \n"
-  "movdqa     0x10(%%r11,%3,1),%%xmm5          \n"
-  "pavgb      %%xmm4,%%xmm2                    \n"
-  "pavgb      %%xmm5,%%xmm3                    \n"
-  "movdqa     0x0(%%r11,%3,2),%%xmm4           \n"
-  "movdqa     0x10(%%r11,%3,2),%%xmm5          \n"
-  "movdqa     0x0(%%r11,%%r10,1),%%xmm6        \n"
-  "pavgb      %%xmm6,%%xmm4                    \n"
-  "movdqa     0x10(%%r11,%%r10,1),%%xmm6       \n"
-  "pavgb      %%xmm6,%%xmm5                    \n"
-  "pavgb      %%xmm4,%%xmm2                    \n"
-  "pavgb      %%xmm5,%%xmm3                    \n"
   "pavgb      %%xmm2,%%xmm0                    \n"
   "pavgb      %%xmm3,%%xmm1                    \n"
-  "psadbw     %%xmm7,%%xmm0                    \n"
-  "psadbw     %%xmm7,%%xmm1                    \n"
-  "pshufd     $0xd8,%%xmm0,%%xmm0              \n"
-  "pshufd     $0x8d,%%xmm1,%%xmm1              \n"
-  "por        %%xmm1,%%xmm0                    \n"
-  "psrlw      $0x3,%%xmm0                      \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movd       %%xmm0,(%1)                      \n"
-  "lea        0x4(%1),%1                       \n"
-  "sub        $0x4,%2                          \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "psrlw      $0x8,%%xmm0                      \n"
+  "movdqa     %%xmm1,%%xmm3                    \n"
+  "psrlw      $0x8,%%xmm1                      \n"
+  "pand       %%xmm5,%%xmm2                    \n"
+  "pand       %%xmm5,%%xmm3                    \n"
+  "pavgw      %%xmm2,%%xmm0                    \n"
+  "pavgw      %%xmm3,%%xmm1                    \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x10,%2                         \n"
   "ja         1b                               \n"
-  : "+r"(src_ptr),     // %0
-    "+r"(dst_ptr),     // %1
-    "+r"(dst_width)    // %2
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
   : "r"(static_cast<intptr_t>(src_stride))   // %3
-  : "memory", "cc", "r10", "r11", "xmm6", "xmm7"
+  : "memory", "cc"
 );
 }
 
-#define HAS_SCALEROWDOWN34_SSSE3
-static void ScaleRowDown34_SSSE3(const uint8* src_ptr, int src_stride,
-                                 uint8* dst_ptr, int dst_width) {
+#define HAS_SCALEROWDOWN4_SSE2
+static void ScaleRowDown4_SSE2(const uint8* src_ptr, int src_stride,
+                               uint8* dst_ptr, int dst_width) {
   asm volatile (
-  "movdqa     (%3),%%xmm3                      \n"
-  "movdqa     (%4),%%xmm4                      \n"
-  "movdqa     (%5),%%xmm5                      \n"
+  "pcmpeqb    %%xmm5,%%xmm5                    \n"
+  "psrld      $0x18,%%xmm5                     \n"
 "1:"
   "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     0x10(%0),%%xmm2                  \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
   "lea        0x20(%0),%0                      \n"
-  "movdqa     %%xmm2,%%xmm1                    \n"
-  "palignr    $0x8,%%xmm0,%%xmm1               \n"
-  "pshufb     %%xmm3,%%xmm0                    \n"
-  "pshufb     %%xmm4,%%xmm1                    \n"
-  "pshufb     %%xmm5,%%xmm2                    \n"
+  "pand       %%xmm5,%%xmm0                    \n"
+  "pand       %%xmm5,%%xmm1                    \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
   "movq       %%xmm0,(%1)                      \n"
-  "movq       %%xmm1,0x8(%1)                   \n"
-  "movq       %%xmm2,0x10(%1)                  \n"
-  "lea        0x18(%1),%1                      \n"
-  "sub        $0x18,%2                         \n"
+  "lea        0x8(%1),%1                       \n"
+  "sub        $0x8,%2                          \n"
   "ja         1b                               \n"
-  : "+r"(src_ptr),     // %0
-    "+r"(dst_ptr),     // %1
-    "+r"(dst_width)    // %2
-  : "r"(_shuf0),   // %3
-    "r"(_shuf1),   // %4
-    "r"(_shuf2)    // %5
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
   : "memory", "cc"
 );
 }
 
-static void ScaleRowDown34_1_Int_SSSE3(const uint8* src_ptr, int src_stride,
-                                       uint8* dst_ptr, int dst_width) {
+static void ScaleRowDown4Int_SSE2(const uint8* src_ptr, int src_stride,
+                                  uint8* dst_ptr, int dst_width) {
+  intptr_t temp = 0;
   asm volatile (
-  "movdqa     (%4),%%xmm2                      \n"  // _shuf01
-  "movdqa     (%5),%%xmm3                      \n"  // _shuf11
-  "movdqa     (%6),%%xmm4                      \n"  // _shuf21
-  "movdqa     (%7),%%xmm5                      \n"  // _madd01
-  "movdqa     (%8),%%xmm6                      \n"  // _madd11
-  "movdqa     (%9),%%xmm7                      \n"  // _round34
-  "movdqa     (%10),%%xmm8                     \n"  // _madd21
+  "pcmpeqb    %%xmm7,%%xmm7                    \n"
+  "psrlw      $0x8,%%xmm7                      \n"
+  "lea        (%4,%4,2),%3                     \n"
 "1:"
   "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     (%0,%3),%%xmm1                   \n"
-  "pavgb      %%xmm1,%%xmm0                    \n"
-  "pshufb     %%xmm2,%%xmm0                    \n"
-  "pmaddubsw  %%xmm5,%%xmm0                    \n"
-  "paddsw     %%xmm7,%%xmm0                    \n"
-  "psrlw      $0x2,%%xmm0                      \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movq       %%xmm0,(%1)                      \n"
-  "movdqu     0x8(%0),%%xmm0                   \n"
-  "movdqu     0x8(%0,%3),%%xmm1                \n"
-  "pavgb      %%xmm1,%%xmm0                    \n"
-  "pshufb     %%xmm3,%%xmm0                    \n"
-  "pmaddubsw  %%xmm6,%%xmm0                    \n"
-  "paddsw     %%xmm7,%%xmm0                    \n"
-  "psrlw      $0x2,%%xmm0                      \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movq       %%xmm0,0x8(%1)                   \n"
-  "movdqa     0x10(%0),%%xmm0                  \n"
-  "movdqa     0x10(%0,%3),%%xmm1               \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "movdqa     (%0,%4,1),%%xmm2                 \n"
+  "movdqa     0x10(%0,%4,1),%%xmm3             \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "pavgb      %%xmm3,%%xmm1                    \n"
+  "movdqa     (%0,%4,2),%%xmm2                 \n"
+  "movdqa     0x10(%0,%4,2),%%xmm3             \n"
+  "movdqa     (%0,%3,1),%%xmm4                 \n"
+  "movdqa     0x10(%0,%3,1),%%xmm5             \n"
   "lea        0x20(%0),%0                      \n"
-  "pavgb      %%xmm1,%%xmm0                    \n"
-  "pshufb     %%xmm4,%%xmm0                    \n"
-  "pmaddubsw  %%xmm8,%%xmm0                    \n"
-  "paddsw     %%xmm7,%%xmm0                    \n"
-  "psrlw      $0x2,%%xmm0                      \n"
+  "pavgb      %%xmm4,%%xmm2                    \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "pavgb      %%xmm5,%%xmm3                    \n"
+  "pavgb      %%xmm3,%%xmm1                    \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "psrlw      $0x8,%%xmm0                      \n"
+  "movdqa     %%xmm1,%%xmm3                    \n"
+  "psrlw      $0x8,%%xmm1                      \n"
+  "pand       %%xmm7,%%xmm2                    \n"
+  "pand       %%xmm7,%%xmm3                    \n"
+  "pavgw      %%xmm2,%%xmm0                    \n"
+  "pavgw      %%xmm3,%%xmm1                    \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "psrlw      $0x8,%%xmm0                      \n"
+  "pand       %%xmm7,%%xmm2                    \n"
+  "pavgw      %%xmm2,%%xmm0                    \n"
   "packuswb   %%xmm0,%%xmm0                    \n"
-  "movq       %%xmm0,0x10(%1)                  \n"
-  "lea        0x18(%1),%1                      \n"
-  "sub        $0x18,%2                         \n"
+  "movq       %%xmm0,(%1)                      \n"
+  "lea        0x8(%1),%1                       \n"
+  "sub        $0x8,%2                          \n"
   "ja         1b                               \n"
   : "+r"(src_ptr),     // %0
     "+r"(dst_ptr),     // %1
-    "+r"(dst_width)    // %2
-  : "r"(static_cast<intptr_t>(src_stride)),  // %3
-    "r"(_shuf01),   // %4
-    "r"(_shuf11),   // %5
-    "r"(_shuf21),   // %6
-    "r"(_madd01),   // %7
-    "r"(_madd11),   // %8
-    "r"(_round34),  // %9
-    "r"(_madd21)    // %10
-  : "memory", "cc", "xmm6", "xmm7", "xmm8"
+    "+r"(dst_width),   // %2
+    "+r"(temp)         // %3
+  : "r"(static_cast<intptr_t>(src_stride))    // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm6", "xmm7"
+#endif
 );
 }
 
-static void ScaleRowDown34_0_Int_SSSE3(const uint8* src_ptr, int src_stride,
-                                       uint8* dst_ptr, int dst_width) {
+#define HAS_SCALEROWDOWN8_SSE2
+static void ScaleRowDown8_SSE2(const uint8* src_ptr, int src_stride,
+                               uint8* dst_ptr, int dst_width) {
   asm volatile (
-  "movdqa     (%4),%%xmm2                      \n"  // _shuf01
-  "movdqa     (%5),%%xmm3                      \n"  // _shuf11
-  "movdqa     (%6),%%xmm4                      \n"  // _shuf21
-  "movdqa     (%7),%%xmm5                      \n"  // _madd01
-  "movdqa     (%8),%%xmm6                      \n"  // _madd11
-  "movdqa     (%9),%%xmm7                      \n"  // _round34
-  "movdqa     (%10),%%xmm8                     \n"  // _madd21
+  "pcmpeqb    %%xmm5,%%xmm5                    \n"
+  "psrlq      $0x38,%%xmm5                     \n"
 "1:"
   "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     (%0,%3,1),%%xmm1                 \n"
-  "pavgb      %%xmm0,%%xmm1                    \n"
-  "pavgb      %%xmm1,%%xmm0                    \n"
-  "pshufb     %%xmm2,%%xmm0                    \n"
-  "pmaddubsw  %%xmm5,%%xmm0                    \n"
-  "paddsw     %%xmm7,%%xmm0                    \n"
-  "psrlw      $0x2,%%xmm0                      \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movq       %%xmm0,(%1)                      \n"
-  "movdqu     0x8(%0),%%xmm0                   \n"
-  "movdqu     0x8(%0,%3,1),%%xmm1              \n"
-  "pavgb      %%xmm0,%%xmm1                    \n"
-  "pavgb      %%xmm1,%%xmm0                    \n"
-  "pshufb     %%xmm3,%%xmm0                    \n"
-  "pmaddubsw  %%xmm6,%%xmm0                    \n"
-  "paddsw     %%xmm7,%%xmm0                    \n"
-  "psrlw      $0x2,%%xmm0                      \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movq       %%xmm0,0x8(%1)                   \n"
-  "movdqa     0x10(%0),%%xmm0                  \n"
-  "movdqa     0x10(%0,%3,1),%%xmm1             \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
   "lea        0x20(%0),%0                      \n"
-  "pavgb      %%xmm0,%%xmm1                    \n"
-  "pavgb      %%xmm1,%%xmm0                    \n"
-  "pshufb     %%xmm4,%%xmm0                    \n"
-  "pmaddubsw  %%xmm8,%%xmm0                    \n"
-  "paddsw     %%xmm7,%%xmm0                    \n"
-  "psrlw      $0x2,%%xmm0                      \n"
+  "pand       %%xmm5,%%xmm0                    \n"
+  "pand       %%xmm5,%%xmm1                    \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
   "packuswb   %%xmm0,%%xmm0                    \n"
-  "movq       %%xmm0,0x10(%1)                  \n"
-  "lea        0x18(%1),%1                      \n"
-  "sub        $0x18,%2                         \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movd       %%xmm0,(%1)                      \n"
+  "lea        0x4(%1),%1                       \n"
+  "sub        $0x4,%2                          \n"
   "ja         1b                               \n"
-  : "+r"(src_ptr),     // %0
-    "+r"(dst_ptr),     // %1
-    "+r"(dst_width)    // %2
-  : "r"(static_cast<intptr_t>(src_stride)),  // %3
-    "r"(_shuf01),   // %4
-    "r"(_shuf11),   // %5
-    "r"(_shuf21),   // %6
-    "r"(_madd01),   // %7
-    "r"(_madd11),   // %8
-    "r"(_round34),  // %9
-    "r"(_madd21)    // %10
-  : "memory", "cc", "xmm6", "xmm7", "xmm8"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
+  : "memory", "cc"
 );
 }
 
-#define HAS_SCALEROWDOWN38_SSSE3
-static void ScaleRowDown38_SSSE3(const uint8* src_ptr, int src_stride,
-                                 uint8* dst_ptr, int dst_width) {
+// MMX versions of the row functions above for processors with SSE but not
+// SSE2.  pavgb, pavgw and psadbw are SSE instructions.
+// Reads 16 pixels, throws half away and writes 8 pixels.
+#define HAS_SCALEROWDOWN2_SSE
+static void ScaleRowDown2_SSE(const uint8* src_ptr, int src_stride,
+                              uint8* dst_ptr, int dst_width) {
   asm volatile (
-  "movdqa     (%3),%%xmm4                      \n"
-  "movdqa     (%4),%%xmm5                      \n"
+  "pcmpeqb    %%mm5,%%mm5                      \n"
+  "psrlw      $0x8,%%mm5                       \n"
 "1:"
-  "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     0x10(%0),%%xmm1                  \n"
-  "lea        0x20(%0),%0                      \n"
-  "pshufb     %%xmm4,%%xmm0                    \n"
-  "pshufb     %%xmm5,%%xmm1                    \n"
-  "paddusb    %%xmm1,%%xmm0                    \n"
-  "movq       %%xmm0,(%1)                      \n"
-  "movhlps    %%xmm0,%%xmm1                    \n"
-  "movd       %%xmm1,0x8(%1)                   \n"
-  "lea        0xc(%1),%1                       \n"
-  "sub        $0xc,%2                          \n"
+  "movq       (%0),%%mm0                       \n"
+  "movq       0x8(%0),%%mm1                    \n"
+  "lea        0x10(%0),%0                      \n"
+  "pand       %%mm5,%%mm0                      \n"
+  "pand       %%mm5,%%mm1                      \n"
+  "packuswb   %%mm1,%%mm0                      \n"
+  "movq       %%mm0,(%1)                       \n"
+  "lea        0x8(%1),%1                       \n"
+  "sub        $0x8,%2                          \n"
   "ja         1b                               \n"
-  : "+r"(src_ptr),     // %0
-    "+r"(dst_ptr),     // %1
-    "+r"(dst_width)    // %2
-  : "r"(_shuf38a),  // %3
-    "r"(_shuf38b)   // %4
+  "emms                                        \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
   : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm5"
+#endif
 );
 }
 
-static void ScaleRowDown38_3_Int_SSSE3(const uint8* src_ptr, int src_stride,
-                                       uint8* dst_ptr, int dst_width) {
+// Blends 16x2 rectangle to 8x1.
+static void ScaleRowDown2Int_SSE(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
   asm volatile (
-  "movdqa     (%4),%%xmm4                      \n"
-  "movdqa     (%5),%%xmm5                      \n"
-  "movdqa     (%6),%%xmm6                      \n"
-  "pxor       %%xmm7,%%xmm7                    \n"
+  "pcmpeqb    %%mm5,%%mm5                      \n"
+  "psrlw      $0x8,%%mm5                       \n"
 "1:"
-  "movdqa     (%0),%%xmm0                      \n"
-  "movdqa     (%0,%3,1),%%xmm2                 \n"
-  "movhlps    %%xmm0,%%xmm1                    \n"
-  "movhlps    %%xmm2,%%xmm3                    \n"
-  "punpcklbw  %%xmm7,%%xmm0                    \n"
-  "punpcklbw  %%xmm7,%%xmm1                    \n"
-  "punpcklbw  %%xmm7,%%xmm2                    \n"
-  "punpcklbw  %%xmm7,%%xmm3                    \n"
-  "paddusw    %%xmm2,%%xmm0                    \n"
-  "paddusw    %%xmm3,%%xmm1                    \n"
-  "movdqa     (%0,%3,2),%%xmm2                 \n"
+  "movq       (%0),%%mm0                       \n"
+  "movq       0x8(%0),%%mm1                    \n"
+  "movq       (%0,%3,1),%%mm2                  \n"
+  "movq       0x8(%0,%3,1),%%mm3               \n"
   "lea        0x10(%0),%0                      \n"
-  "movhlps    %%xmm2,%%xmm3                    \n"
-  "punpcklbw  %%xmm7,%%xmm2                    \n"
-  "punpcklbw  %%xmm7,%%xmm3                    \n"
-  "paddusw    %%xmm2,%%xmm0                    \n"
-  "paddusw    %%xmm3,%%xmm1                    \n"
-  "movdqa     %%xmm0,%%xmm2                    \n"
-  "psrldq     $0x2,%%xmm0                      \n"
-  "paddusw    %%xmm0,%%xmm2                    \n"
-  "psrldq     $0x2,%%xmm0                      \n"
-  "paddusw    %%xmm0,%%xmm2                    \n"
-  "pshufb     %%xmm4,%%xmm2                    \n"
-  "movdqa     %%xmm1,%%xmm3                    \n"
-  "psrldq     $0x2,%%xmm1                      \n"
-  "paddusw    %%xmm1,%%xmm3                    \n"
-  "psrldq     $0x2,%%xmm1                      \n"
-  "paddusw    %%xmm1,%%xmm3                    \n"
-  "pshufb     %%xmm5,%%xmm3                    \n"
-  "paddusw    %%xmm3,%%xmm2                    \n"
-  "pmulhuw    %%xmm6,%%xmm2                    \n"
-  "packuswb   %%xmm2,%%xmm2                    \n"
-  "movd       %%xmm2,(%1)                      \n"
-  "pextrw     $0x2,%%xmm2,%%eax                \n"
-  "mov        %%ax,0x4(%1)                     \n"
-  "lea        0x6(%1),%1                       \n"
-  "sub        $0x6,%2                          \n"
+  "pavgb      %%mm2,%%mm0                      \n"
+  "pavgb      %%mm3,%%mm1                      \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "psrlw      $0x8,%%mm0                       \n"
+  "movq       %%mm1,%%mm3                      \n"
+  "psrlw      $0x8,%%mm1                       \n"
+  "pand       %%mm5,%%mm2                      \n"
+  "pand       %%mm5,%%mm3                      \n"
+  "pavgw      %%mm2,%%mm0                      \n"
+  "pavgw      %%mm3,%%mm1                      \n"
+  "packuswb   %%mm1,%%mm0                      \n"
+  "movq       %%mm0,(%1)                       \n"
+  "lea        0x8(%1),%1                       \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride))   // %3
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm5"
+#endif
+);
+}
+
+// Point samples 16 pixels to 4 pixels.
+#define HAS_SCALEROWDOWN4_SSE
+static void ScaleRowDown4_SSE(const uint8* src_ptr, int src_stride,
+                              uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "pcmpeqb    %%mm5,%%mm5                      \n"
+  "psrld      $0x18,%%mm5                      \n"
+"1:"
+  "movq       (%0),%%mm0                       \n"
+  "movq       0x8(%0),%%mm1                    \n"
+  "lea        0x10(%0),%0                      \n"
+  "pand       %%mm5,%%mm0                      \n"
+  "pand       %%mm5,%%mm1                      \n"
+  "packuswb   %%mm1,%%mm0                      \n"
+  "packuswb   %%mm0,%%mm0                      \n"
+  "movd       %%mm0,(%1)                       \n"
+  "lea        0x4(%1),%1                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm5"
+#endif
+);
+}
+
+// Blends 16x4 rectangle to 4x1.
+static void ScaleRowDown4Int_SSE(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pcmpeqb    %%mm7,%%mm7                      \n"
+  "psrlw      $0x8,%%mm7                       \n"
+  "lea        (%4,%4,2),%3                     \n"
+"1:"
+  "movq       (%0),%%mm0                       \n"
+  "movq       0x8(%0),%%mm1                    \n"
+  "movq       (%0,%4,1),%%mm2                  \n"
+  "movq       0x8(%0,%4,1),%%mm3               \n"
+  "pavgb      %%mm2,%%mm0                      \n"
+  "pavgb      %%mm3,%%mm1                      \n"
+  "movq       (%0,%4,2),%%mm2                  \n"
+  "movq       0x8(%0,%4,2),%%mm3               \n"
+  "movq       (%0,%3,1),%%mm4                  \n"
+  "movq       0x8(%0,%3,1),%%mm5               \n"
+  "lea        0x10(%0),%0                      \n"
+  "pavgb      %%mm4,%%mm2                      \n"
+  "pavgb      %%mm2,%%mm0                      \n"
+  "pavgb      %%mm5,%%mm3                      \n"
+  "pavgb      %%mm3,%%mm1                      \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "psrlw      $0x8,%%mm0                       \n"
+  "movq       %%mm1,%%mm3                      \n"
+  "psrlw      $0x8,%%mm1                       \n"
+  "pand       %%mm7,%%mm2                      \n"
+  "pand       %%mm7,%%mm3                      \n"
+  "pavgw      %%mm2,%%mm0                      \n"
+  "pavgw      %%mm3,%%mm1                      \n"
+  "packuswb   %%mm1,%%mm0                      \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "psrlw      $0x8,%%mm0                       \n"
+  "pand       %%mm7,%%mm2                      \n"
+  "pavgw      %%mm2,%%mm0                      \n"
+  "packuswb   %%mm0,%%mm0                      \n"
+  "movd       %%mm0,(%1)                       \n"
+  "lea        0x4(%1),%1                       \n"
+  "sub        $0x4,%2                          \n"
   "ja         1b                               \n"
+  "emms                                        \n"
   : "+r"(src_ptr),     // %0
     "+r"(dst_ptr),     // %1
-    "+r"(dst_width)    // %2
-  : "r"(static_cast<intptr_t>(src_stride)),  // %3
-    "r"(_shufac0),   // %4
-    "r"(_shufac3),   // %5
-    "r"(_scaleac3)   // %6
-  : "memory", "cc", "rax", "xmm6", "xmm7"
+    "+r"(dst_width),   // %2
+    "+r"(temp)         // %3
+  : "r"(static_cast<intptr_t>(src_stride))    // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm4", "mm5", "mm7"
+#endif
 );
 }
 
-static void ScaleRowDown38_2_Int_SSSE3(const uint8* src_ptr, int src_stride,
-                                       uint8* dst_ptr, int dst_width) {
+// Point samples 32 pixels to 4 pixels.
+#define HAS_SCALEROWDOWN8_SSE
+static void ScaleRowDown8_SSE(const uint8* src_ptr, int src_stride,
+                              uint8* dst_ptr, int dst_width) {
   asm volatile (
-  "movdqa     (%4),%%xmm4                      \n"
-  "movdqa     (%5),%%xmm5                      \n"
-  "movdqa     (%6),%%xmm6                      \n"
-  "movdqa     (%7),%%xmm7                      \n"
+  "pcmpeqb    %%mm5,%%mm5                      \n"
+  "psrlq      $0x38,%%mm5                      \n"
 "1:"
-  "movdqa     (%0),%%xmm2                      \n"
-  "pavgb      (%0,%3,1),%%xmm2                 \n"
+  "movq       (%0),%%mm0                       \n"
+  "movq       0x8(%0),%%mm1                    \n"
+  "movq       0x10(%0),%%mm2                   \n"
+  "movq       0x18(%0),%%mm3                   \n"
+  "lea        0x20(%0),%0                      \n"
+  "pand       %%mm5,%%mm0                      \n"
+  "pand       %%mm5,%%mm1                      \n"
+  "pand       %%mm5,%%mm2                      \n"
+  "pand       %%mm5,%%mm3                      \n"
+  "packssdw   %%mm1,%%mm0                      \n"
+  "packssdw   %%mm3,%%mm2                      \n"
+  "packssdw   %%mm2,%%mm0                      \n"
+  "packuswb   %%mm0,%%mm0                      \n"
+  "movd       %%mm0,(%1)                       \n"
+  "lea        0x4(%1),%1                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm5"
+#endif
+);
+}
+
+// Averages 32x8 rectangle to 4x1.  psadbw sums each 8 pixels of a row, so
+// the 64 pixels of each box are summed exactly and rounded once.
+static void ScaleRowDown8Int_SSE(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pxor       %%mm7,%%mm7                      \n"
+  "pcmpeqb    %%mm6,%%mm6                      \n"
+  "psrlw      $0xf,%%mm6                       \n"
+  "psllw      $0x5,%%mm6                       \n"
+"1:"
+  "movq       (%0),%%mm0                       \n"
+  "movq       0x8(%0),%%mm1                    \n"
+  "movq       0x10(%0),%%mm2                   \n"
+  "movq       0x18(%0),%%mm3                   \n"
+  "lea        (%0,%4,1),%3                     \n"
+  "psadbw     %%mm7,%%mm0                      \n"
+  "psadbw     %%mm7,%%mm1                      \n"
+  "psadbw     %%mm7,%%mm2                      \n"
+  "psadbw     %%mm7,%%mm3                      \n"
+  "movq       (%3),%%mm4                       \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm0                      \n"
+  "movq       0x8(%3),%%mm4                    \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm1                      \n"
+  "movq       0x10(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm2                      \n"
+  "movq       0x18(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm3                      \n"
+  "lea        (%3,%4,1),%3                     \n"
+  "movq       (%3),%%mm4                       \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm0                      \n"
+  "movq       0x8(%3),%%mm4                    \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm1                      \n"
+  "movq       0x10(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm2                      \n"
+  "movq       0x18(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm3                      \n"
+  "lea        (%3,%4,1),%3                     \n"
+  "movq       (%3),%%mm4                       \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm0                      \n"
+  "movq       0x8(%3),%%mm4                    \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm1                      \n"
+  "movq       0x10(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm2                      \n"
+  "movq       0x18(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm3                      \n"
+  "lea        (%3,%4,1),%3                     \n"
+  "movq       (%3),%%mm4                       \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm0                      \n"
+  "movq       0x8(%3),%%mm4                    \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm1                      \n"
+  "movq       0x10(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm2                      \n"
+  "movq       0x18(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm3                      \n"
+  "lea        (%3,%4,1),%3                     \n"
+  "movq       (%3),%%mm4                       \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm0                      \n"
+  "movq       0x8(%3),%%mm4                    \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm1                      \n"
+  "movq       0x10(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm2                      \n"
+  "movq       0x18(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm3                      \n"
+  "lea        (%3,%4,1),%3                     \n"
+  "movq       (%3),%%mm4                       \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm0                      \n"
+  "movq       0x8(%3),%%mm4                    \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm1                      \n"
+  "movq       0x10(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm2                      \n"
+  "movq       0x18(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm3                      \n"
+  "lea        (%3,%4,1),%3                     \n"
+  "movq       (%3),%%mm4                       \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm0                      \n"
+  "movq       0x8(%3),%%mm4                    \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm1                      \n"
+  "movq       0x10(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm2                      \n"
+  "movq       0x18(%3),%%mm4                   \n"
+  "psadbw     %%mm7,%%mm4                      \n"
+  "paddw      %%mm4,%%mm3                      \n"
+  "punpcklwd  %%mm1,%%mm0                      \n"
+  "punpcklwd  %%mm3,%%mm2                      \n"
+  "punpckldq  %%mm2,%%mm0                      \n"
+  "paddw      %%mm6,%%mm0                      \n"
+  "psrlw      $0x6,%%mm0                       \n"
+  "packuswb   %%mm0,%%mm0                      \n"
+  "movd       %%mm0,(%1)                       \n"
+  "lea        0x20(%0),%0                      \n"
+  "lea        0x4(%1),%1                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(dst_width),   // %2
+    "+r"(temp)         // %3
+  : "r"(static_cast<intptr_t>(src_stride))    // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm4", "mm6", "mm7"
+#endif
+);
+}
+
+// Point samples 8 pixels to 6 pixels.  pshufw copies word 3 next to word 0
+// and masks keep bytes 0,1 and 7; the rest come from the source shifted by
+// one byte.  The 6 pixels are stored as 2 overlapping dwords.
+#define HAS_SCALEROWDOWN34_SSE
+static void ScaleRowDown34_SSE(const uint8* src_ptr, int src_stride,
+                               uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "movq       (%3),%%mm6                       \n"
+  "movq       0x8(%3),%%mm7                    \n"
+"1:"
+  "movq       (%0),%%mm0                       \n"
+  "lea        0x8(%0),%0                       \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "pshufw     $0xf0,%%mm0,%%mm0                \n"
+  "psrlq      $0x8,%%mm1                       \n"
+  "pand       %%mm6,%%mm0                      \n"
+  "pand       %%mm7,%%mm1                      \n"
+  "por        %%mm1,%%mm0                      \n"
+  "movd       %%mm0,(%1)                       \n"
+  "psrlq      $0x10,%%mm0                      \n"
+  "movd       %%mm0,0x2(%1)                    \n"
+  "lea        0x6(%1),%1                       \n"
+  "sub        $0x6,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  : "r"(_mask34)      // %3
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm6", "mm7"
+#endif
+);
+}
+
+// Point samples 16 pixels to 6 pixels, 3 from each 8.  pshufw moves byte 6
+// to byte 2 and the source shifted by 2 bytes supplies byte 3.
+#define HAS_SCALEROWDOWN38_SSE
+static void ScaleRowDown38_SSE(const uint8* src_ptr, int src_stride,
+                               uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "movq       (%3),%%mm6                       \n"
+  "movq       0x8(%3),%%mm7                    \n"
+"1:"
+  "movq       (%0),%%mm0                       \n"
+  "movq       0x8(%0),%%mm2                    \n"
   "lea        0x10(%0),%0                      \n"
-  "movdqa     %%xmm2,%%xmm0                    \n"
-  "pshufb     %%xmm4,%%xmm0                    \n"
-  "movdqa     %%xmm2,%%xmm1                    \n"
-  "pshufb     %%xmm5,%%xmm1                    \n"
-  "paddusw    %%xmm1,%%xmm0                    \n"
-  "pshufb     %%xmm6,%%xmm2                    \n"
-  "paddusw    %%xmm2,%%xmm0                    \n"
-  "pmulhuw    %%xmm7,%%xmm0                    \n"
-  "packuswb   %%xmm0,%%xmm0                    \n"
-  "movd       %%xmm0,(%1)                      \n"
-  "pextrw     $0x2,%%xmm0,%%eax                \n"
-  "mov        %%ax,0x4(%1)                     \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "pshufw     $0xc,%%mm0,%%mm0                 \n"
+  "pshufw     $0xc,%%mm2,%%mm2                 \n"
+  "psrlq      $0x10,%%mm1                      \n"
+  "psrlq      $0x10,%%mm3                      \n"
+  "pand       %%mm6,%%mm0                      \n"
+  "pand       %%mm6,%%mm2                      \n"
+  "pand       %%mm7,%%mm1                      \n"
+  "pand       %%mm7,%%mm3                      \n"
+  "por        %%mm1,%%mm0                      \n"
+  "por        %%mm3,%%mm2                      \n"
+  "psllq      $0x18,%%mm2                      \n"
+  "por        %%mm2,%%mm0                      \n"
+  "movd       %%mm0,(%1)                       \n"
+  "psrlq      $0x10,%%mm0                      \n"
+  "movd       %%mm0,0x2(%1)                    \n"
   "lea        0x6(%1),%1                       \n"
   "sub        $0x6,%2                          \n"
   "ja         1b                               \n"
-  : "+r"(src_ptr),     // %0
-    "+r"(dst_ptr),     // %1
-    "+r"(dst_width)    // %2
+  "emms                                        \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  : "r"(_mask38)      // %3
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm6", "mm7"
+#endif
+);
+}
+
+// Box filters 16x3 to 6x1.  Each 8 columns are summed as words, the sums of
+// columns 0-2, 3-5 and 6-7 are gathered with pshufw into words 0, 1 and 2,
+// and pmulhuw divides them exactly as ScaleRowDown38_3_Int_C does.
+static void ScaleRowDown38_3_Int_SSE(const uint8* src_ptr, int src_stride,
+                                     uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "pxor       %%mm7,%%mm7                      \n"
+  "movq       (%4),%%mm6                       \n"
+"1:"
+  "movq       (%0),%%mm0                       \n"
+  "movq       (%0,%3,1),%%mm2                  \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm7,%%mm0                      \n"
+  "punpckhbw  %%mm7,%%mm1                      \n"
+  "punpcklbw  %%mm7,%%mm2                      \n"
+  "punpckhbw  %%mm7,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm1                      \n"
+  "movq       (%0,%3,2),%%mm2                  \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm7,%%mm2                      \n"
+  "punpckhbw  %%mm7,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm1                      \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "psrlq      $0x10,%%mm2                      \n"
+  "movq       %%mm0,%%mm3                      \n"
+  "psrlq      $0x20,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm0                      \n"
+  "movq       %%mm1,%%mm2                      \n"
+  "psrlq      $0x10,%%mm2                      \n"
+  "paddw      %%mm2,%%mm1                      \n"
+  "pshufw     $0xc0,%%mm0,%%mm0                \n"
+  "psrlq      $0x20,%%mm0                      \n"
+  "pshufw     $0x8,%%mm1,%%mm1                 \n"
+  "psllq      $0x10,%%mm1                      \n"
+  "paddw      %%mm1,%%mm0                      \n"
+  "pmulhuw    %%mm6,%%mm0                      \n"
+  "packuswb   %%mm7,%%mm0                      \n"
+  "movq       %%mm0,%%mm4                      \n"
+  "movq       0x8(%0),%%mm0                    \n"
+  "movq       0x8(%0,%3,1),%%mm2               \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm7,%%mm0                      \n"
+  "punpckhbw  %%mm7,%%mm1                      \n"
+  "punpcklbw  %%mm7,%%mm2                      \n"
+  "punpckhbw  %%mm7,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm1                      \n"
+  "movq       0x8(%0,%3,2),%%mm2               \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm7,%%mm2                      \n"
+  "punpckhbw  %%mm7,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm1                      \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "psrlq      $0x10,%%mm2                      \n"
+  "movq       %%mm0,%%mm3                      \n"
+  "psrlq      $0x20,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm0                      \n"
+  "movq       %%mm1,%%mm2                      \n"
+  "psrlq      $0x10,%%mm2                      \n"
+  "paddw      %%mm2,%%mm1                      \n"
+  "pshufw     $0xc0,%%mm0,%%mm0                \n"
+  "psrlq      $0x20,%%mm0                      \n"
+  "pshufw     $0x8,%%mm1,%%mm1                 \n"
+  "psllq      $0x10,%%mm1                      \n"
+  "paddw      %%mm1,%%mm0                      \n"
+  "pmulhuw    %%mm6,%%mm0                      \n"
+  "packuswb   %%mm7,%%mm0                      \n"
+  "psllq      $0x18,%%mm0                      \n"
+  "por        %%mm4,%%mm0                      \n"
+  "movd       %%mm0,(%1)                       \n"
+  "psrlq      $0x10,%%mm0                      \n"
+  "movd       %%mm0,0x2(%1)                    \n"
+  "lea        0x10(%0),%0                      \n"
+  "lea        0x6(%1),%1                       \n"
+  "sub        $0x6,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
   : "r"(static_cast<intptr_t>(src_stride)),  // %3
-    "r"(_shufab0),   // %4
-    "r"(_shufab1),   // %5
-    "r"(_shufab2),   // %6
-    "r"(_scaleab2)   // %7
-  : "memory", "cc", "rax", "xmm6", "xmm7"
+    "r"(_scale38)     // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm4", "mm6", "mm7"
+#endif
 );
 }
 
-#define HAS_SCALEADDROWS_SSE2
-static void ScaleAddRows_SSE2(const uint8* src_ptr, int src_stride,
-                              uint16* dst_ptr, int src_width,
-                              int src_height) {
+// Box filters 16x2 to 6x1.  Same as ScaleRowDown38_2_Int_C.
+static void ScaleRowDown38_2_Int_SSE(const uint8* src_ptr, int src_stride,
+                                     uint8* dst_ptr, int dst_width) {
   asm volatile (
-  "pxor       %%xmm5,%%xmm5                    \n"
+  "pxor       %%mm7,%%mm7                      \n"
+  "movq       0x8(%4),%%mm6                    \n"
 "1:"
-  "movdqa     (%0),%%xmm2                      \n"
-  "lea        (%0,%4,1),%%r10                  \n"
-  "movhlps    %%xmm2,%%xmm3                    \n"
-  "lea        -0x1(%3),%%r11                   \n"
-  "punpcklbw  %%xmm5,%%xmm2                    \n"
-  "punpcklbw  %%xmm5,%%xmm3                    \n"
+  "movq       (%0),%%mm0                       \n"
+  "movq       (%0,%3,1),%%mm2                  \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm7,%%mm0                      \n"
+  "punpckhbw  %%mm7,%%mm1                      \n"
+  "punpcklbw  %%mm7,%%mm2                      \n"
+  "punpckhbw  %%mm7,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm1                      \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "psrlq      $0x10,%%mm2                      \n"
+  "movq       %%mm0,%%mm3                      \n"
+  "psrlq      $0x20,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm0                      \n"
+  "movq       %%mm1,%%mm2                      \n"
+  "psrlq      $0x10,%%mm2                      \n"
+  "paddw      %%mm2,%%mm1                      \n"
+  "pshufw     $0xc0,%%mm0,%%mm0                \n"
+  "psrlq      $0x20,%%mm0                      \n"
+  "pshufw     $0x8,%%mm1,%%mm1                 \n"
+  "psllq      $0x10,%%mm1                      \n"
+  "paddw      %%mm1,%%mm0                      \n"
+  "pmulhuw    %%mm6,%%mm0                      \n"
+  "packuswb   %%mm7,%%mm0                      \n"
+  "movq       %%mm0,%%mm4                      \n"
+  "movq       0x8(%0),%%mm0                    \n"
+  "movq       0x8(%0,%3,1),%%mm2               \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm7,%%mm0                      \n"
+  "punpckhbw  %%mm7,%%mm1                      \n"
+  "punpcklbw  %%mm7,%%mm2                      \n"
+  "punpckhbw  %%mm7,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm1                      \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "psrlq      $0x10,%%mm2                      \n"
+  "movq       %%mm0,%%mm3                      \n"
+  "psrlq      $0x20,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm0                      \n"
+  "movq       %%mm1,%%mm2                      \n"
+  "psrlq      $0x10,%%mm2                      \n"
+  "paddw      %%mm2,%%mm1                      \n"
+  "pshufw     $0xc0,%%mm0,%%mm0                \n"
+  "psrlq      $0x20,%%mm0                      \n"
+  "pshufw     $0x8,%%mm1,%%mm1                 \n"
+  "psllq      $0x10,%%mm1                      \n"
+  "paddw      %%mm1,%%mm0                      \n"
+  "pmulhuw    %%mm6,%%mm0                      \n"
+  "packuswb   %%mm7,%%mm0                      \n"
+  "psllq      $0x18,%%mm0                      \n"
+  "por        %%mm4,%%mm0                      \n"
+  "movd       %%mm0,(%1)                       \n"
+  "psrlq      $0x10,%%mm0                      \n"
+  "movd       %%mm0,0x2(%1)                    \n"
+  "lea        0x10(%0),%0                      \n"
+  "lea        0x6(%1),%1                       \n"
+  "sub        $0x6,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(_scale38)     // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm4", "mm6", "mm7"
+#endif
+);
+}
 
+// Reads 8xN bytes and produces 8 shorts at a time.
+#define HAS_SCALEADDROWS_MMX
+static void ScaleAddRows_MMX(const uint8* src_ptr, int src_stride,
+                             uint16* dst_ptr, int src_width,
+                             int src_height) {
+  intptr_t temp = 0;
+  intptr_t rows = 0;
+  asm volatile (
+  "pxor       %%mm5,%%mm5                      \n"
+"1:"
+  "movq       (%0),%%mm2                       \n"
+  "lea        (%0,%5,1),%3                     \n"
+  "mov        %6,%k4                           \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm5,%%mm2                      \n"
+  "punpckhbw  %%mm5,%%mm3                      \n"
+  "sub        $0x1,%4                          \n"
+  "jbe        3f                               \n"
 "2:"
-  "movdqa     (%%r10),%%xmm0                   \n"
-  "lea        (%%r10,%4,1),%%r10               \n"
-  "movhlps    %%xmm0,%%xmm1                    \n"
-  "punpcklbw  %%xmm5,%%xmm0                    \n"
-  "punpcklbw  %%xmm5,%%xmm1                    \n"
-  "paddusw    %%xmm0,%%xmm2                    \n"
-  "paddusw    %%xmm1,%%xmm3                    \n"
-  "sub        $0x1,%%r11                       \n"
+  "movq       (%3),%%mm0                       \n"
+  "lea        (%3,%5,1),%3                     \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "punpcklbw  %%mm5,%%mm0                      \n"
+  "punpckhbw  %%mm5,%%mm1                      \n"
+  "paddusw    %%mm0,%%mm2                      \n"
+  "paddusw    %%mm1,%%mm3                      \n"
+  "sub        $0x1,%4                          \n"
   "ja         2b                               \n"
-
-  "movdqa     %%xmm2,(%1)                      \n"
-  "movdqa     %%xmm3,0x10(%1)                  \n"
-  "lea        0x20(%1),%1                      \n"
-  "lea        0x10(%0),%0                      \n"
-  "sub        $0x10,%2                         \n"
+"3:"
+  "movq       %%mm2,(%1)                       \n"
+  "movq       %%mm3,0x8(%1)                    \n"
+  "lea        0x10(%1),%1                      \n"
+  "lea        0x8(%0),%0                       \n"
+  "subl       $0x8,%2                          \n"
   "ja         1b                               \n"
+  "emms                                        \n"
   : "+r"(src_ptr),     // %0
     "+r"(dst_ptr),     // %1
-    "+r"(src_width),   // %2
-    "+r"(src_height)   // %3
-  : "r"(static_cast<intptr_t>(src_stride))  // %4
-  : "memory", "cc", "r10", "r11"
+    "+rm"(src_width),  // %2
+    "+r"(temp),        // %3
+    "+r"(rows)         // %4
+  : "r"(static_cast<intptr_t>(src_stride)),  // %5
+    "rm"(src_height)   // %6
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm5"
+#endif
 );
 }
 
-// Bilinear row filtering combines 16x2 -> 16x1. SSE2 version
-#define HAS_SCALEFILTERROWS_SSE2
-static void ScaleFilterRows_SSE2(uint8* dst_ptr,
-                                 const uint8* src_ptr, int src_stride,
-                                 int dst_width, int source_y_fraction) {
-  if (source_y_fraction == 0) {
-    asm volatile (
-    "1:"
-      "movdqa     (%1),%%xmm0                  \n"
-      "lea        0x10(%1),%1                  \n"
-      "movdqa     %%xmm0,(%0)                  \n"
-      "lea        0x10(%0),%0                  \n"
-      "sub        $0x10,%2                     \n"
-      "ja         1b                           \n"
-      "mov        -0x1(%0),%%al                \n"
-      "mov        %%al,(%0)                    \n"
-      : "+r"(dst_ptr),     // %0
-        "+r"(src_ptr),     // %1
-        "+r"(dst_width)    // %2
-      :
+// Running sum of 4 shorts at a time: dst_ptr[x] is the sum of src_ptr[0]
+// to src_ptr[x].
+#define HAS_SCALEINTEGRATEROW_SSE2
+static void ScaleIntegrateRow_SSE2(const uint16* src_ptr, uint32* dst_ptr,
+                                   int width) {
+  asm volatile (
+  "pxor       %%xmm5,%%xmm5                    \n"
+  "pxor       %%xmm4,%%xmm4                    \n"
+"1:"
+  "movq       (%0),%%xmm0                      \n"
+  "lea        0x8(%0),%0                       \n"
+  "punpcklwd  %%xmm5,%%xmm0                    \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "pslldq     $0x4,%%xmm1                      \n"
+  "paddd      %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "pslldq     $0x8,%%xmm1                      \n"
+  "paddd      %%xmm1,%%xmm0                    \n"
+  "paddd      %%xmm4,%%xmm0                    \n"
+  "pshufd     $0xff,%%xmm0,%%xmm4              \n"
+  "movdqu     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(width)       // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm4", "xmm5"
+#endif
+);
+}
+
+// Bilinear column filtering.  The 16.16 positions are stepped in general
+// purpose registers, which gather each pair of source pixels and the
+// fraction into words.  The row is then filtered as
+//   a + ((b - a) * f >> 16)
+// which equals (a * (65536 - f) + b * f) >> 16 exactly.  pmulhw treats
+// fractions of 0x8000 and above as negative, so (b - a) is added back for
+// those.
+#define HAS_SCALEFILTERCOLS_SSE2
+static void ScaleFilterCols_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                 int dst_width, int x, int dx) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pcmpeqb    %%xmm7,%%xmm7                    \n"
+  "psrlw      $0x8,%%xmm7                      \n"
+"1:"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x0,%k4,%%xmm0                  \n"
+  "pinsrw     $0x0,%3,%%xmm1                   \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x1,%k4,%%xmm0                  \n"
+  "pinsrw     $0x1,%3,%%xmm1                   \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x2,%k4,%%xmm0                  \n"
+  "pinsrw     $0x2,%3,%%xmm1                   \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x3,%k4,%%xmm0                  \n"
+  "pinsrw     $0x3,%3,%%xmm1                   \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x4,%k4,%%xmm0                  \n"
+  "pinsrw     $0x4,%3,%%xmm1                   \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x5,%k4,%%xmm0                  \n"
+  "pinsrw     $0x5,%3,%%xmm1                   \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x6,%k4,%%xmm0                  \n"
+  "pinsrw     $0x6,%3,%%xmm1                   \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x7,%k4,%%xmm0                  \n"
+  "pinsrw     $0x7,%3,%%xmm1                   \n"
+  "add        %5,%3                            \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "pand       %%xmm7,%%xmm0                    \n"
+  "psrlw      $0x8,%%xmm2                      \n"
+  "psubw      %%xmm0,%%xmm2                    \n"
+  "movdqa     %%xmm1,%%xmm3                    \n"
+  "psraw      $0xf,%%xmm3                      \n"
+  "pand       %%xmm2,%%xmm3                    \n"
+  "pmulhw     %%xmm1,%%xmm2                    \n"
+  "paddw      %%xmm3,%%xmm2                    \n"
+  "paddw      %%xmm0,%%xmm2                    \n"
+  "packuswb   %%xmm2,%%xmm2                    \n"
+  "movq       %%xmm2,(%0)                      \n"
+  "lea        0x8(%0),%0                       \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width),   // %2
+    "+r"(x),           // %3
+    "+r"(temp)         // %4
+  : "rm"(dx)           // %5
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm7"
+#endif
+);
+}
+
+// Bilinear column filtering.  MMX version of ScaleFilterCols_SSE2 for
+// processors with SSE but not SSE2.  pinsrw is an SSE instruction.
+#define HAS_SCALEFILTERCOLS_SSE
+static void ScaleFilterCols_SSE(uint8* dst_ptr, const uint8* src_ptr,
+                                int dst_width, int x, int dx) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pcmpeqb    %%mm7,%%mm7                      \n"
+  "psrlw      $0x8,%%mm7                       \n"
+"1:"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x0,%k4,%%mm0                   \n"
+  "pinsrw     $0x0,%3,%%mm1                    \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x1,%k4,%%mm0                   \n"
+  "pinsrw     $0x1,%3,%%mm1                    \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x2,%k4,%%mm0                   \n"
+  "pinsrw     $0x2,%3,%%mm1                    \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movzwl     (%1,%4,1),%k4                    \n"
+  "pinsrw     $0x3,%k4,%%mm0                   \n"
+  "pinsrw     $0x3,%3,%%mm1                    \n"
+  "add        %5,%3                            \n"
+  "movq     %%mm0,%%mm2                        \n"
+  "pand       %%mm7,%%mm0                      \n"
+  "psrlw      $0x8,%%mm2                       \n"
+  "psubw      %%mm0,%%mm2                      \n"
+  "movq     %%mm1,%%mm3                        \n"
+  "psraw      $0xf,%%mm3                       \n"
+  "pand       %%mm2,%%mm3                      \n"
+  "pmulhw     %%mm1,%%mm2                      \n"
+  "paddw      %%mm3,%%mm2                      \n"
+  "paddw      %%mm0,%%mm2                      \n"
+  "packuswb   %%mm2,%%mm2                      \n"
+  "movd       %%mm2,(%0)                       \n"
+  "lea        0x4(%0),%0                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width),   // %2
+    "+r"(x),           // %3
+    "+r"(temp)         // %4
+  : "rm"(dx)           // %5
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm7"
+#endif
+);
+}
+
+// Upscale a row by 2 by duplicating each pixel.
+// Alignment requirement: none.
+#define HAS_SCALECOLSUP2_SSE2
+static void ScaleColsUp2_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                              int dst_width) {
+  asm volatile (
+"1:"
+  "movdqu     (%1),%%xmm0                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "punpcklbw  %%xmm0,%%xmm0                    \n"
+  "punpckhbw  %%xmm1,%%xmm1                    \n"
+  "movdqu     %%xmm0,(%0)                      \n"
+  "movdqu     %%xmm1,0x10(%0)                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "sub        $0x20,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1"
+#endif
+);
+}
+
+#define HAS_SCALECOLSUP2_MMX
+static void ScaleColsUp2_MMX(uint8* dst_ptr, const uint8* src_ptr,
+                             int dst_width) {
+  asm volatile (
+"1:"
+  "movq       (%1),%%mm0                       \n"
+  "lea        0x8(%1),%1                       \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "punpcklbw  %%mm0,%%mm0                      \n"
+  "punpckhbw  %%mm1,%%mm1                      \n"
+  "movq       %%mm0,(%0)                       \n"
+  "movq       %%mm1,0x8(%0)                    \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x10,%2                         \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1"
+#endif
+);
+}
+
+// Bilinear upscale a row by 2.  Odd pixels are the average of their
+// neighbours, rounded down to match ScaleFilterCols_C.  pavgb rounds up, so
+// the low bit of a ^ b is subtracted.
+// Reads one pixel past the end of the source row.
+// Writes up to 31 pixels past dst_width.
+#define HAS_SCALEFILTERCOLSUP2_SSE2
+static void ScaleFilterColsUp2_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                    int dst_width, int, int) {
+  asm volatile (
+  "pcmpeqb    %%xmm7,%%xmm7                    \n"
+  "psrlw      $0xf,%%xmm7                      \n"
+  "packuswb   %%xmm7,%%xmm7                    \n"
+"1:"
+  "movdqu     (%1),%%xmm0                      \n"
+  "movdqu     0x1(%1),%%xmm1                   \n"
+  "lea        0x10(%1),%1                      \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "pxor       %%xmm1,%%xmm2                    \n"
+  "pand       %%xmm7,%%xmm2                    \n"
+  "pavgb      %%xmm0,%%xmm1                    \n"
+  "psubb      %%xmm2,%%xmm1                    \n"
+  "movdqa     %%xmm0,%%xmm3                    \n"
+  "punpcklbw  %%xmm1,%%xmm0                    \n"
+  "punpckhbw  %%xmm1,%%xmm3                    \n"
+  "movdqu     %%xmm0,(%0)                      \n"
+  "movdqu     %%xmm3,0x10(%0)                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "sub        $0x20,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm7"
+#endif
+);
+}
+
+// MMX version of ScaleFilterColsUp2_SSE2.  pavgb is an SSE instruction.
+// Writes up to 15 pixels past dst_width.
+#define HAS_SCALEFILTERCOLSUP2_SSE
+static void ScaleFilterColsUp2_SSE(uint8* dst_ptr, const uint8* src_ptr,
+                                   int dst_width, int, int) {
+  asm volatile (
+  "pcmpeqb    %%mm7,%%mm7                      \n"
+  "psrlw      $0xf,%%mm7                       \n"
+  "packuswb   %%mm7,%%mm7                      \n"
+"1:"
+  "movq       (%1),%%mm0                       \n"
+  "movq       0x1(%1),%%mm1                    \n"
+  "lea        0x8(%1),%1                       \n"
+  "movq       %%mm0,%%mm2                      \n"
+  "pxor       %%mm1,%%mm2                      \n"
+  "pand       %%mm7,%%mm2                      \n"
+  "pavgb      %%mm0,%%mm1                      \n"
+  "psubb      %%mm2,%%mm1                      \n"
+  "movq       %%mm0,%%mm3                      \n"
+  "punpcklbw  %%mm1,%%mm0                      \n"
+  "punpckhbw  %%mm1,%%mm3                      \n"
+  "movq       %%mm0,(%0)                       \n"
+  "movq       %%mm3,0x8(%0)                    \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x10,%2                         \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm7"
+#endif
+);
+}
+
+// Bilinear upscale a row by 3/2.  8 source pixels make 12 destination
+// pixels, filtered with the coefficients in _up32.
+// Reads up to 16 pixels past the end of the source row.
+// Writes up to 15 pixels past dst_width.
+#define HAS_SCALEFILTERCOLSUP32_SSSE3
+static void ScaleFilterColsUp32_SSSE3(uint8* dst_ptr, const uint8* src_ptr,
+                                      int dst_width, int, int) {
+  asm volatile (
+  "movdqa     (%3),%%xmm2                      \n"
+  "movdqa     0x10(%3),%%xmm3                  \n"
+  "movdqa     0x20(%3),%%xmm4                  \n"
+  "movdqa     0x30(%3),%%xmm5                  \n"
+  "pcmpeqb    %%xmm6,%%xmm6                    \n"
+  "psrlw      $0xf,%%xmm6                      \n"
+  "psllw      $0x5,%%xmm6                      \n"
+"1:"
+  "movdqu     (%1),%%xmm0                      \n"
+  "lea        0x8(%1),%1                       \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "pshufb     %%xmm2,%%xmm0                    \n"
+  "pshufb     %%xmm3,%%xmm1                    \n"
+  "pmaddubsw  %%xmm4,%%xmm0                    \n"
+  "pmaddubsw  %%xmm5,%%xmm1                    \n"
+  "paddsw     %%xmm6,%%xmm0                    \n"
+  "paddsw     %%xmm6,%%xmm1                    \n"
+  "psrlw      $0x6,%%xmm0                      \n"
+  "psrlw      $0x6,%%xmm1                      \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqu     %%xmm0,(%0)                      \n"
+  "lea        0xc(%0),%0                       \n"
+  "sub        $0xc,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(_up32)         // %3
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6"
+#endif
+);
+}
+
+// Bilinear upscale a row by 4/3.  12 source pixels make 16 destination
+// pixels, filtered with the coefficients in _up43.
+// Reads up to 22 pixels past the end of the source row.
+// Writes up to 15 pixels past dst_width.
+#define HAS_SCALEFILTERCOLSUP43_SSSE3
+static void ScaleFilterColsUp43_SSSE3(uint8* dst_ptr, const uint8* src_ptr,
+                                      int dst_width, int, int) {
+  asm volatile (
+  "movdqa     (%3),%%xmm2                      \n"
+  "movdqa     0x10(%3),%%xmm4                  \n"
+  "pcmpeqb    %%xmm6,%%xmm6                    \n"
+  "psrlw      $0xf,%%xmm6                      \n"
+  "psllw      $0x5,%%xmm6                      \n"
+"1:"
+  "movdqu     (%1),%%xmm0                      \n"
+  "movdqu     0x6(%1),%%xmm1                   \n"
+  "lea        0xc(%1),%1                       \n"
+  "pshufb     %%xmm2,%%xmm0                    \n"
+  "pshufb     %%xmm2,%%xmm1                    \n"
+  "pmaddubsw  %%xmm4,%%xmm0                    \n"
+  "pmaddubsw  %%xmm4,%%xmm1                    \n"
+  "paddsw     %%xmm6,%%xmm0                    \n"
+  "paddsw     %%xmm6,%%xmm1                    \n"
+  "psrlw      $0x6,%%xmm0                      \n"
+  "psrlw      $0x6,%%xmm1                      \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqu     %%xmm0,(%0)                      \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x10,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(_up43)         // %3
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm4", "xmm6"
+#endif
+);
+}
+
+// Blend 2 rows as (row0 * (256 - f) + row1 * f) >> 8.
+// Alignment requirement: src0_ptr and src1_ptr 16 byte aligned.
+#define HAS_SCALEBLENDROWS_SSE2
+static void ScaleBlendRows_SSE2(uint8* dst_ptr, const uint8* src0_ptr,
+                                const uint8* src1_ptr, int dst_width,
+                                int source_y_fraction) {
+  asm volatile (
+  "movd       %4,%%xmm6                        \n"
+  "punpcklwd  %%xmm6,%%xmm6                    \n"
+  "pshufd     $0x0,%%xmm6,%%xmm6               \n"
+  "pcmpeqb    %%xmm5,%%xmm5                    \n"
+  "psrlw      $0xf,%%xmm5                      \n"
+  "psllw      $0x8,%%xmm5                      \n"
+  "psubw      %%xmm6,%%xmm5                    \n"
+  "pxor       %%xmm7,%%xmm7                    \n"
+"1:"
+  "movdqa     (%1),%%xmm0                      \n"
+  "movdqa     (%2),%%xmm2                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "lea        0x10(%2),%2                      \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "movdqa     %%xmm2,%%xmm3                    \n"
+  "punpcklbw  %%xmm7,%%xmm0                    \n"
+  "punpcklbw  %%xmm7,%%xmm2                    \n"
+  "punpckhbw  %%xmm7,%%xmm1                    \n"
+  "punpckhbw  %%xmm7,%%xmm3                    \n"
+  "pmullw     %%xmm5,%%xmm0                    \n"
+  "pmullw     %%xmm5,%%xmm1                    \n"
+  "pmullw     %%xmm6,%%xmm2                    \n"
+  "pmullw     %%xmm6,%%xmm3                    \n"
+  "paddw      %%xmm2,%%xmm0                    \n"
+  "paddw      %%xmm3,%%xmm1                    \n"
+  "psrlw      $0x8,%%xmm0                      \n"
+  "psrlw      $0x8,%%xmm1                      \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqu     %%xmm0,(%0)                      \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x10,%3                         \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src0_ptr),    // %1
+    "+r"(src1_ptr),    // %2
+    "+r"(dst_width)    // %3
+  : "r"(source_y_fraction)  // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "xmm6", "xmm7"
+#endif
+);
+}
+
+#define HAS_SCALEBLENDROWS_MMX
+static void ScaleBlendRows_MMX(uint8* dst_ptr, const uint8* src0_ptr,
+                               const uint8* src1_ptr, int dst_width,
+                               int source_y_fraction) {
+  asm volatile (
+  "movd       %4,%%mm6                         \n"
+  "punpcklwd  %%mm6,%%mm6                      \n"
+  "punpckldq  %%mm6,%%mm6                      \n"
+  "pcmpeqb    %%mm5,%%mm5                      \n"
+  "psrlw      $0xf,%%mm5                       \n"
+  "psllw      $0x8,%%mm5                       \n"
+  "psubw      %%mm6,%%mm5                      \n"
+  "pxor       %%mm7,%%mm7                      \n"
+"1:"
+  "movq       (%1),%%mm0                       \n"
+  "movq       (%2),%%mm2                       \n"
+  "lea        0x8(%1),%1                       \n"
+  "lea        0x8(%2),%2                       \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm7,%%mm0                      \n"
+  "punpcklbw  %%mm7,%%mm2                      \n"
+  "punpckhbw  %%mm7,%%mm1                      \n"
+  "punpckhbw  %%mm7,%%mm3                      \n"
+  "pmullw     %%mm5,%%mm0                      \n"
+  "pmullw     %%mm5,%%mm1                      \n"
+  "pmullw     %%mm6,%%mm2                      \n"
+  "pmullw     %%mm6,%%mm3                      \n"
+  "paddw      %%mm2,%%mm0                      \n"
+  "paddw      %%mm3,%%mm1                      \n"
+  "psrlw      $0x8,%%mm0                       \n"
+  "psrlw      $0x8,%%mm1                       \n"
+  "packuswb   %%mm1,%%mm0                      \n"
+  "movq       %%mm0,(%0)                       \n"
+  "lea        0x8(%0),%0                       \n"
+  "sub        $0x8,%3                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src0_ptr),    // %1
+    "+r"(src1_ptr),    // %2
+    "+r"(dst_width)    // %3
+  : "r"(source_y_fraction)  // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm5", "mm6", "mm7"
+#endif
+);
+}
+
+// Accumulate 2 rows of a vertical polyphase filter into 32 bit sums.
+// coeffs holds the coefficient for src0_ptr in the low 16 bits and the
+// coefficient for src1_ptr in the high 16 bits.
+// Alignment requirement: dst_acc 16 byte aligned.
+#define HAS_SCALEACCUMROWS2_SSE2
+static void ScaleAccumRows2_SSE2(int32* dst_acc, const uint8* src0_ptr,
+                                 const uint8* src1_ptr, int src_width,
+                                 int coeffs) {
+  asm volatile (
+  "movd       %4,%%xmm7                        \n"
+  "pshufd     $0x0,%%xmm7,%%xmm7               \n"
+  "pxor       %%xmm6,%%xmm6                    \n"
+"1:"
+  "movq       (%1),%%xmm0                      \n"
+  "movq       (%2),%%xmm1                      \n"
+  "lea        0x8(%1),%1                       \n"
+  "lea        0x8(%2),%2                       \n"
+  "punpcklbw  %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "punpcklbw  %%xmm6,%%xmm0                    \n"
+  "punpckhbw  %%xmm6,%%xmm1                    \n"
+  "pmaddwd    %%xmm7,%%xmm0                    \n"
+  "pmaddwd    %%xmm7,%%xmm1                    \n"
+  "paddd      (%0),%%xmm0                      \n"
+  "paddd      0x10(%0),%%xmm1                  \n"
+  "movdqa     %%xmm0,(%0)                      \n"
+  "movdqa     %%xmm1,0x10(%0)                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "sub        $0x8,%3                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_acc),     // %0
+    "+r"(src0_ptr),    // %1
+    "+r"(src1_ptr),    // %2
+    "+r"(src_width)    // %3
+  : "r"(coeffs)        // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm6", "xmm7"
+#endif
+);
+}
+
+#define HAS_SCALEACCUMROWS2_MMX
+static void ScaleAccumRows2_MMX(int32* dst_acc, const uint8* src0_ptr,
+                                const uint8* src1_ptr, int src_width,
+                                int coeffs) {
+  asm volatile (
+  "movd       %4,%%mm7                         \n"
+  "punpckldq  %%mm7,%%mm7                      \n"
+  "pxor       %%mm6,%%mm6                      \n"
+"1:"
+  "movd       (%1),%%mm0                       \n"
+  "movd       (%2),%%mm1                       \n"
+  "lea        0x4(%1),%1                       \n"
+  "lea        0x4(%2),%2                       \n"
+  "punpcklbw  %%mm1,%%mm0                      \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "punpcklbw  %%mm6,%%mm0                      \n"
+  "punpckhbw  %%mm6,%%mm1                      \n"
+  "pmaddwd    %%mm7,%%mm0                      \n"
+  "pmaddwd    %%mm7,%%mm1                      \n"
+  "paddd      (%0),%%mm0                       \n"
+  "paddd      0x8(%0),%%mm1                    \n"
+  "movq       %%mm0,(%0)                       \n"
+  "movq       %%mm1,0x8(%0)                    \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x4,%3                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(dst_acc),     // %0
+    "+r"(src0_ptr),    // %1
+    "+r"(src1_ptr),    // %2
+    "+r"(src_width)    // %3
+  : "r"(coeffs)        // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm6", "mm7"
+#endif
+);
+}
+
+// Shift 32 bit sums of a polyphase filter down to pixels.
+// Writes up to 7 pixels past width.
+// Alignment requirement: src_acc 16 byte aligned.
+#define HAS_SCALEPACKROW_SSE2
+static void ScalePackRow_SSE2(uint8* dst_ptr, const int32* src_acc,
+                              int width) {
+  asm volatile (
+"1:"
+  "movdqa     (%1),%%xmm0                      \n"
+  "movdqa     0x10(%1),%%xmm1                  \n"
+  "lea        0x20(%1),%1                      \n"
+  "psrad      $0xe,%%xmm0                      \n"
+  "psrad      $0xe,%%xmm1                      \n"
+  "packssdw   %%xmm1,%%xmm0                    \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movq       %%xmm0,(%0)                      \n"
+  "lea        0x8(%0),%0                       \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_acc),     // %1
+    "+r"(width)        // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1"
+#endif
+);
+}
+
+// Writes up to 3 pixels past width.
+#define HAS_SCALEPACKROW_MMX
+static void ScalePackRow_MMX(uint8* dst_ptr, const int32* src_acc,
+                             int width) {
+  asm volatile (
+"1:"
+  "movq       (%1),%%mm0                       \n"
+  "movq       0x8(%1),%%mm1                    \n"
+  "lea        0x10(%1),%1                      \n"
+  "psrad      $0xe,%%mm0                       \n"
+  "psrad      $0xe,%%mm1                       \n"
+  "packssdw   %%mm1,%%mm0                      \n"
+  "packuswb   %%mm0,%%mm0                      \n"
+  "movd       %%mm0,(%0)                       \n"
+  "lea        0x4(%0),%0                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_acc),     // %1
+    "+r"(width)        // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1"
+#endif
+);
+}
+
+// Horizontal polyphase filter with 8 taps, 4 pixels at a time.  Each pixel
+// is a pmaddwd of 8 source pixels with its coefficients, and the 4 sets of
+// partial sums are then transposed and added.
+#define HAS_SCALEFILTERCOLS8_SSE2
+static void ScaleFilterCols8_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                  int dst_width, const ScaleFilterPos* pos,
+                                  int) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pxor       %%xmm5,%%xmm5                    \n"
+  "pcmpeqb    %%xmm7,%%xmm7                    \n"
+  "psrld      $0x1f,%%xmm7                     \n"
+  "pslld      $0xd,%%xmm7                      \n"
+"1:"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%xmm0                 \n"
+  "mov        %c6(%3),%4                       \n"
+  "punpcklbw  %%xmm5,%%xmm0                    \n"
+  "pmaddwd    (%4),%%xmm0                      \n"
+  "lea        %c5(%3),%3                       \n"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%xmm1                 \n"
+  "mov        %c6(%3),%4                       \n"
+  "punpcklbw  %%xmm5,%%xmm1                    \n"
+  "pmaddwd    (%4),%%xmm1                      \n"
+  "lea        %c5(%3),%3                       \n"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%xmm2                 \n"
+  "mov        %c6(%3),%4                       \n"
+  "punpcklbw  %%xmm5,%%xmm2                    \n"
+  "pmaddwd    (%4),%%xmm2                      \n"
+  "lea        %c5(%3),%3                       \n"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%xmm3                 \n"
+  "mov        %c6(%3),%4                       \n"
+  "punpcklbw  %%xmm5,%%xmm3                    \n"
+  "pmaddwd    (%4),%%xmm3                      \n"
+  "lea        %c5(%3),%3                       \n"
+  "movdqa     %%xmm0,%%xmm4                    \n"
+  "punpckldq  %%xmm1,%%xmm0                    \n"
+  "punpckhdq  %%xmm1,%%xmm4                    \n"
+  "paddd      %%xmm4,%%xmm0                    \n"
+  "movdqa     %%xmm2,%%xmm6                    \n"
+  "punpckldq  %%xmm3,%%xmm2                    \n"
+  "punpckhdq  %%xmm3,%%xmm6                    \n"
+  "paddd      %%xmm6,%%xmm2                    \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "punpcklqdq %%xmm2,%%xmm0                    \n"
+  "punpckhqdq %%xmm2,%%xmm1                    \n"
+  "paddd      %%xmm1,%%xmm0                    \n"
+  "paddd      %%xmm7,%%xmm0                    \n"
+  "psrad      $0xe,%%xmm0                      \n"
+  "packssdw   %%xmm0,%%xmm0                    \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movd       %%xmm0,(%0)                      \n"
+  "lea        0x4(%0),%0                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width),   // %2
+    "+r"(pos),         // %3
+    "+r"(temp)         // %4
+  : "i"(sizeof(ScaleFilterPos)),  // %5
+    "i"(sizeof(intptr_t))         // %6
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7"
+#endif
+);
+}
+
+// Horizontal polyphase filter with 16 taps, 4 pixels at a time.
+#define HAS_SCALEFILTERCOLS16_SSE2
+static void ScaleFilterCols16_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                   int dst_width, const ScaleFilterPos* pos,
+                                   int) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pxor       %%xmm5,%%xmm5                    \n"
+  "pcmpeqb    %%xmm7,%%xmm7                    \n"
+  "psrld      $0x1f,%%xmm7                     \n"
+  "pslld      $0xd,%%xmm7                      \n"
+"1:"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%xmm0                 \n"
+  "movq       0x8(%1,%4,1),%%xmm6              \n"
+  "mov        %c6(%3),%4                       \n"
+  "punpcklbw  %%xmm5,%%xmm0                    \n"
+  "punpcklbw  %%xmm5,%%xmm6                    \n"
+  "pmaddwd    (%4),%%xmm0                      \n"
+  "pmaddwd    0x10(%4),%%xmm6                  \n"
+  "paddd      %%xmm6,%%xmm0                    \n"
+  "lea        %c5(%3),%3                       \n"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%xmm1                 \n"
+  "movq       0x8(%1,%4,1),%%xmm6              \n"
+  "mov        %c6(%3),%4                       \n"
+  "punpcklbw  %%xmm5,%%xmm1                    \n"
+  "punpcklbw  %%xmm5,%%xmm6                    \n"
+  "pmaddwd    (%4),%%xmm1                      \n"
+  "pmaddwd    0x10(%4),%%xmm6                  \n"
+  "paddd      %%xmm6,%%xmm1                    \n"
+  "lea        %c5(%3),%3                       \n"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%xmm2                 \n"
+  "movq       0x8(%1,%4,1),%%xmm6              \n"
+  "mov        %c6(%3),%4                       \n"
+  "punpcklbw  %%xmm5,%%xmm2                    \n"
+  "punpcklbw  %%xmm5,%%xmm6                    \n"
+  "pmaddwd    (%4),%%xmm2                      \n"
+  "pmaddwd    0x10(%4),%%xmm6                  \n"
+  "paddd      %%xmm6,%%xmm2                    \n"
+  "lea        %c5(%3),%3                       \n"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%xmm3                 \n"
+  "movq       0x8(%1,%4,1),%%xmm6              \n"
+  "mov        %c6(%3),%4                       \n"
+  "punpcklbw  %%xmm5,%%xmm3                    \n"
+  "punpcklbw  %%xmm5,%%xmm6                    \n"
+  "pmaddwd    (%4),%%xmm3                      \n"
+  "pmaddwd    0x10(%4),%%xmm6                  \n"
+  "paddd      %%xmm6,%%xmm3                    \n"
+  "lea        %c5(%3),%3                       \n"
+  "movdqa     %%xmm0,%%xmm4                    \n"
+  "punpckldq  %%xmm1,%%xmm0                    \n"
+  "punpckhdq  %%xmm1,%%xmm4                    \n"
+  "paddd      %%xmm4,%%xmm0                    \n"
+  "movdqa     %%xmm2,%%xmm6                    \n"
+  "punpckldq  %%xmm3,%%xmm2                    \n"
+  "punpckhdq  %%xmm3,%%xmm6                    \n"
+  "paddd      %%xmm6,%%xmm2                    \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "punpcklqdq %%xmm2,%%xmm0                    \n"
+  "punpckhqdq %%xmm2,%%xmm1                    \n"
+  "paddd      %%xmm1,%%xmm0                    \n"
+  "paddd      %%xmm7,%%xmm0                    \n"
+  "psrad      $0xe,%%xmm0                      \n"
+  "packssdw   %%xmm0,%%xmm0                    \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movd       %%xmm0,(%0)                      \n"
+  "lea        0x4(%0),%0                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width),   // %2
+    "+r"(pos),         // %3
+    "+r"(temp)         // %4
+  : "i"(sizeof(ScaleFilterPos)),  // %5
+    "i"(sizeof(intptr_t))         // %6
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7"
+#endif
+);
+}
+
+// Horizontal polyphase filter with 8 taps, 2 pixels at a time.
+#define HAS_SCALEFILTERCOLS8_MMX
+static void ScaleFilterCols8_MMX(uint8* dst_ptr, const uint8* src_ptr,
+                                 int dst_width, const ScaleFilterPos* pos,
+                                 int) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pxor       %%mm5,%%mm5                      \n"
+  "pcmpeqb    %%mm7,%%mm7                      \n"
+  "psrld      $0x1f,%%mm7                      \n"
+  "pslld      $0xd,%%mm7                       \n"
+"1:"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%mm0                  \n"
+  "mov        %c6(%3),%4                       \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "punpcklbw  %%mm5,%%mm0                      \n"
+  "punpckhbw  %%mm5,%%mm1                      \n"
+  "pmaddwd    (%4),%%mm0                       \n"
+  "pmaddwd    0x8(%4),%%mm1                    \n"
+  "paddd      %%mm1,%%mm0                      \n"
+  "lea        %c5(%3),%3                       \n"
+  "mov        (%3),%4                          \n"
+  "movq       (%1,%4,1),%%mm2                  \n"
+  "mov        %c6(%3),%4                       \n"
+  "movq       %%mm2,%%mm3                      \n"
+  "punpcklbw  %%mm5,%%mm2                      \n"
+  "punpckhbw  %%mm5,%%mm3                      \n"
+  "pmaddwd    (%4),%%mm2                       \n"
+  "pmaddwd    0x8(%4),%%mm3                    \n"
+  "paddd      %%mm3,%%mm2                      \n"
+  "lea        %c5(%3),%3                       \n"
+  "movq       %%mm0,%%mm1                      \n"
+  "punpckldq  %%mm2,%%mm0                      \n"
+  "punpckhdq  %%mm2,%%mm1                      \n"
+  "paddd      %%mm1,%%mm0                      \n"
+  "paddd      %%mm7,%%mm0                      \n"
+  "psrad      $0xe,%%mm0                       \n"
+  "packssdw   %%mm0,%%mm0                      \n"
+  "packuswb   %%mm0,%%mm0                      \n"
+  "movd       %%mm0,%k4                        \n"
+  "mov        %w4,(%0)                         \n"
+  "lea        0x2(%0),%0                       \n"
+  "sub        $0x2,%2                          \n"
+  "ja         1b                               \n"
+  "emms                                        \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width),   // %2
+    "+r"(pos),         // %3
+    "+r"(temp)         // %4
+  : "i"(sizeof(ScaleFilterPos)),  // %5
+    "i"(sizeof(intptr_t))         // %6
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "mm0", "mm1", "mm2", "mm3", "mm5", "mm7"
+#endif
+);
+}
+
+#if defined(__i386__)
+extern "C" void ScaleRowDown8Int_SSE2(const uint8* src_ptr, int src_stride,
+                                      uint8* dst_ptr, int dst_width);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleRowDown8Int_SSE2             \n"
+"_ScaleRowDown8Int_SSE2:                       \n"
+#else
+    ".global ScaleRowDown8Int_SSE2             \n"
+"ScaleRowDown8Int_SSE2:                        \n"
+#endif
+    "pusha                                     \n"
+    "mov    0x24(%esp),%esi                    \n"
+    "mov    0x28(%esp),%ebx                    \n"
+    "mov    0x2c(%esp),%edi                    \n"
+    "mov    0x30(%esp),%ecx                    \n"
+    "lea    (%ebx,%ebx,2),%edx                 \n"
+    "pxor   %xmm7,%xmm7                        \n"
+
+"1:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa 0x10(%esi),%xmm1                   \n"
+    "movdqa (%esi,%ebx,1),%xmm2                \n"
+    "movdqa 0x10(%esi,%ebx,1),%xmm3            \n"
+    "pavgb  %xmm2,%xmm0                        \n"
+    "pavgb  %xmm3,%xmm1                        \n"
+    "movdqa (%esi,%ebx,2),%xmm2                \n"
+    "movdqa 0x10(%esi,%ebx,2),%xmm3            \n"
+    "movdqa (%esi,%edx,1),%xmm4                \n"
+    "movdqa 0x10(%esi,%edx,1),%xmm5            \n"
+    "lea    (%esi,%ebx,4),%ebp                 \n"
+    "lea    0x20(%esi),%esi                    \n"
+    "pavgb  %xmm4,%xmm2                        \n"
+    "pavgb  %xmm5,%xmm3                        \n"
+    "pavgb  %xmm2,%xmm0                        \n"
+    "pavgb  %xmm3,%xmm1                        \n"
+    "movdqa 0x0(%ebp),%xmm2                    \n"
+    "movdqa 0x10(%ebp),%xmm3                   \n"
+    "movdqa 0x0(%ebp,%ebx,1),%xmm4             \n"
+    "movdqa 0x10(%ebp,%ebx,1),%xmm5            \n"
+    "pavgb  %xmm4,%xmm2                        \n"
+    "pavgb  %xmm5,%xmm3                        \n"
+    "movdqa 0x0(%ebp,%ebx,2),%xmm4             \n"
+    "movdqa 0x10(%ebp,%ebx,2),%xmm5            \n"
+    "movdqa 0x0(%ebp,%edx,1),%xmm6             \n"
+    "pavgb  %xmm6,%xmm4                        \n"
+    "movdqa 0x10(%ebp,%edx,1),%xmm6            \n"
+    "pavgb  %xmm6,%xmm5                        \n"
+    "pavgb  %xmm4,%xmm2                        \n"
+    "pavgb  %xmm5,%xmm3                        \n"
+    "pavgb  %xmm2,%xmm0                        \n"
+    "pavgb  %xmm3,%xmm1                        \n"
+    "psadbw %xmm7,%xmm0                        \n"
+    "psadbw %xmm7,%xmm1                        \n"
+    "pshufd $0xd8,%xmm0,%xmm0                  \n"
+    "pshufd $0x8d,%xmm1,%xmm1                  \n"
+    "por    %xmm1,%xmm0                        \n"
+    "psrlw  $0x3,%xmm0                         \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "movd   %xmm0,(%edi)                       \n"
+    "lea    0x4(%edi),%edi                     \n"
+    "sub    $0x4,%ecx                          \n"
+    "ja     1b                                 \n"
+    "popa                                      \n"
+    "ret                                       \n"
+);
+
+// fpic is used for magiccam plugin
+#if !defined(__PIC__)
+#define HAS_SCALEROWDOWN34_SSSE3
+extern "C" void ScaleRowDown34_SSSE3(const uint8* src_ptr, int src_stride,
+                                     uint8* dst_ptr, int dst_width);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleRowDown34_SSSE3              \n"
+"_ScaleRowDown34_SSSE3:                        \n"
+#else
+    ".global ScaleRowDown34_SSSE3              \n"
+"ScaleRowDown34_SSSE3:                         \n"
+#endif
+    "pusha                                     \n"
+    "mov    0x24(%esp),%esi                    \n"
+    "mov    0x2c(%esp),%edi                    \n"
+    "mov    0x30(%esp),%ecx                    \n"
+    "movdqa _shuf0,%xmm3                       \n"
+    "movdqa _shuf1,%xmm4                       \n"
+    "movdqa _shuf2,%xmm5                       \n"
+
+"1:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa 0x10(%esi),%xmm2                   \n"
+    "lea    0x20(%esi),%esi                    \n"
+    "movdqa %xmm2,%xmm1                        \n"
+    "palignr $0x8,%xmm0,%xmm1                  \n"
+    "pshufb %xmm3,%xmm0                        \n"
+    "pshufb %xmm4,%xmm1                        \n"
+    "pshufb %xmm5,%xmm2                        \n"
+    "movq   %xmm0,(%edi)                       \n"
+    "movq   %xmm1,0x8(%edi)                    \n"
+    "movq   %xmm2,0x10(%edi)                   \n"
+    "lea    0x18(%edi),%edi                    \n"
+    "sub    $0x18,%ecx                         \n"
+    "ja     1b                                 \n"
+    "popa                                      \n"
+    "ret                                       \n"
+);
+
+extern "C" void ScaleRowDown34_1_Int_SSSE3(const uint8* src_ptr, int src_stride,
+                                           uint8* dst_ptr, int dst_width);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleRowDown34_1_Int_SSSE3        \n"
+"_ScaleRowDown34_1_Int_SSSE3:                  \n"
+#else
+    ".global ScaleRowDown34_1_Int_SSSE3        \n"
+"ScaleRowDown34_1_Int_SSSE3:                   \n"
+#endif
+    "pusha                                     \n"
+    "mov    0x24(%esp),%esi                    \n"
+    "mov    0x28(%esp),%ebp                    \n"
+    "mov    0x2c(%esp),%edi                    \n"
+    "mov    0x30(%esp),%ecx                    \n"
+    "movdqa _shuf01,%xmm2                      \n"
+    "movdqa _shuf11,%xmm3                      \n"
+    "movdqa _shuf21,%xmm4                      \n"
+    "movdqa _madd01,%xmm5                      \n"
+    "movdqa _madd11,%xmm6                      \n"
+    "movdqa _round34,%xmm7                     \n"
+
+"1:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa (%esi,%ebp),%xmm1                  \n"
+    "pavgb  %xmm1,%xmm0                        \n"
+    "pshufb %xmm2,%xmm0                        \n"
+    "pmaddubsw %xmm5,%xmm0                     \n"
+    "paddsw %xmm7,%xmm0                        \n"
+    "psrlw  $0x2,%xmm0                         \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "movq   %xmm0,(%edi)                       \n"
+    "movdqu 0x8(%esi),%xmm0                    \n"
+    "movdqu 0x8(%esi,%ebp),%xmm1               \n"
+    "pavgb  %xmm1,%xmm0                        \n"
+    "pshufb %xmm3,%xmm0                        \n"
+    "pmaddubsw %xmm6,%xmm0                     \n"
+    "paddsw %xmm7,%xmm0                        \n"
+    "psrlw  $0x2,%xmm0                         \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "movq   %xmm0,0x8(%edi)                    \n"
+    "movdqa 0x10(%esi),%xmm0                   \n"
+    "movdqa 0x10(%esi,%ebp),%xmm1              \n"
+    "lea    0x20(%esi),%esi                    \n"
+    "pavgb  %xmm1,%xmm0                        \n"
+    "pshufb %xmm4,%xmm0                        \n"
+    "movdqa  _madd21,%xmm1                     \n"
+    "pmaddubsw %xmm1,%xmm0                     \n"
+    "paddsw %xmm7,%xmm0                        \n"
+    "psrlw  $0x2,%xmm0                         \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "movq   %xmm0,0x10(%edi)                   \n"
+    "lea    0x18(%edi),%edi                    \n"
+    "sub    $0x18,%ecx                         \n"
+    "ja     1b                                 \n"
+
+    "popa                                      \n"
+    "ret                                       \n"
+);
+
+extern "C" void ScaleRowDown34_0_Int_SSSE3(const uint8* src_ptr, int src_stride,
+                                           uint8* dst_ptr, int dst_width);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleRowDown34_0_Int_SSSE3        \n"
+"_ScaleRowDown34_0_Int_SSSE3:                  \n"
+#else
+    ".global ScaleRowDown34_0_Int_SSSE3        \n"
+"ScaleRowDown34_0_Int_SSSE3:                   \n"
+#endif
+    "pusha                                     \n"
+    "mov    0x24(%esp),%esi                    \n"
+    "mov    0x28(%esp),%ebp                    \n"
+    "mov    0x2c(%esp),%edi                    \n"
+    "mov    0x30(%esp),%ecx                    \n"
+    "movdqa _shuf01,%xmm2                      \n"
+    "movdqa _shuf11,%xmm3                      \n"
+    "movdqa _shuf21,%xmm4                      \n"
+    "movdqa _madd01,%xmm5                      \n"
+    "movdqa _madd11,%xmm6                      \n"
+    "movdqa _round34,%xmm7                     \n"
+
+"1:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa (%esi,%ebp,1),%xmm1                \n"
+    "pavgb  %xmm0,%xmm1                        \n"
+    "pavgb  %xmm1,%xmm0                        \n"
+    "pshufb %xmm2,%xmm0                        \n"
+    "pmaddubsw %xmm5,%xmm0                     \n"
+    "paddsw %xmm7,%xmm0                        \n"
+    "psrlw  $0x2,%xmm0                         \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "movq   %xmm0,(%edi)                       \n"
+    "movdqu 0x8(%esi),%xmm0                    \n"
+    "movdqu 0x8(%esi,%ebp,1),%xmm1             \n"
+    "pavgb  %xmm0,%xmm1                        \n"
+    "pavgb  %xmm1,%xmm0                        \n"
+    "pshufb %xmm3,%xmm0                        \n"
+    "pmaddubsw %xmm6,%xmm0                     \n"
+    "paddsw %xmm7,%xmm0                        \n"
+    "psrlw  $0x2,%xmm0                         \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "movq   %xmm0,0x8(%edi)                    \n"
+    "movdqa 0x10(%esi),%xmm0                   \n"
+    "movdqa 0x10(%esi,%ebp,1),%xmm1            \n"
+    "lea    0x20(%esi),%esi                    \n"
+    "pavgb  %xmm0,%xmm1                        \n"
+    "pavgb  %xmm1,%xmm0                        \n"
+    "pshufb %xmm4,%xmm0                        \n"
+    "movdqa  _madd21,%xmm1                     \n"
+    "pmaddubsw %xmm1,%xmm0                     \n"
+    "paddsw %xmm7,%xmm0                        \n"
+    "psrlw  $0x2,%xmm0                         \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "movq   %xmm0,0x10(%edi)                   \n"
+    "lea    0x18(%edi),%edi                    \n"
+    "sub    $0x18,%ecx                         \n"
+    "ja     1b                                 \n"
+    "popa                                      \n"
+    "ret                                       \n"
+);
+
+#define HAS_SCALEROWDOWN38_SSSE3
+extern "C" void ScaleRowDown38_SSSE3(const uint8* src_ptr, int src_stride,
+                                     uint8* dst_ptr, int dst_width);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleRowDown38_SSSE3              \n"
+"_ScaleRowDown38_SSSE3:                        \n"
+#else
+    ".global ScaleRowDown38_SSSE3              \n"
+"ScaleRowDown38_SSSE3:                         \n"
+#endif
+    "pusha                                     \n"
+    "mov    0x24(%esp),%esi                    \n"
+    "mov    0x28(%esp),%edx                    \n"
+    "mov    0x2c(%esp),%edi                    \n"
+    "mov    0x30(%esp),%ecx                    \n"
+    "movdqa _shuf38a ,%xmm4                    \n"
+    "movdqa _shuf38b ,%xmm5                    \n"
+
+"1:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa 0x10(%esi),%xmm1                   \n"
+    "lea    0x20(%esi),%esi                    \n"
+    "pshufb %xmm4,%xmm0                        \n"
+    "pshufb %xmm5,%xmm1                        \n"
+    "paddusb %xmm1,%xmm0                       \n"
+    "movq   %xmm0,(%edi)                       \n"
+    "movhlps %xmm0,%xmm1                       \n"
+    "movd   %xmm1,0x8(%edi)                    \n"
+    "lea    0xc(%edi),%edi                     \n"
+    "sub    $0xc,%ecx                          \n"
+    "ja     1b                                 \n"
+    "popa                                      \n"
+    "ret                                       \n"
+);
+
+extern "C" void ScaleRowDown38_3_Int_SSSE3(const uint8* src_ptr, int src_stride,
+                                           uint8* dst_ptr, int dst_width);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleRowDown38_3_Int_SSSE3        \n"
+"_ScaleRowDown38_3_Int_SSSE3:                  \n"
+#else
+    ".global ScaleRowDown38_3_Int_SSSE3        \n"
+"ScaleRowDown38_3_Int_SSSE3:                   \n"
+#endif
+    "pusha                                     \n"
+    "mov    0x24(%esp),%esi                    \n"
+    "mov    0x28(%esp),%edx                    \n"
+    "mov    0x2c(%esp),%edi                    \n"
+    "mov    0x30(%esp),%ecx                    \n"
+    "movdqa _shufac0,%xmm4                     \n"
+    "movdqa _shufac3,%xmm5                     \n"
+    "movdqa _scaleac3,%xmm6                    \n"
+    "pxor   %xmm7,%xmm7                        \n"
+
+"1:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa (%esi,%edx,1),%xmm2                \n"
+    "movhlps %xmm0,%xmm1                       \n"
+    "movhlps %xmm2,%xmm3                       \n"
+    "punpcklbw %xmm7,%xmm0                     \n"
+    "punpcklbw %xmm7,%xmm1                     \n"
+    "punpcklbw %xmm7,%xmm2                     \n"
+    "punpcklbw %xmm7,%xmm3                     \n"
+    "paddusw %xmm2,%xmm0                       \n"
+    "paddusw %xmm3,%xmm1                       \n"
+    "movdqa (%esi,%edx,2),%xmm2                \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "movhlps %xmm2,%xmm3                       \n"
+    "punpcklbw %xmm7,%xmm2                     \n"
+    "punpcklbw %xmm7,%xmm3                     \n"
+    "paddusw %xmm2,%xmm0                       \n"
+    "paddusw %xmm3,%xmm1                       \n"
+    "movdqa %xmm0,%xmm2                        \n"
+    "psrldq $0x2,%xmm0                         \n"
+    "paddusw %xmm0,%xmm2                       \n"
+    "psrldq $0x2,%xmm0                         \n"
+    "paddusw %xmm0,%xmm2                       \n"
+    "pshufb %xmm4,%xmm2                        \n"
+    "movdqa %xmm1,%xmm3                        \n"
+    "psrldq $0x2,%xmm1                         \n"
+    "paddusw %xmm1,%xmm3                       \n"
+    "psrldq $0x2,%xmm1                         \n"
+    "paddusw %xmm1,%xmm3                       \n"
+    "pshufb %xmm5,%xmm3                        \n"
+    "paddusw %xmm3,%xmm2                       \n"
+    "pmulhuw %xmm6,%xmm2                       \n"
+    "packuswb %xmm2,%xmm2                      \n"
+    "movd   %xmm2,(%edi)                       \n"
+    "pextrw $0x2,%xmm2,%eax                    \n"
+    "mov    %ax,0x4(%edi)                      \n"
+    "lea    0x6(%edi),%edi                     \n"
+    "sub    $0x6,%ecx                          \n"
+    "ja     1b                                 \n"
+    "popa                                      \n"
+    "ret                                       \n"
+);
+
+extern "C" void ScaleRowDown38_2_Int_SSSE3(const uint8* src_ptr, int src_stride,
+                                           uint8* dst_ptr, int dst_width);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleRowDown38_2_Int_SSSE3        \n"
+"_ScaleRowDown38_2_Int_SSSE3:                  \n"
+#else
+    ".global ScaleRowDown38_2_Int_SSSE3        \n"
+"ScaleRowDown38_2_Int_SSSE3:                   \n"
+#endif
+    "pusha                                     \n"
+    "mov    0x24(%esp),%esi                    \n"
+    "mov    0x28(%esp),%edx                    \n"
+    "mov    0x2c(%esp),%edi                    \n"
+    "mov    0x30(%esp),%ecx                    \n"
+    "movdqa _shufab0,%xmm4                     \n"
+    "movdqa _shufab1,%xmm5                     \n"
+    "movdqa _shufab2,%xmm6                     \n"
+    "movdqa _scaleab2,%xmm7                    \n"
+
+"1:"
+    "movdqa (%esi),%xmm2                       \n"
+    "pavgb  (%esi,%edx,1),%xmm2                \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "movdqa %xmm2,%xmm0                        \n"
+    "pshufb %xmm4,%xmm0                        \n"
+    "movdqa %xmm2,%xmm1                        \n"
+    "pshufb %xmm5,%xmm1                        \n"
+    "paddusw %xmm1,%xmm0                       \n"
+    "pshufb %xmm6,%xmm2                        \n"
+    "paddusw %xmm2,%xmm0                       \n"
+    "pmulhuw %xmm7,%xmm0                       \n"
+    "packuswb %xmm0,%xmm0                      \n"
+    "movd   %xmm0,(%edi)                       \n"
+    "pextrw $0x2,%xmm0,%eax                    \n"
+    "mov    %ax,0x4(%edi)                      \n"
+    "lea    0x6(%edi),%edi                     \n"
+    "sub    $0x6,%ecx                          \n"
+    "ja     1b                                 \n"
+    "popa                                      \n"
+    "ret                                       \n"
+);
+#endif // __PIC__
+
+#define HAS_SCALEADDROWS_SSE2
+extern "C" void ScaleAddRows_SSE2(const uint8* src_ptr, int src_stride,
+                                  uint16* dst_ptr, int src_width,
+                                  int src_height);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleAddRows_SSE2                 \n"
+"_ScaleAddRows_SSE2:                           \n"
+#else
+    ".global ScaleAddRows_SSE2                 \n"
+"ScaleAddRows_SSE2:                            \n"
+#endif
+    "pusha                                     \n"
+    "mov    0x24(%esp),%esi                    \n"
+    "mov    0x28(%esp),%edx                    \n"
+    "mov    0x2c(%esp),%edi                    \n"
+    "mov    0x30(%esp),%ecx                    \n"
+    "mov    0x34(%esp),%ebx                    \n"
+    "pxor   %xmm5,%xmm5                        \n"
+
+"1:"
+    "movdqa (%esi),%xmm2                       \n"
+    "lea    (%esi,%edx,1),%eax                 \n"
+    "movhlps %xmm2,%xmm3                       \n"
+    "lea    -0x1(%ebx),%ebp                    \n"
+    "punpcklbw %xmm5,%xmm2                     \n"
+    "punpcklbw %xmm5,%xmm3                     \n"
+
+"2:"
+    "movdqa (%eax),%xmm0                       \n"
+    "lea    (%eax,%edx,1),%eax                 \n"
+    "movhlps %xmm0,%xmm1                       \n"
+    "punpcklbw %xmm5,%xmm0                     \n"
+    "punpcklbw %xmm5,%xmm1                     \n"
+    "paddusw %xmm0,%xmm2                       \n"
+    "paddusw %xmm1,%xmm3                       \n"
+    "sub    $0x1,%ebp                          \n"
+    "ja     2b                                 \n"
+
+    "movdqa %xmm2,(%edi)                       \n"
+    "movdqa %xmm3,0x10(%edi)                   \n"
+    "lea    0x20(%edi),%edi                    \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "sub    $0x10,%ecx                         \n"
+    "ja     1b                                 \n"
+    "popa                                      \n"
+    "ret                                       \n"
+);
+
+// Bilinear row filtering combines 16x2 -> 16x1. SSE2 version
+#define HAS_SCALEFILTERROWS_SSE2
+extern "C" void ScaleFilterRows_SSE2(uint8* dst_ptr,
+                                     const uint8* src_ptr, int src_stride,
+                                     int dst_width, int source_y_fraction);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleFilterRows_SSE2              \n"
+"_ScaleFilterRows_SSE2:                        \n"
+#else
+    ".global ScaleFilterRows_SSE2              \n"
+"ScaleFilterRows_SSE2:                         \n"
+#endif
+    "push   %esi                               \n"
+    "push   %edi                               \n"
+    "mov    0xc(%esp),%edi                     \n"
+    "mov    0x10(%esp),%esi                    \n"
+    "mov    0x14(%esp),%edx                    \n"
+    "mov    0x18(%esp),%ecx                    \n"
+    "mov    0x1c(%esp),%eax                    \n"
+    "cmp    $0x0,%eax                          \n"
+    "je     2f                                 \n"
+    "cmp    $0x80,%eax                         \n"
+    "je     3f                                 \n"
+    "movd   %eax,%xmm6                         \n"
+    "punpcklwd %xmm6,%xmm6                     \n"
+    "pshufd $0x0,%xmm6,%xmm6                   \n"
+    "neg    %eax                               \n"
+    "add    $0x100,%eax                        \n"
+    "movd   %eax,%xmm5                         \n"
+    "punpcklwd %xmm5,%xmm5                     \n"
+    "pshufd $0x0,%xmm5,%xmm5                   \n"
+    "pxor   %xmm7,%xmm7                        \n"
+
+"1:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa (%esi,%edx,1),%xmm2                \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "movdqa %xmm0,%xmm1                        \n"
+    "movdqa %xmm2,%xmm3                        \n"
+    "punpcklbw %xmm7,%xmm0                     \n"
+    "punpcklbw %xmm7,%xmm2                     \n"
+    "punpckhbw %xmm7,%xmm1                     \n"
+    "punpckhbw %xmm7,%xmm3                     \n"
+    "pmullw %xmm5,%xmm0                        \n"
+    "pmullw %xmm5,%xmm1                        \n"
+    "pmullw %xmm6,%xmm2                        \n"
+    "pmullw %xmm6,%xmm3                        \n"
+    "paddusw %xmm2,%xmm0                       \n"
+    "paddusw %xmm3,%xmm1                       \n"
+    "psrlw  $0x8,%xmm0                         \n"
+    "psrlw  $0x8,%xmm1                         \n"
+    "packuswb %xmm1,%xmm0                      \n"
+    "movdqa %xmm0,(%edi)                       \n"
+    "lea    0x10(%edi),%edi                    \n"
+    "sub    $0x10,%ecx                         \n"
+    "ja     1b                                 \n"
+    "mov    -0x1(%edi),%al                     \n"
+    "mov    %al,(%edi)                         \n"
+    "pop    %edi                               \n"
+    "pop    %esi                               \n"
+    "ret                                       \n"
+
+"2:"
+    "movdqa (%esi),%xmm0                       \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "movdqa %xmm0,(%edi)                       \n"
+    "lea    0x10(%edi),%edi                    \n"
+    "sub    $0x10,%ecx                         \n"
+    "ja     2b                                 \n"
+
+    "mov    -0x1(%edi),%al                     \n"
+    "mov    %al,(%edi)                         \n"
+    "pop    %edi                               \n"
+    "pop    %esi                               \n"
+    "ret                                       \n"
+
+"3:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa (%esi,%edx,1),%xmm2                \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "pavgb  %xmm2,%xmm0                        \n"
+    "movdqa %xmm0,(%edi)                       \n"
+    "lea    0x10(%edi),%edi                    \n"
+    "sub    $0x10,%ecx                         \n"
+    "ja     3b                                 \n"
+
+    "mov    -0x1(%edi),%al                     \n"
+    "mov    %al,(%edi)                         \n"
+    "pop    %edi                               \n"
+    "pop    %esi                               \n"
+    "ret                                       \n"
+);
+
+// Bilinear row filtering combines 16x2 -> 16x1. SSSE3 version
+#define HAS_SCALEFILTERROWS_SSSE3
+extern "C" void ScaleFilterRows_SSSE3(uint8* dst_ptr,
+                                      const uint8* src_ptr, int src_stride,
+                                      int dst_width, int source_y_fraction);
+  asm(
+    ".text                                     \n"
+#if defined(OSX)
+    ".globl _ScaleFilterRows_SSSE3             \n"
+"_ScaleFilterRows_SSSE3:                       \n"
+#else
+    ".global ScaleFilterRows_SSSE3             \n"
+"ScaleFilterRows_SSSE3:                        \n"
+#endif
+    "push   %esi                               \n"
+    "push   %edi                               \n"
+    "mov    0xc(%esp),%edi                     \n"
+    "mov    0x10(%esp),%esi                    \n"
+    "mov    0x14(%esp),%edx                    \n"
+    "mov    0x18(%esp),%ecx                    \n"
+    "mov    0x1c(%esp),%eax                    \n"
+    "cmp    $0x2,%eax                          \n"
+    "jb     2f                                 \n"
+    "cmp    $0x80,%eax                         \n"
+    "je     3f                                 \n"
+    "shr    %eax                               \n"
+    "mov    %al,%ah                            \n"
+    "neg    %al                                \n"
+    "add    $0x80,%al                          \n"
+    "movd   %eax,%xmm5                         \n"
+    "punpcklwd %xmm5,%xmm5                     \n"
+    "pshufd $0x0,%xmm5,%xmm5                   \n"
+
+"1:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa (%esi,%edx,1),%xmm2                \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "movdqa %xmm0,%xmm1                        \n"
+    "punpcklbw %xmm2,%xmm0                     \n"
+    "punpckhbw %xmm2,%xmm1                     \n"
+    "pmaddubsw %xmm5,%xmm0                     \n"
+    "pmaddubsw %xmm5,%xmm1                     \n"
+    "psrlw  $0x7,%xmm0                         \n"
+    "psrlw  $0x7,%xmm1                         \n"
+    "packuswb %xmm1,%xmm0                      \n"
+    "movdqa %xmm0,(%edi)                       \n"
+    "lea    0x10(%edi),%edi                    \n"
+    "sub    $0x10,%ecx                         \n"
+    "ja     1b                                 \n"
+    "mov    -0x1(%edi),%al                     \n"
+    "mov    %al,(%edi)                         \n"
+    "pop    %edi                               \n"
+    "pop    %esi                               \n"
+    "ret                                       \n"
+
+"2:"
+    "movdqa (%esi),%xmm0                       \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "movdqa %xmm0,(%edi)                       \n"
+    "lea    0x10(%edi),%edi                    \n"
+    "sub    $0x10,%ecx                         \n"
+    "ja     2b                                 \n"
+    "mov    -0x1(%edi),%al                     \n"
+    "mov    %al,(%edi)                         \n"
+    "pop    %edi                               \n"
+    "pop    %esi                               \n"
+    "ret                                       \n"
+
+"3:"
+    "movdqa (%esi),%xmm0                       \n"
+    "movdqa (%esi,%edx,1),%xmm2                \n"
+    "lea    0x10(%esi),%esi                    \n"
+    "pavgb  %xmm2,%xmm0                        \n"
+    "movdqa %xmm0,(%edi)                       \n"
+    "lea    0x10(%edi),%edi                    \n"
+    "sub    $0x10,%ecx                         \n"
+    "ja     3b                                 \n"
+    "mov    -0x1(%edi),%al                     \n"
+    "mov    %al,(%edi)                         \n"
+    "pop    %edi                               \n"
+    "pop    %esi                               \n"
+    "ret                                       \n"
+);
+
+#elif defined(__x86_64__)
+static void ScaleRowDown8Int_SSE2(const uint8* src_ptr, int src_stride,
+                                  uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "lea        (%3,%3,2),%%r10                  \n"
+  "pxor       %%xmm7,%%xmm7                    \n"
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "movdqa     (%0,%3,1),%%xmm2                 \n"
+  "movdqa     0x10(%0,%3,1),%%xmm3             \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "pavgb      %%xmm3,%%xmm1                    \n"
+  "movdqa     (%0,%3,2),%%xmm2                 \n"
+  "movdqa     0x10(%0,%3,2),%%xmm3             \n"
+  "movdqa     (%0,%%r10,1),%%xmm4              \n"
+  "movdqa     0x10(%0,%%r10,1),%%xmm5          \n"
+  "lea        (%0,%3,4),%%r11                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "pavgb      %%xmm4,%%xmm2                    \n"
+  "pavgb      %%xmm5,%%xmm3                    \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "pavgb      %%xmm3,%%xmm1                    \n"
+  "movdqa     0x0(%%r11),%%xmm2                \n"
+  "movdqa     0x10(%%r11),%%xmm3               \n"
+  "movdqa     0x0(%%r11,%3,1),%%xmm4           \n"
+  "movdqa     0x10(%%r11,%3,1),%%xmm5          \n"
+  "pavgb      %%xmm4,%%xmm2                    \n"
+  "pavgb      %%xmm5,%%xmm3                    \n"
+  "movdqa     0x0(%%r11,%3,2),%%xmm4           \n"
+  "movdqa     0x10(%%r11,%3,2),%%xmm5          \n"
+  "movdqa     0x0(%%r11,%%r10,1),%%xmm6        \n"
+  "pavgb      %%xmm6,%%xmm4                    \n"
+  "movdqa     0x10(%%r11,%%r10,1),%%xmm6       \n"
+  "pavgb      %%xmm6,%%xmm5                    \n"
+  "pavgb      %%xmm4,%%xmm2                    \n"
+  "pavgb      %%xmm5,%%xmm3                    \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "pavgb      %%xmm3,%%xmm1                    \n"
+  "psadbw     %%xmm7,%%xmm0                    \n"
+  "psadbw     %%xmm7,%%xmm1                    \n"
+  "pshufd     $0xd8,%%xmm0,%%xmm0              \n"
+  "pshufd     $0x8d,%%xmm1,%%xmm1              \n"
+  "por        %%xmm1,%%xmm0                    \n"
+  "psrlw      $0x3,%%xmm0                      \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movd       %%xmm0,(%1)                      \n"
+  "lea        0x4(%1),%1                       \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(static_cast<intptr_t>(src_stride))   // %3
+  : "memory", "cc", "r10", "r11", "xmm6", "xmm7"
+);
+}
+
+#define HAS_SCALEROWDOWN34_SSSE3
+static void ScaleRowDown34_SSSE3(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "movdqa     (%3),%%xmm3                      \n"
+  "movdqa     (%4),%%xmm4                      \n"
+  "movdqa     (%5),%%xmm5                      \n"
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm2                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "movdqa     %%xmm2,%%xmm1                    \n"
+  "palignr    $0x8,%%xmm0,%%xmm1               \n"
+  "pshufb     %%xmm3,%%xmm0                    \n"
+  "pshufb     %%xmm4,%%xmm1                    \n"
+  "pshufb     %%xmm5,%%xmm2                    \n"
+  "movq       %%xmm0,(%1)                      \n"
+  "movq       %%xmm1,0x8(%1)                   \n"
+  "movq       %%xmm2,0x10(%1)                  \n"
+  "lea        0x18(%1),%1                      \n"
+  "sub        $0x18,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(_shuf0),   // %3
+    "r"(_shuf1),   // %4
+    "r"(_shuf2)    // %5
+  : "memory", "cc"
+);
+}
+
+static void ScaleRowDown34_1_Int_SSSE3(const uint8* src_ptr, int src_stride,
+                                       uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "movdqa     (%4),%%xmm2                      \n"  // _shuf01
+  "movdqa     (%5),%%xmm3                      \n"  // _shuf11
+  "movdqa     (%6),%%xmm4                      \n"  // _shuf21
+  "movdqa     (%7),%%xmm5                      \n"  // _madd01
+  "movdqa     (%8),%%xmm6                      \n"  // _madd11
+  "movdqa     (%9),%%xmm7                      \n"  // _round34
+  "movdqa     (%10),%%xmm8                     \n"  // _madd21
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     (%0,%3),%%xmm1                   \n"
+  "pavgb      %%xmm1,%%xmm0                    \n"
+  "pshufb     %%xmm2,%%xmm0                    \n"
+  "pmaddubsw  %%xmm5,%%xmm0                    \n"
+  "paddsw     %%xmm7,%%xmm0                    \n"
+  "psrlw      $0x2,%%xmm0                      \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movq       %%xmm0,(%1)                      \n"
+  "movdqu     0x8(%0),%%xmm0                   \n"
+  "movdqu     0x8(%0,%3),%%xmm1                \n"
+  "pavgb      %%xmm1,%%xmm0                    \n"
+  "pshufb     %%xmm3,%%xmm0                    \n"
+  "pmaddubsw  %%xmm6,%%xmm0                    \n"
+  "paddsw     %%xmm7,%%xmm0                    \n"
+  "psrlw      $0x2,%%xmm0                      \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movq       %%xmm0,0x8(%1)                   \n"
+  "movdqa     0x10(%0),%%xmm0                  \n"
+  "movdqa     0x10(%0,%3),%%xmm1               \n"
+  "lea        0x20(%0),%0                      \n"
+  "pavgb      %%xmm1,%%xmm0                    \n"
+  "pshufb     %%xmm4,%%xmm0                    \n"
+  "pmaddubsw  %%xmm8,%%xmm0                    \n"
+  "paddsw     %%xmm7,%%xmm0                    \n"
+  "psrlw      $0x2,%%xmm0                      \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movq       %%xmm0,0x10(%1)                  \n"
+  "lea        0x18(%1),%1                      \n"
+  "sub        $0x18,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(_shuf01),   // %4
+    "r"(_shuf11),   // %5
+    "r"(_shuf21),   // %6
+    "r"(_madd01),   // %7
+    "r"(_madd11),   // %8
+    "r"(_round34),  // %9
+    "r"(_madd21)    // %10
+  : "memory", "cc", "xmm6", "xmm7", "xmm8"
+);
+}
+
+static void ScaleRowDown34_0_Int_SSSE3(const uint8* src_ptr, int src_stride,
+                                       uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "movdqa     (%4),%%xmm2                      \n"  // _shuf01
+  "movdqa     (%5),%%xmm3                      \n"  // _shuf11
+  "movdqa     (%6),%%xmm4                      \n"  // _shuf21
+  "movdqa     (%7),%%xmm5                      \n"  // _madd01
+  "movdqa     (%8),%%xmm6                      \n"  // _madd11
+  "movdqa     (%9),%%xmm7                      \n"  // _round34
+  "movdqa     (%10),%%xmm8                     \n"  // _madd21
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     (%0,%3,1),%%xmm1                 \n"
+  "pavgb      %%xmm0,%%xmm1                    \n"
+  "pavgb      %%xmm1,%%xmm0                    \n"
+  "pshufb     %%xmm2,%%xmm0                    \n"
+  "pmaddubsw  %%xmm5,%%xmm0                    \n"
+  "paddsw     %%xmm7,%%xmm0                    \n"
+  "psrlw      $0x2,%%xmm0                      \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movq       %%xmm0,(%1)                      \n"
+  "movdqu     0x8(%0),%%xmm0                   \n"
+  "movdqu     0x8(%0,%3,1),%%xmm1              \n"
+  "pavgb      %%xmm0,%%xmm1                    \n"
+  "pavgb      %%xmm1,%%xmm0                    \n"
+  "pshufb     %%xmm3,%%xmm0                    \n"
+  "pmaddubsw  %%xmm6,%%xmm0                    \n"
+  "paddsw     %%xmm7,%%xmm0                    \n"
+  "psrlw      $0x2,%%xmm0                      \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movq       %%xmm0,0x8(%1)                   \n"
+  "movdqa     0x10(%0),%%xmm0                  \n"
+  "movdqa     0x10(%0,%3,1),%%xmm1             \n"
+  "lea        0x20(%0),%0                      \n"
+  "pavgb      %%xmm0,%%xmm1                    \n"
+  "pavgb      %%xmm1,%%xmm0                    \n"
+  "pshufb     %%xmm4,%%xmm0                    \n"
+  "pmaddubsw  %%xmm8,%%xmm0                    \n"
+  "paddsw     %%xmm7,%%xmm0                    \n"
+  "psrlw      $0x2,%%xmm0                      \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movq       %%xmm0,0x10(%1)                  \n"
+  "lea        0x18(%1),%1                      \n"
+  "sub        $0x18,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(_shuf01),   // %4
+    "r"(_shuf11),   // %5
+    "r"(_shuf21),   // %6
+    "r"(_madd01),   // %7
+    "r"(_madd11),   // %8
+    "r"(_round34),  // %9
+    "r"(_madd21)    // %10
+  : "memory", "cc", "xmm6", "xmm7", "xmm8"
+);
+}
+
+#define HAS_SCALEROWDOWN38_SSSE3
+static void ScaleRowDown38_SSSE3(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "movdqa     (%3),%%xmm4                      \n"
+  "movdqa     (%4),%%xmm5                      \n"
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "pshufb     %%xmm4,%%xmm0                    \n"
+  "pshufb     %%xmm5,%%xmm1                    \n"
+  "paddusb    %%xmm1,%%xmm0                    \n"
+  "movq       %%xmm0,(%1)                      \n"
+  "movhlps    %%xmm0,%%xmm1                    \n"
+  "movd       %%xmm1,0x8(%1)                   \n"
+  "lea        0xc(%1),%1                       \n"
+  "sub        $0xc,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(_shuf38a),  // %3
+    "r"(_shuf38b)   // %4
+  : "memory", "cc"
+);
+}
+
+static void ScaleRowDown38_3_Int_SSSE3(const uint8* src_ptr, int src_stride,
+                                       uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "movdqa     (%4),%%xmm4                      \n"
+  "movdqa     (%5),%%xmm5                      \n"
+  "movdqa     (%6),%%xmm6                      \n"
+  "pxor       %%xmm7,%%xmm7                    \n"
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     (%0,%3,1),%%xmm2                 \n"
+  "movhlps    %%xmm0,%%xmm1                    \n"
+  "movhlps    %%xmm2,%%xmm3                    \n"
+  "punpcklbw  %%xmm7,%%xmm0                    \n"
+  "punpcklbw  %%xmm7,%%xmm1                    \n"
+  "punpcklbw  %%xmm7,%%xmm2                    \n"
+  "punpcklbw  %%xmm7,%%xmm3                    \n"
+  "paddusw    %%xmm2,%%xmm0                    \n"
+  "paddusw    %%xmm3,%%xmm1                    \n"
+  "movdqa     (%0,%3,2),%%xmm2                 \n"
+  "lea        0x10(%0),%0                      \n"
+  "movhlps    %%xmm2,%%xmm3                    \n"
+  "punpcklbw  %%xmm7,%%xmm2                    \n"
+  "punpcklbw  %%xmm7,%%xmm3                    \n"
+  "paddusw    %%xmm2,%%xmm0                    \n"
+  "paddusw    %%xmm3,%%xmm1                    \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "psrldq     $0x2,%%xmm0                      \n"
+  "paddusw    %%xmm0,%%xmm2                    \n"
+  "psrldq     $0x2,%%xmm0                      \n"
+  "paddusw    %%xmm0,%%xmm2                    \n"
+  "pshufb     %%xmm4,%%xmm2                    \n"
+  "movdqa     %%xmm1,%%xmm3                    \n"
+  "psrldq     $0x2,%%xmm1                      \n"
+  "paddusw    %%xmm1,%%xmm3                    \n"
+  "psrldq     $0x2,%%xmm1                      \n"
+  "paddusw    %%xmm1,%%xmm3                    \n"
+  "pshufb     %%xmm5,%%xmm3                    \n"
+  "paddusw    %%xmm3,%%xmm2                    \n"
+  "pmulhuw    %%xmm6,%%xmm2                    \n"
+  "packuswb   %%xmm2,%%xmm2                    \n"
+  "movd       %%xmm2,(%1)                      \n"
+  "pextrw     $0x2,%%xmm2,%%eax                \n"
+  "mov        %%ax,0x4(%1)                     \n"
+  "lea        0x6(%1),%1                       \n"
+  "sub        $0x6,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(_shufac0),   // %4
+    "r"(_shufac3),   // %5
+    "r"(_scaleac3)   // %6
+  : "memory", "cc", "rax", "xmm6", "xmm7"
+);
+}
+
+static void ScaleRowDown38_2_Int_SSSE3(const uint8* src_ptr, int src_stride,
+                                       uint8* dst_ptr, int dst_width) {
+  asm volatile (
+  "movdqa     (%4),%%xmm4                      \n"
+  "movdqa     (%5),%%xmm5                      \n"
+  "movdqa     (%6),%%xmm6                      \n"
+  "movdqa     (%7),%%xmm7                      \n"
+"1:"
+  "movdqa     (%0),%%xmm2                      \n"
+  "pavgb      (%0,%3,1),%%xmm2                 \n"
+  "lea        0x10(%0),%0                      \n"
+  "movdqa     %%xmm2,%%xmm0                    \n"
+  "pshufb     %%xmm4,%%xmm0                    \n"
+  "movdqa     %%xmm2,%%xmm1                    \n"
+  "pshufb     %%xmm5,%%xmm1                    \n"
+  "paddusw    %%xmm1,%%xmm0                    \n"
+  "pshufb     %%xmm6,%%xmm2                    \n"
+  "paddusw    %%xmm2,%%xmm0                    \n"
+  "pmulhuw    %%xmm7,%%xmm0                    \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movd       %%xmm0,(%1)                      \n"
+  "pextrw     $0x2,%%xmm0,%%eax                \n"
+  "mov        %%ax,0x4(%1)                     \n"
+  "lea        0x6(%1),%1                       \n"
+  "sub        $0x6,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(_shufab0),   // %4
+    "r"(_shufab1),   // %5
+    "r"(_shufab2),   // %6
+    "r"(_scaleab2)   // %7
+  : "memory", "cc", "rax", "xmm6", "xmm7"
+);
+}
+
+#define HAS_SCALEADDROWS_SSE2
+static void ScaleAddRows_SSE2(const uint8* src_ptr, int src_stride,
+                              uint16* dst_ptr, int src_width,
+                              int src_height) {
+  asm volatile (
+  "pxor       %%xmm5,%%xmm5                    \n"
+"1:"
+  "movdqa     (%0),%%xmm2                      \n"
+  "lea        (%0,%4,1),%%r10                  \n"
+  "movhlps    %%xmm2,%%xmm3                    \n"
+  "lea        -0x1(%3),%%r11                   \n"
+  "punpcklbw  %%xmm5,%%xmm2                    \n"
+  "punpcklbw  %%xmm5,%%xmm3                    \n"
+
+"2:"
+  "movdqa     (%%r10),%%xmm0                   \n"
+  "lea        (%%r10,%4,1),%%r10               \n"
+  "movhlps    %%xmm0,%%xmm1                    \n"
+  "punpcklbw  %%xmm5,%%xmm0                    \n"
+  "punpcklbw  %%xmm5,%%xmm1                    \n"
+  "paddusw    %%xmm0,%%xmm2                    \n"
+  "paddusw    %%xmm1,%%xmm3                    \n"
+  "sub        $0x1,%%r11                       \n"
+  "ja         2b                               \n"
+
+  "movdqa     %%xmm2,(%1)                      \n"
+  "movdqa     %%xmm3,0x10(%1)                  \n"
+  "lea        0x20(%1),%1                      \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x10,%2                         \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_ptr),     // %1
+    "+r"(src_width),   // %2
+    "+r"(src_height)   // %3
+  : "r"(static_cast<intptr_t>(src_stride))  // %4
+  : "memory", "cc", "r10", "r11"
+);
+}
+
+// Bilinear row filtering combines 16x2 -> 16x1. SSE2 version
+#define HAS_SCALEFILTERROWS_SSE2
+static void ScaleFilterRows_SSE2(uint8* dst_ptr,
+                                 const uint8* src_ptr, int src_stride,
+                                 int dst_width, int source_y_fraction) {
+  if (source_y_fraction == 0) {
+    asm volatile (
+    "1:"
+      "movdqa     (%1),%%xmm0                  \n"
+      "lea        0x10(%1),%1                  \n"
+      "movdqa     %%xmm0,(%0)                  \n"
+      "lea        0x10(%0),%0                  \n"
+      "sub        $0x10,%2                     \n"
+      "ja         1b                           \n"
+      "mov        -0x1(%0),%%al                \n"
+      "mov        %%al,(%0)                    \n"
+      : "+r"(dst_ptr),     // %0
+        "+r"(src_ptr),     // %1
+        "+r"(dst_width)    // %2
+      :
       : "memory", "cc", "rax"
     );
     return;
@@ -2681,1048 +5759,3223 @@ static void ScaleFilterRows_SSE2(uint8* dst_ptr,
       : "memory", "cc", "rax", "xmm6", "xmm7"
     );
   }
-  return;
+  return;
+}
+
+// Bilinear row filtering combines 16x2 -> 16x1. SSSE3 version
+#define HAS_SCALEFILTERROWS_SSSE3
+static void ScaleFilterRows_SSSE3(uint8* dst_ptr,
+                                  const uint8* src_ptr, int src_stride,
+                                  int dst_width, int source_y_fraction) {
+  // Fractions are halved to 7 bits, so 1 copies row 0 like 0 does, rather
+  // than weighting row 0 by 128, which pmaddubsw would take as -128.
+  if (source_y_fraction < 2) {
+    asm volatile (
+   "1:"
+      "movdqa     (%1),%%xmm0                  \n"
+      "lea        0x10(%1),%1                  \n"
+      "movdqa     %%xmm0,(%0)                  \n"
+      "lea        0x10(%0),%0                  \n"
+      "sub        $0x10,%2                     \n"
+      "ja         1b                           \n"
+      "mov        -0x1(%0),%%al                \n"
+      "mov        %%al,(%0)                    \n"
+      : "+r"(dst_ptr),     // %0
+        "+r"(src_ptr),     // %1
+        "+r"(dst_width)    // %2
+      :
+      : "memory", "cc", "rax"
+    );
+    return;
+  } else if (source_y_fraction == 128) {
+    asm volatile (
+    "1:"
+      "movdqa     (%1),%%xmm0                  \n"
+      "movdqa     (%1,%3,1),%%xmm2             \n"
+      "lea        0x10(%1),%1                  \n"
+      "pavgb      %%xmm2,%%xmm0                \n"
+      "movdqa     %%xmm0,(%0)                  \n"
+      "lea        0x10(%0),%0                  \n"
+      "sub        $0x10,%2                     \n"
+      "ja         1b                           \n"
+      "mov        -0x1(%0),%%al                \n"
+      "mov        %%al,(%0)                    \n"
+      : "+r"(dst_ptr),     // %0
+        "+r"(src_ptr),     // %1
+        "+r"(dst_width)    // %2
+      : "r"(static_cast<intptr_t>(src_stride))  // %3
+     : "memory", "cc", "rax"
+    );
+    return;
+  } else {
+    asm volatile (
+      "mov        %3,%%eax                     \n"
+      "shr        %%eax                        \n"
+      "mov        %%al,%%ah                    \n"
+      "neg        %%al                         \n"
+      "add        $0x80,%%al                   \n"
+      "movd       %%eax,%%xmm5                 \n"
+      "punpcklwd  %%xmm5,%%xmm5                \n"
+      "pshufd     $0x0,%%xmm5,%%xmm5           \n"
+    "1:"
+      "movdqa     (%1),%%xmm0                  \n"
+      "movdqa     (%1,%4,1),%%xmm2             \n"
+      "lea        0x10(%1),%1                  \n"
+      "movdqa     %%xmm0,%%xmm1                \n"
+      "punpcklbw  %%xmm2,%%xmm0                \n"
+      "punpckhbw  %%xmm2,%%xmm1                \n"
+      "pmaddubsw  %%xmm5,%%xmm0                \n"
+      "pmaddubsw  %%xmm5,%%xmm1                \n"
+      "psrlw      $0x7,%%xmm0                  \n"
+      "psrlw      $0x7,%%xmm1                  \n"
+      "packuswb   %%xmm1,%%xmm0                \n"
+      "movdqa     %%xmm0,(%0)                  \n"
+      "lea        0x10(%0),%0                  \n"
+      "sub        $0x10,%2                     \n"
+      "ja         1b                           \n"
+      "mov        -0x1(%0),%%al                \n"
+      "mov        %%al,(%0)                    \n"
+      : "+r"(dst_ptr),     // %0
+        "+r"(src_ptr),     // %1
+        "+r"(dst_width),   // %2
+        "+r"(source_y_fraction)  // %3
+      : "r"(static_cast<intptr_t>(src_stride))  // %4
+      : "memory", "cc", "rax"
+    );
+  }
+  return;
+}
+#endif
+#endif
+
+// CPU agnostic row functions
+static void ScaleRowDown2_C(const uint8* src_ptr, int,
+                            uint8* dst, int dst_width) {
+  for (int x = 0; x < dst_width; ++x) {
+    *dst++ = *src_ptr;
+    src_ptr += 2;
+  }
+}
+
+static void ScaleRowDown2Int_C(const uint8* src_ptr, int src_stride,
+                               uint8* dst, int dst_width) {
+  for (int x = 0; x < dst_width; ++x) {
+    *dst++ = (src_ptr[0] + src_ptr[1] +
+              src_ptr[src_stride] + src_ptr[src_stride + 1] + 2) >> 2;
+    src_ptr += 2;
+  }
+}
+
+static void ScaleRowDown4_C(const uint8* src_ptr, int,
+                            uint8* dst, int dst_width) {
+  for (int x = 0; x < dst_width; ++x) {
+    *dst++ = *src_ptr;
+    src_ptr += 4;
+  }
+}
+
+static void ScaleRowDown4Int_C(const uint8* src_ptr, int src_stride,
+                               uint8* dst, int dst_width) {
+  for (int x = 0; x < dst_width; ++x) {
+    *dst++ = (src_ptr[0] + src_ptr[1] + src_ptr[2] + src_ptr[3] +
+              src_ptr[src_stride + 0] + src_ptr[src_stride + 1] +
+              src_ptr[src_stride + 2] + src_ptr[src_stride + 3] +
+              src_ptr[src_stride * 2 + 0] + src_ptr[src_stride * 2 + 1] +
+              src_ptr[src_stride * 2 + 2] + src_ptr[src_stride * 2 + 3] +
+              src_ptr[src_stride * 3 + 0] + src_ptr[src_stride * 3 + 1] +
+              src_ptr[src_stride * 3 + 2] + src_ptr[src_stride * 3 + 3] +
+              8) >> 4;
+    src_ptr += 4;
+  }
+}
+
+// 640 output pixels is enough to allow 5120 input pixels with 1/8 scale down.
+// Keeping the total buffer under 4096 bytes avoids a stackcheck, saving 4% cpu.
+static const int kMaxOutputWidth = 640;
+static const int kMaxRow12 = kMaxOutputWidth * 2;
+
+static void ScaleRowDown8_C(const uint8* src_ptr, int,
+                            uint8* dst, int dst_width) {
+  for (int x = 0; x < dst_width; ++x) {
+    *dst++ = *src_ptr;
+    src_ptr += 8;
+  }
+}
+
+// Note calling code checks width is less than max and if not
+// uses ScaleRowDown8_C instead.
+static void ScaleRowDown8Int_C(const uint8* src_ptr, int src_stride,
+                               uint8* dst, int dst_width) {
+  ALIGN16(uint8 src_row[kMaxRow12 * 2]);
+  assert(dst_width <= kMaxOutputWidth);
+  ScaleRowDown4Int_C(src_ptr, src_stride, src_row, dst_width * 2);
+  ScaleRowDown4Int_C(src_ptr + src_stride * 4, src_stride,
+                     src_row + kMaxOutputWidth,
+                     dst_width * 2);
+  ScaleRowDown2Int_C(src_row, kMaxOutputWidth, dst, dst_width);
+}
+
+static void ScaleRowDown34_C(const uint8* src_ptr, int,
+                             uint8* dst, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  uint8* dend = dst + dst_width;
+  do {
+    dst[0] = src_ptr[0];
+    dst[1] = src_ptr[1];
+    dst[2] = src_ptr[3];
+    dst += 3;
+    src_ptr += 4;
+  } while (dst < dend);
+}
+
+// Filter rows 0 and 1 together, 3 : 1
+static void ScaleRowDown34_0_Int_C(const uint8* src_ptr, int src_stride,
+                                   uint8* d, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  uint8* dend = d + dst_width;
+  const uint8* s = src_ptr;
+  const uint8* t = src_ptr + src_stride;
+  do {
+    uint8 a0 = (s[0] * 3 + s[1] * 1 + 2) >> 2;
+    uint8 a1 = (s[1] * 1 + s[2] * 1 + 1) >> 1;
+    uint8 a2 = (s[2] * 1 + s[3] * 3 + 2) >> 2;
+    uint8 b0 = (t[0] * 3 + t[1] * 1 + 2) >> 2;
+    uint8 b1 = (t[1] * 1 + t[2] * 1 + 1) >> 1;
+    uint8 b2 = (t[2] * 1 + t[3] * 3 + 2) >> 2;
+    d[0] = (a0 * 3 + b0 + 2) >> 2;
+    d[1] = (a1 * 3 + b1 + 2) >> 2;
+    d[2] = (a2 * 3 + b2 + 2) >> 2;
+    d += 3;
+    s += 4;
+    t += 4;
+  } while (d < dend);
+}
+
+// Filter rows 1 and 2 together, 1 : 1
+static void ScaleRowDown34_1_Int_C(const uint8* src_ptr, int src_stride,
+                                   uint8* d, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  uint8* dend = d + dst_width;
+  const uint8* s = src_ptr;
+  const uint8* t = src_ptr + src_stride;
+  do {
+    uint8 a0 = (s[0] * 3 + s[1] * 1 + 2) >> 2;
+    uint8 a1 = (s[1] * 1 + s[2] * 1 + 1) >> 1;
+    uint8 a2 = (s[2] * 1 + s[3] * 3 + 2) >> 2;
+    uint8 b0 = (t[0] * 3 + t[1] * 1 + 2) >> 2;
+    uint8 b1 = (t[1] * 1 + t[2] * 1 + 1) >> 1;
+    uint8 b2 = (t[2] * 1 + t[3] * 3 + 2) >> 2;
+    d[0] = (a0 + b0 + 1) >> 1;
+    d[1] = (a1 + b1 + 1) >> 1;
+    d[2] = (a2 + b2 + 1) >> 1;
+    d += 3;
+    s += 4;
+    t += 4;
+  } while (d < dend);
+}
+
+#if defined(HAS_SCALEFILTERROWS_SSE2) || defined(HAS_SCALEBLENDROWS_MMX)
+// Filter row to 3/4
+static void ScaleFilterCols34_C(uint8* dst_ptr, const uint8* src_ptr,
+                                int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  uint8* dend = dst_ptr + dst_width;
+  const uint8* s = src_ptr;
+  do {
+    dst_ptr[0] = (s[0] * 3 + s[1] * 1 + 2) >> 2;
+    dst_ptr[1] = (s[1] * 1 + s[2] * 1 + 1) >> 1;
+    dst_ptr[2] = (s[2] * 1 + s[3] * 3 + 2) >> 2;
+    dst_ptr += 3;
+    s += 4;
+  } while (dst_ptr < dend);
+}
+#endif
+
+static void ScaleFilterCols_C(uint8* dst_ptr, const uint8* src_ptr,
+                              int dst_width, int x, int dx) {
+  for (int j = 0; j < dst_width; ++j) {
+    int xi = x >> 16;
+    int xf1 = x & 0xffff;
+    int xf0 = 65536 - xf1;
+
+    *dst_ptr++ = (src_ptr[xi] * xf0 + src_ptr[xi + 1] * xf1) >> 16;
+    x += dx;
+  }
+}
+
+// Upscale a row by 2 by duplicating each pixel.
+static void ScaleColsUp2_C(uint8* dst_ptr, const uint8* src_ptr,
+                           int dst_width) {
+  for (int j = 0; j < dst_width - 1; j += 2) {
+    dst_ptr[0] = src_ptr[0];
+    dst_ptr[1] = src_ptr[0];
+    dst_ptr += 2;
+    ++src_ptr;
+  }
+  if (dst_width & 1) {
+    dst_ptr[0] = src_ptr[0];
+  }
+}
+
+// Bilinear upscale a row by 2.  Same as ScaleFilterCols_C with a dx of 1/2.
+static void ScaleFilterColsUp2_C(uint8* dst_ptr, const uint8* src_ptr,
+                                 int dst_width, int, int) {
+  for (int j = 0; j < dst_width; j += 2) {
+    dst_ptr[0] = src_ptr[0];
+    dst_ptr[1] = (src_ptr[0] + src_ptr[1]) >> 1;
+    dst_ptr += 2;
+    ++src_ptr;
+  }
+}
+
+// Bilinear upscale a row by 3/2, with coefficients in 64ths.
+static void ScaleFilterColsUp32_C(uint8* dst_ptr, const uint8* src_ptr,
+                                  int dst_width, int, int) {
+  for (int j = 0; j < dst_width; j += 3) {
+    dst_ptr[0] = src_ptr[0];
+    dst_ptr[1] = (src_ptr[0] * 21 + src_ptr[1] * 43 + 32) >> 6;
+    dst_ptr[2] = (src_ptr[1] * 43 + src_ptr[2] * 21 + 32) >> 6;
+    dst_ptr += 3;
+    src_ptr += 2;
+  }
+}
+
+// Bilinear upscale a row by 4/3, with coefficients in 64ths.
+static void ScaleFilterColsUp43_C(uint8* dst_ptr, const uint8* src_ptr,
+                                  int dst_width, int, int) {
+  for (int j = 0; j < dst_width; j += 4) {
+    dst_ptr[0] = src_ptr[0];
+    dst_ptr[1] = (src_ptr[0] * 16 + src_ptr[1] * 48 + 32) >> 6;
+    dst_ptr[2] = (src_ptr[1] * 32 + src_ptr[2] * 32 + 32) >> 6;
+    dst_ptr[3] = (src_ptr[2] * 48 + src_ptr[3] * 16 + 32) >> 6;
+    dst_ptr += 4;
+    src_ptr += 3;
+  }
+}
+
+// Blend 2 rows as (row0 * (256 - f) + row1 * f) >> 8.
+static void ScaleBlendRows_C(uint8* dst_ptr, const uint8* src0_ptr,
+                             const uint8* src1_ptr, int dst_width,
+                             int source_y_fraction) {
+  int y1_fraction = source_y_fraction;
+  int y0_fraction = 256 - y1_fraction;
+  for (int j = 0; j < dst_width; ++j) {
+    dst_ptr[j] = (src0_ptr[j] * y0_fraction + src1_ptr[j] * y1_fraction) >> 8;
+  }
+}
+
+// Accumulate 2 rows of a vertical polyphase filter into 32 bit sums.
+// coeffs holds the coefficient for src0_ptr in the low 16 bits and the
+// coefficient for src1_ptr in the high 16 bits.
+static void ScaleAccumRows2_C(int32* dst_acc, const uint8* src0_ptr,
+                              const uint8* src1_ptr, int src_width,
+                              int coeffs) {
+  int c0 = static_cast<int16>(coeffs & 0xffff);
+  int c1 = static_cast<int16>((coeffs >> 16) & 0xffff);
+  for (int x = 0; x < src_width; ++x) {
+    dst_acc[x] += src0_ptr[x] * c0 + src1_ptr[x] * c1;
+  }
+}
+
+static inline uint8 ClampFilterSum(int sum) {
+  int v = sum >> kFilterBits;
+  return static_cast<uint8>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// Shift 32 bit sums of a polyphase filter down to pixels.
+static void ScalePackRow_C(uint8* dst_ptr, const int32* src_acc, int width) {
+  for (int x = 0; x < width; ++x) {
+    dst_ptr[x] = ClampFilterSum(src_acc[x]);
+  }
+}
+
+// Horizontal polyphase filter with any number of taps.
+static void ScaleFilterColsN_C(uint8* dst_ptr, const uint8* src_ptr,
+                               int dst_width, const ScaleFilterPos* pos,
+                               int taps) {
+  for (int j = 0; j < dst_width; ++j) {
+    const uint8* s = src_ptr + pos[j].offset;
+    const int16* c = pos[j].coeffs;
+    int sum = 1 << (kFilterBits - 1);
+    for (int k = 0; k < taps; ++k) {
+      sum += s[k] * c[k];
+    }
+    dst_ptr[j] = ClampFilterSum(sum);
+  }
+}
+
+// Row buffers up to this width are kept on the stack.  Wider images use a
+// buffer allocated by ScaleRowBuffer.
+static const int kMaxInputWidth = 2560;
+
+// Returns a 16 byte aligned buffer of at least 'size' bytes.  Uses 'stack'
+// if it is at least 'stack_size' bytes, otherwise allocates from the heap.
+// *mem is set to the allocation, which must be released with
+// FreeScaleRowBuffer.
+static uint8* ScaleRowBuffer(uint8* stack, int stack_size, int size,
+                             uint8** mem) {
+  *mem = NULL;
+  if (size <= stack_size) {
+    return stack;
+  }
+  *mem = new uint8[size + 15];
+  return ALIGNP(*mem, 16);
+}
+
+static void FreeScaleRowBuffer(uint8* mem) {
+  delete[] mem;
+}
+
+#if defined(HAS_SCALEFILTERROWS_SSE2)
+#define HAS_SCALEROWDOWN34_SSE2
+// Filter rows 0 and 1 together, 3 : 1
+// Note calling code checks the width is less than kMaxInputWidth.
+static void ScaleRowDown34_0_Int_SSE2(const uint8* src_ptr, int src_stride,
+                                      uint8* dst_ptr, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  ALIGN16(uint8 row[kMaxInputWidth + 1]);
+  ScaleFilterRows_SSE2(row, src_ptr, src_stride, dst_width * 4 / 3,
+                       256 / 4);
+  ScaleFilterCols34_C(dst_ptr, row, dst_width);
+}
+
+// Filter rows 1 and 2 together, 1 : 1
+static void ScaleRowDown34_1_Int_SSE2(const uint8* src_ptr, int src_stride,
+                                      uint8* dst_ptr, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  ALIGN16(uint8 row[kMaxInputWidth + 1]);
+  ScaleFilterRows_SSE2(row, src_ptr, src_stride, dst_width * 4 / 3, 256 / 2);
+  ScaleFilterCols34_C(dst_ptr, row, dst_width);
+}
+#endif
+
+#if defined(HAS_SCALEBLENDROWS_MMX)
+#define HAS_SCALEFILTERROWS_MMX
+// Bilinear row filtering combines 8x2 -> 8x1, for processors without SSE2.
+// Same as ScaleFilterRows_C.
+static void ScaleFilterRows_MMX(uint8* dst_ptr,
+                                const uint8* src_ptr, int src_stride,
+                                int dst_width, int source_y_fraction) {
+  ScaleBlendRows_MMX(dst_ptr, src_ptr, src_ptr + src_stride, dst_width,
+                     source_y_fraction);
+  dst_ptr[dst_width] = dst_ptr[dst_width - 1];
+}
+
+#define HAS_SCALEROWDOWN34_MMX
+// Filter rows 0 and 1 together, 3 : 1
+// Note calling code checks the width is less than kMaxInputWidth.
+static void ScaleRowDown34_0_Int_MMX(const uint8* src_ptr, int src_stride,
+                                     uint8* dst_ptr, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  ALIGN16(uint8 row[kMaxInputWidth + 1]);
+  ScaleFilterRows_MMX(row, src_ptr, src_stride, dst_width * 4 / 3, 256 / 4);
+  ScaleFilterCols34_C(dst_ptr, row, dst_width);
+}
+
+// Filter rows 1 and 2 together, 1 : 1
+static void ScaleRowDown34_1_Int_MMX(const uint8* src_ptr, int src_stride,
+                                     uint8* dst_ptr, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  ALIGN16(uint8 row[kMaxInputWidth + 1]);
+  ScaleFilterRows_MMX(row, src_ptr, src_stride, dst_width * 4 / 3, 256 / 2);
+  ScaleFilterCols34_C(dst_ptr, row, dst_width);
+}
+#endif
+
+static void ScaleRowDown38_C(const uint8* src_ptr, int,
+                             uint8* dst, int dst_width) {
+  assert(dst_width % 3 == 0);
+  for (int x = 0; x < dst_width; x += 3) {
+    dst[0] = src_ptr[0];
+    dst[1] = src_ptr[3];
+    dst[2] = src_ptr[6];
+    dst += 3;
+    src_ptr += 8;
+  }
+}
+
+// 8x3 -> 3x1
+static void ScaleRowDown38_3_Int_C(const uint8* src_ptr, int src_stride,
+                                   uint8* dst_ptr, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  for (int i = 0; i < dst_width; i+=3) {
+    dst_ptr[0] = (src_ptr[0] + src_ptr[1] + src_ptr[2] +
+        src_ptr[src_stride + 0] + src_ptr[src_stride + 1] +
+        src_ptr[src_stride + 2] + src_ptr[src_stride * 2 + 0] +
+        src_ptr[src_stride * 2 + 1] + src_ptr[src_stride * 2 + 2]) *
+        (65536 / 9) >> 16;
+    dst_ptr[1] = (src_ptr[3] + src_ptr[4] + src_ptr[5] +
+        src_ptr[src_stride + 3] + src_ptr[src_stride + 4] +
+        src_ptr[src_stride + 5] + src_ptr[src_stride * 2 + 3] +
+        src_ptr[src_stride * 2 + 4] + src_ptr[src_stride * 2 + 5]) *
+        (65536 / 9) >> 16;
+    dst_ptr[2] = (src_ptr[6] + src_ptr[7] +
+        src_ptr[src_stride + 6] + src_ptr[src_stride + 7] +
+        src_ptr[src_stride * 2 + 6] + src_ptr[src_stride * 2 + 7]) *
+        (65536 / 6) >> 16;
+    src_ptr += 8;
+    dst_ptr += 3;
+  }
+}
+
+// 8x2 -> 3x1
+static void ScaleRowDown38_2_Int_C(const uint8* src_ptr, int src_stride,
+                                   uint8* dst_ptr, int dst_width) {
+  assert((dst_width % 3 == 0) && (dst_width > 0));
+  for (int i = 0; i < dst_width; i+=3) {
+    dst_ptr[0] = (src_ptr[0] + src_ptr[1] + src_ptr[2] +
+        src_ptr[src_stride + 0] + src_ptr[src_stride + 1] +
+        src_ptr[src_stride + 2]) * (65536 / 6) >> 16;
+    dst_ptr[1] = (src_ptr[3] + src_ptr[4] + src_ptr[5] +
+        src_ptr[src_stride + 3] + src_ptr[src_stride + 4] +
+        src_ptr[src_stride + 5]) * (65536 / 6) >> 16;
+    dst_ptr[2] = (src_ptr[6] + src_ptr[7] +
+        src_ptr[src_stride + 6] + src_ptr[src_stride + 7]) *
+        (65536 / 4) >> 16;
+    src_ptr += 8;
+    dst_ptr += 3;
+  }
+}
+
+// C version 8x2 -> 8x1
+static void ScaleFilterRows_C(uint8* dst_ptr,
+                              const uint8* src_ptr, int src_stride,
+                              int dst_width, int source_y_fraction) {
+  assert(dst_width > 0);
+  int y1_fraction = source_y_fraction;
+  int y0_fraction = 256 - y1_fraction;
+  const uint8* src_ptr1 = src_ptr + src_stride;
+  for (int x = 0; x < dst_width; ++x) {
+    dst_ptr[x] = (src_ptr[x] * y0_fraction + src_ptr1[x] * y1_fraction) >> 8;
+  }
+  dst_ptr[dst_width] = dst_ptr[dst_width - 1];
+}
+
+void ScaleAddRows_C(const uint8* src_ptr, int src_stride,
+                    uint16* dst_ptr, int src_width, int src_height) {
+  assert(src_width > 0);
+  assert(src_height > 0);
+  for (int x = 0; x < src_width; ++x) {
+    const uint8* s = src_ptr + x;
+    int sum = 0;
+    for (int y = 0; y < src_height; ++y) {
+      sum += s[0];
+      s += src_stride;
+    }
+    dst_ptr[x] = sum;
+  }
+}
+
+#if defined(HAS_SCALEADDROWS_SSE2)
+// Any width.  SSE2 sums multiples of 16 columns and C the rest.  The SSE2
+// version needs at least 2 rows.
+static void ScaleAddRows_Any_SSE2(const uint8* src_ptr, int src_stride,
+                                  uint16* dst_ptr, int src_width,
+                                  int src_height) {
+  int n = src_width & ~15;
+  if (src_height < 2) {
+    n = 0;
+  }
+  if (n > 0) {
+    ScaleAddRows_SSE2(src_ptr, src_stride, dst_ptr, n, src_height);
+  }
+  if (n < src_width) {
+    ScaleAddRows_C(src_ptr + n, src_stride, dst_ptr + n, src_width - n,
+                   src_height);
+  }
+}
+#endif
+
+#if defined(HAS_SCALEADDROWS_MMX)
+// Any width.  MMX sums multiples of 8 columns and C the rest.
+static void ScaleAddRows_Any_MMX(const uint8* src_ptr, int src_stride,
+                                 uint16* dst_ptr, int src_width,
+                                 int src_height) {
+  int n = src_width & ~7;
+  if (n > 0) {
+    ScaleAddRows_MMX(src_ptr, src_stride, dst_ptr, n, src_height);
+  }
+  if (n < src_width) {
+    ScaleAddRows_C(src_ptr + n, src_stride, dst_ptr + n, src_width - n,
+                   src_height);
+  }
+}
+#endif
+
+// Any width.  The SIMD row function scales the largest multiple of MASK + 1
+// output pixels and the C version the rest.  Each output pixel reduces
+// FACTOR source pixels.
+#define SDANY(NAMEANY, SCALEROWDOWN_SIMD, SCALEROWDOWN_C, FACTOR, MASK)       \
+    static void NAMEANY(const uint8* src_ptr, int src_stride,                 \
+                        uint8* dst_ptr, int dst_width) {                      \
+      int n = dst_width & ~MASK;                                              \
+      if (n > 0) {                                                            \
+        SCALEROWDOWN_SIMD(src_ptr, src_stride, dst_ptr, n);                   \
+      }                                                                       \
+      if (n < dst_width) {                                                    \
+        SCALEROWDOWN_C(src_ptr + n * FACTOR, src_stride, dst_ptr + n,         \
+                       dst_width - n);                                        \
+      }                                                                       \
+    }
+
+#if defined(HAS_SCALEROWDOWN2_SSE2)
+SDANY(ScaleRowDown2_Any_SSE2, ScaleRowDown2_SSE2, ScaleRowDown2_C, 2, 15)
+SDANY(ScaleRowDown2Int_Any_SSE2, ScaleRowDown2Int_SSE2, ScaleRowDown2Int_C,
+      2, 15)
+#endif
+#if defined(HAS_SCALEROWDOWN2_SSE)
+SDANY(ScaleRowDown2_Any_SSE, ScaleRowDown2_SSE, ScaleRowDown2_C, 2, 7)
+SDANY(ScaleRowDown2Int_Any_SSE, ScaleRowDown2Int_SSE, ScaleRowDown2Int_C,
+      2, 7)
+#endif
+#if defined(HAS_SCALEROWDOWN4_SSE2)
+SDANY(ScaleRowDown4_Any_SSE2, ScaleRowDown4_SSE2, ScaleRowDown4_C, 4, 7)
+SDANY(ScaleRowDown4Int_Any_SSE2, ScaleRowDown4Int_SSE2, ScaleRowDown4Int_C,
+      4, 7)
+#endif
+#if defined(HAS_SCALEROWDOWN4_SSE)
+SDANY(ScaleRowDown4_Any_SSE, ScaleRowDown4_SSE, ScaleRowDown4_C, 4, 3)
+SDANY(ScaleRowDown4Int_Any_SSE, ScaleRowDown4Int_SSE, ScaleRowDown4Int_C,
+      4, 3)
+#endif
+#if defined(HAS_SCALEROWDOWN8_SSE2)
+SDANY(ScaleRowDown8_Any_SSE2, ScaleRowDown8_SSE2, ScaleRowDown8_C, 8, 15)
+SDANY(ScaleRowDown8Int_Any_SSE2, ScaleRowDown8Int_SSE2, ScaleRowDown8Int_C,
+      8, 15)
+#endif
+#if defined(HAS_SCALEROWDOWN8_SSE)
+SDANY(ScaleRowDown8_Any_SSE, ScaleRowDown8_SSE, ScaleRowDown8_C, 8, 3)
+SDANY(ScaleRowDown8Int_Any_SSE, ScaleRowDown8Int_SSE, ScaleRowDown8Int_C,
+      8, 3)
+#endif
+#undef SDANY
+
+// Any width.  The SIMD version filters the largest multiple of MASK + 1
+// pixels and the C version the rest, including the pixel written past the
+// end of the row.
+#define SFRANY(NAMEANY, SCALEFILTERROWS_SIMD, MASK)                           \
+    static void NAMEANY(uint8* dst_ptr, const uint8* src_ptr,                 \
+                        int src_stride, int dst_width,                        \
+                        int source_y_fraction) {                              \
+      int n = dst_width & ~MASK;                                              \
+      if (n > 0) {                                                            \
+        SCALEFILTERROWS_SIMD(dst_ptr, src_ptr, src_stride, n,                 \
+                             source_y_fraction);                              \
+      }                                                                       \
+      if (n < dst_width) {                                                    \
+        ScaleFilterRows_C(dst_ptr + n, src_ptr + n, src_stride,               \
+                          dst_width - n, source_y_fraction);                  \
+      }                                                                       \
+    }
+
+#if defined(HAS_SCALEFILTERROWS_SSSE3)
+SFRANY(ScaleFilterRows_Any_SSSE3, ScaleFilterRows_SSSE3, 15)
+#endif
+#if defined(HAS_SCALEFILTERROWS_SSE2)
+SFRANY(ScaleFilterRows_Any_SSE2, ScaleFilterRows_SSE2, 15)
+#endif
+#if defined(HAS_SCALEFILTERROWS_MMX)
+SFRANY(ScaleFilterRows_Any_MMX, ScaleFilterRows_MMX, 7)
+#endif
+#undef SFRANY
+
+// Any width.  The SIMD version filters the largest multiple of MASK + 1
+// output pixels and the C version the rest from the same 16.16 position.
+#define SFCANY(NAMEANY, SCALEFILTERCOLS_SIMD, MASK)                           \
+    static void NAMEANY(uint8* dst_ptr, const uint8* src_ptr,                 \
+                        int dst_width, int x, int dx) {                       \
+      int n = dst_width & ~MASK;                                              \
+      if (n > 0) {                                                            \
+        SCALEFILTERCOLS_SIMD(dst_ptr, src_ptr, n, x, dx);                     \
+      }                                                                       \
+      if (n < dst_width) {                                                    \
+        ScaleFilterCols_C(dst_ptr + n, src_ptr, dst_width - n, x + n * dx,    \
+                          dx);                                                \
+      }                                                                       \
+    }
+
+#if defined(HAS_SCALEFILTERCOLS_SSE2)
+SFCANY(ScaleFilterCols_Any_SSE2, ScaleFilterCols_SSE2, 7)
+#endif
+#if defined(HAS_SCALEFILTERCOLS_SSE)
+SFCANY(ScaleFilterCols_Any_SSE, ScaleFilterCols_SSE, 3)
+#endif
+#undef SFCANY
+
+// Running sum of a row of column sums: dst_ptr[x] is the sum of src_ptr[0]
+// to src_ptr[x].  If add is true the running sum is added to dst_ptr
+// instead, which sums boxes too tall for 16 bit column sums.
+static void ScaleIntegrateRow_C(const uint16* src_ptr, uint32* dst_ptr,
+                                int width, bool add) {
+  uint32 sum = 0u;
+  for (int x = 0; x < width; ++x) {
+    sum += src_ptr[x];
+    dst_ptr[x] = add ? dst_ptr[x] + sum : sum;
+  }
+}
+
+// Reduces a group of source rows to one row of a plane.
+typedef void (*ScaleRowDownFunc)(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width);
+
+// Methods used to scale the rows of a plane.
+enum PlaneScaleMethod {
+  kScaleCopy,
+  kScaleDown2,
+  kScaleDown4,
+  kScaleDown8,
+  kScaleDown34,
+  kScaleDown38,
+  kScaleBox,
+  kScaleBilinear,
+  kScaleBilinearSimple,
+  kScaleSimple,
+  kScaleUp2Simple,
+  kScaleUpBilinear,
+  kScalePolyphase
+};
+
+struct ScaleFilterTable;
+
+// Scales the rows of one plane.  The method, its row functions and the
+// size of its row buffer are chosen once from the geometry and alignment
+// of the plane, and can then be reused for any number of frames.
+struct PlaneScaler {
+  PlaneScaleMethod method;
+  int src_width;
+  int src_height;
+  int dst_width;
+  int dst_height;
+  int src_stride;
+  int dst_stride;
+  FilterMode filtering;
+  int dx;
+  int dy;
+  // A source rectangle is scaled with dx, dy and the 16.16 source position
+  // of the first output pixel, x0 and y0, set by InitPlaneScalerRect.
+  bool rect;
+  int x0;
+  int y0;
+  int row_size;  // Size of the row buffer passed to RunPlaneScaler.
+
+  ScaleRowDownFunc ScaleRowDown0;
+  ScaleRowDownFunc ScaleRowDown1;
+  void (*ScaleFilterRows)(uint8* dst_ptr, const uint8* src_ptr,
+                          int src_stride,
+                          int dst_width, int source_y_fraction);
+  void (*ScaleFilterCols)(uint8* dst_ptr, const uint8* src_ptr,
+                          int dst_width, int x, int dx);
+  void (*ScaleColsUp2)(uint8* dst_ptr, const uint8* src_ptr, int dst_width);
+  void (*ScaleBlendRows)(uint8* dst_ptr, const uint8* src0_ptr,
+                         const uint8* src1_ptr, int dst_width,
+                         int source_y_fraction);
+  void (*ScaleAddRows)(const uint8* src_ptr, int src_stride,
+                       uint16* dst_ptr, int src_width, int src_height);
+  void (*ScaleIntegrateRow)(const uint16* src_ptr, uint32* dst_ptr,
+                            int width);
+  void (*ScaleAccumRows2)(int32* dst_acc, const uint8* src0_ptr,
+                          const uint8* src1_ptr, int src_width, int coeffs);
+  void (*ScalePackRow)(uint8* dst_ptr, const int32* src_acc, int width);
+  void (*ScaleFilterColsN)(uint8* dst_ptr, const uint8* src_ptr,
+                           int dst_width, const ScaleFilterPos* pos,
+                           int taps);
+  const ScaleFilterTable* table_x;
+  const ScaleFilterTable* table_y;
+  ScaleFilterTable* owned_x;  // Tables that are not cached.
+  ScaleFilterTable* owned_y;
+};
+
+// The Init functions below choose the row functions for a plane.  src_ptr
+// and dst_ptr are only used to check alignment.
+
+/**
+ * Scale plane, 1/2
+ *
+ * This is an optimized version for scaling down a plane to 1/2 of
+ * its original size.
+ *
+ */
+static void InitScalePlaneDown2(PlaneScaler* s,
+                                const uint8* src_ptr, uint8* dst_ptr) {
+  assert(s->src_width % 2 == 0);
+  assert(s->src_height % 2 == 0);
+  const int dst_width = s->dst_width;
+  const FilterMode filtering = s->filtering;
+  s->method = kScaleDown2;
+
+#if defined(HAS_SCALEROWDOWN2_NEON)
+  if (TestCpuFlag(kCpuHasNEON) &&
+      (dst_width % 16 == 0)) {
+    s->ScaleRowDown0 = filtering ? ScaleRowDown2Int_NEON : ScaleRowDown2_NEON;
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN2_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (dst_width >= 16) &&
+      (s->src_stride % 16 == 0) && (s->dst_stride % 16 == 0) &&
+      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 16)) {
+    if (dst_width % 16 == 0) {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown2Int_SSE2 :
+                                     ScaleRowDown2_SSE2;
+    } else {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown2Int_Any_SSE2 :
+                                     ScaleRowDown2_Any_SSE2;
+    }
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN2_SSE)
+  if (TestCpuFlag(kCpuHasSSE) &&
+      (dst_width >= 8)) {
+    if (dst_width % 8 == 0) {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown2Int_SSE : ScaleRowDown2_SSE;
+    } else {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown2Int_Any_SSE :
+                                     ScaleRowDown2_Any_SSE;
+    }
+  } else
+#endif
+  {
+    s->ScaleRowDown0 = filtering ? ScaleRowDown2Int_C : ScaleRowDown2_C;
+  }
+}
+
+static void ScalePlaneDown2(const PlaneScaler* s,
+                            const uint8* src_ptr, uint8* dst_ptr,
+                            int y_begin, int y_end) {
+  const int src_stride = s->src_stride;
+  const int dst_stride = s->dst_stride;
+  src_ptr += (src_stride << 1) * y_begin;
+  dst_ptr += dst_stride * y_begin;
+  for (int y = y_begin; y < y_end; ++y) {
+    s->ScaleRowDown0(src_ptr, src_stride, dst_ptr, s->dst_width);
+    src_ptr += (src_stride << 1);
+    dst_ptr += dst_stride;
+  }
+}
+
+/**
+ * Scale plane, 1/4
+ *
+ * This is an optimized version for scaling down a plane to 1/4 of
+ * its original size.
+ */
+static void InitScalePlaneDown4(PlaneScaler* s,
+                                const uint8* src_ptr, uint8* dst_ptr) {
+  assert(s->src_width % 4 == 0);
+  assert(s->src_height % 4 == 0);
+  const int dst_width = s->dst_width;
+  const FilterMode filtering = s->filtering;
+  s->method = kScaleDown4;
+
+#if defined(HAS_SCALEROWDOWN4_NEON)
+  if (TestCpuFlag(kCpuHasNEON) &&
+      (dst_width % 4 == 0)) {
+    s->ScaleRowDown0 = filtering ? ScaleRowDown4Int_NEON : ScaleRowDown4_NEON;
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN4_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (dst_width >= 8) && (s->src_stride % 16 == 0) &&
+      (s->dst_stride % 8 == 0) &&
+      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 8)) {
+    if (dst_width % 8 == 0) {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown4Int_SSE2 :
+                                     ScaleRowDown4_SSE2;
+    } else {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown4Int_Any_SSE2 :
+                                     ScaleRowDown4_Any_SSE2;
+    }
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN4_SSE)
+  if (TestCpuFlag(kCpuHasSSE) &&
+      (dst_width >= 4)) {
+    if (dst_width % 4 == 0) {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown4Int_SSE : ScaleRowDown4_SSE;
+    } else {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown4Int_Any_SSE :
+                                     ScaleRowDown4_Any_SSE;
+    }
+  } else
+#endif
+  {
+    s->ScaleRowDown0 = filtering ? ScaleRowDown4Int_C : ScaleRowDown4_C;
+  }
+}
+
+static void ScalePlaneDown4(const PlaneScaler* s,
+                            const uint8* src_ptr, uint8* dst_ptr,
+                            int y_begin, int y_end) {
+  const int src_stride = s->src_stride;
+  const int dst_stride = s->dst_stride;
+  src_ptr += (src_stride << 2) * y_begin;
+  dst_ptr += dst_stride * y_begin;
+  for (int y = y_begin; y < y_end; ++y) {
+    s->ScaleRowDown0(src_ptr, src_stride, dst_ptr, s->dst_width);
+    src_ptr += (src_stride << 2);
+    dst_ptr += dst_stride;
+  }
+}
+
+/**
+ * Scale plane, 1/8
+ *
+ * This is an optimized version for scaling down a plane to 1/8
+ * of its original size.
+ *
+ */
+static void InitScalePlaneDown8(PlaneScaler* s,
+                                const uint8* src_ptr, uint8* dst_ptr) {
+  assert(s->src_width % 8 == 0);
+  assert(s->src_height % 8 == 0);
+  const int dst_width = s->dst_width;
+  const FilterMode filtering = s->filtering;
+  s->method = kScaleDown8;
+#if defined(HAS_SCALEROWDOWN8_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (dst_width >= 16) && dst_width <= kMaxOutputWidth &&
+      (s->src_stride % 16 == 0) && (s->dst_stride % 16 == 0) &&
+      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 16)) {
+    if (dst_width % 16 == 0) {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown8Int_SSE2 :
+                                     ScaleRowDown8_SSE2;
+    } else {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown8Int_Any_SSE2 :
+                                     ScaleRowDown8_Any_SSE2;
+    }
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN8_SSE)
+  if (TestCpuFlag(kCpuHasSSE) &&
+      (dst_width >= 4)) {
+    if (dst_width % 4 == 0) {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown8Int_SSE : ScaleRowDown8_SSE;
+    } else {
+      s->ScaleRowDown0 = filtering ? ScaleRowDown8Int_Any_SSE :
+                                     ScaleRowDown8_Any_SSE;
+    }
+  } else
+#endif
+  {
+    s->ScaleRowDown0 = filtering && (dst_width <= kMaxOutputWidth) ?
+        ScaleRowDown8Int_C : ScaleRowDown8_C;
+  }
+}
+
+static void ScalePlaneDown8(const PlaneScaler* s,
+                            const uint8* src_ptr, uint8* dst_ptr,
+                            int y_begin, int y_end) {
+  const int src_stride = s->src_stride;
+  const int dst_stride = s->dst_stride;
+  src_ptr += (src_stride << 3) * y_begin;
+  dst_ptr += dst_stride * y_begin;
+  for (int y = y_begin; y < y_end; ++y) {
+    s->ScaleRowDown0(src_ptr, src_stride, dst_ptr, s->dst_width);
+    src_ptr += (src_stride << 3);
+    dst_ptr += dst_stride;
+  }
+}
+
+/**
+ * Scale plane down, 3/4
+ *
+ * Provided by Frank Barchard (fbarchard@google.com)
+ *
+ */
+static void InitScalePlaneDown34(PlaneScaler* s,
+                                 const uint8* src_ptr, uint8* dst_ptr) {
+  assert(s->dst_width % 3 == 0);
+  const int dst_width = s->dst_width;
+  const FilterMode filtering = s->filtering;
+  s->method = kScaleDown34;
+#if defined(HAS_SCALEROWDOWN34_NEON)
+  if (TestCpuFlag(kCpuHasNEON) &&
+      (dst_width % 24 == 0)) {
+    if (!filtering) {
+      s->ScaleRowDown0 = ScaleRowDown34_NEON;
+      s->ScaleRowDown1 = ScaleRowDown34_NEON;
+    } else {
+      s->ScaleRowDown0 = ScaleRowDown34_0_Int_NEON;
+      s->ScaleRowDown1 = ScaleRowDown34_1_Int_NEON;
+    }
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN34_SSSE3)
+  if (TestCpuFlag(kCpuHasSSSE3) &&
+      (dst_width % 24 == 0) && (s->src_stride % 16 == 0) &&
+      (s->dst_stride % 8 == 0) &&
+      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 8)) {
+    if (!filtering) {
+      s->ScaleRowDown0 = ScaleRowDown34_SSSE3;
+      s->ScaleRowDown1 = ScaleRowDown34_SSSE3;
+    } else {
+      s->ScaleRowDown0 = ScaleRowDown34_0_Int_SSSE3;
+      s->ScaleRowDown1 = ScaleRowDown34_1_Int_SSSE3;
+    }
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN34_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (dst_width % 24 == 0) && (s->src_stride % 16 == 0) &&
+      (s->dst_stride % 8 == 0) && (s->src_width <= kMaxInputWidth) &&
+      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 8) &&
+      filtering) {
+    s->ScaleRowDown0 = ScaleRowDown34_0_Int_SSE2;
+    s->ScaleRowDown1 = ScaleRowDown34_1_Int_SSE2;
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN34_MMX)
+  if (TestCpuFlag(kCpuHasMMX) &&
+      (dst_width % 6 == 0) && (s->src_width <= kMaxInputWidth) &&
+      filtering) {
+    s->ScaleRowDown0 = ScaleRowDown34_0_Int_MMX;
+    s->ScaleRowDown1 = ScaleRowDown34_1_Int_MMX;
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN34_SSE)
+  if (TestCpuFlag(kCpuHasSSE) &&
+      (dst_width % 6 == 0) && !filtering) {
+    s->ScaleRowDown0 = ScaleRowDown34_SSE;
+    s->ScaleRowDown1 = ScaleRowDown34_SSE;
+  } else
+#endif
+  {
+    if (!filtering) {
+      s->ScaleRowDown0 = ScaleRowDown34_C;
+      s->ScaleRowDown1 = ScaleRowDown34_C;
+    } else {
+      s->ScaleRowDown0 = ScaleRowDown34_0_Int_C;
+      s->ScaleRowDown1 = ScaleRowDown34_1_Int_C;
+    }
+  }
+}
+
+static void ScalePlaneDown34(const PlaneScaler* s,
+                             const uint8* src_ptr, uint8* dst_ptr,
+                             int y_begin, int y_end) {
+  const int src_stride = s->src_stride;
+  const int dst_stride = s->dst_stride;
+  const int dst_width = s->dst_width;
+  // Every 3 destination rows consume 4 source rows.
+  int src_row = y_begin % 3;
+  src_ptr += src_stride * ((y_begin / 3) * 4 + src_row);
+  dst_ptr += dst_stride * y_begin;
+  for (int y = y_begin; y < y_end; ++y) {
+    switch (src_row) {
+      case 0:
+        s->ScaleRowDown0(src_ptr, src_stride, dst_ptr, dst_width);
+        break;
+
+      case 1:
+        s->ScaleRowDown1(src_ptr, src_stride, dst_ptr, dst_width);
+        break;
+
+      case 2:
+        s->ScaleRowDown0(src_ptr + src_stride, -src_stride,
+                         dst_ptr, dst_width);
+        break;
+    }
+    ++src_row;
+    src_ptr += src_stride;
+    dst_ptr += dst_stride;
+    if (src_row >= 3) {
+      src_ptr += src_stride;
+      src_row = 0;
+    }
+  }
+}
+
+/**
+ * Scale plane, 3/8
+ *
+ * This is an optimized version for scaling down a plane to 3/8
+ * of its original size.
+ *
+ * Reduces 16x3 to 6x1
+ */
+static void InitScalePlaneDown38(PlaneScaler* s,
+                                 const uint8* src_ptr, uint8* dst_ptr) {
+  assert(s->dst_width % 3 == 0);
+  const int dst_width = s->dst_width;
+  const FilterMode filtering = s->filtering;
+  s->method = kScaleDown38;
+  // ScaleRowDown0 reduces 3 source rows and ScaleRowDown1 reduces 2.
+#if defined(HAS_SCALEROWDOWN38_NEON)
+  if (TestCpuFlag(kCpuHasNEON) &&
+      (dst_width % 12 == 0)) {
+    if (!filtering) {
+      s->ScaleRowDown0 = ScaleRowDown38_NEON;
+      s->ScaleRowDown1 = ScaleRowDown38_NEON;
+    } else {
+      s->ScaleRowDown0 = ScaleRowDown38_3_Int_NEON;
+      s->ScaleRowDown1 = ScaleRowDown38_2_Int_NEON;
+    }
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN38_SSSE3)
+  if (TestCpuFlag(kCpuHasSSSE3) &&
+      (dst_width % 24 == 0) && (s->src_stride % 16 == 0) &&
+      (s->dst_stride % 8 == 0) &&
+      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 8)) {
+    if (!filtering) {
+      s->ScaleRowDown0 = ScaleRowDown38_SSSE3;
+      s->ScaleRowDown1 = ScaleRowDown38_SSSE3;
+    } else {
+      s->ScaleRowDown0 = ScaleRowDown38_3_Int_SSSE3;
+      s->ScaleRowDown1 = ScaleRowDown38_2_Int_SSSE3;
+    }
+  } else
+#endif
+#if defined(HAS_SCALEROWDOWN38_SSE)
+  if (TestCpuFlag(kCpuHasSSE) &&
+      (dst_width % 6 == 0)) {
+    if (!filtering) {
+      s->ScaleRowDown0 = ScaleRowDown38_SSE;
+      s->ScaleRowDown1 = ScaleRowDown38_SSE;
+    } else {
+      s->ScaleRowDown0 = ScaleRowDown38_3_Int_SSE;
+      s->ScaleRowDown1 = ScaleRowDown38_2_Int_SSE;
+    }
+  } else
+#endif
+  {
+    if (!filtering) {
+      s->ScaleRowDown0 = ScaleRowDown38_C;
+      s->ScaleRowDown1 = ScaleRowDown38_C;
+    } else {
+      s->ScaleRowDown0 = ScaleRowDown38_3_Int_C;
+      s->ScaleRowDown1 = ScaleRowDown38_2_Int_C;
+    }
+  }
+}
+
+static void ScalePlaneDown38(const PlaneScaler* s,
+                             const uint8* src_ptr, uint8* dst_ptr,
+                             int y_begin, int y_end) {
+  const int src_stride = s->src_stride;
+  const int dst_stride = s->dst_stride;
+  const int dst_width = s->dst_width;
+  // Every 3 destination rows consume 8 source rows, as 3, 3 and 2.
+  int src_row = y_begin % 3;
+  src_ptr += src_stride * ((y_begin / 3) * 8 + src_row * 3);
+  dst_ptr += dst_stride * y_begin;
+  for (int y = y_begin; y < y_end; ++y) {
+    switch (src_row) {
+      case 0:
+      case 1:
+        s->ScaleRowDown0(src_ptr, src_stride, dst_ptr, dst_width);
+        src_ptr += src_stride * 3;
+        ++src_row;
+        break;
+
+      case 2:
+        s->ScaleRowDown1(src_ptr, src_stride, dst_ptr, dst_width);
+        src_ptr += src_stride * 2;
+        src_row = 0;
+        break;
+    }
+    dst_ptr += dst_stride;
+  }
+}
+
+// Column sums in 16 bits hold up to 257 rows of 255.  Taller boxes are
+// summed in parts of this many rows.
+static const int kMaxBoxRows = 256;
+
+// Averages boxes of columns using running sums, so the cost does not
+// depend on the width of the boxes.  sums[x] is the sum of the first x
+// columns of the box rows, and sums[0] is 0.
+// Each box sum is divided by its area with a 32 bit reciprocal, rounded
+// up.  The result is the sum divided by the area, rounded down, for boxes
+// of up to 4096 pixels, and at most 1 more for larger boxes.
+static void ScaleAddCols_C(int dst_width, int boxheight, int x, int dx,
+                           const uint32* sums, uint8* dst_ptr) {
+  uint32 scaletbl[2];
+  int minboxwidth = dx >> 16;
+  scaletbl[0] = static_cast<uint32>(
+      0xffffffffu / (minboxwidth * boxheight) + 1);
+  scaletbl[1] = static_cast<uint32>(
+      0xffffffffu / ((minboxwidth + 1) * boxheight) + 1);
+  const uint32* scaleptr = scaletbl - minboxwidth;
+  for (int i = 0; i < dst_width; ++i) {
+    int ix = x >> 16;
+    x += dx;
+    int ix1 = x >> 16;
+    *dst_ptr++ = static_cast<uint8>(
+        (static_cast<uint64>(sums[ix1] - sums[ix]) * scaleptr[ix1 - ix]) >>
+        32);
+  }
+}
+
+/**
+ * Scale plane down to any dimensions, with interpolation.
+ * (boxfilter).
+ *
+ * Same method as SimpleScale, which is fixed point, outputting
+ * one pixel of destination using fixed point (16.16) to step
+ * through source, sampling a box of pixel with simple
+ * averaging.
+ */
+static void InitScalePlaneBox(PlaneScaler* s,
+                              const uint8* src_ptr, uint8* dst_ptr) {
+  assert(s->dst_width > 0);
+  assert(s->dst_height > 0);
+  const int src_width = s->src_width;
+  s->method = kScaleBox;
+  if (!s->rect) {
+    s->dy = (s->src_height << 16) / s->dst_height;
+    s->dx = (src_width << 16) / s->dst_width;
+  }
+  // A row of 16 bit column sums, then src_width + 1 running sums.
+  s->row_size = ((src_width * 2 + 15) & ~15) + (src_width + 1) * 4;
+#if defined(HAS_SCALEADDROWS_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (s->src_stride % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
+      (src_width >= 16)) {
+    s->ScaleAddRows = ScaleAddRows_Any_SSE2;
+  } else
+#endif
+#if defined(HAS_SCALEADDROWS_MMX)
+  if (TestCpuFlag(kCpuHasMMX) &&
+      (src_width >= 8)) {
+    s->ScaleAddRows = ScaleAddRows_Any_MMX;
+  } else
+#endif
+  {
+    s->ScaleAddRows = ScaleAddRows_C;
+  }
+#if defined(HAS_SCALEINTEGRATEROW_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && (src_width % 4 == 0)) {
+    s->ScaleIntegrateRow = ScaleIntegrateRow_SSE2;
+  } else
+#endif
+  {
+    s->ScaleIntegrateRow = NULL;
+  }
+}
+
+// Each output row sums the columns of its box of source rows, reading each
+// source row once.  The column sums are then turned into running sums, so
+// each output pixel is the difference of 2 running sums.
+static void ScalePlaneBox(const PlaneScaler* s,
+                          const uint8* src_ptr, uint8* dst_ptr,
+                          uint8* row_buffer, int y_begin, int y_end) {
+  const int src_width = s->src_width;
+  const int src_height = s->src_height;
+  const int dst_width = s->dst_width;
+  const int src_stride = s->src_stride;
+  const int dst_stride = s->dst_stride;
+  const int dx = s->dx;
+  const int dy = s->dy;
+  uint16* row = reinterpret_cast<uint16*>(row_buffer);
+  uint32* sums = reinterpret_cast<uint32*>(
+      row_buffer + ((src_width * 2 + 15) & ~15));
+  sums[0] = 0u;
+  int y = s->y0 + dy * y_begin;
+  if (y > (src_height << 16)) {
+    y = (src_height << 16);
+  }
+  dst_ptr += dst_stride * y_begin;
+  for (int j = y_begin; j < y_end; ++j) {
+    int iy = y >> 16;
+    const uint8* const src = src_ptr + iy * src_stride;
+    y += dy;
+    if (y > (src_height << 16)) {
+      y = (src_height << 16);
+    }
+    int boxheight = (y >> 16) - iy;
+    if (boxheight <= kMaxBoxRows && s->ScaleIntegrateRow) {
+      s->ScaleAddRows(src, src_stride, row, src_width, boxheight);
+      s->ScaleIntegrateRow(row, sums + 1, src_width);
+    } else {
+      for (int h = 0; h < boxheight; h += kMaxBoxRows) {
+        int rows = boxheight - h;
+        if (rows > kMaxBoxRows) {
+          rows = kMaxBoxRows;
+        }
+        s->ScaleAddRows(src + h * src_stride, src_stride, row, src_width,
+                        rows);
+        ScaleIntegrateRow_C(row, sums + 1, src_width, h > 0);
+      }
+    }
+    ScaleAddCols_C(dst_width, boxheight, s->x0, dx, sums, dst_ptr);
+    dst_ptr += dst_stride;
+  }
+}
+
+/**
+ * Scale plane to/from any dimensions, with interpolation.
+ */
+static void ScalePlaneBilinearSimple(const PlaneScaler* s,
+                                     const uint8* src_ptr, uint8* dst_ptr,
+                                     int y_begin, int y_end) {
+  const int src_width = s->src_width;
+  const int src_height = s->src_height;
+  const int dst_width = s->dst_width;
+  const int dst_height = s->dst_height;
+  const int src_stride = s->src_stride;
+  const int dst_stride = s->dst_stride;
+  uint8* dst = dst_ptr + dst_stride * y_begin;
+  int dx = s->dx;
+  int dy = s->dy;
+  int maxx = ((src_width - 1) << 16) - 1;
+  int maxy = ((src_height - 1) << 16) - 1;
+  int y = (dst_height < src_height) ? 32768 :
+      (src_height << 16) / dst_height - 32768;
+  if (y_begin > 0) {
+    y += dy * y_begin;
+    if (y > maxy)
+      y = maxy;
+  }
+  for (int i = y_begin; i < y_end; ++i) {
+    int cy = (y < 0) ? 0 : y;
+    int yi = cy >> 16;
+    int yf = cy & 0xffff;
+    const uint8* const src = src_ptr + yi * src_stride;
+    int x = (dst_width < src_width) ? 32768 :
+        (src_width << 16) / dst_width - 32768;
+    for (int j = 0; j < dst_width; ++j) {
+      int cx = (x < 0) ? 0 : x;
+      int xi = cx >> 16;
+      int xf = cx & 0xffff;
+      int r0 = (src[xi] * (65536 - xf) + src[xi + 1] * xf) >> 16;
+      int r1 = (src[xi + src_stride] * (65536 - xf) +
+          src[xi + src_stride + 1] * xf) >> 16;
+      *dst++ = (r0 * (65536 - yf) + r1 * yf) >> 16;
+      x += dx;
+      if (x > maxx)
+        x = maxx;
+    }
+    dst += dst_stride - dst_width;
+    y += dy;
+    if (y > maxy)
+      y = maxy;
+  }
 }
 
-// Bilinear row filtering combines 16x2 -> 16x1. SSSE3 version
-#define HAS_SCALEFILTERROWS_SSSE3
-static void ScaleFilterRows_SSSE3(uint8* dst_ptr,
-                                  const uint8* src_ptr, int src_stride,
-                                  int dst_width, int source_y_fraction) {
-  if (source_y_fraction == 0) {
-    asm volatile (
-   "1:"
-      "movdqa     (%1),%%xmm0                  \n"
-      "lea        0x10(%1),%1                  \n"
-      "movdqa     %%xmm0,(%0)                  \n"
-      "lea        0x10(%0),%0                  \n"
-      "sub        $0x10,%2                     \n"
-      "ja         1b                           \n"
-      "mov        -0x1(%0),%%al                \n"
-      "mov        %%al,(%0)                    \n"
-      : "+r"(dst_ptr),     // %0
-        "+r"(src_ptr),     // %1
-        "+r"(dst_width)    // %2
-      :
-      : "memory", "cc", "rax"
-    );
-    return;
-  } else if (source_y_fraction == 128) {
-    asm volatile (
-    "1:"
-      "movdqa     (%1),%%xmm0                  \n"
-      "movdqa     (%1,%3,1),%%xmm2             \n"
-      "lea        0x10(%1),%1                  \n"
-      "pavgb      %%xmm2,%%xmm0                \n"
-      "movdqa     %%xmm0,(%0)                  \n"
-      "lea        0x10(%0),%0                  \n"
-      "sub        $0x10,%2                     \n"
-      "ja         1b                           \n"
-      "mov        -0x1(%0),%%al                \n"
-      "mov        %%al,(%0)                    \n"
-      : "+r"(dst_ptr),     // %0
-        "+r"(src_ptr),     // %1
-        "+r"(dst_width)    // %2
-      : "r"(static_cast<intptr_t>(src_stride))  // %3
-     : "memory", "cc", "rax"
-    );
+/**
+ * Scale plane to/from any dimensions, with bilinear
+ * interpolation.
+ */
+static void InitScalePlaneBilinear(PlaneScaler* s,
+                                   const uint8* src_ptr, uint8* dst_ptr) {
+  assert(s->dst_width > 0);
+  assert(s->dst_height > 0);
+  const int src_width = s->src_width;
+  if (!s->rect) {
+    s->dy = (s->src_height << 16) / s->dst_height;
+    s->dx = (src_width << 16) / s->dst_width;
+  }
+  // ScalePlaneBilinearSimple samples pixel centers, which a rectangle
+  // does not.
+  if (src_width % 8 != 0 && !s->rect) {
+    s->method = kScaleBilinearSimple;
     return;
-  } else {
-    asm volatile (
-      "mov        %3,%%eax                     \n"
-      "shr        %%eax                        \n"
-      "mov        %%al,%%ah                    \n"
-      "neg        %%al                         \n"
-      "add        $0x80,%%al                   \n"
-      "movd       %%eax,%%xmm5                 \n"
-      "punpcklwd  %%xmm5,%%xmm5                \n"
-      "pshufd     $0x0,%%xmm5,%%xmm5           \n"
-    "1:"
-      "movdqa     (%1),%%xmm0                  \n"
-      "movdqa     (%1,%4,1),%%xmm2             \n"
-      "lea        0x10(%1),%1                  \n"
-      "movdqa     %%xmm0,%%xmm1                \n"
-      "punpcklbw  %%xmm2,%%xmm0                \n"
-      "punpckhbw  %%xmm2,%%xmm1                \n"
-      "pmaddubsw  %%xmm5,%%xmm0                \n"
-      "pmaddubsw  %%xmm5,%%xmm1                \n"
-      "psrlw      $0x7,%%xmm0                  \n"
-      "psrlw      $0x7,%%xmm1                  \n"
-      "packuswb   %%xmm1,%%xmm0                \n"
-      "movdqa     %%xmm0,(%0)                  \n"
-      "lea        0x10(%0),%0                  \n"
-      "sub        $0x10,%2                     \n"
-      "ja         1b                           \n"
-      "mov        -0x1(%0),%%al                \n"
-      "mov        %%al,(%0)                    \n"
-      : "+r"(dst_ptr),     // %0
-        "+r"(src_ptr),     // %1
-        "+r"(dst_width),   // %2
-        "+r"(source_y_fraction)  // %3
-      : "r"(static_cast<intptr_t>(src_stride))  // %4
-      : "memory", "cc", "rax"
-    );
   }
-  return;
-}
+  s->method = kScaleBilinear;
+  // ScaleFilterRows writes one pixel past the end of the row.
+  s->row_size = src_width + 1;
+#if defined(HAS_SCALEFILTERROWS_SSSE3)
+  if (TestCpuFlag(kCpuHasSSSE3) &&
+      (s->src_stride % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
+      (src_width >= 16)) {
+    s->ScaleFilterRows = (src_width % 16 == 0) ? ScaleFilterRows_SSSE3 :
+                                                 ScaleFilterRows_Any_SSSE3;
+  } else
+#endif
+#if defined(HAS_SCALEFILTERROWS_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (s->src_stride % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
+      (src_width >= 16)) {
+    s->ScaleFilterRows = (src_width % 16 == 0) ? ScaleFilterRows_SSE2 :
+                                                 ScaleFilterRows_Any_SSE2;
+  } else
+#endif
+#if defined(HAS_SCALEFILTERROWS_MMX)
+  if (TestCpuFlag(kCpuHasMMX) &&
+      (src_width >= 8)) {
+    s->ScaleFilterRows = (src_width % 8 == 0) ? ScaleFilterRows_MMX :
+                                                ScaleFilterRows_Any_MMX;
+  } else
+#endif
+  {
+    s->ScaleFilterRows = ScaleFilterRows_C;
+  }
+#if defined(HAS_SCALEFILTERCOLS_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && (s->dst_width >= 8)) {
+    s->ScaleFilterCols = (s->dst_width % 8 == 0) ? ScaleFilterCols_SSE2 :
+                                                   ScaleFilterCols_Any_SSE2;
+  } else
 #endif
+#if defined(HAS_SCALEFILTERCOLS_SSE)
+  if (TestCpuFlag(kCpuHasSSE) && (s->dst_width >= 4)) {
+    s->ScaleFilterCols = (s->dst_width % 4 == 0) ? ScaleFilterCols_SSE :
+                                                   ScaleFilterCols_Any_SSE;
+  } else
 #endif
+  {
+    s->ScaleFilterCols = ScaleFilterCols_C;
+  }
+}
 
-// CPU agnostic row functions
-static void ScaleRowDown2_C(const uint8* src_ptr, int,
-                            uint8* dst, int dst_width) {
-  for (int x = 0; x < dst_width; ++x) {
-    *dst++ = *src_ptr;
-    src_ptr += 2;
+static void ScalePlaneBilinear(const PlaneScaler* s,
+                               const uint8* src_ptr, uint8* dst_ptr,
+                               uint8* row, int y_begin, int y_end) {
+  const int src_stride = s->src_stride;
+  const int dst_stride = s->dst_stride;
+  const int dy = s->dy;
+  // max is filter of last 2 rows.  A single row is blended with itself.
+  const int row_stride = (s->src_height > 1) ? src_stride : 0;
+  int maxy = (s->src_height > 1) ? ((s->src_height - 1) << 16) - 1 : 0;
+  // Each output row filters source rows iy and iy + 1, so bands that are
+  // scaled independently overlap by one source row.
+  int y = s->y0;
+  if (y_begin > 0) {
+    y += dy * y_begin;
+    if (y > maxy) {
+      y = maxy;
+    }
+  }
+  dst_ptr += dst_stride * y_begin;
+  for (int j = y_begin; j < y_end; ++j) {
+    int iy = y >> 16;
+    int fy = (y >> 8) & 255;
+    const uint8* const src = src_ptr + iy * src_stride;
+    s->ScaleFilterRows(row, src, row_stride, s->src_width, fy);
+    s->ScaleFilterCols(dst_ptr, row, s->dst_width, s->x0, s->dx);
+    dst_ptr += dst_stride;
+    y += dy;
+    if (y > maxy) {
+      y = maxy;
+    }
   }
 }
 
-static void ScaleRowDown2Int_C(const uint8* src_ptr, int src_stride,
-                               uint8* dst, int dst_width) {
-  for (int x = 0; x < dst_width; ++x) {
-    *dst++ = (src_ptr[0] + src_ptr[1] +
-              src_ptr[src_stride] + src_ptr[src_stride + 1] + 2) >> 2;
-    src_ptr += 2;
+/**
+ * Scale plane to/from any dimensions, without interpolation.
+ * Fixed point math is used for performance: The upper 16 bits
+ * of x and dx is the integer part of the source position and
+ * the lower 16 bits are the fixed decimal part.
+ */
+static void ScalePlaneSimple(const PlaneScaler* s,
+                             const uint8* src_ptr, uint8* dst_ptr,
+                             int y_begin, int y_end) {
+  const int dst_width = s->dst_width;
+  const int dst_stride = s->dst_stride;
+  uint8* dst = dst_ptr + dst_stride * y_begin;
+  int dx = s->dx;
+  for (int y = y_begin; y < y_end; ++y) {
+    // A source rectangle is stepped in 16.16 fixed point, from y0.
+    int iy = s->rect ? (s->y0 + y * s->dy) >> 16 :
+        y * s->src_height / s->dst_height;
+    const uint8* const src = src_ptr + iy * s->src_stride;
+    // TODO(fbarchard): Round X coordinate by setting x=0x8000.
+    int x = s->x0;
+    for (int i = 0; i < dst_width; ++i) {
+      *dst++ = src[x >> 16];
+      x += dx;
+    }
+    dst += dst_stride - dst_width;
   }
 }
 
-static void ScaleRowDown4_C(const uint8* src_ptr, int,
-                            uint8* dst, int dst_width) {
-  for (int x = 0; x < dst_width; ++x) {
-    *dst++ = *src_ptr;
-    src_ptr += 4;
+static void InitScalePlaneSimple(PlaneScaler* s) {
+  s->method = kScaleSimple;
+  if (!s->rect) {
+    s->dx = (s->src_width << 16) / s->dst_width;
   }
 }
 
-static void ScaleRowDown4Int_C(const uint8* src_ptr, int src_stride,
-                               uint8* dst, int dst_width) {
-  for (int x = 0; x < dst_width; ++x) {
-    *dst++ = (src_ptr[0] + src_ptr[1] + src_ptr[2] + src_ptr[3] +
-              src_ptr[src_stride + 0] + src_ptr[src_stride + 1] +
-              src_ptr[src_stride + 2] + src_ptr[src_stride + 3] +
-              src_ptr[src_stride * 2 + 0] + src_ptr[src_stride * 2 + 1] +
-              src_ptr[src_stride * 2 + 2] + src_ptr[src_stride * 2 + 3] +
-              src_ptr[src_stride * 3 + 0] + src_ptr[src_stride * 3 + 1] +
-              src_ptr[src_stride * 3 + 2] + src_ptr[src_stride * 3 + 3] +
-              8) >> 4;
-    src_ptr += 4;
+/**
+ * Scale plane to/from any dimensions.
+ */
+static void InitScalePlaneAnySize(PlaneScaler* s,
+                                  const uint8* src_ptr, uint8* dst_ptr) {
+  if (!s->filtering) {
+    InitScalePlaneSimple(s);
+  } else {
+    // fall back to non-optimized version
+    InitScalePlaneBilinear(s, src_ptr, dst_ptr);
   }
 }
 
-// 640 output pixels is enough to allow 5120 input pixels with 1/8 scale down.
-// Keeping the total buffer under 4096 bytes avoids a stackcheck, saving 4% cpu.
-static const int kMaxOutputWidth = 640;
-static const int kMaxRow12 = kMaxOutputWidth * 2;
+/**
+ * Scale plane down, any size
+ *
+ * This is an optimized version for scaling down a plane to any size.
+ * The current implementation is ~10 times faster compared to the
+ * reference implementation for e.g. XGA->LowResPAL
+ *
+ */
+static void InitScalePlaneDown(PlaneScaler* s,
+                               const uint8* src_ptr, uint8* dst_ptr) {
+  if (!s->filtering) {
+    InitScalePlaneSimple(s);
+  } else if (s->filtering == kFilterBilinear ||
+             s->dst_height * 2 > s->src_height) {
+    // between 1/2x and 1x use bilinear
+    InitScalePlaneBilinear(s, src_ptr, dst_ptr);
+  } else {
+    InitScalePlaneBox(s, src_ptr, dst_ptr);
+  }
+}
 
-static void ScaleRowDown8_C(const uint8* src_ptr, int,
-                            uint8* dst, int dst_width) {
-  for (int x = 0; x < dst_width; ++x) {
-    *dst++ = *src_ptr;
-    src_ptr += 8;
+/**
+ * Scale plane up by 2 horizontally, without interpolation.
+ *
+ * Bit exact with ScalePlaneSimple.  Source rows that are used by
+ * consecutive destination rows are scaled once and then copied.
+ */
+static void InitScalePlaneUp2Simple(PlaneScaler* s) {
+  assert(s->dst_width == s->src_width * 2);
+  const int dst_width = s->dst_width;
+  s->method = kScaleUp2Simple;
+#if defined(HAS_SCALECOLSUP2_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && (dst_width % 32 == 0)) {
+    s->ScaleColsUp2 = ScaleColsUp2_SSE2;
+  } else
+#endif
+#if defined(HAS_SCALECOLSUP2_MMX)
+  if (TestCpuFlag(kCpuHasMMX) && (dst_width % 16 == 0)) {
+    s->ScaleColsUp2 = ScaleColsUp2_MMX;
+  } else
+#endif
+  {
+    s->ScaleColsUp2 = ScaleColsUp2_C;
   }
 }
 
-// Note calling code checks width is less than max and if not
-// uses ScaleRowDown8_C instead.
-static void ScaleRowDown8Int_C(const uint8* src_ptr, int src_stride,
-                               uint8* dst, int dst_width) {
-  ALIGN16(uint8 src_row[kMaxRow12 * 2]);
-  assert(dst_width <= kMaxOutputWidth);
-  ScaleRowDown4Int_C(src_ptr, src_stride, src_row, dst_width * 2);
-  ScaleRowDown4Int_C(src_ptr + src_stride * 4, src_stride,
-                     src_row + kMaxOutputWidth,
-                     dst_width * 2);
-  ScaleRowDown2Int_C(src_row, kMaxOutputWidth, dst, dst_width);
+static void ScalePlaneUp2Simple(const PlaneScaler* s,
+                                const uint8* src_ptr, uint8* dst_ptr,
+                                int y_begin, int y_end) {
+  const int dst_width = s->dst_width;
+  const int dst_stride = s->dst_stride;
+  uint8* dst = dst_ptr + dst_stride * y_begin;
+  int last_iy = -1;
+  for (int y = y_begin; y < y_end; ++y) {
+    int iy = y * s->src_height / s->dst_height;
+    if (iy == last_iy) {
+      memcpy(dst, dst - dst_stride, dst_width);
+    } else {
+      s->ScaleColsUp2(dst, src_ptr + iy * s->src_stride, dst_width);
+      last_iy = iy;
+    }
+    dst += dst_stride;
+  }
+}
+
+// Source rows are copied with the last pixel duplicated, so the column
+// filters can read past the end of the row.  The slack also covers the
+// pixels the column filters read and write past the end of their rows.
+static const int kUpRowSlack = 32;
+
+/**
+ * Scale plane up to any dimensions, with bilinear interpolation.
+ *
+ * Source rows are scaled horizontally once, into a pair of row buffers,
+ * and each destination row is a vertical blend of the two rows.  Source
+ * rows are reused by several destination rows when scaling up, so this
+ * does much less work per row than ScalePlaneBilinear.
+ *
+ * Scaling by 2, 3/2 and 4/3 horizontally uses column filters with fixed
+ * phases.  The vertical position is computed exactly for each row so those
+ * ratios also repeat exactly vertically.
+ */
+static void InitScalePlaneUpBilinear(PlaneScaler* s) {
+  assert(s->dst_width >= s->src_width);
+  assert(s->dst_height >= s->src_height);
+  const int src_width = s->src_width;
+  const int dst_width = s->dst_width;
+  s->method = kScaleUpBilinear;
+  s->dx = (src_width << 16) / dst_width;
+  // The column filters write to the row buffers, so they may write past
+  // dst_width.
+  if (dst_width == src_width * 2) {
+#if defined(HAS_SCALEFILTERCOLSUP2_SSE2)
+    if (TestCpuFlag(kCpuHasSSE2)) {
+      s->ScaleFilterCols = ScaleFilterColsUp2_SSE2;
+    } else
+#endif
+#if defined(HAS_SCALEFILTERCOLSUP2_SSE)
+    if (TestCpuFlag(kCpuHasSSE)) {
+      s->ScaleFilterCols = ScaleFilterColsUp2_SSE;
+    } else
+#endif
+    {
+      s->ScaleFilterCols = ScaleFilterColsUp2_C;
+    }
+  } else if (dst_width * 2 == src_width * 3) {
+#if defined(HAS_SCALEFILTERCOLSUP32_SSSE3)
+    if (TestCpuFlag(kCpuHasSSSE3)) {
+      s->ScaleFilterCols = ScaleFilterColsUp32_SSSE3;
+    } else
+#endif
+    {
+      s->ScaleFilterCols = ScaleFilterColsUp32_C;
+    }
+  } else if (dst_width * 3 == src_width * 4) {
+#if defined(HAS_SCALEFILTERCOLSUP43_SSSE3)
+    if (TestCpuFlag(kCpuHasSSSE3)) {
+      s->ScaleFilterCols = ScaleFilterColsUp43_SSSE3;
+    } else
+#endif
+    {
+      s->ScaleFilterCols = ScaleFilterColsUp43_C;
+    }
+  } else {
+#if defined(HAS_SCALEFILTERCOLS_SSE2)
+    if (TestCpuFlag(kCpuHasSSE2)) {
+      s->ScaleFilterCols = ScaleFilterCols_SSE2;
+    } else
+#endif
+#if defined(HAS_SCALEFILTERCOLS_SSE)
+    if (TestCpuFlag(kCpuHasSSE)) {
+      s->ScaleFilterCols = ScaleFilterCols_SSE;
+    } else
+#endif
+    {
+      s->ScaleFilterCols = ScaleFilterCols_C;
+    }
+  }
+#if defined(HAS_SCALEBLENDROWS_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && (dst_width % 16 == 0)) {
+    s->ScaleBlendRows = ScaleBlendRows_SSE2;
+  } else
+#endif
+#if defined(HAS_SCALEBLENDROWS_MMX)
+  if (TestCpuFlag(kCpuHasMMX) && (dst_width % 8 == 0)) {
+    s->ScaleBlendRows = ScaleBlendRows_MMX;
+  } else
+#endif
+  {
+    s->ScaleBlendRows = ScaleBlendRows_C;
+  }
+  s->row_size = ((src_width + 1 + kUpRowSlack + 15) & ~15) +
+                ((dst_width + kUpRowSlack + 15) & ~15) * 2;
+}
+
+static void ScalePlaneUpBilinear(const PlaneScaler* s,
+                                 const uint8* src_ptr, uint8* dst_ptr,
+                                 uint8* row_buffer, int y_begin, int y_end) {
+  const int src_width = s->src_width;
+  const int src_height = s->src_height;
+  const int dst_width = s->dst_width;
+  const int dst_height = s->dst_height;
+  const int src_row_size = (src_width + 1 + kUpRowSlack + 15) & ~15;
+  const int dst_row_size = (dst_width + kUpRowSlack + 15) & ~15;
+  uint8* src_row = row_buffer;
+  uint8* rows[2] = { src_row + src_row_size,
+                     src_row + src_row_size + dst_row_size };
+  int rows_y[2] = { -1, -1 };
+
+  uint8* dst = dst_ptr + s->dst_stride * y_begin;
+  for (int j = y_begin; j < y_end; ++j) {
+    int y = static_cast<int>((static_cast<int64>(j) * src_height << 16) /
+                             dst_height);
+    int iy[2] = { y >> 16, (y >> 16) + 1 };
+    int fy = (y >> 8) & 255;
+    if (iy[1] >= src_height) {
+      iy[1] = src_height - 1;
+    }
+    if (rows_y[0] != iy[0] && rows_y[1] == iy[0]) {
+      uint8* row = rows[0];
+      rows[0] = rows[1];
+      rows[1] = row;
+      rows_y[0] = rows_y[1];
+      rows_y[1] = -1;
+    }
+    for (int i = 0; i < (fy ? 2 : 1); ++i) {
+      if (rows_y[i] != iy[i]) {
+        memcpy(src_row, src_ptr + iy[i] * s->src_stride, src_width);
+        src_row[src_width] = src_row[src_width - 1];
+        s->ScaleFilterCols(rows[i], src_row, dst_width, 0, s->dx);
+        rows_y[i] = iy[i];
+      }
+    }
+    if (fy == 0) {
+      memcpy(dst, rows[0], dst_width);
+    } else {
+      s->ScaleBlendRows(dst, rows[0], rows[1], dst_width, fy);
+    }
+    dst += s->dst_stride;
+  }
+}
+
+/**
+ * Scale plane up to any dimensions.
+ */
+static void InitScalePlaneUp(PlaneScaler* s) {
+  if (s->filtering) {
+    InitScalePlaneUpBilinear(s);
+  } else if (s->dst_width == s->src_width * 2) {
+    InitScalePlaneUp2Simple(s);
+  } else {
+    InitScalePlaneSimple(s);
+  }
 }
 
-static void ScaleRowDown34_C(const uint8* src_ptr, int,
-                             uint8* dst, int dst_width) {
-  assert((dst_width % 3 == 0) && (dst_width > 0));
-  uint8* dend = dst + dst_width;
-  do {
-    dst[0] = src_ptr[0];
-    dst[1] = src_ptr[1];
-    dst[2] = src_ptr[3];
-    dst += 3;
-    src_ptr += 4;
-  } while (dst < dend);
+// Polyphase filters quantize the source position to kFilterPhases phases.
+static const int kFilterPhaseBits = 6;
+static const int kFilterPhases = 1 << kFilterPhaseBits;
+
+// Coefficients of a polyphase filter for scaling one dimension.
+struct ScaleFilterTable {
+  int src_size;
+  int dst_size;
+  FilterMode filtering;
+  int taps;             // Coefficients per phase, a multiple of 8.
+  ScaleFilterPos* pos;  // dst_size positions.
+  int16* coeffs;        // kFilterPhases rows of taps coefficients.
+  uint8* coeffs_mem;
+};
+
+// Catmull-Rom bicubic, or Lanczos with 3 lobes.
+static double ScaleFilterKernel(FilterMode filtering, double x) {
+  x = fabs(x);
+  if (filtering == kFilterBicubic) {
+    if (x < 1.0) {
+      return (1.5 * x - 2.5) * x * x + 1.0;
+    }
+    if (x < 2.0) {
+      return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    }
+    return 0.0;
+  }
+  if (x < 1e-8) {
+    return 1.0;
+  }
+  if (x >= 3.0) {
+    return 0.0;
+  }
+  const double kPi = 3.14159265358979323846;
+  double pix = kPi * x;
+  return 3.0 * sin(pix) * sin(pix / 3.0) / (pix * pix);
 }
 
-// Filter rows 0 and 1 together, 3 : 1
-static void ScaleRowDown34_0_Int_C(const uint8* src_ptr, int src_stride,
-                                   uint8* d, int dst_width) {
-  assert((dst_width % 3 == 0) && (dst_width > 0));
-  uint8* dend = d + dst_width;
-  const uint8* s = src_ptr;
-  const uint8* t = src_ptr + src_stride;
-  do {
-    uint8 a0 = (s[0] * 3 + s[1] * 1 + 2) >> 2;
-    uint8 a1 = (s[1] * 1 + s[2] * 1 + 1) >> 1;
-    uint8 a2 = (s[2] * 1 + s[3] * 3 + 2) >> 2;
-    uint8 b0 = (t[0] * 3 + t[1] * 1 + 2) >> 2;
-    uint8 b1 = (t[1] * 1 + t[2] * 1 + 1) >> 1;
-    uint8 b2 = (t[2] * 1 + t[3] * 3 + 2) >> 2;
-    d[0] = (a0 * 3 + b0 + 2) >> 2;
-    d[1] = (a1 * 3 + b1 + 2) >> 2;
-    d[2] = (a2 * 3 + b2 + 2) >> 2;
-    d += 3;
-    s += 4;
-    t += 4;
-  } while (d < dend);
+static void FreeScaleFilterTable(ScaleFilterTable* table) {
+  if (table) {
+    delete[] table->pos;
+    delete[] table->coeffs_mem;
+    delete table;
+  }
 }
 
-// Filter rows 1 and 2 together, 1 : 1
-static void ScaleRowDown34_1_Int_C(const uint8* src_ptr, int src_stride,
-                                   uint8* d, int dst_width) {
-  assert((dst_width % 3 == 0) && (dst_width > 0));
-  uint8* dend = d + dst_width;
-  const uint8* s = src_ptr;
-  const uint8* t = src_ptr + src_stride;
-  do {
-    uint8 a0 = (s[0] * 3 + s[1] * 1 + 2) >> 2;
-    uint8 a1 = (s[1] * 1 + s[2] * 1 + 1) >> 1;
-    uint8 a2 = (s[2] * 1 + s[3] * 3 + 2) >> 2;
-    uint8 b0 = (t[0] * 3 + t[1] * 1 + 2) >> 2;
-    uint8 b1 = (t[1] * 1 + t[2] * 1 + 1) >> 1;
-    uint8 b2 = (t[2] * 1 + t[3] * 3 + 2) >> 2;
-    d[0] = (a0 + b0 + 1) >> 1;
-    d[1] = (a1 + b1 + 1) >> 1;
-    d[2] = (a2 + b2 + 1) >> 1;
-    d += 3;
-    s += 4;
-    t += 4;
-  } while (d < dend);
+// Widest polyphase filter, the taps of ScaleFilterCols16_SSE2.  Scaling
+// down further than this allows uses box filtering instead.
+static const int kMaxFilterTaps = 16;
+
+// Returns half the number of source pixels the filter covers.  When
+// scaling down, the filter is stretched by the scale factor so every source
+// pixel contributes.
+static int ScaleFilterHalfWidth(int src_size, int dst_size,
+                                FilterMode filtering) {
+  double scale = static_cast<double>(src_size) / dst_size;
+  double filter_scale = scale > 1.0 ? scale : 1.0;
+  int radius = (filtering == kFilterBicubic) ? 2 : 3;
+  return static_cast<int>(ceil(radius * filter_scale));
 }
 
-#if defined(HAS_SCALEFILTERROWS_SSE2)
-// Filter row to 3/4
-static void ScaleFilterCols34_C(uint8* dst_ptr, const uint8* src_ptr,
-                                int dst_width) {
-  assert((dst_width % 3 == 0) && (dst_width > 0));
-  uint8* dend = dst_ptr + dst_width;
-  const uint8* s = src_ptr;
-  do {
-    dst_ptr[0] = (s[0] * 3 + s[1] * 1 + 2) >> 2;
-    dst_ptr[1] = (s[1] * 1 + s[2] * 1 + 1) >> 1;
-    dst_ptr[2] = (s[2] * 1 + s[3] * 3 + 2) >> 2;
-    dst_ptr += 3;
-    s += 4;
-  } while (dst_ptr < dend);
+// Returns the coefficients per phase, a multiple of 8.
+static int ScaleFilterTaps(int src_size, int dst_size, FilterMode filtering) {
+  return (ScaleFilterHalfWidth(src_size, dst_size, filtering) * 2 + 7) & ~7;
 }
-#endif
-
-static void ScaleFilterCols_C(uint8* dst_ptr, const uint8* src_ptr,
-                              int dst_width, int dx) {
-  int x = 0;
-  for (int j = 0; j < dst_width; ++j) {
-    int xi = x >> 16;
-    int xf1 = x & 0xffff;
-    int xf0 = 65536 - xf1;
 
-    *dst_ptr++ = (src_ptr[xi] * xf0 + src_ptr[xi + 1] * xf1) >> 16;
-    x += dx;
+// Output pixel i is centered at source position (i + 0.5) * scale - 0.5.
+// Each phase is normalized so its coefficients sum to exactly
+// 1 << kFilterBits.
+static ScaleFilterTable* BuildScaleFilterTable(int src_size, int dst_size,
+                                               FilterMode filtering) {
+  double scale = static_cast<double>(src_size) / dst_size;
+  double filter_scale = scale > 1.0 ? scale : 1.0;
+  int half = ScaleFilterHalfWidth(src_size, dst_size, filtering);
+  ScaleFilterTable* table = new ScaleFilterTable;
+  table->src_size = src_size;
+  table->dst_size = dst_size;
+  table->filtering = filtering;
+  table->taps = ScaleFilterTaps(src_size, dst_size, filtering);
+  table->pos = new ScaleFilterPos[dst_size];
+  table->coeffs_mem = new uint8[kFilterPhases * table->taps * 2 + 15];
+  table->coeffs = reinterpret_cast<int16*>(ALIGNP(table->coeffs_mem, 16));
+  memset(table->coeffs, 0, kFilterPhases * table->taps * 2);
+
+  double* weights = new double[half * 2];
+  for (int p = 0; p < kFilterPhases; ++p) {
+    double fraction = static_cast<double>(p) / kFilterPhases;
+    double sum = 0.0;
+    for (int k = 0; k < half * 2; ++k) {
+      weights[k] = ScaleFilterKernel(filtering,
+                                     (k - (half - 1) - fraction) /
+                                     filter_scale);
+      sum += weights[k];
+    }
+    int16* coeffs = table->coeffs + p * table->taps;
+    int total = 0;
+    int center = (fraction < 0.5) ? half - 1 : half;
+    for (int k = 0; k < half * 2; ++k) {
+      coeffs[k] = static_cast<int16>(
+          floor(weights[k] / sum * (1 << kFilterBits) + 0.5));
+      total += coeffs[k];
+    }
+    coeffs[center] += (1 << kFilterBits) - total;
   }
+  delete[] weights;
+
+  for (int i = 0; i < dst_size; ++i) {
+    int64 x = ((static_cast<int64>(i) * 2 + 1) * src_size << 16) /
+              (dst_size * 2) - 32768;
+    int ix = static_cast<int>(x >> 16);
+    int phase = static_cast<int>((x & 0xffff) >> (16 - kFilterPhaseBits));
+    table->pos[i].offset = ix - (half - 1);
+    table->pos[i].coeffs = table->coeffs + phase * table->taps;
+  }
+  return table;
 }
 
-static const int kMaxInputWidth = 2560;
-#if defined(HAS_SCALEFILTERROWS_SSE2)
-#define HAS_SCALEROWDOWN34_SSE2
-// Filter rows 0 and 1 together, 3 : 1
-static void ScaleRowDown34_0_Int_SSE2(const uint8* src_ptr, int src_stride,
-                                      uint8* dst_ptr, int dst_width) {
-  assert((dst_width % 3 == 0) && (dst_width > 0));
-  ALIGN16(uint8 row[kMaxInputWidth]);
-  ScaleFilterRows_SSE2(row, src_ptr, src_stride, dst_width * 4 / 3,
-                       256 / 4);
-  ScaleFilterCols34_C(dst_ptr, row, dst_width);
+// Filter tables are built once per geometry and kept for the life of the
+// process.  Entries are only ever added, with an atomic exchange, and read
+// with an acquire load, so they can be read without locking.
+static const int kFilterCacheSize = 16;
+static ScaleFilterTable* volatile filter_cache_[kFilterCacheSize];
+
+// Returns the filter table for a geometry.  If the cache is full the table
+// is also returned in *owned, and the caller must free it.
+static const ScaleFilterTable* GetScaleFilterTable(int src_size,
+                                                   int dst_size,
+                                                   FilterMode filtering,
+                                                   ScaleFilterTable** owned) {
+  *owned = NULL;
+  for (int i = 0; i < kFilterCacheSize; ++i) {
+    const ScaleFilterTable* table = static_cast<const ScaleFilterTable*>(
+        AtomicLoadAcquirePointer(
+            reinterpret_cast<void* volatile*>(&filter_cache_[i])));
+    if (!table) {
+      break;
+    }
+    if (table->src_size == src_size && table->dst_size == dst_size &&
+        table->filtering == filtering) {
+      return table;
+    }
+  }
+  ScaleFilterTable* table = BuildScaleFilterTable(src_size, dst_size,
+                                                  filtering);
+  for (int i = 0; i < kFilterCacheSize; ++i) {
+    const ScaleFilterTable* cached = static_cast<const ScaleFilterTable*>(
+        AtomicCompareExchangePointer(
+            reinterpret_cast<void* volatile*>(&filter_cache_[i]),
+            table, NULL));
+    if (!cached) {
+      return table;
+    }
+    if (cached->src_size == src_size && cached->dst_size == dst_size &&
+        cached->filtering == filtering) {
+      // Another thread added the same table.
+      FreeScaleFilterTable(table);
+      return cached;
+    }
+  }
+  *owned = table;
+  return table;
 }
 
-// Filter rows 1 and 2 together, 1 : 1
-static void ScaleRowDown34_1_Int_SSE2(const uint8* src_ptr, int src_stride,
-                                      uint8* dst_ptr, int dst_width) {
-  assert((dst_width % 3 == 0) && (dst_width > 0));
-  ALIGN16(uint8 row[kMaxInputWidth]);
-  ScaleFilterRows_SSE2(row, src_ptr, src_stride, dst_width * 4 / 3, 256 / 2);
-  ScaleFilterCols34_C(dst_ptr, row, dst_width);
-}
+/**
+ * Scale plane to/from any dimensions, with a separable polyphase bicubic or
+ * Lanczos filter.
+ *
+ * Each output row is filtered vertically from the source rows into a row
+ * buffer, which is padded by repeating the edge pixels, and then filtered
+ * horizontally into the destination.
+ */
+static void InitScalePlanePolyphase(PlaneScaler* s) {
+  const int src_width = s->src_width;
+  const int dst_width = s->dst_width;
+  s->method = kScalePolyphase;
+  s->table_x = GetScaleFilterTable(src_width, dst_width, s->filtering,
+                                   &s->owned_x);
+  s->table_y = GetScaleFilterTable(s->src_height, s->dst_height,
+                                   s->filtering, &s->owned_y);
+
+#if defined(HAS_SCALEACCUMROWS2_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && (src_width % 8 == 0)) {
+    s->ScaleAccumRows2 = ScaleAccumRows2_SSE2;
+  } else
 #endif
-
-static void ScaleRowDown38_C(const uint8* src_ptr, int,
-                             uint8* dst, int dst_width) {
-  assert(dst_width % 3 == 0);
-  for (int x = 0; x < dst_width; x += 3) {
-    dst[0] = src_ptr[0];
-    dst[1] = src_ptr[3];
-    dst[2] = src_ptr[6];
-    dst += 3;
-    src_ptr += 8;
+#if defined(HAS_SCALEACCUMROWS2_MMX)
+  if (TestCpuFlag(kCpuHasMMX) && (src_width % 4 == 0)) {
+    s->ScaleAccumRows2 = ScaleAccumRows2_MMX;
+  } else
+#endif
+  {
+    s->ScaleAccumRows2 = ScaleAccumRows2_C;
+  }
+  // ScalePackRow writes to the row buffer, so it may write past the width.
+#if defined(HAS_SCALEPACKROW_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2)) {
+    s->ScalePackRow = ScalePackRow_SSE2;
+  } else
+#endif
+#if defined(HAS_SCALEPACKROW_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    s->ScalePackRow = ScalePackRow_MMX;
+  } else
+#endif
+  {
+    s->ScalePackRow = ScalePackRow_C;
+  }
+#if defined(HAS_SCALEFILTERCOLS8_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && s->table_x->taps == 8 &&
+      (dst_width % 4 == 0)) {
+    s->ScaleFilterColsN = ScaleFilterCols8_SSE2;
+  } else
+#endif
+#if defined(HAS_SCALEFILTERCOLS16_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && s->table_x->taps == 16 &&
+      (dst_width % 4 == 0)) {
+    s->ScaleFilterColsN = ScaleFilterCols16_SSE2;
+  } else
+#endif
+#if defined(HAS_SCALEFILTERCOLS8_MMX)
+  if (TestCpuFlag(kCpuHasMMX) && s->table_x->taps == 8 &&
+      (dst_width % 2 == 0)) {
+    s->ScaleFilterColsN = ScaleFilterCols8_MMX;
+  } else
+#endif
+  {
+    s->ScaleFilterColsN = ScaleFilterColsN_C;
   }
+
+  // The row buffer holds the 32 bit sums of a row, followed by the row,
+  // which is padded by taps pixels on each side.  The padding covers the
+  // source pixels read by positions past the edges.
+  const int acc_width = (src_width + 7) & ~7;
+  s->row_size = acc_width * 5 + s->table_x->taps * 2 + 16;
 }
 
-// 8x3 -> 3x1
-static void ScaleRowDown38_3_Int_C(const uint8* src_ptr, int src_stride,
-                                   uint8* dst_ptr, int dst_width) {
-  assert((dst_width % 3 == 0) && (dst_width > 0));
-  for (int i = 0; i < dst_width; i+=3) {
-    dst_ptr[0] = (src_ptr[0] + src_ptr[1] + src_ptr[2] +
-        src_ptr[src_stride + 0] + src_ptr[src_stride + 1] +
-        src_ptr[src_stride + 2] + src_ptr[src_stride * 2 + 0] +
-        src_ptr[src_stride * 2 + 1] + src_ptr[src_stride * 2 + 2]) *
-        (65536 / 9) >> 16;
-    dst_ptr[1] = (src_ptr[3] + src_ptr[4] + src_ptr[5] +
-        src_ptr[src_stride + 3] + src_ptr[src_stride + 4] +
-        src_ptr[src_stride + 5] + src_ptr[src_stride * 2 + 3] +
-        src_ptr[src_stride * 2 + 4] + src_ptr[src_stride * 2 + 5]) *
-        (65536 / 9) >> 16;
-    dst_ptr[2] = (src_ptr[6] + src_ptr[7] +
-        src_ptr[src_stride + 6] + src_ptr[src_stride + 7] +
-        src_ptr[src_stride * 2 + 6] + src_ptr[src_stride * 2 + 7]) *
-        (65536 / 6) >> 16;
-    src_ptr += 8;
-    dst_ptr += 3;
+static void ScalePlanePolyphase(const PlaneScaler* s,
+                                const uint8* src_ptr, uint8* dst_ptr,
+                                uint8* row_buffer, int y_begin, int y_end) {
+  const int src_width = s->src_width;
+  const int src_height = s->src_height;
+  const int src_stride = s->src_stride;
+  const ScaleFilterTable* table_x = s->table_x;
+  const ScaleFilterTable* table_y = s->table_y;
+  const int pad = table_x->taps;
+  const int acc_width = (src_width + 7) & ~7;
+  int32* acc = reinterpret_cast<int32*>(row_buffer);
+  uint8* row = row_buffer + acc_width * 4 + pad;
+
+  uint8* dst = dst_ptr + s->dst_stride * y_begin;
+  for (int j = y_begin; j < y_end; ++j) {
+    const ScaleFilterPos& pos = table_y->pos[j];
+    for (int x = 0; x < acc_width; ++x) {
+      acc[x] = 1 << (kFilterBits - 1);
+    }
+    for (int k = 0; k < table_y->taps; k += 2) {
+      int c0 = pos.coeffs[k];
+      int c1 = pos.coeffs[k + 1];
+      if (c0 == 0 && c1 == 0) {
+        continue;
+      }
+      int y0 = static_cast<int>(pos.offset) + k;
+      int y1 = y0 + 1;
+      y0 = y0 < 0 ? 0 : (y0 >= src_height ? src_height - 1 : y0);
+      y1 = y1 < 0 ? 0 : (y1 >= src_height ? src_height - 1 : y1);
+      s->ScaleAccumRows2(acc, src_ptr + y0 * src_stride,
+                         src_ptr + y1 * src_stride, src_width,
+                         static_cast<int>(static_cast<uint16>(c0) |
+                                          (static_cast<uint32>(
+                                               static_cast<uint16>(c1))
+                                           << 16)));
+    }
+    s->ScalePackRow(row, acc, src_width);
+    memset(row - pad, row[0], pad);
+    memset(row + src_width, row[src_width - 1], pad);
+    s->ScaleFilterColsN(dst, row, s->dst_width, table_x->pos, table_x->taps);
+    dst += s->dst_stride;
   }
 }
 
-// 8x2 -> 3x1
-static void ScaleRowDown38_2_Int_C(const uint8* src_ptr, int src_stride,
-                                   uint8* dst_ptr, int dst_width) {
-  assert((dst_width % 3 == 0) && (dst_width > 0));
-  for (int i = 0; i < dst_width; i+=3) {
-    dst_ptr[0] = (src_ptr[0] + src_ptr[1] + src_ptr[2] +
-        src_ptr[src_stride + 0] + src_ptr[src_stride + 1] +
-        src_ptr[src_stride + 2]) * (65536 / 6) >> 16;
-    dst_ptr[1] = (src_ptr[3] + src_ptr[4] + src_ptr[5] +
-        src_ptr[src_stride + 3] + src_ptr[src_stride + 4] +
-        src_ptr[src_stride + 5]) * (65536 / 6) >> 16;
-    dst_ptr[2] = (src_ptr[6] + src_ptr[7] +
-        src_ptr[src_stride + 6] + src_ptr[src_stride + 7]) *
-        (65536 / 4) >> 16;
-    src_ptr += 8;
-    dst_ptr += 3;
+// Copies rows of a plane of plane_size bytes.  A large plane with 16 byte
+// aligned rows is written with streaming stores.
+static void CopyPlane(int src_width, int src_height,
+                      int dst_width, int dst_height,
+                      int src_stride, int dst_stride,
+                      const uint8* src_ptr, uint8* dst_ptr,
+                      int plane_size) {
+  CopyRowFunc CopyRow = GetCopyRow_NT(plane_size, dst_ptr, dst_stride, 16);
+  if (CopyRow) {
+    const uint8* src = src_ptr;
+    uint8* dst = dst_ptr;
+    for (int i = 0; i < src_height; ++i) {
+      CopyRow(src, dst, src_width);
+      dst += dst_stride;
+      src += src_stride;
+    }
+    SFENCE();
+    EMMS();
+  } else if (src_stride == src_width && dst_stride == dst_width) {
+    // All contiguous, so can use REALLY fast path.
+    memcpy(dst_ptr, src_ptr, src_width * src_height);
+  } else {
+    // Not all contiguous; must copy scanlines individually
+    const uint8* src = src_ptr;
+    uint8* dst = dst_ptr;
+    for (int i = 0; i < src_height; ++i) {
+      memcpy(dst, src, src_width);
+      dst += dst_stride;
+      src += src_stride;
+    }
   }
 }
 
-// C version 8x2 -> 8x1
-static void ScaleFilterRows_C(uint8* dst_ptr,
-                              const uint8* src_ptr, int src_stride,
-                              int dst_width, int source_y_fraction) {
-  assert(dst_width > 0);
-  int y1_fraction = source_y_fraction;
-  int y0_fraction = 256 - y1_fraction;
-  const uint8* src_ptr1 = src_ptr + src_stride;
-  uint8* end = dst_ptr + dst_width;
-  do {
-    dst_ptr[0] = (src_ptr[0] * y0_fraction + src_ptr1[0] * y1_fraction) >> 8;
-    dst_ptr[1] = (src_ptr[1] * y0_fraction + src_ptr1[1] * y1_fraction) >> 8;
-    dst_ptr[2] = (src_ptr[2] * y0_fraction + src_ptr1[2] * y1_fraction) >> 8;
-    dst_ptr[3] = (src_ptr[3] * y0_fraction + src_ptr1[3] * y1_fraction) >> 8;
-    dst_ptr[4] = (src_ptr[4] * y0_fraction + src_ptr1[4] * y1_fraction) >> 8;
-    dst_ptr[5] = (src_ptr[5] * y0_fraction + src_ptr1[5] * y1_fraction) >> 8;
-    dst_ptr[6] = (src_ptr[6] * y0_fraction + src_ptr1[6] * y1_fraction) >> 8;
-    dst_ptr[7] = (src_ptr[7] * y0_fraction + src_ptr1[7] * y1_fraction) >> 8;
-    src_ptr += 8;
-    src_ptr1 += 8;
-    dst_ptr += 8;
-  } while (dst_ptr < end);
-  dst_ptr[0] = dst_ptr[-1];
+// Chooses how to scale a plane and the row functions to use.
+// Use specialized scales to improve performance for common resolutions.
+// For example, all the 1/2 scalings will use ScalePlaneDown2()
+// src_ptr and dst_ptr are only used to check alignment.
+static void InitPlaneScaler(PlaneScaler* s,
+                            int src_width, int src_height,
+                            int dst_width, int dst_height,
+                            int src_stride, int dst_stride,
+                            const uint8* src_ptr, uint8* dst_ptr,
+                            FilterMode filtering, bool use_ref) {
+  // A polyphase filter wider than kMaxFilterTaps would run in C, so large
+  // reductions are box filtered instead.
+  if ((filtering == kFilterBicubic || filtering == kFilterLanczos) &&
+      (ScaleFilterTaps(src_width, dst_width, filtering) > kMaxFilterTaps ||
+       ScaleFilterTaps(src_height, dst_height, filtering) > kMaxFilterTaps)) {
+    filtering = kFilterBox;
+  }
+  memset(s, 0, sizeof(*s));
+  s->src_width = src_width;
+  s->src_height = src_height;
+  s->dst_width = dst_width;
+  s->dst_height = dst_height;
+  s->src_stride = src_stride;
+  s->dst_stride = dst_stride;
+  s->filtering = filtering;
+  if (dst_width == src_width && dst_height == src_height) {
+    // Straight copy.
+    s->method = kScaleCopy;
+  } else if (filtering == kFilterBicubic || filtering == kFilterLanczos) {
+    InitScalePlanePolyphase(s);
+  } else if (dst_width <= src_width && dst_height <= src_height) {
+    // Scale down.
+    if (use_ref) {
+      // For testing, allow the optimized versions to be disabled.
+      InitScalePlaneDown(s, src_ptr, dst_ptr);
+    } else if (4 * dst_width == 3 * src_width &&
+               4 * dst_height == 3 * src_height) {
+      // optimized, 3/4
+      InitScalePlaneDown34(s, src_ptr, dst_ptr);
+    } else if (2 * dst_width == src_width && 2 * dst_height == src_height) {
+      // optimized, 1/2
+      InitScalePlaneDown2(s, src_ptr, dst_ptr);
+    // 3/8 rounded up for odd sized chroma height.
+    } else if (8 * dst_width == 3 * src_width &&
+               dst_height == ((src_height * 3 + 7) / 8)) {
+      // optimized, 3/8
+      InitScalePlaneDown38(s, src_ptr, dst_ptr);
+    } else if (4 * dst_width == src_width && 4 * dst_height == src_height) {
+      // optimized, 1/4
+      InitScalePlaneDown4(s, src_ptr, dst_ptr);
+    } else if (8 * dst_width == src_width && 8 * dst_height == src_height) {
+      // optimized, 1/8
+      InitScalePlaneDown8(s, src_ptr, dst_ptr);
+    } else {
+      // Arbitrary downsample
+      InitScalePlaneDown(s, src_ptr, dst_ptr);
+    }
+  } else if (dst_width >= src_width && dst_height >= src_height &&
+             !use_ref) {
+    // Scale up.
+    InitScalePlaneUp(s);
+  } else {
+    // Arbitrary scale up and/or down.
+    InitScalePlaneAnySize(s, src_ptr, dst_ptr);
+  }
 }
 
-void ScaleAddRows_C(const uint8* src_ptr, int src_stride,
-                    uint16* dst_ptr, int src_width, int src_height) {
-  assert(src_width > 0);
-  assert(src_height > 0);
-  for (int x = 0; x < src_width; ++x) {
-    const uint8* s = src_ptr + x;
-    int sum = 0;
-    for (int y = 0; y < src_height; ++y) {
-      sum += s[0];
-      s += src_stride;
-    }
-    dst_ptr[x] = sum;
+// Chooses how to scale the rectangle of a plane at (crop_x, crop_y) with
+// size crop_width x crop_height, all in 16.16 fixed point.  Returns the
+// source pointer to pass to RunPlaneScaler.
+// A rectangle on whole pixels is scaled like a plane of that size.
+// Otherwise the fractional position is folded into the starting x0 and y0
+// of the bilinear, box or simple scaler, and the source is offset to the
+// pixels the rectangle spans.  The offset is rounded down to 16 pixels so
+// the row functions see the alignment of the plane.
+static const uint8* InitPlaneScalerRect(PlaneScaler* s,
+                                        int src_width, int src_height,
+                                        int crop_x, int crop_y,
+                                        int crop_width, int crop_height,
+                                        int dst_width, int dst_height,
+                                        int src_stride, int dst_stride,
+                                        const uint8* src_ptr, uint8* dst_ptr,
+                                        FilterMode filtering, bool use_ref) {
+  if (((crop_x | crop_y | crop_width | crop_height) & 0xffff) == 0) {
+    src_ptr += (crop_y >> 16) * src_stride + (crop_x >> 16);
+    InitPlaneScaler(s, crop_width >> 16, crop_height >> 16,
+                    dst_width, dst_height, src_stride, dst_stride,
+                    src_ptr, dst_ptr, filtering, use_ref);
+    return src_ptr;
+  }
+  const int ix = (crop_x >> 16) & ~15;
+  const int iy = crop_y >> 16;
+  // Bilinear filtering reads one pixel past the last one sampled.
+  int span_width = ((crop_x + crop_width - 1) >> 16) + 2 - ix;
+  int span_height = ((crop_y + crop_height - 1) >> 16) + 2 - iy;
+  if (ix + ((span_width + 15) & ~15) <= src_width) {
+    span_width = (span_width + 15) & ~15;
+  } else if (ix + span_width > src_width) {
+    span_width = src_width - ix;
+  }
+  if (iy + span_height > src_height) {
+    span_height = src_height - iy;
+  }
+  src_ptr += iy * src_stride + ix;
+
+  memset(s, 0, sizeof(*s));
+  s->src_width = span_width;
+  s->src_height = span_height;
+  s->dst_width = dst_width;
+  s->dst_height = dst_height;
+  s->src_stride = src_stride;
+  s->dst_stride = dst_stride;
+  s->filtering = filtering;
+  s->rect = true;
+  s->dx = crop_width / dst_width;
+  s->dy = crop_height / dst_height;
+  s->x0 = crop_x - (ix << 16);
+  s->y0 = crop_y - (iy << 16);
+  if (!filtering) {
+    InitScalePlaneSimple(s);
+  } else if (filtering >= kFilterBox &&
+             s->dx >= (2 << 16) && s->dy >= (2 << 16)) {
+    // Polyphase filters are not used for rectangles.
+    InitScalePlaneBox(s, src_ptr, dst_ptr);
+  } else {
+    InitScalePlaneBilinear(s, src_ptr, dst_ptr);
   }
+  return src_ptr;
 }
 
-/**
- * Scale plane, 1/2
- *
- * This is an optimized version for scaling down a plane to 1/2 of
- * its original size.
- *
- */
-static void ScalePlaneDown2(int src_width, int src_height,
-                            int dst_width, int dst_height,
-                            int src_stride, int dst_stride,
-                            const uint8* src_ptr, uint8* dst_ptr,
-                            FilterMode filtering) {
-  assert(src_width % 2 == 0);
-  assert(src_height % 2 == 0);
-  void (*ScaleRowDown2)(const uint8* src_ptr, int src_stride,
-                        uint8* dst_ptr, int dst_width);
+static void FreePlaneScaler(PlaneScaler* s) {
+  FreeScaleFilterTable(s->owned_x);
+  FreeScaleFilterTable(s->owned_y);
+}
 
-#if defined(HAS_SCALEROWDOWN2_NEON)
-  if (TestCpuFlag(kCpuHasNEON) &&
-      (dst_width % 16 == 0)) {
-    ScaleRowDown2 = filtering ? ScaleRowDown2Int_NEON : ScaleRowDown2_NEON;
-  } else
-#endif
-#if defined(HAS_SCALEROWDOWN2_SSE2)
-  if (TestCpuFlag(kCpuHasSSE2) &&
-      (dst_width % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
-      IS_ALIGNED(dst_ptr, 16)) {
-    ScaleRowDown2 = filtering ? ScaleRowDown2Int_SSE2 : ScaleRowDown2_SSE2;
-  } else
-#endif
-  {
-    ScaleRowDown2 = filtering ? ScaleRowDown2Int_C : ScaleRowDown2_C;
+// Scales output rows [y_begin, y_end) of a plane.  row_buffer is 16 byte
+// aligned and holds at least s->row_size bytes.
+static void RunPlaneScaler(const PlaneScaler* s,
+                           const uint8* src, uint8* dst, uint8* row_buffer,
+                           int y_begin, int y_end) {
+  switch (s->method) {
+    case kScaleCopy:
+      CopyPlane(s->src_width, y_end - y_begin, s->dst_width, y_end - y_begin,
+                s->src_stride, s->dst_stride,
+                src + s->src_stride * y_begin, dst + s->dst_stride * y_begin,
+                s->dst_width * s->dst_height);
+      break;
+    case kScaleDown2:
+      ScalePlaneDown2(s, src, dst, y_begin, y_end);
+      break;
+    case kScaleDown4:
+      ScalePlaneDown4(s, src, dst, y_begin, y_end);
+      break;
+    case kScaleDown8:
+      ScalePlaneDown8(s, src, dst, y_begin, y_end);
+      break;
+    case kScaleDown34:
+      ScalePlaneDown34(s, src, dst, y_begin, y_end);
+      break;
+    case kScaleDown38:
+      ScalePlaneDown38(s, src, dst, y_begin, y_end);
+      break;
+    case kScaleBox:
+      ScalePlaneBox(s, src, dst, row_buffer, y_begin, y_end);
+      break;
+    case kScaleBilinear:
+      ScalePlaneBilinear(s, src, dst, row_buffer, y_begin, y_end);
+      break;
+    case kScaleBilinearSimple:
+      ScalePlaneBilinearSimple(s, src, dst, y_begin, y_end);
+      break;
+    case kScaleSimple:
+      ScalePlaneSimple(s, src, dst, y_begin, y_end);
+      break;
+    case kScaleUp2Simple:
+      ScalePlaneUp2Simple(s, src, dst, y_begin, y_end);
+      break;
+    case kScaleUpBilinear:
+      ScalePlaneUpBilinear(s, src, dst, row_buffer, y_begin, y_end);
+      break;
+    case kScalePolyphase:
+      ScalePlanePolyphase(s, src, dst, row_buffer, y_begin, y_end);
+      break;
   }
+}
 
-  for (int y = 0; y < dst_height; ++y) {
-    ScaleRowDown2(src_ptr, src_stride, dst_ptr, dst_width);
-    src_ptr += (src_stride << 1);
-    dst_ptr += dst_stride;
+// Sets first and last to the source rows read to scale output row y of a
+// plane, clamped to the plane.  This follows the row stepping of the
+// ScalePlane functions above, which must be kept in step with it.
+static void PlaneScalerSourceRows(const PlaneScaler* s, int y,
+                                  int* first, int* last) {
+  const int src_height = s->src_height;
+  int y0 = y;
+  int y1 = y;
+  switch (s->method) {
+    case kScaleCopy:
+      break;
+    case kScaleDown2:
+      y0 = y * 2;
+      y1 = y0 + 1;
+      break;
+    case kScaleDown4:
+      y0 = y * 4;
+      y1 = y0 + 3;
+      break;
+    case kScaleDown8:
+      y0 = y * 8;
+      y1 = y0 + 7;
+      break;
+    case kScaleDown34:
+      y0 = (y / 3) * 4 + y % 3;
+      y1 = y0 + 1;
+      break;
+    case kScaleDown38:
+      y0 = (y / 3) * 8 + (y % 3) * 3;
+      y1 = y0 + ((y % 3 == 2) ? 1 : 2);
+      break;
+    case kScaleBox: {
+      const int maxy = src_height << 16;
+      int yb = s->y0 + s->dy * y;
+      if (yb > maxy) {
+        yb = maxy;
+      }
+      int ye = yb + s->dy;
+      if (ye > maxy) {
+        ye = maxy;
+      }
+      y0 = yb >> 16;
+      y1 = (ye >> 16) - 1;
+      break;
+    }
+    case kScaleBilinear: {
+      const int maxy = (src_height > 1) ? ((src_height - 1) << 16) - 1 : 0;
+      int yb = s->y0;
+      if (y > 0) {
+        yb += s->dy * y;
+        if (yb > maxy) {
+          yb = maxy;
+        }
+      }
+      y0 = yb >> 16;
+      y1 = y0 + 1;
+      break;
+    }
+    case kScaleBilinearSimple: {
+      const int maxy = ((src_height - 1) << 16) - 1;
+      int yb = (s->dst_height < src_height) ? 32768 :
+          (src_height << 16) / s->dst_height - 32768;
+      if (y > 0) {
+        yb += s->dy * y;
+        if (yb > maxy) {
+          yb = maxy;
+        }
+      }
+      y0 = ((yb < 0) ? 0 : yb) >> 16;
+      y1 = y0 + 1;
+      break;
+    }
+    case kScaleSimple:
+      y0 = s->rect ? (s->y0 + y * s->dy) >> 16 :
+          y * src_height / s->dst_height;
+      y1 = y0;
+      break;
+    case kScaleUp2Simple:
+      y0 = y * src_height / s->dst_height;
+      y1 = y0;
+      break;
+    case kScaleUpBilinear:
+      y0 = static_cast<int>((static_cast<int64>(y) * src_height << 16) /
+                            s->dst_height) >> 16;
+      y1 = y0 + 1;
+      break;
+    case kScalePolyphase:
+      y0 = static_cast<int>(s->table_y->pos[y].offset);
+      y1 = y0 + s->table_y->taps - 1;
+      break;
   }
+  *first = (y0 < 0) ? 0 : ((y0 >= src_height) ? src_height - 1 : y0);
+  *last = (y1 < *first) ? *first :
+      ((y1 >= src_height) ? src_height - 1 : y1);
 }
 
-/**
- * Scale plane, 1/4
- *
- * This is an optimized version for scaling down a plane to 1/4 of
- * its original size.
- */
-static void ScalePlaneDown4(int src_width, int src_height,
-                            int dst_width, int dst_height,
-                            int src_stride, int dst_stride,
-                            const uint8* src_ptr, uint8* dst_ptr,
-                            FilterMode filtering) {
-  assert(src_width % 4 == 0);
-  assert(src_height % 4 == 0);
-  void (*ScaleRowDown4)(const uint8* src_ptr, int src_stride,
-                        uint8* dst_ptr, int dst_width);
+// Runs a scaler with a row buffer on the stack if it fits, then frees it.
+static void RunPlaneScalerOnce(PlaneScaler* s, const uint8* src, uint8* dst,
+                               int y_begin, int y_end) {
+  ALIGN16(uint8 row_stack[kMaxInputWidth * 5]);
+  uint8* row_mem;
+  uint8* row = ScaleRowBuffer(row_stack, static_cast<int>(sizeof(row_stack)),
+                              s->row_size, &row_mem);
+  RunPlaneScaler(s, src, dst, row, y_begin, y_end);
+  FreeScaleRowBuffer(row_mem);
+  FreePlaneScaler(s);
+}
 
-#if defined(HAS_SCALEROWDOWN4_NEON)
-  if (TestCpuFlag(kCpuHasNEON) &&
-      (dst_width % 4 == 0)) {
-    ScaleRowDown4 = filtering ? ScaleRowDown4Int_NEON : ScaleRowDown4_NEON;
-  } else
-#endif
-#if defined(HAS_SCALEROWDOWN4_SSE2)
-  if (TestCpuFlag(kCpuHasSSE2) &&
-      (dst_width % 8 == 0) && (src_stride % 16 == 0) &&
-      (dst_stride % 8 == 0) &&
-      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 8)) {
-    ScaleRowDown4 = filtering ? ScaleRowDown4Int_SSE2 : ScaleRowDown4_SSE2;
-  } else
-#endif
-  {
-    ScaleRowDown4 = filtering ? ScaleRowDown4Int_C : ScaleRowDown4_C;
-  }
+// Scales output rows [y_begin, y_end) of a plane.
+// The scaler and its row functions are chosen from the geometry and
+// alignment of the whole plane, so a band of rows is bit exact with the
+// same rows produced by scaling the plane in one call.
+static void ScalePlaneRows(const uint8* src, int src_stride,
+                           int src_width, int src_height,
+                           uint8* dst, int dst_stride,
+                           int dst_width, int dst_height,
+                           FilterMode filtering, bool use_ref,
+                           int y_begin, int y_end) {
+  PlaneScaler scaler;
+  InitPlaneScaler(&scaler, src_width, src_height, dst_width, dst_height,
+                  src_stride, dst_stride, src, dst, filtering, use_ref);
+  RunPlaneScalerOnce(&scaler, src, dst, y_begin, y_end);
+}
 
-  for (int y = 0; y < dst_height; ++y) {
-    ScaleRowDown4(src_ptr, src_stride, dst_ptr, dst_width);
-    src_ptr += (src_stride << 2);
-    dst_ptr += dst_stride;
+void ScalePlane(const uint8* src, int src_stride,
+                int src_width, int src_height,
+                uint8* dst, int dst_stride,
+                int dst_width, int dst_height,
+                FilterMode filtering) {
+  ScalePlaneRows(src, src_stride, src_width, src_height,
+                 dst, dst_stride, dst_width, dst_height,
+                 filtering, use_reference_impl_, 0, dst_height);
+}
+
+int ScalePlaneRect(const uint8* src, int src_stride,
+                   int src_width, int src_height,
+                   int crop_x, int crop_y, int crop_width, int crop_height,
+                   uint8* dst, int dst_stride,
+                   int dst_width, int dst_height,
+                   FilterMode filtering) {
+  if (!src || src_width <= 0 || src_height <= 0 ||
+      crop_x < 0 || crop_y < 0 || crop_width <= 0 || crop_height <= 0 ||
+      crop_width > (src_width << 16) - crop_x ||
+      crop_height > (src_height << 16) - crop_y ||
+      !dst || dst_width <= 0 || dst_height <= 0) {
+    return -1;
   }
+  PlaneScaler scaler;
+  src = InitPlaneScalerRect(&scaler, src_width, src_height,
+                            crop_x, crop_y, crop_width, crop_height,
+                            dst_width, dst_height, src_stride, dst_stride,
+                            src, dst, filtering, use_reference_impl_);
+  RunPlaneScalerOnce(&scaler, src, dst, 0, dst_height);
+  return 0;
 }
 
 /**
- * Scale plane, 1/8
+ * Scale a plane.
  *
- * This is an optimized version for scaling down a plane to 1/8
- * of its original size.
+ * This function in turn calls a scaling function
+ * suitable for handling the desired resolutions.
  *
  */
-static void ScalePlaneDown8(int src_width, int src_height,
-                            int dst_width, int dst_height,
-                            int src_stride, int dst_stride,
-                            const uint8* src_ptr, uint8* dst_ptr,
-                            FilterMode filtering) {
-  assert(src_width % 8 == 0);
-  assert(src_height % 8 == 0);
-  void (*ScaleRowDown8)(const uint8* src_ptr, int src_stride,
-                        uint8* dst_ptr, int dst_width);
-#if defined(HAS_SCALEROWDOWN8_SSE2)
-  if (TestCpuFlag(kCpuHasSSE2) &&
-      (dst_width % 16 == 0) && dst_width <= kMaxOutputWidth &&
-      (src_stride % 16 == 0) && (dst_stride % 16 == 0) &&
-      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 16)) {
-    ScaleRowDown8 = filtering ? ScaleRowDown8Int_SSE2 : ScaleRowDown8_SSE2;
-  } else
-#endif
-  {
-    ScaleRowDown8 = filtering && (dst_width <= kMaxOutputWidth) ?
-        ScaleRowDown8Int_C : ScaleRowDown8_C;
+
+int I420Scale(const uint8* src_y, int src_stride_y,
+              const uint8* src_u, int src_stride_u,
+              const uint8* src_v, int src_stride_v,
+              int src_width, int src_height,
+              uint8* dst_y, int dst_stride_y,
+              uint8* dst_u, int dst_stride_u,
+              uint8* dst_v, int dst_stride_v,
+              int dst_width, int dst_height,
+              FilterMode filtering) {
+  if (!src_y || !src_u || !src_v || src_width <= 0 || src_height == 0 ||
+      !dst_y || !dst_u || !dst_v || dst_width <= 0 || dst_height <= 0) {
+    return -1;
   }
-  for (int y = 0; y < dst_height; ++y) {
-    ScaleRowDown8(src_ptr, src_stride, dst_ptr, dst_width);
-    src_ptr += (src_stride << 3);
-    dst_ptr += dst_stride;
+  // Negative height means invert the image.
+  if (src_height < 0) {
+    src_height = -src_height;
+    int halfheight = (src_height + 1) >> 1;
+    src_y = src_y + (src_height - 1) * src_stride_y;
+    src_u = src_u + (halfheight - 1) * src_stride_u;
+    src_v = src_v + (halfheight - 1) * src_stride_v;
+    src_stride_y = -src_stride_y;
+    src_stride_u = -src_stride_u;
+    src_stride_v = -src_stride_v;
   }
+  int halfsrc_width = (src_width + 1) >> 1;
+  int halfsrc_height = (src_height + 1) >> 1;
+  int halfdst_width = (dst_width + 1) >> 1;
+  int halfoheight = (dst_height + 1) >> 1;
+
+  ScalePlane(src_y, src_stride_y, src_width, src_height,
+             dst_y, dst_stride_y, dst_width, dst_height,
+             filtering);
+  ScalePlane(src_u, src_stride_u, halfsrc_width, halfsrc_height,
+             dst_u, dst_stride_u, halfdst_width, halfoheight,
+             filtering);
+  ScalePlane(src_v, src_stride_v, halfsrc_width, halfsrc_height,
+             dst_v, dst_stride_v, halfdst_width, halfoheight,
+             filtering);
+  return 0;
 }
 
-/**
- * Scale plane down, 3/4
- *
- * Provided by Frank Barchard (fbarchard@google.com)
- *
- */
-static void ScalePlaneDown34(int src_width, int src_height,
-                             int dst_width, int dst_height,
-                             int src_stride, int dst_stride,
-                             const uint8* src_ptr, uint8* dst_ptr,
-                             FilterMode filtering) {
-  assert(dst_width % 3 == 0);
-  void (*ScaleRowDown34_0)(const uint8* src_ptr, int src_stride,
-                           uint8* dst_ptr, int dst_width);
-  void (*ScaleRowDown34_1)(const uint8* src_ptr, int src_stride,
-                           uint8* dst_ptr, int dst_width);
-#if defined(HAS_SCALEROWDOWN34_NEON)
-  if (TestCpuFlag(kCpuHasNEON) &&
-      (dst_width % 24 == 0)) {
-    if (!filtering) {
-      ScaleRowDown34_0 = ScaleRowDown34_NEON;
-      ScaleRowDown34_1 = ScaleRowDown34_NEON;
-    } else {
-      ScaleRowDown34_0 = ScaleRowDown34_0_Int_NEON;
-      ScaleRowDown34_1 = ScaleRowDown34_1_Int_NEON;
-    }
-  } else
-#endif
-#if defined(HAS_SCALEROWDOWN34_SSSE3)
-  if (TestCpuFlag(kCpuHasSSSE3) &&
-      (dst_width % 24 == 0) && (src_stride % 16 == 0) &&
-      (dst_stride % 8 == 0) &&
-      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 8)) {
-    if (!filtering) {
-      ScaleRowDown34_0 = ScaleRowDown34_SSSE3;
-      ScaleRowDown34_1 = ScaleRowDown34_SSSE3;
-    } else {
-      ScaleRowDown34_0 = ScaleRowDown34_0_Int_SSSE3;
-      ScaleRowDown34_1 = ScaleRowDown34_1_Int_SSSE3;
-    }
-  } else
-#endif
-#if defined(HAS_SCALEROWDOWN34_SSE2)
-  if (TestCpuFlag(kCpuHasSSE2) &&
-      (dst_width % 24 == 0) && (src_stride % 16 == 0) &&
-      (dst_stride % 8 == 0) &&
-      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 8) &&
-      filtering) {
-    ScaleRowDown34_0 = ScaleRowDown34_0_Int_SSE2;
-    ScaleRowDown34_1 = ScaleRowDown34_1_Int_SSE2;
-  } else
-#endif
-  {
-    if (!filtering) {
-      ScaleRowDown34_0 = ScaleRowDown34_C;
-      ScaleRowDown34_1 = ScaleRowDown34_C;
-    } else {
-      ScaleRowDown34_0 = ScaleRowDown34_0_Int_C;
-      ScaleRowDown34_1 = ScaleRowDown34_1_Int_C;
-    }
+int I420ScaleRect(const uint8* src_y, int src_stride_y,
+                  const uint8* src_u, int src_stride_u,
+                  const uint8* src_v, int src_stride_v,
+                  int src_width, int src_height,
+                  int crop_x, int crop_y, int crop_width, int crop_height,
+                  uint8* dst_y, int dst_stride_y,
+                  uint8* dst_u, int dst_stride_u,
+                  uint8* dst_v, int dst_stride_v,
+                  int dst_width, int dst_height,
+                  FilterMode filtering) {
+  if (!src_y || !src_u || !src_v || src_width <= 0 || src_height == 0 ||
+      !dst_y || !dst_u || !dst_v || dst_width <= 0 || dst_height <= 0) {
+    return -1;
+  }
+  // Negative height means invert the image.
+  if (src_height < 0) {
+    src_height = -src_height;
+    int halfheight = (src_height + 1) >> 1;
+    src_y = src_y + (src_height - 1) * src_stride_y;
+    src_u = src_u + (halfheight - 1) * src_stride_u;
+    src_v = src_v + (halfheight - 1) * src_stride_v;
+    src_stride_y = -src_stride_y;
+    src_stride_u = -src_stride_u;
+    src_stride_v = -src_stride_v;
+  }
+  int halfsrc_width = (src_width + 1) >> 1;
+  int halfsrc_height = (src_height + 1) >> 1;
+  int halfdst_width = (dst_width + 1) >> 1;
+  int halfoheight = (dst_height + 1) >> 1;
+  // The chroma rectangle is half the size, rounded to keep it non empty.
+  // A rectangle on whole pixels has the chroma of the cropped image, as
+  // I420Scale of that image would scale it.
+  int halfcrop_x = crop_x >> 1;
+  int halfcrop_y = crop_y >> 1;
+  int halfcrop_width = (crop_width + 1) >> 1;
+  int halfcrop_height = (crop_height + 1) >> 1;
+  if (((crop_x | crop_y | crop_width | crop_height) & 0xffff) == 0) {
+    halfcrop_x = (crop_x >> 17) << 16;
+    halfcrop_y = (crop_y >> 17) << 16;
+    halfcrop_width = (((crop_width >> 16) + 1) >> 1) << 16;
+    halfcrop_height = (((crop_height >> 16) + 1) >> 1) << 16;
   }
-  int src_row = 0;
-  for (int y = 0; y < dst_height; ++y) {
-    switch (src_row) {
-      case 0:
-        ScaleRowDown34_0(src_ptr, src_stride, dst_ptr, dst_width);
-        break;
 
-      case 1:
-        ScaleRowDown34_1(src_ptr, src_stride, dst_ptr, dst_width);
-        break;
+  if (ScalePlaneRect(src_y, src_stride_y, src_width, src_height,
+                     crop_x, crop_y, crop_width, crop_height,
+                     dst_y, dst_stride_y, dst_width, dst_height,
+                     filtering) != 0) {
+    return -1;
+  }
+  ScalePlaneRect(src_u, src_stride_u, halfsrc_width, halfsrc_height,
+                 halfcrop_x, halfcrop_y, halfcrop_width, halfcrop_height,
+                 dst_u, dst_stride_u, halfdst_width, halfoheight,
+                 filtering);
+  ScalePlaneRect(src_v, src_stride_v, halfsrc_width, halfsrc_height,
+                 halfcrop_x, halfcrop_y, halfcrop_width, halfcrop_height,
+                 dst_v, dst_stride_v, halfdst_width, halfoheight,
+                 filtering);
+  return 0;
+}
 
-      case 2:
-        ScaleRowDown34_0(src_ptr + src_stride, -src_stride,
-                         dst_ptr, dst_width);
-        break;
+// Bytes of scaled Y, U and V rows that I420ScaleToARGB keeps between
+// scaling and conversion.  Half of a 16 KB L1 data cache, leaving room for
+// the source rows and the scalers' own row buffers.
+static const int kScaleConvertStripSize = 8192;
+
+typedef void (*YUVToRGBRowFunc)(const uint8* y_buf, const uint8* u_buf,
+                                const uint8* v_buf, uint8* rgb_buf,
+                                int width);
+
+// Scales a strip of rows of each plane into row buffers and converts the
+// strip to RGB before scaling the next one, so the scaled frame is never
+// written to memory.  The planes are scaled with the same scalers as
+// I420Scale, so the output is bit exact with I420Scale followed by
+// the conversion.  A plane that is not resized is converted directly from
+// the source.
+static int I420ScaleToRGB(const uint8* src_y, int src_stride_y,
+                          const uint8* src_u, int src_stride_u,
+                          const uint8* src_v, int src_stride_v,
+                          int src_width, int src_height,
+                          uint8* dst_rgb, int dst_stride_rgb,
+                          int dst_width, int dst_height,
+                          FilterMode filtering,
+                          YUVToRGBRowFunc ConvertRow) {
+  if (!src_y || !src_u || !src_v || src_width <= 0 || src_height == 0 ||
+      !dst_rgb || dst_width <= 0 || dst_height == 0) {
+    return -1;
+  }
+  // Negative height means invert the image.
+  if (src_height < 0) {
+    src_height = -src_height;
+    int halfheight = (src_height + 1) >> 1;
+    src_y = src_y + (src_height - 1) * src_stride_y;
+    src_u = src_u + (halfheight - 1) * src_stride_u;
+    src_v = src_v + (halfheight - 1) * src_stride_v;
+    src_stride_y = -src_stride_y;
+    src_stride_u = -src_stride_u;
+    src_stride_v = -src_stride_v;
+  }
+  if (dst_height < 0) {
+    dst_height = -dst_height;
+    dst_rgb = dst_rgb + (dst_height - 1) * dst_stride_rgb;
+    dst_stride_rgb = -dst_stride_rgb;
+  }
+  const int halfsrc_width = (src_width + 1) >> 1;
+  const int halfsrc_height = (src_height + 1) >> 1;
+  const int halfdst_width = (dst_width + 1) >> 1;
+  const int halfdst_height = (dst_height + 1) >> 1;
+
+  // An even number of rows per strip, so each strip starts a chroma row.
+  const int strip_stride_y = (dst_width + 15) & ~15;
+  const int strip_stride_uv = (halfdst_width + 15) & ~15;
+  int strip_rows = (kScaleConvertStripSize /
+                    (strip_stride_y + strip_stride_uv)) & ~1;
+  if (strip_rows < 2) {
+    strip_rows = 2;
+  }
+  if (strip_rows > dst_height + 1) {
+    strip_rows = (dst_height + 1) & ~1;
+  }
+  const int strip_size_y = strip_stride_y * strip_rows;
+  const int strip_size_uv = strip_stride_uv * (strip_rows >> 1);
+  ALIGN16(uint8 strip_stack[kScaleConvertStripSize]);
+  uint8* strip_mem;
+  uint8* strip_y = ScaleRowBuffer(strip_stack,
+                                  static_cast<int>(sizeof(strip_stack)),
+                                  strip_size_y + strip_size_uv * 2,
+                                  &strip_mem);
+  uint8* strip_u = strip_y + strip_size_y;
+  uint8* strip_v = strip_u + strip_size_uv;
+
+  PlaneScaler scalers[3];
+  InitPlaneScaler(&scalers[0], src_width, src_height, dst_width, dst_height,
+                  src_stride_y, strip_stride_y, src_y, strip_y,
+                  filtering, use_reference_impl_);
+  InitPlaneScaler(&scalers[1], halfsrc_width, halfsrc_height,
+                  halfdst_width, halfdst_height,
+                  src_stride_u, strip_stride_uv, src_u, strip_u,
+                  filtering, use_reference_impl_);
+  InitPlaneScaler(&scalers[2], halfsrc_width, halfsrc_height,
+                  halfdst_width, halfdst_height,
+                  src_stride_v, strip_stride_uv, src_v, strip_v,
+                  filtering, use_reference_impl_);
+  int row_size = 0;
+  for (int i = 0; i < 3; ++i) {
+    if (scalers[i].row_size > row_size) {
+      row_size = scalers[i].row_size;
     }
-    ++src_row;
-    src_ptr += src_stride;
-    dst_ptr += dst_stride;
-    if (src_row >= 3) {
-      src_ptr += src_stride;
-      src_row = 0;
+  }
+  ALIGN16(uint8 row_stack[kMaxInputWidth * 5]);
+  uint8* row_mem;
+  uint8* row = ScaleRowBuffer(row_stack, static_cast<int>(sizeof(row_stack)),
+                              row_size, &row_mem);
+
+  const bool copy_y = scalers[0].method == kScaleCopy;
+  const bool copy_uv = scalers[1].method == kScaleCopy;
+  for (int y = 0; y < dst_height; y += strip_rows) {
+    const int y_end = (y + strip_rows < dst_height) ? y + strip_rows :
+                      dst_height;
+    const int uv_begin = y >> 1;
+    const int uv_end = (y_end + 1) >> 1;
+    // The scalers write row i of a plane at dst + dst_stride * i, so the
+    // strip is passed offset back to the first row of the band.
+    const uint8* row_y = src_y + src_stride_y * y;
+    int stride_y = src_stride_y;
+    if (!copy_y) {
+      RunPlaneScaler(&scalers[0], src_y, strip_y - strip_stride_y * y, row,
+                     y, y_end);
+      row_y = strip_y;
+      stride_y = strip_stride_y;
+    }
+    const uint8* row_u = src_u + src_stride_u * uv_begin;
+    const uint8* row_v = src_v + src_stride_v * uv_begin;
+    int stride_u = src_stride_u;
+    int stride_v = src_stride_v;
+    if (!copy_uv) {
+      RunPlaneScaler(&scalers[1], src_u,
+                     strip_u - strip_stride_uv * uv_begin, row,
+                     uv_begin, uv_end);
+      RunPlaneScaler(&scalers[2], src_v,
+                     strip_v - strip_stride_uv * uv_begin, row,
+                     uv_begin, uv_end);
+      row_u = strip_u;
+      row_v = strip_v;
+      stride_u = strip_stride_uv;
+      stride_v = strip_stride_uv;
     }
+    for (int i = y; i < y_end; ++i) {
+      ConvertRow(row_y, row_u, row_v, dst_rgb, dst_width);
+      dst_rgb += dst_stride_rgb;
+      row_y += stride_y;
+      if (i & 1) {
+        row_u += stride_u;
+        row_v += stride_v;
+      }
+    }
+  }
+  // MMX used for ConvertRow requires an emms instruction.
+  EMMS();
+
+  FreeScaleRowBuffer(row_mem);
+  FreeScaleRowBuffer(strip_mem);
+  for (int i = 0; i < 3; ++i) {
+    FreePlaneScaler(&scalers[i]);
   }
+  return 0;
 }
 
-/**
- * Scale plane, 3/8
- *
- * This is an optimized version for scaling down a plane to 3/8
- * of its original size.
- *
- * Reduces 16x3 to 6x1
- */
-static void ScalePlaneDown38(int src_width, int src_height,
-                             int dst_width, int dst_height,
-                             int src_stride, int dst_stride,
-                             const uint8* src_ptr, uint8* dst_ptr,
-                             FilterMode filtering) {
-  assert(dst_width % 3 == 0);
-  void (*ScaleRowDown38_3)(const uint8* src_ptr, int src_stride,
-                           uint8* dst_ptr, int dst_width);
-  void (*ScaleRowDown38_2)(const uint8* src_ptr, int src_stride,
-                           uint8* dst_ptr, int dst_width);
-#if defined(HAS_SCALEROWDOWN38_NEON)
-  if (TestCpuFlag(kCpuHasNEON) &&
-      (dst_width % 12 == 0)) {
-    if (!filtering) {
-      ScaleRowDown38_3 = ScaleRowDown38_NEON;
-      ScaleRowDown38_2 = ScaleRowDown38_NEON;
-    } else {
-      ScaleRowDown38_3 = ScaleRowDown38_3_Int_NEON;
-      ScaleRowDown38_2 = ScaleRowDown38_2_Int_NEON;
-    }
-  } else
+int I420ScaleToARGB(const uint8* src_y, int src_stride_y,
+                    const uint8* src_u, int src_stride_u,
+                    const uint8* src_v, int src_stride_v,
+                    int src_width, int src_height,
+                    uint8* dst_argb, int dst_stride_argb,
+                    int dst_width, int dst_height,
+                    FilterMode filtering) {
+  YUVToRGBRowFunc ConvertRow = FastConvertYUVToARGBRow_C;
+#if defined(HAS_FASTCONVERTYUVTOARGBROW_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    ConvertRow = FastConvertYUVToARGBRow_Any_MMX;
+  }
 #endif
-#if defined(HAS_SCALEROWDOWN38_SSSE3)
-  if (TestCpuFlag(kCpuHasSSSE3) &&
-      (dst_width % 24 == 0) && (src_stride % 16 == 0) &&
-      (dst_stride % 8 == 0) &&
-      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 8)) {
-    if (!filtering) {
-      ScaleRowDown38_3 = ScaleRowDown38_SSSE3;
-      ScaleRowDown38_2 = ScaleRowDown38_SSSE3;
-    } else {
-      ScaleRowDown38_3 = ScaleRowDown38_3_Int_SSSE3;
-      ScaleRowDown38_2 = ScaleRowDown38_2_Int_SSSE3;
-    }
-  } else
+  return I420ScaleToRGB(src_y, src_stride_y, src_u, src_stride_u,
+                        src_v, src_stride_v, src_width, src_height,
+                        dst_argb, dst_stride_argb, dst_width, dst_height,
+                        filtering, ConvertRow);
+}
+
+int I420ScaleToRGB565(const uint8* src_y, int src_stride_y,
+                      const uint8* src_u, int src_stride_u,
+                      const uint8* src_v, int src_stride_v,
+                      int src_width, int src_height,
+                      uint8* dst_rgb565, int dst_stride_rgb565,
+                      int dst_width, int dst_height,
+                      FilterMode filtering) {
+  YUVToRGBRowFunc ConvertRow = FastConvertYUVToRGB565Row_C;
+#if defined(HAS_FASTCONVERTYUVTOARGBROW_MMX)
+  if (TestCpuFlag(kCpuHasMMX)) {
+    ConvertRow = FastConvertYUVToRGB565Row_Any_MMX;
+  }
 #endif
-  {
-    if (!filtering) {
-      ScaleRowDown38_3 = ScaleRowDown38_C;
-      ScaleRowDown38_2 = ScaleRowDown38_C;
-    } else {
-      ScaleRowDown38_3 = ScaleRowDown38_3_Int_C;
-      ScaleRowDown38_2 = ScaleRowDown38_2_Int_C;
-    }
+  return I420ScaleToRGB(src_y, src_stride_y, src_u, src_stride_u,
+                        src_v, src_stride_v, src_width, src_height,
+                        dst_rgb565, dst_stride_rgb565, dst_width, dst_height,
+                        filtering, ConvertRow);
+}
+
+// Scalers for the planes of an I420 frame, and the row buffer they share.
+struct ScalePlan {
+  int src_height;  // Negative to invert the image.
+  PlaneScaler planes[3];
+  uint8* row_mem;
+  uint8* row;
+};
+
+ScalePlan* ScalePlanCreate(int src_width, int src_height,
+                           int src_stride_y, int src_stride_u,
+                           int src_stride_v,
+                           int dst_width, int dst_height,
+                           int dst_stride_y, int dst_stride_u,
+                           int dst_stride_v,
+                           FilterMode filtering) {
+  if (src_width <= 0 || src_height == 0 || dst_width <= 0 ||
+      dst_height <= 0) {
+    return NULL;
+  }
+  ScalePlan* plan = new ScalePlan;
+  plan->src_height = src_height;
+  if (src_height < 0) {
+    src_height = -src_height;
+    src_stride_y = -src_stride_y;
+    src_stride_u = -src_stride_u;
+    src_stride_v = -src_stride_v;
   }
-  int src_row = 0;
-  for (int y = 0; y < dst_height; ++y) {
-    switch (src_row) {
-      case 0:
-      case 1:
-        ScaleRowDown38_3(src_ptr, src_stride, dst_ptr, dst_width);
-        src_ptr += src_stride * 3;
-        ++src_row;
-        break;
+  int halfsrc_width = (src_width + 1) >> 1;
+  int halfsrc_height = (src_height + 1) >> 1;
+  int halfdst_width = (dst_width + 1) >> 1;
+  int halfoheight = (dst_height + 1) >> 1;
 
-      case 2:
-        ScaleRowDown38_2(src_ptr, src_stride, dst_ptr, dst_width);
-        src_ptr += src_stride * 2;
-        src_row = 0;
-        break;
+  // The row functions are chosen for 16 byte aligned planes.
+  // ScalePlanExecute checks the alignment of each frame.
+  InitPlaneScaler(&plan->planes[0], src_width, src_height,
+                  dst_width, dst_height, src_stride_y, dst_stride_y,
+                  NULL, NULL, filtering, use_reference_impl_);
+  InitPlaneScaler(&plan->planes[1], halfsrc_width, halfsrc_height,
+                  halfdst_width, halfoheight, src_stride_u, dst_stride_u,
+                  NULL, NULL, filtering, use_reference_impl_);
+  InitPlaneScaler(&plan->planes[2], halfsrc_width, halfsrc_height,
+                  halfdst_width, halfoheight, src_stride_v, dst_stride_v,
+                  NULL, NULL, filtering, use_reference_impl_);
+  int row_size = 0;
+  for (int i = 0; i < 3; ++i) {
+    if (plan->planes[i].row_size > row_size) {
+      row_size = plan->planes[i].row_size;
     }
-    dst_ptr += dst_stride;
   }
+  plan->row = ScaleRowBuffer(NULL, 0, row_size, &plan->row_mem);
+  return plan;
 }
 
-inline static uint32 SumBox(int iboxwidth, int iboxheight,
-                            int src_stride, const uint8* src_ptr) {
-  assert(iboxwidth > 0);
-  assert(iboxheight > 0);
-  uint32 sum = 0u;
-  for (int y = 0; y < iboxheight; ++y) {
-    for (int x = 0; x < iboxwidth; ++x) {
-      sum += src_ptr[x];
+int ScalePlanExecute(ScalePlan* plan,
+                     const uint8* src_y, const uint8* src_u,
+                     const uint8* src_v,
+                     uint8* dst_y, uint8* dst_u, uint8* dst_v) {
+  if (!plan || !src_y || !src_u || !src_v || !dst_y || !dst_u || !dst_v) {
+    return -1;
+  }
+  const uint8* src[3] = { src_y, src_u, src_v };
+  uint8* dst[3] = { dst_y, dst_u, dst_v };
+  for (int i = 0; i < 3; ++i) {
+    const PlaneScaler* s = &plan->planes[i];
+    // Negative height means invert the image.
+    if (plan->src_height < 0) {
+      src[i] -= (s->src_height - 1) * s->src_stride;
+    }
+    if (IS_ALIGNED(src[i], 16) && IS_ALIGNED(dst[i], 16)) {
+      RunPlaneScaler(s, src[i], dst[i], plan->row, 0, s->dst_height);
+    } else {
+      ScalePlaneRows(src[i], s->src_stride, s->src_width, s->src_height,
+                     dst[i], s->dst_stride, s->dst_width, s->dst_height,
+                     s->filtering, use_reference_impl_, 0, s->dst_height);
     }
-    src_ptr += src_stride;
   }
-  return sum;
+  return 0;
 }
 
-static void ScalePlaneBoxRow(int dst_width, int boxheight,
-                             int dx, int src_stride,
-                             const uint8* src_ptr, uint8* dst_ptr) {
-  int x = 0;
-  for (int i = 0; i < dst_width; ++i) {
-    int ix = x >> 16;
-    x += dx;
-    int boxwidth = (x >> 16) - ix;
-    *dst_ptr++ = SumBox(boxwidth, boxheight, src_stride, src_ptr + ix) /
-        (boxwidth * boxheight);
+void ScalePlanDestroy(ScalePlan* plan) {
+  if (plan) {
+    for (int i = 0; i < 3; ++i) {
+      FreePlaneScaler(&plan->planes[i]);
+    }
+    FreeScaleRowBuffer(plan->row_mem);
+    delete plan;
   }
 }
 
-inline static uint32 SumPixels(int iboxwidth, const uint16* src_ptr) {
-  assert(iboxwidth > 0);
-  uint32 sum = 0u;
-  for (int x = 0; x < iboxwidth; ++x) {
-    sum += src_ptr[x];
+// Source rows at the end of a stream ring, beyond the rows the scaler
+// reads at once.  Slices are copied into this space, and the rows no
+// longer read are only discarded when it fills.
+static const int kStreamRows = 32;
+
+// One plane of a ScaleStream.  Source rows [ring_y, src_y) are kept in
+// the ring, which is 16 byte aligned with a 16 byte aligned stride, so the
+// scaler uses the same row functions as for an aligned plane.
+struct ScaleStreamPlane {
+  PlaneScaler scaler;
+  uint8* ring;
+  uint8* ring_mem;
+  int ring_stride;
+  int ring_rows;  // Capacity of the ring.
+  int ring_y;     // Source row held in the first row of the ring.
+  int src_y;      // Source rows pushed so far in this frame.
+  int dst_y;      // Output rows scaled so far in this frame.
+  bool dst_aligned;
+};
+
+struct ScaleStream {
+  FilterMode filtering;
+  ScaleStreamPlane planes[3];
+  uint8* row_mem;
+  uint8* row;
+  int row_size;
+};
+
+// Chooses the row functions of each plane for the alignment of dst.  The
+// ring is the source, so only the alignment of dst varies.
+static void InitScaleStreamPlanes(ScaleStream* stream, uint8* const dst[3]) {
+  for (int i = 0; i < 3; ++i) {
+    ScaleStreamPlane* p = &stream->planes[i];
+    const bool dst_aligned = IS_ALIGNED(dst[i], 16);
+    if (dst_aligned == p->dst_aligned) {
+      continue;
+    }
+    PlaneScaler* s = &p->scaler;
+    const int src_width = s->src_width;
+    const int src_height = s->src_height;
+    const int dst_width = s->dst_width;
+    const int dst_height = s->dst_height;
+    const int dst_stride = s->dst_stride;
+    FreePlaneScaler(s);
+    InitPlaneScaler(s, src_width, src_height, dst_width, dst_height,
+                    p->ring_stride, dst_stride, p->ring, dst[i],
+                    stream->filtering, use_reference_impl_);
+    p->dst_aligned = dst_aligned;
   }
-  return sum;
-}
-
-static void ScaleAddCols2_C(int dst_width, int boxheight, int dx,
-                            const uint16* src_ptr, uint8* dst_ptr) {
-  int scaletbl[2];
-  int minboxwidth = (dx >> 16);
-  scaletbl[0] = 65536 / (minboxwidth * boxheight);
-  scaletbl[1] = 65536 / ((minboxwidth + 1) * boxheight);
-  int *scaleptr = scaletbl - minboxwidth;
-  int x = 0;
-  for (int i = 0; i < dst_width; ++i) {
-    int ix = x >> 16;
-    x += dx;
-    int boxwidth = (x >> 16) - ix;
-    *dst_ptr++ = SumPixels(boxwidth, src_ptr + ix) * scaleptr[boxwidth] >> 16;
+  int row_size = stream->row_size;
+  for (int i = 0; i < 3; ++i) {
+    if (stream->planes[i].scaler.row_size > row_size) {
+      row_size = stream->planes[i].scaler.row_size;
+    }
   }
-}
-
-static void ScaleAddCols1_C(int dst_width, int boxheight, int dx,
-                            const uint16* src_ptr, uint8* dst_ptr) {
-  int boxwidth = (dx >> 16);
-  int scaleval = 65536 / (boxwidth * boxheight);
-  int x = 0;
-  for (int i = 0; i < dst_width; ++i) {
-    *dst_ptr++ = SumPixels(boxwidth, src_ptr + x) * scaleval >> 16;
-    x += boxwidth;
+  if (!stream->row || row_size > stream->row_size) {
+    FreeScaleRowBuffer(stream->row_mem);
+    stream->row = ScaleRowBuffer(NULL, 0, row_size, &stream->row_mem);
+    stream->row_size = row_size;
   }
 }
 
-/**
- * Scale plane down to any dimensions, with interpolation.
- * (boxfilter).
- *
- * Same method as SimpleScale, which is fixed point, outputting
- * one pixel of destination using fixed point (16.16) to step
- * through source, sampling a box of pixel with simple
- * averaging.
- */
-static void ScalePlaneBox(int src_width, int src_height,
-                          int dst_width, int dst_height,
-                          int src_stride, int dst_stride,
-                          const uint8* src_ptr, uint8* dst_ptr) {
-  assert(dst_width > 0);
-  assert(dst_height > 0);
-  int dy = (src_height << 16) / dst_height;
-  int dx = (src_width << 16) / dst_width;
-  if ((src_width % 16 != 0) || (src_width > kMaxInputWidth) ||
-      dst_height * 2 > src_height) {
-    uint8* dst = dst_ptr;
-    int dy = (src_height << 16) / dst_height;
-    int dx = (src_width << 16) / dst_width;
-    int y = 0;
-    for (int j = 0; j < dst_height; ++j) {
-      int iy = y >> 16;
-      const uint8* const src = src_ptr + iy * src_stride;
-      y += dy;
-      if (y > (src_height << 16)) {
-        y = (src_height << 16);
+// Appends num_rows source rows to a plane, and scales every output row
+// whose source rows have all been pushed.
+static void ScaleStreamPlanePush(ScaleStreamPlane* p,
+                                 const uint8* src, int src_stride,
+                                 int num_rows, uint8* dst, uint8* row) {
+  const PlaneScaler* s = &p->scaler;
+  const int stride = p->ring_stride;
+  int first, last;
+  for (;;) {
+    int y_end = p->dst_y;
+    while (y_end < s->dst_height) {
+      PlaneScalerSourceRows(s, y_end, &first, &last);
+      if (last >= p->src_y) {
+        break;
       }
-      int boxheight = (y >> 16) - iy;
-      ScalePlaneBoxRow(dst_width, boxheight,
-                       dx, src_stride,
-                       src, dst);
-
-      dst += dst_stride;
+      ++y_end;
     }
-  } else {
-    ALIGN16(uint16 row[kMaxInputWidth]);
-    void (*ScaleAddRows)(const uint8* src_ptr, int src_stride,
-                         uint16* dst_ptr, int src_width, int src_height);
-    void (*ScaleAddCols)(int dst_width, int boxheight, int dx,
-                         const uint16* src_ptr, uint8* dst_ptr);
-#if defined(HAS_SCALEADDROWS_SSE2)
-    if (TestCpuFlag(kCpuHasSSE2) &&
-        (src_stride % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
-        (src_width % 16) == 0) {
-      ScaleAddRows = ScaleAddRows_SSE2;
-    } else
-#endif
-    {
-      ScaleAddRows = ScaleAddRows_C;
+    if (y_end > p->dst_y) {
+      RunPlaneScaler(s, p->ring - p->ring_y * stride, dst, row,
+                     p->dst_y, y_end);
+      p->dst_y = y_end;
     }
-    if (dx & 0xffff) {
-      ScaleAddCols = ScaleAddCols2_C;
-    } else {
-      ScaleAddCols = ScaleAddCols1_C;
+    if (num_rows == 0) {
+      break;
     }
-
-    int y = 0;
-    for (int j = 0; j < dst_height; ++j) {
-      int iy = y >> 16;
-      const uint8* const src = src_ptr + iy * src_stride;
-      y += dy;
-      if (y > (src_height << 16)) {
-        y = (src_height << 16);
+    // Rows before the first one read by the next output row are no
+    // longer needed.
+    first = s->src_height;
+    if (p->dst_y < s->dst_height) {
+      PlaneScalerSourceRows(s, p->dst_y, &first, &last);
+    }
+    if (first >= p->src_y) {
+      p->ring_y = first;
+      int skip = first - p->src_y;
+      if (skip > num_rows) {
+        skip = num_rows;
       }
-      int boxheight = (y >> 16) - iy;
-      ScaleAddRows(src, src_stride, row, src_width, boxheight);
-      ScaleAddCols(dst_width, boxheight, dx, row, dst_ptr);
-      dst_ptr += dst_stride;
+      src += skip * src_stride;
+      num_rows -= skip;
+      p->src_y += skip;
+    } else if (p->ring_rows - (p->src_y - p->ring_y) < num_rows &&
+               first > p->ring_y) {
+      memmove(p->ring, p->ring + (first - p->ring_y) * stride,
+              (p->src_y - first) * stride);
+      p->ring_y = first;
+    }
+    int rows = p->ring_rows - (p->src_y - p->ring_y);
+    if (rows > num_rows) {
+      rows = num_rows;
+    }
+    uint8* ring_row = p->ring + (p->src_y - p->ring_y) * stride;
+    for (int y = 0; y < rows; ++y) {
+      memcpy(ring_row, src, s->src_width);
+      ring_row += stride;
+      src += src_stride;
     }
+    num_rows -= rows;
+    p->src_y += rows;
   }
 }
 
-/**
- * Scale plane to/from any dimensions, with interpolation.
- */
-static void ScalePlaneBilinearSimple(int src_width, int src_height,
-                                     int dst_width, int dst_height,
-                                     int src_stride, int dst_stride,
-                                     const uint8* src_ptr, uint8* dst_ptr) {
-  uint8* dst = dst_ptr;
-  int dx = (src_width << 16) / dst_width;
-  int dy = (src_height << 16) / dst_height;
-  int maxx = ((src_width - 1) << 16) - 1;
-  int maxy = ((src_height - 1) << 16) - 1;
-  int y = (dst_height < src_height) ? 32768 :
-      (src_height << 16) / dst_height - 32768;
-  for (int i = 0; i < dst_height; ++i) {
-    int cy = (y < 0) ? 0 : y;
-    int yi = cy >> 16;
-    int yf = cy & 0xffff;
-    const uint8* const src = src_ptr + yi * src_stride;
-    int x = (dst_width < src_width) ? 32768 :
-        (src_width << 16) / dst_width - 32768;
-    for (int j = 0; j < dst_width; ++j) {
-      int cx = (x < 0) ? 0 : x;
-      int xi = cx >> 16;
-      int xf = cx & 0xffff;
-      int r0 = (src[xi] * (65536 - xf) + src[xi + 1] * xf) >> 16;
-      int r1 = (src[xi + src_stride] * (65536 - xf) +
-          src[xi + src_stride + 1] * xf) >> 16;
-      *dst++ = (r0 * (65536 - yf) + r1 * yf) >> 16;
-      x += dx;
-      if (x > maxx)
-        x = maxx;
+ScaleStream* ScaleStreamCreate(int src_width, int src_height,
+                               int dst_width, int dst_height,
+                               int dst_stride_y, int dst_stride_u,
+                               int dst_stride_v,
+                               FilterMode filtering) {
+  if (src_width <= 0 || src_height <= 0 || dst_width <= 0 ||
+      dst_height <= 0) {
+    return NULL;
+  }
+  ScaleStream* stream = new ScaleStream;
+  memset(stream, 0, sizeof(*stream));
+  stream->filtering = filtering;
+  const int halfsrc_width = (src_width + 1) >> 1;
+  const int halfsrc_height = (src_height + 1) >> 1;
+  const int halfdst_width = (dst_width + 1) >> 1;
+  const int halfoheight = (dst_height + 1) >> 1;
+  const int dst_stride[3] = { dst_stride_y, dst_stride_u, dst_stride_v };
+  for (int i = 0; i < 3; ++i) {
+    ScaleStreamPlane* p = &stream->planes[i];
+    PlaneScaler* s = &p->scaler;
+    const int plane_src_width = i ? halfsrc_width : src_width;
+    const int plane_src_height = i ? halfsrc_height : src_height;
+    p->ring_stride = (plane_src_width + 15) & ~15;
+    // The scaling method depends only on the geometry, so the ring can be
+    // sized before the row functions are chosen.
+    InitPlaneScaler(s, plane_src_width, plane_src_height,
+                    i ? halfdst_width : dst_width,
+                    i ? halfoheight : dst_height,
+                    p->ring_stride, dst_stride[i], NULL, NULL,
+                    filtering, use_reference_impl_);
+    int span = 1;
+    for (int y = 0; y < s->dst_height; ++y) {
+      int first, last;
+      PlaneScalerSourceRows(s, y, &first, &last);
+      if (last - first + 1 > span) {
+        span = last - first + 1;
+      }
     }
-    dst += dst_stride - dst_width;
-    y += dy;
-    if (y > maxy)
-      y = maxy;
+    p->ring_rows = span + kStreamRows;
+    if (p->ring_rows > plane_src_height) {
+      p->ring_rows = plane_src_height;
+    }
+    // The row functions may read a little past the end of the last row.
+    p->ring = ScaleRowBuffer(NULL, 0, p->ring_rows * p->ring_stride + 16,
+                             &p->ring_mem);
+    p->dst_aligned = true;
   }
+  uint8* const dst_aligned[3] = { NULL, NULL, NULL };
+  InitScaleStreamPlanes(stream, dst_aligned);
+  return stream;
 }
 
-/**
- * Scale plane to/from any dimensions, with bilinear
- * interpolation.
- */
-static void ScalePlaneBilinear(int src_width, int src_height,
-                               int dst_width, int dst_height,
-                               int src_stride, int dst_stride,
-                               const uint8* src_ptr, uint8* dst_ptr) {
-  assert(dst_width > 0);
-  assert(dst_height > 0);
-  int dy = (src_height << 16) / dst_height;
-  int dx = (src_width << 16) / dst_width;
-  if ((src_width % 8 != 0) || (src_width > kMaxInputWidth)) {
-    ScalePlaneBilinearSimple(src_width, src_height, dst_width, dst_height,
-                             src_stride, dst_stride, src_ptr, dst_ptr);
+int ScaleStreamPush(ScaleStream* stream,
+                    const uint8* src_y, int src_stride_y,
+                    const uint8* src_u, int src_stride_u,
+                    const uint8* src_v, int src_stride_v,
+                    int num_rows,
+                    uint8* dst_y, uint8* dst_u, uint8* dst_v) {
+  if (!stream || !src_y || !src_u || !src_v ||
+      !dst_y || !dst_u || !dst_v) {
+    return -1;
+  }
+  ScaleStreamPlane* planes = stream->planes;
+  const int src_height = planes[0].scaler.src_height;
+  const int y = planes[0].src_y;
+  // Every slice but the last starts a pair of rows sharing chroma.
+  if (num_rows <= 0 || y + num_rows > src_height ||
+      (y + num_rows < src_height && (num_rows & 1))) {
+    return -1;
+  }
+  uint8* const dst[3] = { dst_y, dst_u, dst_v };
+  if (y == 0) {
+    InitScaleStreamPlanes(stream, dst);
+  }
+  const int halfrows = ((y + num_rows + 1) >> 1) - (y >> 1);
+  ScaleStreamPlanePush(&planes[0], src_y, src_stride_y, num_rows,
+                       dst_y, stream->row);
+  ScaleStreamPlanePush(&planes[1], src_u, src_stride_u, halfrows,
+                       dst_u, stream->row);
+  ScaleStreamPlanePush(&planes[2], src_v, src_stride_v, halfrows,
+                       dst_v, stream->row);
+
+  // Output row j is complete when luma row j and chroma row j / 2 are.
+  int done = planes[1].dst_y < planes[2].dst_y ?
+      planes[1].dst_y : planes[2].dst_y;
+  done *= 2;
+  if (done > planes[0].dst_y) {
+    done = planes[0].dst_y;
+  }
+  if (planes[0].src_y == src_height) {
+    // The frame is complete.  The next push starts a new frame.
+    for (int i = 0; i < 3; ++i) {
+      planes[i].ring_y = 0;
+      planes[i].src_y = 0;
+      planes[i].dst_y = 0;
+    }
+  }
+  return done;
+}
 
-  } else {
-    ALIGN16(uint8 row[kMaxInputWidth + 1]);
-    void (*ScaleFilterRows)(uint8* dst_ptr, const uint8* src_ptr,
-                            int src_stride,
-                            int dst_width, int source_y_fraction);
-    void (*ScaleFilterCols)(uint8* dst_ptr, const uint8* src_ptr,
-                            int dst_width, int dx);
-#if defined(HAS_SCALEFILTERROWS_SSSE3)
-    if (TestCpuFlag(kCpuHasSSSE3) &&
-        (src_stride % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
-        (src_width % 16) == 0) {
-      ScaleFilterRows = ScaleFilterRows_SSSE3;
-    } else
-#endif
-#if defined(HAS_SCALEFILTERROWS_SSE2)
-    if (TestCpuFlag(kCpuHasSSE2) &&
-        (src_stride % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
-        (src_width % 16) == 0) {
-      ScaleFilterRows = ScaleFilterRows_SSE2;
-    } else
-#endif
-    {
-      ScaleFilterRows = ScaleFilterRows_C;
-    }
-    ScaleFilterCols = ScaleFilterCols_C;
-
-    int y = 0;
-    int maxy = ((src_height - 1) << 16) - 1; // max is filter of last 2 rows.
-    for (int j = 0; j < dst_height; ++j) {
-      int iy = y >> 16;
-      int fy = (y >> 8) & 255;
-      const uint8* const src = src_ptr + iy * src_stride;
-      ScaleFilterRows(row, src, src_stride, src_width, fy);
-      ScaleFilterCols(dst_ptr, row, dst_width, dx);
-      dst_ptr += dst_stride;
-      y += dy;
-      if (y > maxy) {
-        y = maxy;
+// Sets ready[n] to the output rows of a plane that ScaleStreamPlanePush has
+// scaled once n source rows are pushed, for n from 0 to the source height.
+static void ScaleStreamRowsReady(const PlaneScaler* s, int* ready) {
+  int y = 0;
+  for (int n = 0; n <= s->src_height; ++n) {
+    while (y < s->dst_height) {
+      int first, last;
+      PlaneScalerSourceRows(s, y, &first, &last);
+      if (last >= n) {
+        break;
       }
+      ++y;
     }
+    ready[n] = y;
   }
 }
 
-/**
- * Scale plane to/from any dimensions, without interpolation.
- * Fixed point math is used for performance: The upper 16 bits
- * of x and dx is the integer part of the source position and
- * the lower 16 bits are the fixed decimal part.
- */
-static void ScalePlaneSimple(int src_width, int src_height,
-                             int dst_width, int dst_height,
-                             int src_stride, int dst_stride,
-                             const uint8* src_ptr, uint8* dst_ptr) {
-  uint8* dst = dst_ptr;
-  int dx = (src_width << 16) / dst_width;
-  for (int y = 0; y < dst_height; ++y) {
-    const uint8* const src = src_ptr + (y * src_height / dst_height) *
-        src_stride;
-    // TODO(fbarchard): Round X coordinate by setting x=0x8000.
-    int x = 0;
-    for (int i = 0; i < dst_width; ++i) {
-      *dst++ = src[x >> 16];
-      x += dx;
+int ScaleStreamWindowRows(const ScaleStream* stream, int num_rows) {
+  if (!stream || num_rows <= 0) {
+    return -1;
+  }
+  const ScaleStreamPlane* planes = stream->planes;
+  const int src_height = planes[0].scaler.src_height;
+  const int halfsrc_height = planes[1].scaler.src_height;
+  int* ready_y = new int[src_height + 1];
+  int* ready_uv = new int[halfsrc_height + 1];
+  ScaleStreamRowsReady(&planes[0].scaler, ready_y);
+  ScaleStreamRowsReady(&planes[1].scaler, ready_uv);
+  int window_rows = 0;
+  for (int y = 0; y < src_height; y += 2) {
+    const int y_end = (y + num_rows < src_height) ? y + num_rows : src_height;
+    int done = 2 * ready_uv[y >> 1];
+    if (done > ready_y[y]) {
+      done = ready_y[y];
+    }
+    // Chroma row j is written with luma rows 2 * j and 2 * j + 1.
+    int written = 2 * ready_uv[(y_end + 1) >> 1];
+    if (written < ready_y[y_end]) {
+      written = ready_y[y_end];
+    }
+    if (written - done > window_rows) {
+      window_rows = written - done;
     }
-    dst += dst_stride - dst_width;
   }
+  delete[] ready_y;
+  delete[] ready_uv;
+  return window_rows;
 }
 
-/**
- * Scale plane to/from any dimensions.
- */
-static void ScalePlaneAnySize(int src_width, int src_height,
-                              int dst_width, int dst_height,
-                              int src_stride, int dst_stride,
-                              const uint8* src_ptr, uint8* dst_ptr,
-                              FilterMode filtering) {
-  if (!filtering) {
-    ScalePlaneSimple(src_width, src_height, dst_width, dst_height,
-                     src_stride, dst_stride, src_ptr, dst_ptr);
-  } else {
-    // fall back to non-optimized version
-    ScalePlaneBilinear(src_width, src_height, dst_width, dst_height,
-                       src_stride, dst_stride, src_ptr, dst_ptr);
+void ScaleStreamDestroy(ScaleStream* stream) {
+  if (stream) {
+    for (int i = 0; i < 3; ++i) {
+      FreePlaneScaler(&stream->planes[i].scaler);
+      FreeScaleRowBuffer(stream->planes[i].ring_mem);
+    }
+    FreeScaleRowBuffer(stream->row_mem);
+    delete stream;
   }
 }
 
-/**
- * Scale plane down, any size
- *
- * This is an optimized version for scaling down a plane to any size.
- * The current implementation is ~10 times faster compared to the
- * reference implementation for e.g. XGA->LowResPAL
- *
- */
-static void ScalePlaneDown(int src_width, int src_height,
-                           int dst_width, int dst_height,
-                           int src_stride, int dst_stride,
-                           const uint8* src_ptr, uint8* dst_ptr,
-                           FilterMode filtering) {
-  if (!filtering) {
-    ScalePlaneSimple(src_width, src_height, dst_width, dst_height,
-                     src_stride, dst_stride, src_ptr, dst_ptr);
-  } else if (filtering == kFilterBilinear || src_height * 2 > dst_height) {
-    // between 1/2x and 1x use bilinear
-    ScalePlaneBilinear(src_width, src_height, dst_width, dst_height,
-                       src_stride, dst_stride, src_ptr, dst_ptr);
-  } else {
-    ScalePlaneBox(src_width, src_height, dst_width, dst_height,
-                  src_stride, dst_stride, src_ptr, dst_ptr);
+// Bytes of source rows I420ScalePyramid scales into every level before it
+// moves on.  A quarter of a 256 KB L2 cache, so the strip and the level
+// rows scaled from it are still cached when smaller levels read them.
+static const int kScalePyramidStripSize = 65536;
+
+// Orders the levels of a pyramid by decreasing size, and picks the level
+// each is scaled from, or -1 for the source.  A level that is a larger
+// level divided by 2, 4 or 8 is scaled from the smallest such level,
+// which has already been filtered down.  The luma and the chroma sizes
+// must both divide exactly, so all three planes of a level are scaled from
+// the same parent.
+static void ScalePyramidOrder(const ScalePyramidLevel* levels,
+                              int num_levels, int order[], int parent[]) {
+  for (int i = 0; i < num_levels; ++i) {
+    int j = i;
+    while (j > 0 && levels[order[j - 1]].dst_width *
+                    levels[order[j - 1]].dst_height <
+                    levels[i].dst_width * levels[i].dst_height) {
+      order[j] = order[j - 1];
+      --j;
+    }
+    order[j] = i;
+  }
+  for (int n = 0; n < num_levels; ++n) {
+    const int i = order[n];
+    const int width = levels[i].dst_width;
+    const int height = levels[i].dst_height;
+    parent[i] = -1;
+    for (int k = 0; k < n; ++k) {
+      const int p = order[k];
+      const int p_width = levels[p].dst_width;
+      const int p_height = levels[p].dst_height;
+      for (int shift = 1; shift <= 3; ++shift) {
+        if (p_width == (width << shift) && p_height == (height << shift) &&
+            ((p_width + 1) >> 1) == (((width + 1) >> 1) << shift) &&
+            ((p_height + 1) >> 1) == (((height + 1) >> 1) << shift)) {
+          parent[i] = p;
+        }
+      }
+    }
   }
 }
 
-/**
- * Copy plane, no scaling
- *
- * This simply copies the given plane without scaling.
- * The current implementation is ~115 times faster
- * compared to the reference implementation.
- *
- */
-static void CopyPlane(int src_width, int src_height,
-                      int dst_width, int dst_height,
-                      int src_stride, int dst_stride,
-                      const uint8* src_ptr, uint8* dst_ptr) {
-  if (src_stride == src_width && dst_stride == dst_width) {
-    // All contiguous, so can use REALLY fast path.
-    memcpy(dst_ptr, src_ptr, src_width * src_height);
-  } else {
-    // Not all contiguous; must copy scanlines individually
-    const uint8* src = src_ptr;
-    uint8* dst = dst_ptr;
-    for (int i = 0; i < src_height; ++i) {
-      memcpy(dst, src, src_width);
-      dst += dst_stride;
-      src += src_stride;
+// Scales one plane of every level of a pyramid, in the order and from the
+// parents chosen by ScalePyramidOrder.  The source is consumed a strip of
+// rows at a time, and after each strip every level scales the rows whose
+// source rows are complete.
+static void ScalePyramidPlane(const uint8* src, int src_stride,
+                              int src_width, int src_height,
+                              uint8* const dst[], const int dst_stride[],
+                              const int dst_width[], const int dst_height[],
+                              const int order[], const int parent[],
+                              int num_levels, FilterMode filtering) {
+  PlaneScaler scalers[kMaxPyramidLevels];
+  int row_size = 0;
+  for (int n = 0; n < num_levels; ++n) {
+    const int i = order[n];
+    const int p = parent[i];
+    InitPlaneScaler(&scalers[i],
+                    p < 0 ? src_width : dst_width[p],
+                    p < 0 ? src_height : dst_height[p],
+                    dst_width[i], dst_height[i],
+                    p < 0 ? src_stride : dst_stride[p], dst_stride[i],
+                    p < 0 ? src : dst[p], dst[i],
+                    filtering, use_reference_impl_);
+    if (scalers[i].row_size > row_size) {
+      row_size = scalers[i].row_size;
+    }
+  }
+  ALIGN16(uint8 row_stack[kMaxInputWidth * 5]);
+  uint8* row_mem;
+  uint8* row = ScaleRowBuffer(row_stack, static_cast<int>(sizeof(row_stack)),
+                              row_size, &row_mem);
+
+  int strip_rows = kScalePyramidStripSize / src_width;
+  if (strip_rows < 2) {
+    strip_rows = 2;
+  }
+  // Rows of each level scaled so far.
+  int rows[kMaxPyramidLevels] = { 0 };
+  int src_rows = 0;
+  while (src_rows < src_height) {
+    src_rows += strip_rows;
+    if (src_rows > src_height) {
+      src_rows = src_height;
     }
+    for (int n = 0; n < num_levels; ++n) {
+      const int i = order[n];
+      const PlaneScaler* s = &scalers[i];
+      const int p = parent[i];
+      const int avail = p < 0 ? src_rows : rows[p];
+      int y_end = rows[i];
+      while (y_end < s->dst_height) {
+        int first, last;
+        PlaneScalerSourceRows(s, y_end, &first, &last);
+        if (last >= avail) {
+          break;
+        }
+        ++y_end;
+      }
+      if (y_end > rows[i]) {
+        RunPlaneScaler(s, p < 0 ? src : dst[p], dst[i], row, rows[i], y_end);
+        rows[i] = y_end;
+      }
+    }
+  }
+  FreeScaleRowBuffer(row_mem);
+  for (int i = 0; i < num_levels; ++i) {
+    FreePlaneScaler(&scalers[i]);
   }
 }
 
-static void ScalePlane(const uint8* src, int src_stride,
-                       int src_width, int src_height,
-                       uint8* dst, int dst_stride,
-                       int dst_width, int dst_height,
-                       FilterMode filtering, bool use_ref) {
-  // Use specialized scales to improve performance for common resolutions.
-  // For example, all the 1/2 scalings will use ScalePlaneDown2()
-  if (dst_width == src_width && dst_height == src_height) {
-    // Straight copy.
-    CopyPlane(src_width, src_height, dst_width, dst_height, src_stride,
-              dst_stride, src, dst);
-  } else if (dst_width <= src_width && dst_height <= src_height) {
-    // Scale down.
-    if (use_ref) {
-      // For testing, allow the optimized versions to be disabled.
-      ScalePlaneDown(src_width, src_height, dst_width, dst_height,
-                     src_stride, dst_stride, src, dst, filtering);
-    } else if (4 * dst_width == 3 * src_width &&
-               4 * dst_height == 3 * src_height) {
-      // optimized, 3/4
-      ScalePlaneDown34(src_width, src_height, dst_width, dst_height,
-                       src_stride, dst_stride, src, dst, filtering);
-    } else if (2 * dst_width == src_width && 2 * dst_height == src_height) {
-      // optimized, 1/2
-      ScalePlaneDown2(src_width, src_height, dst_width, dst_height,
-                      src_stride, dst_stride, src, dst, filtering);
-    // 3/8 rounded up for odd sized chroma height.
-    } else if (8 * dst_width == 3 * src_width &&
-               dst_height == ((src_height * 3 + 7) / 8)) {
-      // optimized, 3/8
-      ScalePlaneDown38(src_width, src_height, dst_width, dst_height,
-                       src_stride, dst_stride, src, dst, filtering);
-    } else if (4 * dst_width == src_width && 4 * dst_height == src_height) {
-      // optimized, 1/4
-      ScalePlaneDown4(src_width, src_height, dst_width, dst_height,
-                      src_stride, dst_stride, src, dst, filtering);
-    } else if (8 * dst_width == src_width && 8 * dst_height == src_height) {
-      // optimized, 1/8
-      ScalePlaneDown8(src_width, src_height, dst_width, dst_height,
-                      src_stride, dst_stride, src, dst, filtering);
-    } else {
-      // Arbitrary downsample
-      ScalePlaneDown(src_width, src_height, dst_width, dst_height,
-                     src_stride, dst_stride, src, dst, filtering);
+int I420ScalePyramid(const uint8* src_y, int src_stride_y,
+                     const uint8* src_u, int src_stride_u,
+                     const uint8* src_v, int src_stride_v,
+                     int src_width, int src_height,
+                     const ScalePyramidLevel* levels, int num_levels,
+                     FilterMode filtering) {
+  if (!src_y || !src_u || !src_v || src_width <= 0 || src_height == 0 ||
+      !levels || num_levels <= 0 || num_levels > kMaxPyramidLevels) {
+    return -1;
+  }
+  for (int i = 0; i < num_levels; ++i) {
+    if (!levels[i].dst_y || !levels[i].dst_u || !levels[i].dst_v ||
+        levels[i].dst_width <= 0 || levels[i].dst_height <= 0) {
+      return -1;
     }
-  } else {
-    // Arbitrary scale up and/or down.
-    ScalePlaneAnySize(src_width, src_height, dst_width, dst_height,
-                      src_stride, dst_stride, src, dst, filtering);
   }
+  // Negative height means invert the image.
+  if (src_height < 0) {
+    src_height = -src_height;
+    int halfheight = (src_height + 1) >> 1;
+    src_y = src_y + (src_height - 1) * src_stride_y;
+    src_u = src_u + (halfheight - 1) * src_stride_u;
+    src_v = src_v + (halfheight - 1) * src_stride_v;
+    src_stride_y = -src_stride_y;
+    src_stride_u = -src_stride_u;
+    src_stride_v = -src_stride_v;
+  }
+  uint8* dst[3][kMaxPyramidLevels];
+  int dst_stride[3][kMaxPyramidLevels];
+  int dst_width[2][kMaxPyramidLevels];
+  int dst_height[2][kMaxPyramidLevels];
+  for (int i = 0; i < num_levels; ++i) {
+    const ScalePyramidLevel& level = levels[i];
+    dst[0][i] = level.dst_y;
+    dst[1][i] = level.dst_u;
+    dst[2][i] = level.dst_v;
+    dst_stride[0][i] = level.dst_stride_y;
+    dst_stride[1][i] = level.dst_stride_u;
+    dst_stride[2][i] = level.dst_stride_v;
+    dst_width[0][i] = level.dst_width;
+    dst_height[0][i] = level.dst_height;
+    dst_width[1][i] = (level.dst_width + 1) >> 1;
+    dst_height[1][i] = (level.dst_height + 1) >> 1;
+  }
+  int halfsrc_width = (src_width + 1) >> 1;
+  int halfsrc_height = (src_height + 1) >> 1;
+  int order[kMaxPyramidLevels];
+  int parent[kMaxPyramidLevels];
+  ScalePyramidOrder(levels, num_levels, order, parent);
+
+  ScalePyramidPlane(src_y, src_stride_y, src_width, src_height,
+                    dst[0], dst_stride[0], dst_width[0], dst_height[0],
+                    order, parent, num_levels, filtering);
+  ScalePyramidPlane(src_u, src_stride_u, halfsrc_width, halfsrc_height,
+                    dst[1], dst_stride[1], dst_width[1], dst_height[1],
+                    order, parent, num_levels, filtering);
+  ScalePyramidPlane(src_v, src_stride_v, halfsrc_width, halfsrc_height,
+                    dst[2], dst_stride[2], dst_width[1], dst_height[1],
+                    order, parent, num_levels, filtering);
+  return 0;
 }
 
-/**
- * Scale a plane.
- *
- * This function in turn calls a scaling function
- * suitable for handling the desired resolutions.
- *
- */
+// A band of output rows of one plane, scaled by ScaleBandJob.
+struct ScaleBand {
+  const uint8* src;
+  int src_stride;
+  int src_width;
+  int src_height;
+  uint8* dst;
+  int dst_stride;
+  int dst_width;
+  int dst_height;
+  FilterMode filtering;
+  int y_begin;
+  int y_end;
+};
+
+static void ScaleBandJob(void* opaque, int index) {
+  const ScaleBand* band = static_cast<const ScaleBand*>(opaque) + index;
+  ScalePlaneRows(band->src, band->src_stride,
+                 band->src_width, band->src_height,
+                 band->dst, band->dst_stride,
+                 band->dst_width, band->dst_height,
+                 band->filtering, use_reference_impl_,
+                 band->y_begin, band->y_end);
+}
 
-int I420Scale(const uint8* src_y, int src_stride_y,
-              const uint8* src_u, int src_stride_u,
-              const uint8* src_v, int src_stride_v,
-              int src_width, int src_height,
-              uint8* dst_y, int dst_stride_y,
-              uint8* dst_u, int dst_stride_u,
-              uint8* dst_v, int dst_stride_v,
-              int dst_width, int dst_height,
-              FilterMode filtering) {
+// Splits the output rows of a plane into 'num_bands' horizontal bands.
+// Returns the number of non-empty bands added.
+static int AddScaleBands(const uint8* src, int src_stride,
+                         int src_width, int src_height,
+                         uint8* dst, int dst_stride,
+                         int dst_width, int dst_height,
+                         FilterMode filtering, int num_bands,
+                         ScaleBand* bands) {
+  int rows_per_band = (dst_height + num_bands - 1) / num_bands;
+  int count = 0;
+  for (int y = 0; y < dst_height; y += rows_per_band) {
+    ScaleBand* band = bands + count;
+    band->src = src;
+    band->src_stride = src_stride;
+    band->src_width = src_width;
+    band->src_height = src_height;
+    band->dst = dst;
+    band->dst_stride = dst_stride;
+    band->dst_width = dst_width;
+    band->dst_height = dst_height;
+    band->filtering = filtering;
+    band->y_begin = y;
+    band->y_end = (y + rows_per_band < dst_height) ?
+        y + rows_per_band : dst_height;
+    ++count;
+  }
+  return count;
+}
+
+int I420ScaleParallel(const uint8* src_y, int src_stride_y,
+                      const uint8* src_u, int src_stride_u,
+                      const uint8* src_v, int src_stride_v,
+                      int src_width, int src_height,
+                      uint8* dst_y, int dst_stride_y,
+                      uint8* dst_u, int dst_stride_u,
+                      uint8* dst_v, int dst_stride_v,
+                      int dst_width, int dst_height,
+                      FilterMode filtering, int num_threads,
+                      ParallelExecutor executor, void* executor_opaque) {
   if (!src_y || !src_u || !src_v || src_width <= 0 || src_height == 0 ||
-      !dst_y || !dst_u || !dst_v || dst_width <= 0 || dst_height <= 0) {
+      !dst_y || !dst_u || !dst_v || dst_width <= 0 || dst_height <= 0 ||
+      num_threads <= 0) {
     return -1;
   }
   // Negative height means invert the image.
@@ -3736,20 +8989,31 @@ int I420Scale(const uint8* src_y, int src_stride_y,
     src_stride_u = -src_stride_u;
     src_stride_v = -src_stride_v;
   }
+  if (num_threads > kMaxParallelThreads) {
+    num_threads = kMaxParallelThreads;
+  }
   int halfsrc_width = (src_width + 1) >> 1;
   int halfsrc_height = (src_height + 1) >> 1;
   int halfdst_width = (dst_width + 1) >> 1;
   int halfoheight = (dst_height + 1) >> 1;
 
-  ScalePlane(src_y, src_stride_y, src_width, src_height,
-             dst_y, dst_stride_y, dst_width, dst_height,
-             filtering, use_reference_impl_);
-  ScalePlane(src_u, src_stride_u, halfsrc_width, halfsrc_height,
-             dst_u, dst_stride_u, halfdst_width, halfoheight,
-             filtering, use_reference_impl_);
-  ScalePlane(src_v, src_stride_v, halfsrc_width, halfsrc_height,
-             dst_v, dst_stride_v, halfdst_width, halfoheight,
-             filtering, use_reference_impl_);
+  // Each plane is split into one band per thread.
+  ScaleBand bands[kMaxParallelThreads * 3];
+  int count = 0;
+  count += AddScaleBands(src_y, src_stride_y, src_width, src_height,
+                         dst_y, dst_stride_y, dst_width, dst_height,
+                         filtering, num_threads, bands + count);
+  count += AddScaleBands(src_u, src_stride_u, halfsrc_width, halfsrc_height,
+                         dst_u, dst_stride_u, halfdst_width, halfoheight,
+                         filtering, num_threads, bands + count);
+  count += AddScaleBands(src_v, src_stride_v, halfsrc_width, halfsrc_height,
+                         dst_v, dst_stride_v, halfdst_width, halfoheight,
+                         filtering, num_threads, bands + count);
+  if (executor) {
+    executor(executor_opaque, ScaleBandJob, bands, count);
+  } else {
+    RunParallelJobs(ScaleBandJob, bands, count, num_threads);
+  }
   return 0;
 }
 
@@ -3783,13 +9047,13 @@ int Scale(const uint8* src_y, const uint8* src_u, const uint8* src_v,
 
   ScalePlane(src_y, src_stride_y, src_width, src_height,
              dst_y, dst_stride_y, dst_width, dst_height,
-             filtering, use_reference_impl_);
+             filtering);
   ScalePlane(src_u, src_stride_u, halfsrc_width, halfsrc_height,
              dst_u, dst_stride_u, halfdst_width, halfoheight,
-             filtering, use_reference_impl_);
+             filtering);
   ScalePlane(src_v, src_stride_v, halfsrc_width, halfsrc_height,
              dst_v, dst_stride_v, halfdst_width, halfoheight,
-             filtering, use_reference_impl_);
+             filtering);
   return 0;
 }
 
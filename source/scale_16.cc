@@ -0,0 +1,689 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "libyuv/scale_16.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "libyuv/cpu_id.h"
+
+namespace libyuv {
+
+// 16 bit scaling follows the 8 bit plane scalers in scale.cc, with uint16
+// samples and strides counted in samples.  Sums and blends are done in 32
+// bits, so samples may use all 16 bits.
+
+#if defined(WIN32) && !defined(COVERAGE_ENABLED)
+
+#define HAS_SCALEROWDOWN2_16_SSE2
+// Reads 16 samples, throws half away and writes 8 samples.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleRowDown2_16_SSE2(const uint16* src_ptr, int src_stride,
+                                  uint16* dst_ptr, int dst_width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+                                     // src_stride ignored
+    mov        edx, [esp + 12]       // dst_ptr
+    mov        ecx, [esp + 16]       // dst_width
+
+  wloop:
+    movdqa     xmm0, [eax]
+    movdqa     xmm1, [eax + 16]
+    lea        eax,  [eax + 32]
+    pshuflw    xmm0, xmm0, 0x08      // even words to the low 8 bytes
+    pshufhw    xmm0, xmm0, 0x08
+    pshufd     xmm0, xmm0, 0x08
+    pshuflw    xmm1, xmm1, 0x08
+    pshufhw    xmm1, xmm1, 0x08
+    pshufd     xmm1, xmm1, 0x08
+    punpcklqdq xmm0, xmm1
+    movdqa     [edx], xmm0
+    lea        edx, [edx + 16]
+    sub        ecx, 8
+    ja         wloop
+
+    ret
+  }
+}
+
+// Blends 16x2 rectangle to 8x1.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleRowDown2Int_16_SSE2(const uint16* src_ptr, int src_stride,
+                                     uint16* dst_ptr, int dst_width) {
+  __asm {
+    push       esi
+    mov        eax, [esp + 4 + 4]    // src_ptr
+    mov        esi, [esp + 4 + 8]    // src_stride
+    mov        edx, [esp + 4 + 12]   // dst_ptr
+    mov        ecx, [esp + 4 + 16]   // dst_width
+
+  wloop:
+    movdqa     xmm0, [eax]
+    movdqa     xmm1, [eax + 16]
+    movdqa     xmm2, [eax + esi * 2]
+    movdqa     xmm3, [eax + esi * 2 + 16]
+    lea        eax,  [eax + 32]
+    pavgw      xmm0, xmm2            // average rows
+    pavgw      xmm1, xmm3
+    movdqa     xmm2, xmm0            // average columns (16 to 8 samples)
+    movdqa     xmm3, xmm1
+    psrld      xmm2, 16
+    psrld      xmm3, 16
+    pavgw      xmm0, xmm2
+    pavgw      xmm1, xmm3
+    pshuflw    xmm0, xmm0, 0x08      // even words to the low 8 bytes
+    pshufhw    xmm0, xmm0, 0x08
+    pshufd     xmm0, xmm0, 0x08
+    pshuflw    xmm1, xmm1, 0x08
+    pshufhw    xmm1, xmm1, 0x08
+    pshufd     xmm1, xmm1, 0x08
+    punpcklqdq xmm0, xmm1
+    movdqa     [edx], xmm0
+    lea        edx, [edx + 16]
+    sub        ecx, 8
+    ja         wloop
+
+    pop        esi
+    ret
+  }
+}
+
+#define HAS_SCALEFILTERROWS_16_SSE2
+// Blend 2 rows as (row0 * (256 - f) + row1 * f) >> 8, 8 samples at a time.
+// The 32 bit sum is the sum of the pmulhuw high halves plus the carry out
+// of the sum of the pmullw low halves.  source_y_fraction is 1..255.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleFilterRows_16_SSE2(uint16* dst_ptr, const uint16* src_ptr,
+                                    int src_stride, int dst_width,
+                                    int source_y_fraction) {
+  __asm {
+    push       esi
+    push       edi
+    mov        edi, [esp + 8 + 4]   // dst_ptr
+    mov        esi, [esp + 8 + 8]   // src_ptr
+    mov        edx, [esp + 8 + 12]  // src_stride
+    mov        ecx, [esp + 8 + 16]  // dst_width
+    mov        eax, [esp + 8 + 20]  // source_y_fraction (1..255)
+    shl        eax, 8
+    movd       xmm6, eax
+    punpcklwd  xmm6, xmm6
+    pshufd     xmm6, xmm6, 0
+    pxor       xmm5, xmm5           // generate (256 - source_y_fraction) << 8
+    psubw      xmm5, xmm6
+    pcmpeqb    xmm7, xmm7
+
+  wloop:
+    movdqa     xmm0, [esi]
+    movdqa     xmm1, [esi + edx * 2]
+    lea        esi,  [esi + 16]
+    movdqa     xmm2, xmm0
+    movdqa     xmm3, xmm1
+    pmulhuw    xmm0, xmm5           // high halves
+    pmulhuw    xmm1, xmm6
+    pmullw     xmm2, xmm5           // low halves
+    pmullw     xmm3, xmm6
+    paddw      xmm0, xmm1
+    movdqa     xmm1, xmm2
+    paddusw    xmm1, xmm3           // saturates only if the sum carries
+    paddw      xmm2, xmm3
+    pcmpeqw    xmm1, xmm2
+    pxor       xmm1, xmm7           // -1 where the low halves carry
+    psubw      xmm0, xmm1
+    movdqa     [edi], xmm0
+    lea        edi,  [edi + 16]
+    sub        ecx, 8
+    ja         wloop
+
+    pop        edi
+    pop        esi
+    ret
+  }
+}
+
+#define HAS_SCALEADDROWS_16_SSE2
+// Sums src_height rows of 8 samples at a time into 32 bit sums.
+// Alignment requirement: src_ptr 16 byte aligned, dst_sum 16 byte aligned.
+__declspec(naked)
+static void ScaleAddRows_16_SSE2(const uint16* src_ptr, int src_stride,
+                                 uint32* dst_sum, int src_width,
+                                 int src_height) {
+  __asm {
+    push       esi
+    push       edi
+    push       ebx
+    mov        esi, [esp + 12 + 4]  // src_ptr
+    mov        edx, [esp + 12 + 8]  // src_stride
+    mov        edi, [esp + 12 + 12] // dst_sum
+    mov        ebx, [esp + 12 + 16] // src_width
+    pxor       xmm7, xmm7
+    xor        eax, eax
+
+  xloop1:                           // first row is stored
+    movdqa     xmm0, [esi + eax * 2]
+    movdqa     xmm1, xmm0
+    punpcklwd  xmm0, xmm7
+    punpckhwd  xmm1, xmm7
+    movdqa     [edi + eax * 4], xmm0
+    movdqa     [edi + eax * 4 + 16], xmm1
+    add        eax, 8
+    cmp        eax, ebx
+    jb         xloop1
+
+    mov        ecx, [esp + 12 + 20] // src_height
+  yloop:
+    sub        ecx, 1
+    jbe        ydone
+    lea        esi, [esi + edx * 2]
+    xor        eax, eax
+
+  xloop:                            // other rows are added
+    movdqa     xmm0, [esi + eax * 2]
+    movdqa     xmm1, xmm0
+    punpcklwd  xmm0, xmm7
+    punpckhwd  xmm1, xmm7
+    paddd      xmm0, [edi + eax * 4]
+    paddd      xmm1, [edi + eax * 4 + 16]
+    movdqa     [edi + eax * 4], xmm0
+    movdqa     [edi + eax * 4 + 16], xmm1
+    add        eax, 8
+    cmp        eax, ebx
+    jb         xloop
+    jmp        yloop
+
+  ydone:
+    pop        ebx
+    pop        edi
+    pop        esi
+    ret
+  }
+}
+
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+
+#define HAS_SCALEROWDOWN2_16_SSE2
+static void ScaleRowDown2_16_SSE2(const uint16* src_ptr, int src_stride,
+                                  uint16* dst_ptr, int dst_width) {
+  asm volatile (
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "pshuflw    $0x8,%%xmm0,%%xmm0               \n"
+  "pshufhw    $0x8,%%xmm0,%%xmm0               \n"
+  "pshufd     $0x8,%%xmm0,%%xmm0               \n"
+  "pshuflw    $0x8,%%xmm1,%%xmm1               \n"
+  "pshufhw    $0x8,%%xmm1,%%xmm1               \n"
+  "pshufd     $0x8,%%xmm1,%%xmm1               \n"
+  "punpcklqdq %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1"
+#endif
+);
+}
+
+static void ScaleRowDown2Int_16_SSE2(const uint16* src_ptr, int src_stride,
+                                     uint16* dst_ptr, int dst_width) {
+  asm volatile (
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "movdqa     (%0,%3,2),%%xmm2                 \n"
+  "movdqa     0x10(%0,%3,2),%%xmm3             \n"
+  "lea        0x20(%0),%0                      \n"
+  "pavgw      %%xmm2,%%xmm0                    \n"
+  "pavgw      %%xmm3,%%xmm1                    \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "movdqa     %%xmm1,%%xmm3                    \n"
+  "psrld      $0x10,%%xmm2                     \n"
+  "psrld      $0x10,%%xmm3                     \n"
+  "pavgw      %%xmm2,%%xmm0                    \n"
+  "pavgw      %%xmm3,%%xmm1                    \n"
+  "pshuflw    $0x8,%%xmm0,%%xmm0               \n"
+  "pshufhw    $0x8,%%xmm0,%%xmm0               \n"
+  "pshufd     $0x8,%%xmm0,%%xmm0               \n"
+  "pshuflw    $0x8,%%xmm1,%%xmm1               \n"
+  "pshufhw    $0x8,%%xmm1,%%xmm1               \n"
+  "pshufd     $0x8,%%xmm1,%%xmm1               \n"
+  "punpcklqdq %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride))   // %3
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3"
+#endif
+);
+}
+
+#define HAS_SCALEFILTERROWS_16_SSE2
+static void ScaleFilterRows_16_SSE2(uint16* dst_ptr, const uint16* src_ptr,
+                                    int src_stride, int dst_width,
+                                    int source_y_fraction) {
+  asm volatile (
+  "movd       %4,%%xmm6                        \n"
+  "punpcklwd  %%xmm6,%%xmm6                    \n"
+  "pshufd     $0x0,%%xmm6,%%xmm6               \n"
+  "pxor       %%xmm5,%%xmm5                    \n"
+  "psubw      %%xmm6,%%xmm5                    \n"
+  "pcmpeqb    %%xmm7,%%xmm7                    \n"
+"1:"
+  "movdqa     (%1),%%xmm0                      \n"
+  "movdqa     (%1,%3,2),%%xmm1                 \n"
+  "lea        0x10(%1),%1                      \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "movdqa     %%xmm1,%%xmm3                    \n"
+  "pmulhuw    %%xmm5,%%xmm0                    \n"
+  "pmulhuw    %%xmm6,%%xmm1                    \n"
+  "pmullw     %%xmm5,%%xmm2                    \n"
+  "pmullw     %%xmm6,%%xmm3                    \n"
+  "paddw      %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm2,%%xmm1                    \n"
+  "paddusw    %%xmm3,%%xmm1                    \n"
+  "paddw      %%xmm3,%%xmm2                    \n"
+  "pcmpeqw    %%xmm2,%%xmm1                    \n"
+  "pxor       %%xmm7,%%xmm1                    \n"
+  "psubw      %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%0)                      \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(source_y_fraction << 8)              // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "xmm6", "xmm7"
+#endif
+);
+}
+
+#define HAS_SCALEADDROWS_16_SSE2
+static void ScaleAddRows_16_SSE2(const uint16* src_ptr, int src_stride,
+                                 uint32* dst_sum, int src_width,
+                                 int src_height) {
+  intptr_t x = 0;
+  asm volatile (
+  "pxor       %%xmm7,%%xmm7                    \n"
+"1:"
+  "movdqa     (%0,%2,2),%%xmm0                 \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "punpcklwd  %%xmm7,%%xmm0                    \n"
+  "punpckhwd  %%xmm7,%%xmm1                    \n"
+  "movdqa     %%xmm0,(%1,%2,4)                 \n"
+  "movdqa     %%xmm1,0x10(%1,%2,4)             \n"
+  "add        $0x8,%2                          \n"
+  "cmp        %5,%2                            \n"
+  "jb         1b                               \n"
+"2:"
+  "subl       $0x1,%3                          \n"
+  "jbe        4f                               \n"
+  "lea        (%0,%4,2),%0                     \n"
+  "xor        %2,%2                            \n"
+"3:"
+  "movdqa     (%0,%2,2),%%xmm0                 \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "punpcklwd  %%xmm7,%%xmm0                    \n"
+  "punpckhwd  %%xmm7,%%xmm1                    \n"
+  "paddd      (%1,%2,4),%%xmm0                 \n"
+  "paddd      0x10(%1,%2,4),%%xmm1             \n"
+  "movdqa     %%xmm0,(%1,%2,4)                 \n"
+  "movdqa     %%xmm1,0x10(%1,%2,4)             \n"
+  "add        $0x8,%2                          \n"
+  "cmp        %5,%2                            \n"
+  "jb         3b                               \n"
+  "jmp        2b                               \n"
+"4:"
+  : "+r"(src_ptr),     // %0
+    "+r"(dst_sum),     // %1
+    "+r"(x),           // %2
+    "+rm"(src_height)  // %3
+  : "r"(static_cast<intptr_t>(src_stride)),  // %4
+    "rm"(static_cast<intptr_t>(src_width))   // %5
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm7"
+#endif
+);
+}
+
+#endif
+
+static void ScaleRowDown2_16_C(const uint16* src_ptr, int,
+                               uint16* dst, int dst_width) {
+  for (int x = 0; x < dst_width; ++x) {
+    dst[x] = src_ptr[x * 2];
+  }
+}
+
+static void ScaleRowDown2Int_16_C(const uint16* src_ptr, int src_stride,
+                                  uint16* dst, int dst_width) {
+  const uint16* s = src_ptr;
+  const uint16* t = src_ptr + src_stride;
+  for (int x = 0; x < dst_width; ++x) {
+    dst[x] = (s[0] + s[1] + t[0] + t[1] + 2) >> 2;
+    s += 2;
+    t += 2;
+  }
+}
+
+static void ScaleFilterRows_16_C(uint16* dst_ptr, const uint16* src_ptr,
+                                 int src_stride, int dst_width,
+                                 int source_y_fraction) {
+  assert(dst_width > 0);
+  uint32 y1_fraction = source_y_fraction;
+  uint32 y0_fraction = 256 - y1_fraction;
+  const uint16* src_ptr1 = src_ptr + src_stride;
+  for (int x = 0; x < dst_width; ++x) {
+    dst_ptr[x] = static_cast<uint16>((src_ptr[x] * y0_fraction +
+                                      src_ptr1[x] * y1_fraction) >> 8);
+  }
+}
+
+static void ScaleFilterCols_16_C(uint16* dst_ptr, const uint16* src_ptr,
+                                 int dst_width, int x, int dx) {
+  for (int j = 0; j < dst_width; ++j) {
+    const uint16* src = src_ptr + (x >> 16);
+    uint32 f = (x >> 8) & 255;
+    dst_ptr[j] = static_cast<uint16>((src[0] * (256 - f) + src[1] * f) >> 8);
+    x += dx;
+  }
+}
+
+static void ScaleCols_16_C(uint16* dst_ptr, const uint16* src_ptr,
+                           int dst_width, int x, int dx) {
+  for (int j = 0; j < dst_width; ++j) {
+    dst_ptr[j] = src_ptr[x >> 16];
+    x += dx;
+  }
+}
+
+// Sums src_height rows of src_width samples into 32 bit sums.
+static void ScaleAddRows_16_C(const uint16* src_ptr, int src_stride,
+                              uint32* dst_sum, int src_width,
+                              int src_height) {
+  assert(src_height > 0);
+  for (int x = 0; x < src_width; ++x) {
+    const uint16* s = src_ptr + x;
+    uint32 sum = 0u;
+    for (int y = 0; y < src_height; ++y) {
+      sum += s[0];
+      s += src_stride;
+    }
+    dst_sum[x] = sum;
+  }
+}
+
+// A box of more than 65537 samples may overflow 32 bits, so boxes are
+// summed in 64 bits.
+static void ScaleAddCols_16_C(int dst_width, int boxheight, int dx,
+                              const uint32* src_sum, uint16* dst_ptr) {
+  int x = 0;
+  for (int i = 0; i < dst_width; ++i) {
+    int ix = x >> 16;
+    x += dx;
+    int boxwidth = (x >> 16) - ix;
+    uint64 sum = 0u;
+    for (int k = 0; k < boxwidth; ++k) {
+      sum += src_sum[ix + k];
+    }
+    dst_ptr[i] = static_cast<uint16>(sum / (boxwidth * boxheight));
+  }
+}
+
+/**
+ * Scale plane, 1/2
+ *
+ * This is an optimized version for scaling down a plane to 1/2 of
+ * its original size.
+ */
+static void ScalePlaneDown2_16(int src_width, int src_height,
+                               int dst_width, int dst_height,
+                               int src_stride, int dst_stride,
+                               const uint16* src_ptr, uint16* dst_ptr,
+                               FilterMode filtering) {
+  assert(src_width == dst_width * 2);
+  assert(src_height == dst_height * 2);
+  void (*ScaleRowDown2)(const uint16* src_ptr, int src_stride,
+                        uint16* dst_ptr, int dst_width);
+#if defined(HAS_SCALEROWDOWN2_16_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (dst_width % 8 == 0) && (src_stride % 8 == 0) &&
+      (dst_stride % 8 == 0) &&
+      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 16)) {
+    ScaleRowDown2 = filtering ? ScaleRowDown2Int_16_SSE2 :
+        ScaleRowDown2_16_SSE2;
+  } else
+#endif
+  {
+    ScaleRowDown2 = filtering ? ScaleRowDown2Int_16_C : ScaleRowDown2_16_C;
+  }
+
+  for (int y = 0; y < dst_height; ++y) {
+    ScaleRowDown2(src_ptr, src_stride, dst_ptr, dst_width);
+    src_ptr += (src_stride << 1);
+    dst_ptr += dst_stride;
+  }
+}
+
+/**
+ * Scale plane down to any dimensions, with a box filter.
+ *
+ * Each output row sums the source rows of its box into 32 bit column
+ * sums, which are then summed across the width of each box.
+ */
+static void ScalePlaneBox_16(int src_width, int src_height,
+                             int dst_width, int dst_height,
+                             int src_stride, int dst_stride,
+                             const uint16* src_ptr, uint16* dst_ptr) {
+  assert(dst_width * 2 <= src_width);
+  assert(dst_height * 2 <= src_height);
+  int dx = (src_width << 16) / dst_width;
+  int dy = (src_height << 16) / dst_height;
+  void (*ScaleAddRows)(const uint16* src_ptr, int src_stride,
+                       uint32* dst_sum, int src_width, int src_height);
+#if defined(HAS_SCALEADDROWS_16_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (src_width % 8 == 0) && (src_stride % 8 == 0) &&
+      IS_ALIGNED(src_ptr, 16)) {
+    ScaleAddRows = ScaleAddRows_16_SSE2;
+  } else
+#endif
+  {
+    ScaleAddRows = ScaleAddRows_16_C;
+  }
+
+  uint8* row_mem = new uint8[src_width * 4 + 15];
+  uint32* row = reinterpret_cast<uint32*>(ALIGNP(row_mem, 16));
+  int y = 0;
+  for (int j = 0; j < dst_height; ++j) {
+    int iy = y >> 16;
+    const uint16* const src = src_ptr + iy * src_stride;
+    y += dy;
+    if (y > (src_height << 16)) {
+      y = (src_height << 16);
+    }
+    int boxheight = (y >> 16) - iy;
+    ScaleAddRows(src, src_stride, row, src_width, boxheight);
+    ScaleAddCols_16_C(dst_width, boxheight, dx, row, dst_ptr);
+    dst_ptr += dst_stride;
+  }
+  delete[] row_mem;
+}
+
+/**
+ * Scale plane to/from any dimensions, with bilinear interpolation.
+ *
+ * Each output row blends 2 source rows into a row buffer, which is then
+ * filtered horizontally with a 16.16 fixed point step.
+ */
+static void ScalePlaneBilinear_16(int src_width, int src_height,
+                                  int dst_width, int dst_height,
+                                  int src_stride, int dst_stride,
+                                  const uint16* src_ptr, uint16* dst_ptr) {
+  assert(dst_width > 0);
+  assert(dst_height > 0);
+  int dx = (src_width << 16) / dst_width;
+  int dy = (src_height << 16) / dst_height;
+  void (*ScaleFilterRows)(uint16* dst_ptr, const uint16* src_ptr,
+                          int src_stride,
+                          int dst_width, int source_y_fraction);
+#if defined(HAS_SCALEFILTERROWS_16_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (src_stride % 8 == 0) && IS_ALIGNED(src_ptr, 16) &&
+      (src_width % 8 == 0)) {
+    ScaleFilterRows = ScaleFilterRows_16_SSE2;
+  } else
+#endif
+  {
+    ScaleFilterRows = ScaleFilterRows_16_C;
+  }
+
+  // The row has one extra sample, a copy of the last, for the column
+  // filter.
+  uint8* row_mem = new uint8[(src_width + 1) * 2 + 15];
+  uint16* row = reinterpret_cast<uint16*>(ALIGNP(row_mem, 16));
+  // A single source row is blended with itself.
+  const int row_stride = (src_height > 1) ? src_stride : 0;
+  const int maxy = (src_height > 1) ? ((src_height - 1) << 16) - 1 : 0;
+  int y = 0;
+  for (int j = 0; j < dst_height; ++j) {
+    int iy = y >> 16;
+    int fy = (y >> 8) & 255;
+    const uint16* const src = src_ptr + iy * src_stride;
+    if (fy == 0) {
+      memcpy(row, src, src_width * 2);
+    } else {
+      ScaleFilterRows(row, src, row_stride, src_width, fy);
+    }
+    row[src_width] = row[src_width - 1];
+    ScaleFilterCols_16_C(dst_ptr, row, dst_width, 0, dx);
+    dst_ptr += dst_stride;
+    y += dy;
+    if (y > maxy) {
+      y = maxy;
+    }
+  }
+  delete[] row_mem;
+}
+
+/**
+ * Scale plane to/from any dimensions, without interpolation.
+ */
+static void ScalePlaneSimple_16(int src_width, int src_height,
+                                int dst_width, int dst_height,
+                                int src_stride, int dst_stride,
+                                const uint16* src_ptr, uint16* dst_ptr) {
+  int dx = (src_width << 16) / dst_width;
+  for (int y = 0; y < dst_height; ++y) {
+    int iy = static_cast<int>(static_cast<int64>(y) * src_height /
+                              dst_height);
+    ScaleCols_16_C(dst_ptr, src_ptr + iy * src_stride, dst_width, 0, dx);
+    dst_ptr += dst_stride;
+  }
+}
+
+static void CopyPlane_16(int width, int height,
+                         int src_stride, int dst_stride,
+                         const uint16* src_ptr, uint16* dst_ptr) {
+  for (int y = 0; y < height; ++y) {
+    memcpy(dst_ptr, src_ptr, width * 2);
+    src_ptr += src_stride;
+    dst_ptr += dst_stride;
+  }
+}
+
+void ScalePlane_16(const uint16* src, int src_stride,
+                   int src_width, int src_height,
+                   uint16* dst, int dst_stride,
+                   int dst_width, int dst_height,
+                   FilterMode filtering) {
+  if (dst_width == src_width && dst_height == src_height) {
+    // Straight copy.
+    CopyPlane_16(src_width, src_height, src_stride, dst_stride, src, dst);
+  } else if (2 * dst_width == src_width && 2 * dst_height == src_height) {
+    // optimized, 1/2
+    ScalePlaneDown2_16(src_width, src_height, dst_width, dst_height,
+                       src_stride, dst_stride, src, dst, filtering);
+  } else if (!filtering) {
+    ScalePlaneSimple_16(src_width, src_height, dst_width, dst_height,
+                        src_stride, dst_stride, src, dst);
+  } else if (filtering >= kFilterBox &&
+             dst_width * 2 <= src_width && dst_height * 2 <= src_height) {
+    ScalePlaneBox_16(src_width, src_height, dst_width, dst_height,
+                     src_stride, dst_stride, src, dst);
+  } else {
+    ScalePlaneBilinear_16(src_width, src_height, dst_width, dst_height,
+                          src_stride, dst_stride, src, dst);
+  }
+}
+
+int I420Scale_16(const uint16* src_y, int src_stride_y,
+                 const uint16* src_u, int src_stride_u,
+                 const uint16* src_v, int src_stride_v,
+                 int src_width, int src_height,
+                 uint16* dst_y, int dst_stride_y,
+                 uint16* dst_u, int dst_stride_u,
+                 uint16* dst_v, int dst_stride_v,
+                 int dst_width, int dst_height,
+                 FilterMode filtering) {
+  if (!src_y || !src_u || !src_v || src_width <= 0 || src_height == 0 ||
+      !dst_y || !dst_u || !dst_v || dst_width <= 0 || dst_height <= 0) {
+    return -1;
+  }
+  // Negative height means invert the image.
+  if (src_height < 0) {
+    src_height = -src_height;
+    int halfheight = (src_height + 1) >> 1;
+    src_y = src_y + (src_height - 1) * src_stride_y;
+    src_u = src_u + (halfheight - 1) * src_stride_u;
+    src_v = src_v + (halfheight - 1) * src_stride_v;
+    src_stride_y = -src_stride_y;
+    src_stride_u = -src_stride_u;
+    src_stride_v = -src_stride_v;
+  }
+  int halfsrc_width = (src_width + 1) >> 1;
+  int halfsrc_height = (src_height + 1) >> 1;
+  int halfdst_width = (dst_width + 1) >> 1;
+  int halfoheight = (dst_height + 1) >> 1;
+
+  ScalePlane_16(src_y, src_stride_y, src_width, src_height,
+                dst_y, dst_stride_y, dst_width, dst_height,
+                filtering);
+  ScalePlane_16(src_u, src_stride_u, halfsrc_width, halfsrc_height,
+                dst_u, dst_stride_u, halfdst_width, halfoheight,
+                filtering);
+  ScalePlane_16(src_v, src_stride_v, halfsrc_width, halfsrc_height,
+                dst_v, dst_stride_v, halfdst_width, halfoheight,
+                filtering);
+  return 0;
+}
+
+}  // namespace libyuv
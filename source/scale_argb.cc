@@ -0,0 +1,656 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "libyuv/scale_argb.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "libyuv/cpu_id.h"
+
+namespace libyuv {
+
+// ARGB scaling works on 4 byte pixels.  The row functions follow the
+// planar versions in scale.cc, with dst_width counted in pixels.
+
+#if defined(WIN32) && !defined(COVERAGE_ENABLED)
+
+#define HAS_SCALEARGBROWDOWN2_SSE2
+// Reads 8 pixels, throws half away and writes 4 pixels.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleARGBRowDown2_SSE2(const uint8* src_ptr, int src_stride,
+                                   uint8* dst_ptr, int dst_width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+                                     // src_stride ignored
+    mov        edx, [esp + 12]       // dst_ptr
+    mov        ecx, [esp + 16]       // dst_width
+
+  wloop:
+    movdqa     xmm0, [eax]
+    movdqa     xmm1, [eax + 16]
+    lea        eax,  [eax + 32]
+    shufps     xmm0, xmm1, 0x88
+    movdqa     [edx], xmm0
+    lea        edx, [edx + 16]
+    sub        ecx, 4
+    ja         wloop
+
+    ret
+  }
+}
+
+// Blends 8x2 rectangle to 4x1.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleARGBRowDown2Int_SSE2(const uint8* src_ptr, int src_stride,
+                                      uint8* dst_ptr, int dst_width) {
+  __asm {
+    push       esi
+    mov        eax, [esp + 4 + 4]    // src_ptr
+    mov        esi, [esp + 4 + 8]    // src_stride
+    mov        edx, [esp + 4 + 12]   // dst_ptr
+    mov        ecx, [esp + 4 + 16]   // dst_width
+
+  wloop:
+    movdqa     xmm0, [eax]
+    movdqa     xmm1, [eax + 16]
+    movdqa     xmm2, [eax + esi]
+    movdqa     xmm3, [eax + esi + 16]
+    lea        eax,  [eax + 32]
+    pavgb      xmm0, xmm2            // average rows
+    pavgb      xmm1, xmm3
+    movdqa     xmm2, xmm0            // average columns (8 to 4 pixels)
+    shufps     xmm0, xmm1, 0x88      // even pixels
+    shufps     xmm2, xmm1, 0xdd      // odd pixels
+    pavgb      xmm0, xmm2
+    movdqa     [edx], xmm0
+    lea        edx, [edx + 16]
+    sub        ecx, 4
+    ja         wloop
+
+    pop        esi
+    ret
+  }
+}
+
+#define HAS_SCALEARGBFILTERROWS_SSE2
+// Blend 2 rows as (row0 * (256 - f) + row1 * f) >> 8, 4 pixels at a time.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleARGBFilterRows_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                     int src_stride, int dst_width,
+                                     int source_y_fraction) {
+  __asm {
+    push       esi
+    push       edi
+    mov        edi, [esp + 8 + 4]   // dst_ptr
+    mov        esi, [esp + 8 + 8]   // src_ptr
+    mov        edx, [esp + 8 + 12]  // src_stride
+    mov        ecx, [esp + 8 + 16]  // dst_width
+    mov        eax, [esp + 8 + 20]  // source_y_fraction (0..255)
+    movd       xmm6, eax
+    punpcklwd  xmm6, xmm6
+    pshufd     xmm6, xmm6, 0
+    pcmpeqb    xmm5, xmm5           // generate 256 - source_y_fraction
+    psrlw      xmm5, 15
+    psllw      xmm5, 8
+    psubw      xmm5, xmm6
+    pxor       xmm7, xmm7
+
+  wloop:
+    movdqa     xmm0, [esi]
+    movdqa     xmm2, [esi + edx]
+    lea        esi,  [esi + 16]
+    movdqa     xmm1, xmm0
+    movdqa     xmm3, xmm2
+    punpcklbw  xmm0, xmm7
+    punpcklbw  xmm2, xmm7
+    punpckhbw  xmm1, xmm7
+    punpckhbw  xmm3, xmm7
+    pmullw     xmm0, xmm5
+    pmullw     xmm1, xmm5
+    pmullw     xmm2, xmm6
+    pmullw     xmm3, xmm6
+    paddw      xmm0, xmm2
+    paddw      xmm1, xmm3
+    psrlw      xmm0, 8
+    psrlw      xmm1, 8
+    packuswb   xmm0, xmm1
+    movdqa     [edi], xmm0
+    lea        edi,  [edi + 16]
+    sub        ecx, 4
+    ja         wloop
+
+    pop        edi
+    pop        esi
+    ret
+  }
+}
+
+#define HAS_SCALEARGBFILTERCOLS_SSE2
+// Bilinear filter 2 pixels at a time, with a 7 bit fraction:
+// a + (((b - a) * f) >> 7)
+// The source row must have one pixel past the last pixel read at x.
+__declspec(naked)
+static void ScaleARGBFilterCols_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                     int dst_width, int x, int dx) {
+  __asm {
+    push       ebx
+    push       esi
+    push       edi
+    push       ebp
+    mov        edi, [esp + 16 + 4]  // dst_ptr
+    mov        esi, [esp + 16 + 8]  // src_ptr
+    mov        ecx, [esp + 16 + 12] // dst_width
+    mov        ebx, [esp + 16 + 16] // x
+    mov        ebp, [esp + 16 + 20] // dx
+    pxor       xmm7, xmm7
+
+  wloop:
+    mov        eax, ebx
+    shr        eax, 16
+    movd       xmm0, [esi + eax * 4]
+    movd       xmm2, [esi + eax * 4 + 4]
+    movd       xmm4, ebx
+    add        ebx, ebp
+    mov        eax, ebx
+    shr        eax, 16
+    movd       xmm1, [esi + eax * 4]
+    movd       xmm3, [esi + eax * 4 + 4]
+    movd       xmm5, ebx
+    add        ebx, ebp
+    pshuflw    xmm4, xmm4, 0        // fraction in 4 words
+    pshuflw    xmm5, xmm5, 0
+    psrlw      xmm4, 9
+    psrlw      xmm5, 9
+    punpcklbw  xmm0, xmm7
+    punpcklbw  xmm2, xmm7
+    punpcklbw  xmm1, xmm7
+    punpcklbw  xmm3, xmm7
+    psubw      xmm2, xmm0
+    psubw      xmm3, xmm1
+    pmullw     xmm2, xmm4
+    pmullw     xmm3, xmm5
+    psraw      xmm2, 7
+    psraw      xmm3, 7
+    paddw      xmm0, xmm2
+    paddw      xmm1, xmm3
+    punpcklqdq xmm0, xmm1
+    packuswb   xmm0, xmm0
+    movq       qword ptr [edi], xmm0
+    lea        edi,  [edi + 8]
+    sub        ecx, 2
+    ja         wloop
+
+    pop        ebp
+    pop        edi
+    pop        esi
+    pop        ebx
+    ret
+  }
+}
+
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+
+#define HAS_SCALEARGBROWDOWN2_SSE2
+static void ScaleARGBRowDown2_SSE2(const uint8* src_ptr, int src_stride,
+                                   uint8* dst_ptr, int dst_width) {
+  asm volatile (
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "shufps     $0x88,%%xmm1,%%xmm0              \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1"
+#endif
+);
+}
+
+static void ScaleARGBRowDown2Int_SSE2(const uint8* src_ptr, int src_stride,
+                                      uint8* dst_ptr, int dst_width) {
+  asm volatile (
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "movdqa     (%0,%3,1),%%xmm2                 \n"
+  "movdqa     0x10(%0,%3,1),%%xmm3             \n"
+  "lea        0x20(%0),%0                      \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "pavgb      %%xmm3,%%xmm1                    \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "shufps     $0x88,%%xmm1,%%xmm0              \n"
+  "shufps     $0xdd,%%xmm1,%%xmm2              \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride))   // %3
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3"
+#endif
+);
+}
+
+#define HAS_SCALEARGBFILTERROWS_SSE2
+static void ScaleARGBFilterRows_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                     int src_stride, int dst_width,
+                                     int source_y_fraction) {
+  asm volatile (
+  "movd       %4,%%xmm6                        \n"
+  "punpcklwd  %%xmm6,%%xmm6                    \n"
+  "pshufd     $0x0,%%xmm6,%%xmm6               \n"
+  "pcmpeqb    %%xmm5,%%xmm5                    \n"
+  "psrlw      $0xf,%%xmm5                      \n"
+  "psllw      $0x8,%%xmm5                      \n"
+  "psubw      %%xmm6,%%xmm5                    \n"
+  "pxor       %%xmm7,%%xmm7                    \n"
+"1:"
+  "movdqa     (%1),%%xmm0                      \n"
+  "movdqa     (%1,%3,1),%%xmm2                 \n"
+  "lea        0x10(%1),%1                      \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "movdqa     %%xmm2,%%xmm3                    \n"
+  "punpcklbw  %%xmm7,%%xmm0                    \n"
+  "punpcklbw  %%xmm7,%%xmm2                    \n"
+  "punpckhbw  %%xmm7,%%xmm1                    \n"
+  "punpckhbw  %%xmm7,%%xmm3                    \n"
+  "pmullw     %%xmm5,%%xmm0                    \n"
+  "pmullw     %%xmm5,%%xmm1                    \n"
+  "pmullw     %%xmm6,%%xmm2                    \n"
+  "pmullw     %%xmm6,%%xmm3                    \n"
+  "paddw      %%xmm2,%%xmm0                    \n"
+  "paddw      %%xmm3,%%xmm1                    \n"
+  "psrlw      $0x8,%%xmm0                      \n"
+  "psrlw      $0x8,%%xmm1                      \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%0)                      \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x4,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(source_y_fraction)                   // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "xmm6", "xmm7"
+#endif
+);
+}
+
+#define HAS_SCALEARGBFILTERCOLS_SSE2
+static void ScaleARGBFilterCols_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                     int dst_width, int x, int dx) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pxor       %%xmm7,%%xmm7                    \n"
+"1:"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movd       (%1,%4,4),%%xmm0                 \n"
+  "movd       0x4(%1,%4,4),%%xmm2              \n"
+  "movd       %3,%%xmm4                        \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movd       (%1,%4,4),%%xmm1                 \n"
+  "movd       0x4(%1,%4,4),%%xmm3              \n"
+  "movd       %3,%%xmm5                        \n"
+  "add        %5,%3                            \n"
+  "pshuflw    $0x0,%%xmm4,%%xmm4               \n"
+  "pshuflw    $0x0,%%xmm5,%%xmm5               \n"
+  "psrlw      $0x9,%%xmm4                      \n"
+  "psrlw      $0x9,%%xmm5                      \n"
+  "punpcklbw  %%xmm7,%%xmm0                    \n"
+  "punpcklbw  %%xmm7,%%xmm2                    \n"
+  "punpcklbw  %%xmm7,%%xmm1                    \n"
+  "punpcklbw  %%xmm7,%%xmm3                    \n"
+  "psubw      %%xmm0,%%xmm2                    \n"
+  "psubw      %%xmm1,%%xmm3                    \n"
+  "pmullw     %%xmm4,%%xmm2                    \n"
+  "pmullw     %%xmm5,%%xmm3                    \n"
+  "psraw      $0x7,%%xmm2                      \n"
+  "psraw      $0x7,%%xmm3                      \n"
+  "paddw      %%xmm2,%%xmm0                    \n"
+  "paddw      %%xmm3,%%xmm1                    \n"
+  "punpcklqdq %%xmm1,%%xmm0                    \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movq       %%xmm0,(%0)                      \n"
+  "lea        0x8(%0),%0                       \n"
+  "sub        $0x2,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width),   // %2
+    "+r"(x),           // %3
+    "+r"(temp)         // %4
+  : "r"(dx)            // %5
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm7"
+#endif
+);
+}
+
+#endif
+
+static void ScaleARGBRowDown2_C(const uint8* src_ptr, int,
+                                uint8* dst_ptr, int dst_width) {
+  const uint32* src = reinterpret_cast<const uint32*>(src_ptr);
+  uint32* dst = reinterpret_cast<uint32*>(dst_ptr);
+  for (int x = 0; x < dst_width; ++x) {
+    dst[x] = src[x * 2];
+  }
+}
+
+static void ScaleARGBRowDown2Int_C(const uint8* src_ptr, int src_stride,
+                                   uint8* dst_ptr, int dst_width) {
+  for (int x = 0; x < dst_width; ++x) {
+    for (int c = 0; c < 4; ++c) {
+      dst_ptr[c] = (src_ptr[c] + src_ptr[c + 4] +
+                    src_ptr[src_stride + c] +
+                    src_ptr[src_stride + c + 4] + 2) >> 2;
+    }
+    src_ptr += 8;
+    dst_ptr += 4;
+  }
+}
+
+static void ScaleARGBFilterRows_C(uint8* dst_ptr, const uint8* src_ptr,
+                                  int src_stride, int dst_width,
+                                  int source_y_fraction) {
+  assert(dst_width > 0);
+  int y1_fraction = source_y_fraction;
+  int y0_fraction = 256 - y1_fraction;
+  const uint8* src_ptr1 = src_ptr + src_stride;
+  for (int x = 0; x < dst_width * 4; ++x) {
+    dst_ptr[x] = (src_ptr[x] * y0_fraction + src_ptr1[x] * y1_fraction) >> 8;
+  }
+}
+
+static void ScaleARGBFilterCols_C(uint8* dst_ptr, const uint8* src_ptr,
+                                  int dst_width, int x, int dx) {
+  for (int j = 0; j < dst_width; ++j) {
+    const uint8* src = src_ptr + (x >> 16) * 4;
+    int f = (x >> 9) & 0x7f;
+    for (int c = 0; c < 4; ++c) {
+      dst_ptr[c] = src[c] + (((src[c + 4] - src[c]) * f) >> 7);
+    }
+    dst_ptr += 4;
+    x += dx;
+  }
+}
+
+static void ScaleARGBCols_C(uint8* dst_ptr, const uint8* src_ptr,
+                            int dst_width, int x, int dx) {
+  const uint32* src = reinterpret_cast<const uint32*>(src_ptr);
+  uint32* dst = reinterpret_cast<uint32*>(dst_ptr);
+  for (int j = 0; j < dst_width; ++j) {
+    dst[j] = src[x >> 16];
+    x += dx;
+  }
+}
+
+// Sums src_height rows of src_width pixels into 32 bit sums per channel.
+static void ScaleARGBAddRows_C(const uint8* src_ptr, int src_stride,
+                               uint32* dst_sum, int src_width,
+                               int src_height) {
+  assert(src_height > 0);
+  for (int x = 0; x < src_width * 4; ++x) {
+    const uint8* s = src_ptr + x;
+    uint32 sum = 0u;
+    for (int y = 0; y < src_height; ++y) {
+      sum += s[0];
+      s += src_stride;
+    }
+    dst_sum[x] = sum;
+  }
+}
+
+static void ScaleARGBAddCols_C(int dst_width, int boxheight, int dx,
+                               const uint32* src_sum, uint8* dst_ptr) {
+  int x = 0;
+  for (int i = 0; i < dst_width; ++i) {
+    int ix = x >> 16;
+    x += dx;
+    int boxwidth = (x >> 16) - ix;
+    int area = boxwidth * boxheight;
+    for (int c = 0; c < 4; ++c) {
+      uint32 sum = 0u;
+      for (int k = 0; k < boxwidth; ++k) {
+        sum += src_sum[(ix + k) * 4 + c];
+      }
+      dst_ptr[c] = sum / area;
+    }
+    dst_ptr += 4;
+  }
+}
+
+/**
+ * Scale ARGB, 1/2
+ *
+ * This is an optimized version for scaling down an ARGB image to 1/2 of
+ * its original size.
+ */
+static void ScaleARGBDown2(int src_width, int src_height,
+                           int dst_width, int dst_height,
+                           int src_stride, int dst_stride,
+                           const uint8* src_ptr, uint8* dst_ptr,
+                           FilterMode filtering) {
+  assert(src_width == dst_width * 2);
+  assert(src_height == dst_height * 2);
+  void (*ScaleARGBRowDown2)(const uint8* src_ptr, int src_stride,
+                            uint8* dst_ptr, int dst_width);
+#if defined(HAS_SCALEARGBROWDOWN2_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (dst_width % 4 == 0) && (src_stride % 16 == 0) &&
+      (dst_stride % 16 == 0) &&
+      IS_ALIGNED(src_ptr, 16) && IS_ALIGNED(dst_ptr, 16)) {
+    ScaleARGBRowDown2 = filtering ? ScaleARGBRowDown2Int_SSE2 :
+        ScaleARGBRowDown2_SSE2;
+  } else
+#endif
+  {
+    ScaleARGBRowDown2 = filtering ? ScaleARGBRowDown2Int_C :
+        ScaleARGBRowDown2_C;
+  }
+
+  for (int y = 0; y < dst_height; ++y) {
+    ScaleARGBRowDown2(src_ptr, src_stride, dst_ptr, dst_width);
+    src_ptr += (src_stride << 1);
+    dst_ptr += dst_stride;
+  }
+}
+
+/**
+ * Scale ARGB down to any dimensions, with a box filter.
+ *
+ * Same stepping as ScalePlaneBox: each output pixel is the average of a
+ * box of source pixels.  The rows of a box are summed once into a row of
+ * 32 bit sums per channel, which are then summed across each box.
+ */
+static void ScaleARGBBox(int src_width, int src_height,
+                         int dst_width, int dst_height,
+                         int src_stride, int dst_stride,
+                         const uint8* src_ptr, uint8* dst_ptr) {
+  assert(dst_width * 2 <= src_width);
+  assert(dst_height * 2 <= src_height);
+  int dx = (src_width << 16) / dst_width;
+  int dy = (src_height << 16) / dst_height;
+  uint32* row = new uint32[src_width * 4];
+  int y = 0;
+  for (int j = 0; j < dst_height; ++j) {
+    int iy = y >> 16;
+    const uint8* const src = src_ptr + iy * src_stride;
+    y += dy;
+    if (y > (src_height << 16)) {
+      y = (src_height << 16);
+    }
+    int boxheight = (y >> 16) - iy;
+    ScaleARGBAddRows_C(src, src_stride, row, src_width, boxheight);
+    ScaleARGBAddCols_C(dst_width, boxheight, dx, row, dst_ptr);
+    dst_ptr += dst_stride;
+  }
+  delete[] row;
+}
+
+/**
+ * Scale ARGB to/from any dimensions, with bilinear interpolation.
+ *
+ * Each output row blends 2 source rows into a row buffer, which is then
+ * filtered horizontally with a 16.16 fixed point step.
+ */
+static void ScaleARGBBilinear(int src_width, int src_height,
+                              int dst_width, int dst_height,
+                              int src_stride, int dst_stride,
+                              const uint8* src_ptr, uint8* dst_ptr) {
+  assert(dst_width > 0);
+  assert(dst_height > 0);
+  int dx = (src_width << 16) / dst_width;
+  int dy = (src_height << 16) / dst_height;
+  void (*ScaleARGBFilterRows)(uint8* dst_ptr, const uint8* src_ptr,
+                              int src_stride,
+                              int dst_width, int source_y_fraction);
+  void (*ScaleARGBFilterCols)(uint8* dst_ptr, const uint8* src_ptr,
+                              int dst_width, int x, int dx);
+#if defined(HAS_SCALEARGBFILTERROWS_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (src_stride % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
+      (src_width % 4 == 0)) {
+    ScaleARGBFilterRows = ScaleARGBFilterRows_SSE2;
+  } else
+#endif
+  {
+    ScaleARGBFilterRows = ScaleARGBFilterRows_C;
+  }
+#if defined(HAS_SCALEARGBFILTERCOLS_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && (dst_width % 2 == 0)) {
+    ScaleARGBFilterCols = ScaleARGBFilterCols_SSE2;
+  } else
+#endif
+  {
+    ScaleARGBFilterCols = ScaleARGBFilterCols_C;
+  }
+
+  // The row has one extra pixel, a copy of the last, for the column filter.
+  uint8* row_mem = new uint8[(src_width + 1) * 4 + 15];
+  uint8* row = ALIGNP(row_mem, 16);
+  // A single source row is blended with itself.
+  const int row_stride = (src_height > 1) ? src_stride : 0;
+  const int maxy = (src_height > 1) ? ((src_height - 1) << 16) - 1 : 0;
+  int y = 0;
+  for (int j = 0; j < dst_height; ++j) {
+    int iy = y >> 16;
+    int fy = (y >> 8) & 255;
+    ScaleARGBFilterRows(row, src_ptr + iy * src_stride, row_stride,
+                        src_width, fy);
+    memcpy(row + src_width * 4, row + src_width * 4 - 4, 4);
+    ScaleARGBFilterCols(dst_ptr, row, dst_width, 0, dx);
+    dst_ptr += dst_stride;
+    y += dy;
+    if (y > maxy) {
+      y = maxy;
+    }
+  }
+  delete[] row_mem;
+}
+
+/**
+ * Scale ARGB to/from any dimensions, without interpolation.
+ */
+static void ScaleARGBSimple(int src_width, int src_height,
+                            int dst_width, int dst_height,
+                            int src_stride, int dst_stride,
+                            const uint8* src_ptr, uint8* dst_ptr) {
+  int dx = (src_width << 16) / dst_width;
+  for (int y = 0; y < dst_height; ++y) {
+    int iy = static_cast<int>(static_cast<int64>(y) * src_height /
+                              dst_height);
+    ScaleARGBCols_C(dst_ptr, src_ptr + iy * src_stride, dst_width, 0, dx);
+    dst_ptr += dst_stride;
+  }
+}
+
+static void CopyARGB(int width, int height,
+                     int src_stride, int dst_stride,
+                     const uint8* src_ptr, uint8* dst_ptr) {
+  for (int y = 0; y < height; ++y) {
+    memcpy(dst_ptr, src_ptr, width * 4);
+    src_ptr += src_stride;
+    dst_ptr += dst_stride;
+  }
+}
+
+static void ScaleARGB(const uint8* src, int src_stride,
+                      int src_width, int src_height,
+                      uint8* dst, int dst_stride,
+                      int dst_width, int dst_height,
+                      FilterMode filtering) {
+  if (dst_width == src_width && dst_height == src_height) {
+    // Straight copy.
+    CopyARGB(src_width, src_height, src_stride, dst_stride, src, dst);
+  } else if (2 * dst_width == src_width && 2 * dst_height == src_height) {
+    // optimized, 1/2
+    ScaleARGBDown2(src_width, src_height, dst_width, dst_height,
+                   src_stride, dst_stride, src, dst, filtering);
+  } else if (!filtering) {
+    ScaleARGBSimple(src_width, src_height, dst_width, dst_height,
+                    src_stride, dst_stride, src, dst);
+  } else if (filtering >= kFilterBox &&
+             dst_width * 2 <= src_width && dst_height * 2 <= src_height) {
+    ScaleARGBBox(src_width, src_height, dst_width, dst_height,
+                 src_stride, dst_stride, src, dst);
+  } else {
+    ScaleARGBBilinear(src_width, src_height, dst_width, dst_height,
+                      src_stride, dst_stride, src, dst);
+  }
+}
+
+int ARGBScale(const uint8* src_argb, int src_stride_argb,
+              int src_width, int src_height,
+              uint8* dst_argb, int dst_stride_argb,
+              int dst_width, int dst_height,
+              FilterMode filtering) {
+  if (!src_argb || src_width <= 0 || src_height == 0 ||
+      !dst_argb || dst_width <= 0 || dst_height <= 0) {
+    return -1;
+  }
+  // Negative height means invert the image.
+  if (src_height < 0) {
+    src_height = -src_height;
+    src_argb = src_argb + (src_height - 1) * src_stride_argb;
+    src_stride_argb = -src_stride_argb;
+  }
+  ScaleARGB(src_argb, src_stride_argb, src_width, src_height,
+            dst_argb, dst_stride_argb, dst_width, dst_height,
+            filtering);
+  return 0;
+}
+
+}  // namespace libyuv
@@ -0,0 +1,808 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "libyuv/scale_uv.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "libyuv/cpu_id.h"
+#include "row.h"
+
+namespace libyuv {
+
+// UV scaling works on 2 byte pixels of interleaved U and V.  The row
+// functions follow the ARGB versions in scale_argb.cc, with dst_width
+// counted in pixels.
+
+#if defined(WIN32) && !defined(COVERAGE_ENABLED)
+
+#define HAS_SCALEUVROWDOWN2_SSE2
+// Reads 16 pixels, throws half away and writes 8 pixels.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleUVRowDown2_SSE2(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  __asm {
+    mov        eax, [esp + 4]        // src_ptr
+                                     // src_stride ignored
+    mov        edx, [esp + 12]       // dst_ptr
+    mov        ecx, [esp + 16]       // dst_width
+
+  wloop:
+    movdqa     xmm0, [eax]
+    movdqa     xmm1, [eax + 16]
+    lea        eax,  [eax + 32]
+    pslld      xmm0, 16              // even pixels, sign extended
+    pslld      xmm1, 16
+    psrad      xmm0, 16
+    psrad      xmm1, 16
+    packssdw   xmm0, xmm1
+    movdqa     [edx], xmm0
+    lea        edx, [edx + 16]
+    sub        ecx, 8
+    ja         wloop
+
+    ret
+  }
+}
+
+// Blends 16x2 rectangle to 8x1.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleUVRowDown2Int_SSE2(const uint8* src_ptr, int src_stride,
+                                    uint8* dst_ptr, int dst_width) {
+  __asm {
+    push       esi
+    mov        eax, [esp + 4 + 4]    // src_ptr
+    mov        esi, [esp + 4 + 8]    // src_stride
+    mov        edx, [esp + 4 + 12]   // dst_ptr
+    mov        ecx, [esp + 4 + 16]   // dst_width
+
+  wloop:
+    movdqa     xmm0, [eax]
+    movdqa     xmm1, [eax + 16]
+    movdqa     xmm2, [eax + esi]
+    movdqa     xmm3, [eax + esi + 16]
+    lea        eax,  [eax + 32]
+    pavgb      xmm0, xmm2            // average rows
+    pavgb      xmm1, xmm3
+    movdqa     xmm2, xmm0            // average columns (16 to 8 pixels)
+    movdqa     xmm3, xmm1
+    psrld      xmm2, 16
+    psrld      xmm3, 16
+    pavgb      xmm0, xmm2
+    pavgb      xmm1, xmm3
+    pslld      xmm0, 16              // even pixels, sign extended
+    pslld      xmm1, 16
+    psrad      xmm0, 16
+    psrad      xmm1, 16
+    packssdw   xmm0, xmm1
+    movdqa     [edx], xmm0
+    lea        edx, [edx + 16]
+    sub        ecx, 8
+    ja         wloop
+
+    pop        esi
+    ret
+  }
+}
+
+#define HAS_SCALEUVFILTERROWS_SSE2
+// Blend 2 rows as (row0 * (256 - f) + row1 * f) >> 8, 8 pixels at a time.
+// Alignment requirement: src_ptr 16 byte aligned, dst_ptr 16 byte aligned.
+__declspec(naked)
+static void ScaleUVFilterRows_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                   int src_stride, int dst_width,
+                                   int source_y_fraction) {
+  __asm {
+    push       esi
+    push       edi
+    mov        edi, [esp + 8 + 4]   // dst_ptr
+    mov        esi, [esp + 8 + 8]   // src_ptr
+    mov        edx, [esp + 8 + 12]  // src_stride
+    mov        ecx, [esp + 8 + 16]  // dst_width
+    mov        eax, [esp + 8 + 20]  // source_y_fraction (0..255)
+    movd       xmm6, eax
+    punpcklwd  xmm6, xmm6
+    pshufd     xmm6, xmm6, 0
+    pcmpeqb    xmm5, xmm5           // generate 256 - source_y_fraction
+    psrlw      xmm5, 15
+    psllw      xmm5, 8
+    psubw      xmm5, xmm6
+    pxor       xmm7, xmm7
+
+  wloop:
+    movdqa     xmm0, [esi]
+    movdqa     xmm2, [esi + edx]
+    lea        esi,  [esi + 16]
+    movdqa     xmm1, xmm0
+    movdqa     xmm3, xmm2
+    punpcklbw  xmm0, xmm7
+    punpcklbw  xmm2, xmm7
+    punpckhbw  xmm1, xmm7
+    punpckhbw  xmm3, xmm7
+    pmullw     xmm0, xmm5
+    pmullw     xmm1, xmm5
+    pmullw     xmm2, xmm6
+    pmullw     xmm3, xmm6
+    paddw      xmm0, xmm2
+    paddw      xmm1, xmm3
+    psrlw      xmm0, 8
+    psrlw      xmm1, 8
+    packuswb   xmm0, xmm1
+    movdqa     [edi], xmm0
+    lea        edi,  [edi + 16]
+    sub        ecx, 8
+    ja         wloop
+
+    pop        edi
+    pop        esi
+    ret
+  }
+}
+
+#define HAS_SCALEUVFILTERCOLS_SSE2
+// Bilinear filter 2 pixels at a time, with a 7 bit fraction:
+// a + (((b - a) * f) >> 7)
+// The source row must have one pixel past the last pixel read at x.
+__declspec(naked)
+static void ScaleUVFilterCols_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                   int dst_width, int x, int dx) {
+  __asm {
+    push       ebx
+    push       esi
+    push       edi
+    push       ebp
+    mov        edi, [esp + 16 + 4]  // dst_ptr
+    mov        esi, [esp + 16 + 8]  // src_ptr
+    mov        ecx, [esp + 16 + 12] // dst_width
+    mov        ebx, [esp + 16 + 16] // x
+    mov        ebp, [esp + 16 + 20] // dx
+    pxor       xmm7, xmm7
+
+  wloop:
+    mov        eax, ebx
+    shr        eax, 16
+    movd       xmm0, [esi + eax * 2] // pixel and the next pixel
+    movd       xmm4, ebx
+    add        ebx, ebp
+    mov        eax, ebx
+    shr        eax, 16
+    movd       xmm1, [esi + eax * 2]
+    movd       xmm5, ebx
+    add        ebx, ebp
+    punpckldq  xmm0, xmm1           // a0 b0 a1 b1
+    punpckldq  xmm4, xmm5
+    punpcklbw  xmm0, xmm7
+    pshuflw    xmm4, xmm4, 0xa0     // fraction in 2 words per pixel
+    psrlw      xmm4, 9
+    pshufd     xmm2, xmm0, 0x0d     // b0 b1
+    pshufd     xmm0, xmm0, 0x08     // a0 a1
+    psubw      xmm2, xmm0
+    pmullw     xmm2, xmm4
+    psraw      xmm2, 7
+    paddw      xmm0, xmm2
+    packuswb   xmm0, xmm0
+    movd       [edi], xmm0
+    lea        edi,  [edi + 4]
+    sub        ecx, 2
+    ja         wloop
+
+    pop        ebp
+    pop        edi
+    pop        esi
+    pop        ebx
+    ret
+  }
+}
+
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(COVERAGE_ENABLED) && !defined(TARGET_IPHONE_SIMULATOR)
+
+#define HAS_SCALEUVROWDOWN2_SSE2
+static void ScaleUVRowDown2_SSE2(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  asm volatile (
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "lea        0x20(%0),%0                      \n"
+  "pslld      $0x10,%%xmm0                     \n"
+  "pslld      $0x10,%%xmm1                     \n"
+  "psrad      $0x10,%%xmm0                     \n"
+  "psrad      $0x10,%%xmm1                     \n"
+  "packssdw   %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  :
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1"
+#endif
+);
+}
+
+static void ScaleUVRowDown2Int_SSE2(const uint8* src_ptr, int src_stride,
+                                    uint8* dst_ptr, int dst_width) {
+  asm volatile (
+"1:"
+  "movdqa     (%0),%%xmm0                      \n"
+  "movdqa     0x10(%0),%%xmm1                  \n"
+  "movdqa     (%0,%3,1),%%xmm2                 \n"
+  "movdqa     0x10(%0,%3,1),%%xmm3             \n"
+  "lea        0x20(%0),%0                      \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "pavgb      %%xmm3,%%xmm1                    \n"
+  "movdqa     %%xmm0,%%xmm2                    \n"
+  "movdqa     %%xmm1,%%xmm3                    \n"
+  "psrld      $0x10,%%xmm2                     \n"
+  "psrld      $0x10,%%xmm3                     \n"
+  "pavgb      %%xmm2,%%xmm0                    \n"
+  "pavgb      %%xmm3,%%xmm1                    \n"
+  "pslld      $0x10,%%xmm0                     \n"
+  "pslld      $0x10,%%xmm1                     \n"
+  "psrad      $0x10,%%xmm0                     \n"
+  "psrad      $0x10,%%xmm1                     \n"
+  "packssdw   %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%1)                      \n"
+  "lea        0x10(%1),%1                      \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(src_ptr),    // %0
+    "+r"(dst_ptr),    // %1
+    "+r"(dst_width)   // %2
+  : "r"(static_cast<intptr_t>(src_stride))   // %3
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3"
+#endif
+);
+}
+
+#define HAS_SCALEUVFILTERROWS_SSE2
+static void ScaleUVFilterRows_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                   int src_stride, int dst_width,
+                                   int source_y_fraction) {
+  asm volatile (
+  "movd       %4,%%xmm6                        \n"
+  "punpcklwd  %%xmm6,%%xmm6                    \n"
+  "pshufd     $0x0,%%xmm6,%%xmm6               \n"
+  "pcmpeqb    %%xmm5,%%xmm5                    \n"
+  "psrlw      $0xf,%%xmm5                      \n"
+  "psllw      $0x8,%%xmm5                      \n"
+  "psubw      %%xmm6,%%xmm5                    \n"
+  "pxor       %%xmm7,%%xmm7                    \n"
+"1:"
+  "movdqa     (%1),%%xmm0                      \n"
+  "movdqa     (%1,%3,1),%%xmm2                 \n"
+  "lea        0x10(%1),%1                      \n"
+  "movdqa     %%xmm0,%%xmm1                    \n"
+  "movdqa     %%xmm2,%%xmm3                    \n"
+  "punpcklbw  %%xmm7,%%xmm0                    \n"
+  "punpcklbw  %%xmm7,%%xmm2                    \n"
+  "punpckhbw  %%xmm7,%%xmm1                    \n"
+  "punpckhbw  %%xmm7,%%xmm3                    \n"
+  "pmullw     %%xmm5,%%xmm0                    \n"
+  "pmullw     %%xmm5,%%xmm1                    \n"
+  "pmullw     %%xmm6,%%xmm2                    \n"
+  "pmullw     %%xmm6,%%xmm3                    \n"
+  "paddw      %%xmm2,%%xmm0                    \n"
+  "paddw      %%xmm3,%%xmm1                    \n"
+  "psrlw      $0x8,%%xmm0                      \n"
+  "psrlw      $0x8,%%xmm1                      \n"
+  "packuswb   %%xmm1,%%xmm0                    \n"
+  "movdqa     %%xmm0,(%0)                      \n"
+  "lea        0x10(%0),%0                      \n"
+  "sub        $0x8,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width)    // %2
+  : "r"(static_cast<intptr_t>(src_stride)),  // %3
+    "r"(source_y_fraction)                   // %4
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "xmm6", "xmm7"
+#endif
+);
+}
+
+#define HAS_SCALEUVFILTERCOLS_SSE2
+static void ScaleUVFilterCols_SSE2(uint8* dst_ptr, const uint8* src_ptr,
+                                   int dst_width, int x, int dx) {
+  intptr_t temp = 0;
+  asm volatile (
+  "pxor       %%xmm7,%%xmm7                    \n"
+"1:"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movd       (%1,%4,2),%%xmm0                 \n"
+  "movd       %3,%%xmm4                        \n"
+  "add        %5,%3                            \n"
+  "mov        %3,%k4                           \n"
+  "shr        $0x10,%k4                        \n"
+  "movd       (%1,%4,2),%%xmm1                 \n"
+  "movd       %3,%%xmm5                        \n"
+  "add        %5,%3                            \n"
+  "punpckldq  %%xmm1,%%xmm0                    \n"
+  "punpckldq  %%xmm5,%%xmm4                    \n"
+  "punpcklbw  %%xmm7,%%xmm0                    \n"
+  "pshuflw    $0xa0,%%xmm4,%%xmm4              \n"
+  "psrlw      $0x9,%%xmm4                      \n"
+  "pshufd     $0xd,%%xmm0,%%xmm2               \n"
+  "pshufd     $0x8,%%xmm0,%%xmm0               \n"
+  "psubw      %%xmm0,%%xmm2                    \n"
+  "pmullw     %%xmm4,%%xmm2                    \n"
+  "psraw      $0x7,%%xmm2                      \n"
+  "paddw      %%xmm2,%%xmm0                    \n"
+  "packuswb   %%xmm0,%%xmm0                    \n"
+  "movd       %%xmm0,(%0)                      \n"
+  "lea        0x4(%0),%0                       \n"
+  "sub        $0x2,%2                          \n"
+  "ja         1b                               \n"
+  : "+r"(dst_ptr),     // %0
+    "+r"(src_ptr),     // %1
+    "+r"(dst_width),   // %2
+    "+r"(x),           // %3
+    "+r"(temp)         // %4
+  : "r"(dx)            // %5
+  : "memory", "cc"
+#if defined(__x86_64__)
+    , "xmm0", "xmm1", "xmm2", "xmm4", "xmm5", "xmm7"
+#endif
+);
+}
+
+#endif
+
+static void ScaleUVRowDown2_C(const uint8* src_ptr, int,
+                              uint8* dst_ptr, int dst_width) {
+  const uint16* src = reinterpret_cast<const uint16*>(src_ptr);
+  uint16* dst = reinterpret_cast<uint16*>(dst_ptr);
+  for (int x = 0; x < dst_width; ++x) {
+    dst[x] = src[x * 2];
+  }
+}
+
+static void ScaleUVRowDown2Int_C(const uint8* src_ptr, int src_stride,
+                                 uint8* dst_ptr, int dst_width) {
+  for (int x = 0; x < dst_width; ++x) {
+    dst_ptr[0] = (src_ptr[0] + src_ptr[2] +
+                  src_ptr[src_stride] + src_ptr[src_stride + 2] + 2) >> 2;
+    dst_ptr[1] = (src_ptr[1] + src_ptr[3] +
+                  src_ptr[src_stride + 1] + src_ptr[src_stride + 3] + 2) >> 2;
+    src_ptr += 4;
+    dst_ptr += 2;
+  }
+}
+
+static void ScaleUVFilterRows_C(uint8* dst_ptr, const uint8* src_ptr,
+                                int src_stride, int dst_width,
+                                int source_y_fraction) {
+  assert(dst_width > 0);
+  int y1_fraction = source_y_fraction;
+  int y0_fraction = 256 - y1_fraction;
+  const uint8* src_ptr1 = src_ptr + src_stride;
+  for (int x = 0; x < dst_width * 2; ++x) {
+    dst_ptr[x] = (src_ptr[x] * y0_fraction + src_ptr1[x] * y1_fraction) >> 8;
+  }
+}
+
+static void ScaleUVFilterCols_C(uint8* dst_ptr, const uint8* src_ptr,
+                                int dst_width, int x, int dx) {
+  for (int j = 0; j < dst_width; ++j) {
+    const uint8* src = src_ptr + (x >> 16) * 2;
+    int f = (x >> 9) & 0x7f;
+    dst_ptr[0] = src[0] + (((src[2] - src[0]) * f) >> 7);
+    dst_ptr[1] = src[1] + (((src[3] - src[1]) * f) >> 7);
+    dst_ptr += 2;
+    x += dx;
+  }
+}
+
+static void ScaleUVCols_C(uint8* dst_ptr, const uint8* src_ptr,
+                          int dst_width, int x, int dx) {
+  const uint16* src = reinterpret_cast<const uint16*>(src_ptr);
+  uint16* dst = reinterpret_cast<uint16*>(dst_ptr);
+  for (int j = 0; j < dst_width; ++j) {
+    dst[j] = src[x >> 16];
+    x += dx;
+  }
+}
+
+// Sums src_height rows of src_width pixels into 32 bit sums per channel.
+static void ScaleUVAddRows_C(const uint8* src_ptr, int src_stride,
+                             uint32* dst_sum, int src_width,
+                             int src_height) {
+  assert(src_height > 0);
+  for (int x = 0; x < src_width * 2; ++x) {
+    const uint8* s = src_ptr + x;
+    uint32 sum = 0u;
+    for (int y = 0; y < src_height; ++y) {
+      sum += s[0];
+      s += src_stride;
+    }
+    dst_sum[x] = sum;
+  }
+}
+
+static void ScaleUVAddCols_C(int dst_width, int boxheight, int dx,
+                             const uint32* src_sum, uint8* dst_ptr) {
+  int x = 0;
+  for (int i = 0; i < dst_width; ++i) {
+    int ix = x >> 16;
+    x += dx;
+    int boxwidth = (x >> 16) - ix;
+    int area = boxwidth * boxheight;
+    uint32 sum_u = 0u;
+    uint32 sum_v = 0u;
+    for (int k = 0; k < boxwidth; ++k) {
+      sum_u += src_sum[(ix + k) * 2];
+      sum_v += src_sum[(ix + k) * 2 + 1];
+    }
+    dst_ptr[0] = sum_u / area;
+    dst_ptr[1] = sum_v / area;
+    dst_ptr += 2;
+  }
+}
+
+// Destination of the UV scalers.  Rows are written straight to an NV12
+// UV plane, or, for I420, to a row buffer that is split into the U and V
+// planes while it is still in cache.
+struct UVRowStore {
+  uint8* dst_uv;
+  int dst_stride_uv;
+  uint8* dst_u;
+  int dst_stride_u;
+  uint8* dst_v;
+  int dst_stride_v;
+  int width;
+  uint8* row_mem;
+  uint8* row;
+  void (*SplitUVRow)(const uint8* src_uv, uint8* dst_u, uint8* dst_v,
+                     int pix);
+};
+
+static void InitUVRowStore(UVRowStore* s, int width,
+                           uint8* dst_uv, int dst_stride_uv,
+                           uint8* dst_u, int dst_stride_u,
+                           uint8* dst_v, int dst_stride_v) {
+  s->dst_uv = dst_uv;
+  s->dst_stride_uv = dst_stride_uv;
+  s->dst_u = dst_u;
+  s->dst_stride_u = dst_stride_u;
+  s->dst_v = dst_v;
+  s->dst_stride_v = dst_stride_v;
+  s->width = width;
+  s->row_mem = NULL;
+  s->row = NULL;
+  if (dst_uv) {
+    return;
+  }
+  s->row_mem = new uint8[width * 2 + 15];
+  s->row = ALIGNP(s->row_mem, 16);
+#if defined(HAS_SPLITUV_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (width % 16 == 0) &&
+      IS_ALIGNED(dst_u, 16) && (dst_stride_u % 16 == 0) &&
+      IS_ALIGNED(dst_v, 16) && (dst_stride_v % 16 == 0)) {
+    s->SplitUVRow = SplitUV_SSE2;
+  } else
+#endif
+  {
+    s->SplitUVRow = SplitUV_C;
+  }
+}
+
+static void FreeUVRowStore(UVRowStore* s) {
+  delete[] s->row_mem;
+}
+
+// Returns where the next row should be written.
+static uint8* UVRowStoreDst(const UVRowStore* s) {
+  return s->dst_uv ? s->dst_uv : s->row;
+}
+
+// True if every row written to the store is 16 byte aligned.
+static bool UVRowStoreAligned(const UVRowStore* s) {
+  return s->dst_uv ? IS_ALIGNED(s->dst_uv, 16) &&
+      (s->dst_stride_uv % 16 == 0) : true;
+}
+
+// Stores the row written to UVRowStoreDst and moves to the next row.
+static void UVRowStoreNext(UVRowStore* s) {
+  if (s->dst_uv) {
+    s->dst_uv += s->dst_stride_uv;
+  } else {
+    s->SplitUVRow(s->row, s->dst_u, s->dst_v, s->width);
+    s->dst_u += s->dst_stride_u;
+    s->dst_v += s->dst_stride_v;
+  }
+}
+
+/**
+ * Scale UV, 1/2
+ *
+ * This is an optimized version for scaling down a UV plane to 1/2 of
+ * its original size.
+ */
+static void ScaleUVDown2(int src_width, int src_height,
+                         int dst_width, int dst_height,
+                         int src_stride, const uint8* src_ptr,
+                         UVRowStore* dst, FilterMode filtering) {
+  assert(src_width == dst_width * 2);
+  assert(src_height == dst_height * 2);
+  void (*ScaleUVRowDown2)(const uint8* src_ptr, int src_stride,
+                          uint8* dst_ptr, int dst_width);
+#if defined(HAS_SCALEUVROWDOWN2_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (dst_width % 8 == 0) && (src_stride % 16 == 0) &&
+      IS_ALIGNED(src_ptr, 16) && UVRowStoreAligned(dst)) {
+    ScaleUVRowDown2 = filtering ? ScaleUVRowDown2Int_SSE2 :
+        ScaleUVRowDown2_SSE2;
+  } else
+#endif
+  {
+    ScaleUVRowDown2 = filtering ? ScaleUVRowDown2Int_C :
+        ScaleUVRowDown2_C;
+  }
+
+  for (int y = 0; y < dst_height; ++y) {
+    ScaleUVRowDown2(src_ptr, src_stride, UVRowStoreDst(dst), dst_width);
+    UVRowStoreNext(dst);
+    src_ptr += (src_stride << 1);
+  }
+}
+
+/**
+ * Scale UV down to any dimensions, with a box filter.
+ *
+ * Same stepping as ScaleARGBBox, with 2 channels per pixel.
+ */
+static void ScaleUVBox(int src_width, int src_height,
+                       int dst_width, int dst_height,
+                       int src_stride, const uint8* src_ptr,
+                       UVRowStore* dst) {
+  assert(dst_width * 2 <= src_width);
+  assert(dst_height * 2 <= src_height);
+  int dx = (src_width << 16) / dst_width;
+  int dy = (src_height << 16) / dst_height;
+  uint32* row = new uint32[src_width * 2];
+  int y = 0;
+  for (int j = 0; j < dst_height; ++j) {
+    int iy = y >> 16;
+    const uint8* const src = src_ptr + iy * src_stride;
+    y += dy;
+    if (y > (src_height << 16)) {
+      y = (src_height << 16);
+    }
+    int boxheight = (y >> 16) - iy;
+    ScaleUVAddRows_C(src, src_stride, row, src_width, boxheight);
+    ScaleUVAddCols_C(dst_width, boxheight, dx, row, UVRowStoreDst(dst));
+    UVRowStoreNext(dst);
+  }
+  delete[] row;
+}
+
+/**
+ * Scale UV to/from any dimensions, with bilinear interpolation.
+ *
+ * Each output row blends 2 source rows into a row buffer, which is then
+ * filtered horizontally with a 16.16 fixed point step.
+ */
+static void ScaleUVBilinear(int src_width, int src_height,
+                            int dst_width, int dst_height,
+                            int src_stride, const uint8* src_ptr,
+                            UVRowStore* dst) {
+  assert(dst_width > 0);
+  assert(dst_height > 0);
+  int dx = (src_width << 16) / dst_width;
+  int dy = (src_height << 16) / dst_height;
+  void (*ScaleUVFilterRows)(uint8* dst_ptr, const uint8* src_ptr,
+                            int src_stride,
+                            int dst_width, int source_y_fraction);
+  void (*ScaleUVFilterCols)(uint8* dst_ptr, const uint8* src_ptr,
+                            int dst_width, int x, int dx);
+#if defined(HAS_SCALEUVFILTERROWS_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) &&
+      (src_stride % 16 == 0) && IS_ALIGNED(src_ptr, 16) &&
+      (src_width % 8 == 0)) {
+    ScaleUVFilterRows = ScaleUVFilterRows_SSE2;
+  } else
+#endif
+  {
+    ScaleUVFilterRows = ScaleUVFilterRows_C;
+  }
+#if defined(HAS_SCALEUVFILTERCOLS_SSE2)
+  if (TestCpuFlag(kCpuHasSSE2) && (dst_width % 2 == 0)) {
+    ScaleUVFilterCols = ScaleUVFilterCols_SSE2;
+  } else
+#endif
+  {
+    ScaleUVFilterCols = ScaleUVFilterCols_C;
+  }
+
+  // The row has one extra pixel, a copy of the last, for the column filter.
+  uint8* row_mem = new uint8[(src_width + 1) * 2 + 15];
+  uint8* row = ALIGNP(row_mem, 16);
+  // A single source row is blended with itself.
+  const int row_stride = (src_height > 1) ? src_stride : 0;
+  const int maxy = (src_height > 1) ? ((src_height - 1) << 16) - 1 : 0;
+  int y = 0;
+  for (int j = 0; j < dst_height; ++j) {
+    int iy = y >> 16;
+    int fy = (y >> 8) & 255;
+    ScaleUVFilterRows(row, src_ptr + iy * src_stride, row_stride,
+                      src_width, fy);
+    memcpy(row + src_width * 2, row + src_width * 2 - 2, 2);
+    ScaleUVFilterCols(UVRowStoreDst(dst), row, dst_width, 0, dx);
+    UVRowStoreNext(dst);
+    y += dy;
+    if (y > maxy) {
+      y = maxy;
+    }
+  }
+  delete[] row_mem;
+}
+
+/**
+ * Scale UV to/from any dimensions, without interpolation.
+ */
+static void ScaleUVSimple(int src_width, int src_height,
+                          int dst_width, int dst_height,
+                          int src_stride, const uint8* src_ptr,
+                          UVRowStore* dst) {
+  int dx = (src_width << 16) / dst_width;
+  for (int y = 0; y < dst_height; ++y) {
+    int iy = static_cast<int>(static_cast<int64>(y) * src_height /
+                              dst_height);
+    ScaleUVCols_C(UVRowStoreDst(dst), src_ptr + iy * src_stride,
+                  dst_width, 0, dx);
+    UVRowStoreNext(dst);
+  }
+}
+
+static void CopyUV(int width, int height,
+                   int src_stride, const uint8* src_ptr,
+                   UVRowStore* dst) {
+  if (dst->dst_uv) {
+    for (int y = 0; y < height; ++y) {
+      memcpy(UVRowStoreDst(dst), src_ptr, width * 2);
+      UVRowStoreNext(dst);
+      src_ptr += src_stride;
+    }
+    return;
+  }
+  // Split straight from the source, without going through the row.
+  void (*SplitUVRow)(const uint8* src_uv, uint8* dst_u, uint8* dst_v,
+                     int pix) = dst->SplitUVRow;
+  if (!IS_ALIGNED(src_ptr, 16) || (src_stride % 16 != 0)) {
+    SplitUVRow = SplitUV_C;
+  }
+  for (int y = 0; y < height; ++y) {
+    SplitUVRow(src_ptr, dst->dst_u, dst->dst_v, width);
+    dst->dst_u += dst->dst_stride_u;
+    dst->dst_v += dst->dst_stride_v;
+    src_ptr += src_stride;
+  }
+}
+
+static void ScaleUV(const uint8* src, int src_stride,
+                    int src_width, int src_height,
+                    UVRowStore* dst,
+                    int dst_width, int dst_height,
+                    FilterMode filtering) {
+  if (dst_width == src_width && dst_height == src_height) {
+    // Straight copy.
+    CopyUV(src_width, src_height, src_stride, src, dst);
+  } else if (2 * dst_width == src_width && 2 * dst_height == src_height) {
+    // optimized, 1/2
+    ScaleUVDown2(src_width, src_height, dst_width, dst_height,
+                 src_stride, src, dst, filtering);
+  } else if (!filtering) {
+    ScaleUVSimple(src_width, src_height, dst_width, dst_height,
+                  src_stride, src, dst);
+  } else if (filtering >= kFilterBox &&
+             dst_width * 2 <= src_width && dst_height * 2 <= src_height) {
+    ScaleUVBox(src_width, src_height, dst_width, dst_height,
+               src_stride, src, dst);
+  } else {
+    ScaleUVBilinear(src_width, src_height, dst_width, dst_height,
+                    src_stride, src, dst);
+  }
+}
+
+// Scales the Y plane and the interleaved UV plane of an NV12 image into
+// dst_uv, or into dst_u and dst_v if dst_uv is NULL.
+static int NV12ScaleToStore(const uint8* src_y, int src_stride_y,
+                            const uint8* src_uv, int src_stride_uv,
+                            int src_width, int src_height,
+                            uint8* dst_y, int dst_stride_y,
+                            uint8* dst_uv, int dst_stride_uv,
+                            uint8* dst_u, int dst_stride_u,
+                            uint8* dst_v, int dst_stride_v,
+                            int dst_width, int dst_height,
+                            FilterMode filtering) {
+  // Negative height means invert the image.
+  if (src_height < 0) {
+    src_height = -src_height;
+    int halfheight = (src_height + 1) >> 1;
+    src_y = src_y + (src_height - 1) * src_stride_y;
+    src_uv = src_uv + (halfheight - 1) * src_stride_uv;
+    src_stride_y = -src_stride_y;
+    src_stride_uv = -src_stride_uv;
+  }
+  int halfsrc_width = (src_width + 1) >> 1;
+  int halfsrc_height = (src_height + 1) >> 1;
+  int halfdst_width = (dst_width + 1) >> 1;
+  int halfoheight = (dst_height + 1) >> 1;
+
+  // UV has no polyphase filter, so kFilterBicubic and kFilterLanczos give it
+  // box or bilinear filtering.  Y is scaled with the same filter, so that
+  // luma and chroma are equally sharp.
+  if (filtering > kFilterBox) {
+    filtering = kFilterBox;
+  }
+  ScalePlane(src_y, src_stride_y, src_width, src_height,
+             dst_y, dst_stride_y, dst_width, dst_height,
+             filtering);
+  UVRowStore store;
+  InitUVRowStore(&store, halfdst_width, dst_uv, dst_stride_uv,
+                 dst_u, dst_stride_u, dst_v, dst_stride_v);
+  ScaleUV(src_uv, src_stride_uv, halfsrc_width, halfsrc_height,
+          &store, halfdst_width, halfoheight, filtering);
+  FreeUVRowStore(&store);
+  return 0;
+}
+
+int NV12Scale(const uint8* src_y, int src_stride_y,
+              const uint8* src_uv, int src_stride_uv,
+              int src_width, int src_height,
+              uint8* dst_y, int dst_stride_y,
+              uint8* dst_uv, int dst_stride_uv,
+              int dst_width, int dst_height,
+              FilterMode filtering) {
+  if (!src_y || !src_uv || src_width <= 0 || src_height == 0 ||
+      !dst_y || !dst_uv || dst_width <= 0 || dst_height <= 0) {
+    return -1;
+  }
+  return NV12ScaleToStore(src_y, src_stride_y, src_uv, src_stride_uv,
+                          src_width, src_height,
+                          dst_y, dst_stride_y, dst_uv, dst_stride_uv,
+                          NULL, 0, NULL, 0,
+                          dst_width, dst_height, filtering);
+}
+
+int NV12ToI420Scale(const uint8* src_y, int src_stride_y,
+                    const uint8* src_uv, int src_stride_uv,
+                    int src_width, int src_height,
+                    uint8* dst_y, int dst_stride_y,
+                    uint8* dst_u, int dst_stride_u,
+                    uint8* dst_v, int dst_stride_v,
+                    int dst_width, int dst_height,
+                    FilterMode filtering) {
+  if (!src_y || !src_uv || src_width <= 0 || src_height == 0 ||
+      !dst_y || !dst_u || !dst_v || dst_width <= 0 || dst_height <= 0) {
+    return -1;
+  }
+  return NV12ScaleToStore(src_y, src_stride_y, src_uv, src_stride_uv,
+                          src_width, src_height,
+                          dst_y, dst_stride_y, NULL, 0,
+                          dst_u, dst_stride_u, dst_v, dst_stride_v,
+                          dst_width, dst_height, filtering);
+}
+
+}  // namespace libyuv
@@ -0,0 +1,214 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "unit_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libyuv/convert.h"
+#include "libyuv/rotate.h"
+#include "libyuv/scale.h"
+#include "../source/video_common.h"
+
+namespace libyuv {
+
+// Converts a crop of a camera sample with ConvertToI420Scale, and with
+// ConvertToI420 followed by I420Scale and I420Rotate.  The results must be
+// identical, including the padding at the end of each row.
+static int TestConvertToI420Scale(uint32 format, int bpp,
+                                  int src_width, int src_height,
+                                  int crop_x, int crop_y,
+                                  int crop_width, int crop_height,
+                                  int dst_width, int dst_height,
+                                  RotationMode mode, FilterMode f,
+                                  double* fused_time, double* separate_time) {
+  const int abs_src_height = (src_height < 0) ? -src_height : src_height;
+  const int sample_size = ((src_width + 1) & ~1) * bpp * abs_src_height;
+  const int halfcrop_width = (crop_width + 1) >> 1;
+  const int halfcrop_height = (crop_height + 1) >> 1;
+  const int crop_stride_y = (crop_width + 15) & ~15;
+  const int crop_stride_uv = (halfcrop_width + 15) & ~15;
+  const int halfdst_width = (dst_width + 1) >> 1;
+  const int halfdst_height = (dst_height + 1) >> 1;
+  const int scaled_stride_y = (dst_width + 15) & ~15;
+  const int scaled_stride_uv = (halfdst_width + 15) & ~15;
+  const bool transpose = (mode == kRotate90 || mode == kRotate270);
+  const int out_width = transpose ? dst_height : dst_width;
+  const int out_height = transpose ? dst_width : dst_height;
+  const int halfout_width = (out_width + 1) >> 1;
+  const int halfout_height = (out_height + 1) >> 1;
+  const int out_stride_y = (out_width + 15) & ~15;
+  const int out_stride_uv = (halfout_width + 15) & ~15;
+  const int out_y_size = out_stride_y * out_height;
+  const int out_uv_size = out_stride_uv * halfout_height;
+
+  align_buffer_16(sample, sample_size)
+  align_buffer_16(crop_y_plane, crop_stride_y * crop_height)
+  align_buffer_16(crop_u_plane, crop_stride_uv * halfcrop_height)
+  align_buffer_16(crop_v_plane, crop_stride_uv * halfcrop_height)
+  align_buffer_16(scaled_y, scaled_stride_y * dst_height)
+  align_buffer_16(scaled_u, scaled_stride_uv * halfdst_height)
+  align_buffer_16(scaled_v, scaled_stride_uv * halfdst_height)
+  align_buffer_16(ref_y, out_y_size)
+  align_buffer_16(ref_u, out_uv_size)
+  align_buffer_16(ref_v, out_uv_size)
+  align_buffer_16(dst_y, out_y_size)
+  align_buffer_16(dst_u, out_uv_size)
+  align_buffer_16(dst_v, out_uv_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < sample_size; ++i) {
+    sample[i] = (random() & 0xff);
+  }
+  memset(ref_y, 1, out_y_size);
+  memset(ref_u, 1, out_uv_size);
+  memset(ref_v, 1, out_uv_size);
+  memset(dst_y, 1, out_y_size);
+  memset(dst_u, 1, out_uv_size);
+  memset(dst_v, 1, out_uv_size);
+
+  double time0 = get_time();
+  ConvertToI420(sample, sample_size,
+                crop_y_plane, crop_stride_y,
+                crop_u_plane, crop_stride_uv,
+                crop_v_plane, crop_stride_uv,
+                crop_x, crop_y, src_width, src_height,
+                crop_width, crop_height, kRotate0, format);
+  I420Scale(crop_y_plane, crop_stride_y,
+            crop_u_plane, crop_stride_uv,
+            crop_v_plane, crop_stride_uv,
+            crop_width, crop_height,
+            scaled_y, scaled_stride_y,
+            scaled_u, scaled_stride_uv,
+            scaled_v, scaled_stride_uv,
+            dst_width, dst_height, f);
+  I420Rotate(scaled_y, scaled_stride_y,
+             scaled_u, scaled_stride_uv,
+             scaled_v, scaled_stride_uv,
+             ref_y, out_stride_y, ref_u, out_stride_uv, ref_v, out_stride_uv,
+             dst_width, dst_height, mode);
+  *separate_time = get_time() - time0;
+
+  time0 = get_time();
+  int err = ConvertToI420Scale(sample, sample_size,
+                               dst_y, out_stride_y,
+                               dst_u, out_stride_uv,
+                               dst_v, out_stride_uv,
+                               crop_x, crop_y, src_width, src_height,
+                               crop_width, crop_height,
+                               dst_width, dst_height, mode, f, format);
+  *fused_time = get_time() - time0;
+
+  if (err == 0 &&
+      (memcmp(ref_y, dst_y, out_y_size) ||
+       memcmp(ref_u, dst_u, out_uv_size) ||
+       memcmp(ref_v, dst_v, out_uv_size))) {
+    printf("%dx%d crop %dx%d to %dx%d rotate %d filter %d differs\n",
+           src_width, src_height, crop_width, crop_height,
+           dst_width, dst_height, mode, f);
+    err = 1;
+  }
+
+  free_aligned_buffer_16(sample)
+  free_aligned_buffer_16(crop_y_plane)
+  free_aligned_buffer_16(crop_u_plane)
+  free_aligned_buffer_16(crop_v_plane)
+  free_aligned_buffer_16(scaled_y)
+  free_aligned_buffer_16(scaled_u)
+  free_aligned_buffer_16(scaled_v)
+  free_aligned_buffer_16(ref_y)
+  free_aligned_buffer_16(ref_u)
+  free_aligned_buffer_16(ref_v)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_u)
+  free_aligned_buffer_16(dst_v)
+
+  return (err != 0) ? 1 : 0;
+}
+
+TEST_F(libyuvTest, ConvertToI420Scale) {
+  static const RotationMode kModes[] = {
+    kRotate0, kRotate90, kRotate180, kRotate270
+  };
+  // Crop sizes are odd and the scaled sizes are odd, equal and larger.
+  static const int kSizes[][4] = {
+    { 101, 63, 101, 63 },
+    { 101, 63, 51, 31 },
+    { 101, 63, 33, 47 },
+    { 101, 63, 150, 90 },
+    { 101, 63, 404, 250 },
+    { 5, 4, 3, 2 },
+  };
+  double fused_time;
+  double separate_time;
+  int err = 0;
+  for (size_t m = 0; m < sizeof(kModes) / sizeof(kModes[0]); ++m) {
+    for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); ++s) {
+      for (int flip = 0; flip < 2; ++flip) {
+        const int src_height = flip ? -80 : 80;
+        err += TestConvertToI420Scale(FOURCC_YUY2, 2, 121, src_height, 6, 7,
+                                      kSizes[s][0], kSizes[s][1],
+                                      kSizes[s][2], kSizes[s][3],
+                                      kModes[m], kFilterBilinear,
+                                      &fused_time, &separate_time);
+        err += TestConvertToI420Scale(FOURCC_ARGB, 4, 121, src_height, 5, 7,
+                                      kSizes[s][0], kSizes[s][1],
+                                      kSizes[s][2], kSizes[s][3],
+                                      kModes[m], kFilterNone,
+                                      &fused_time, &separate_time);
+      }
+    }
+  }
+  EXPECT_EQ(0, err);
+}
+
+// ConvertToI420 honors the rotation.
+TEST_F(libyuvTest, ConvertToI420Rotate) {
+  double fused_time;
+  double separate_time;
+  int err = 0;
+  for (int m = 0; m <= kRotate270; m += kRotate90) {
+    err += TestConvertToI420Scale(FOURCC_UYVY, 2, 640, 480, 0, 0, 640, 480,
+                                  640, 480, static_cast<RotationMode>(m),
+                                  kFilterNone, &fused_time, &separate_time);
+    err += TestConvertToI420Scale(FOURCC_ABGR, 4, 99, -37, 3, 1, 95, 35,
+                                  95, 35, static_cast<RotationMode>(m),
+                                  kFilterNone, &fused_time, &separate_time);
+  }
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, BenchmarkConvertToI420Scale) {
+  static const RotationMode kModes[] = { kRotate0, kRotate90 };
+  for (size_t m = 0; m < sizeof(kModes) / sizeof(kModes[0]); ++m) {
+    double fused_time = 0.0;
+    double separate_time = 0.0;
+    const int runs = 8;
+    int err = 0;
+    for (int i = 0; i < runs; ++i) {
+      double fused;
+      double separate;
+      err += TestConvertToI420Scale(FOURCC_YUY2, 2, 1280, 720, 0, 0,
+                                    1280, 720, 640, 360, kModes[m],
+                                    kFilterBilinear, &fused, &separate);
+      fused_time += fused;
+      separate_time += separate;
+    }
+    printf("YUY2 1280x720 to 640x360 rotate %d - %8d us fused - "
+           "%8d us separate\n", kModes[m],
+           static_cast<int>(fused_time * 1e6 / runs),
+           static_cast<int>(separate_time * 1e6 / runs));
+    EXPECT_EQ(0, err);
+  }
+}
+
+}  // namespace libyuv
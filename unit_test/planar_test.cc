@@ -0,0 +1,450 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "unit_test.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libyuv/cpu_id.h"
+#include "libyuv/planar_functions.h"
+#include "libyuv/scale.h"
+
+namespace libyuv {
+
+// Widths that are not a multiple of the SIMD row functions' step.  The
+// strides stay 16 byte aligned, so the SIMD versions are used for most of
+// each row and C for the rest.
+static const int kAnyWidths[] = { 1366, 854, 33, 17, 2, 1 };
+
+static int MaxDiff(const uint8* a, const uint8* b, int size) {
+  int max_diff = 0;
+  for (int i = 0; i < size; ++i) {
+    int abs_diff = abs(a[i] - b[i]);
+    if (abs_diff > max_diff) {
+      max_diff = abs_diff;
+    }
+  }
+  return max_diff;
+}
+
+typedef int (*PackedToI420Func)(const uint8* src, int src_stride,
+                                uint8* dst_y, int dst_stride_y,
+                                uint8* dst_u, int dst_stride_u,
+                                uint8* dst_v, int dst_stride_v,
+                                int width, int height);
+
+// Converts a packed 4:2:2 frame with C and with the optimized row
+// functions.  The bytes past the width of each row must not be written.
+static int TestPackedToI420(PackedToI420Func convert, int width, int height) {
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (height + 1) >> 1;
+  const int src_stride = (halfwidth * 4 + 15) & ~15;
+  const int stride_y = (width + 15) & ~15;
+  const int stride_uv = (halfwidth + 15) & ~15;
+  const int y_size = stride_y * height;
+  const int uv_size = stride_uv * halfheight;
+
+  align_buffer_16(src, src_stride * height)
+  align_buffer_16(dst_y_c, y_size)
+  align_buffer_16(dst_u_c, uv_size)
+  align_buffer_16(dst_v_c, uv_size)
+  align_buffer_16(dst_y_opt, y_size)
+  align_buffer_16(dst_u_opt, uv_size)
+  align_buffer_16(dst_v_opt, uv_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_stride * height; ++i) {
+    src[i] = (random() & 0xff);
+  }
+  memset(dst_y_c, 1, y_size);
+  memset(dst_u_c, 1, uv_size);
+  memset(dst_v_c, 1, uv_size);
+  memset(dst_y_opt, 1, y_size);
+  memset(dst_u_opt, 1, uv_size);
+  memset(dst_v_opt, 1, uv_size);
+
+  MaskCpuFlags(kCpuInitialized);
+  convert(src, src_stride, dst_y_c, stride_y, dst_u_c, stride_uv,
+          dst_v_c, stride_uv, width, height);
+  MaskCpuFlags(-1);
+  convert(src, src_stride, dst_y_opt, stride_y, dst_u_opt, stride_uv,
+          dst_v_opt, stride_uv, width, height);
+
+  int max_diff = MaxDiff(dst_y_c, dst_y_opt, y_size);
+  int diff = MaxDiff(dst_u_c, dst_u_opt, uv_size);
+  if (diff > max_diff) {
+    max_diff = diff;
+  }
+  diff = MaxDiff(dst_v_c, dst_v_opt, uv_size);
+  if (diff > max_diff) {
+    max_diff = diff;
+  }
+  // Padding after the last pixel of each row is left alone.
+  for (int y = 0; y < height; ++y) {
+    for (int x = width; x < stride_y; ++x) {
+      if (dst_y_opt[y * stride_y + x] != 1) {
+        max_diff = 255;
+      }
+    }
+  }
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_y_c)
+  free_aligned_buffer_16(dst_u_c)
+  free_aligned_buffer_16(dst_v_c)
+  free_aligned_buffer_16(dst_y_opt)
+  free_aligned_buffer_16(dst_u_opt)
+  free_aligned_buffer_16(dst_v_opt)
+
+  return max_diff;
+}
+
+TEST_F(libyuvTest, YUY2ToI420AnyWidth) {
+  int err = 0;
+  for (size_t i = 0; i < sizeof(kAnyWidths) / sizeof(kAnyWidths[0]); ++i) {
+    err += TestPackedToI420(YUY2ToI420, kAnyWidths[i], 9);
+    err += TestPackedToI420(UYVYToI420, kAnyWidths[i], 9);
+  }
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, NV12ToI420AnyWidth) {
+  int err = 0;
+  for (size_t i = 0; i < sizeof(kAnyWidths) / sizeof(kAnyWidths[0]); ++i) {
+    const int width = kAnyWidths[i];
+    const int height = 10;
+    const int halfwidth = (width + 1) >> 1;
+    const int halfheight = (height + 1) >> 1;
+    const int stride_y = (width + 15) & ~15;
+    const int stride_uv = (halfwidth + 15) & ~15;
+    const int src_stride_uv = (halfwidth * 2 + 15) & ~15;
+    const int uv_size = stride_uv * halfheight;
+
+    align_buffer_16(src_y, stride_y * height)
+    align_buffer_16(src_uv, src_stride_uv * halfheight)
+    align_buffer_16(dst_y, stride_y * height)
+    align_buffer_16(dst_u_c, uv_size)
+    align_buffer_16(dst_v_c, uv_size)
+    align_buffer_16(dst_u_opt, uv_size)
+    align_buffer_16(dst_v_opt, uv_size)
+
+    srandom(time(NULL));
+    for (int j = 0; j < src_stride_uv * halfheight; ++j) {
+      src_uv[j] = (random() & 0xff);
+    }
+    memset(dst_u_c, 1, uv_size);
+    memset(dst_v_c, 1, uv_size);
+    memset(dst_u_opt, 1, uv_size);
+    memset(dst_v_opt, 1, uv_size);
+
+    MaskCpuFlags(kCpuInitialized);
+    NV12ToI420(src_y, stride_y, src_uv, src_stride_uv,
+               dst_y, stride_y, dst_u_c, stride_uv, dst_v_c, stride_uv,
+               width, height);
+    MaskCpuFlags(-1);
+    NV12ToI420(src_y, stride_y, src_uv, src_stride_uv,
+               dst_y, stride_y, dst_u_opt, stride_uv, dst_v_opt, stride_uv,
+               width, height);
+
+    err += MaxDiff(dst_u_c, dst_u_opt, uv_size);
+    err += MaxDiff(dst_v_c, dst_v_opt, uv_size);
+
+    free_aligned_buffer_16(src_y)
+    free_aligned_buffer_16(src_uv)
+    free_aligned_buffer_16(dst_y)
+    free_aligned_buffer_16(dst_u_c)
+    free_aligned_buffer_16(dst_v_c)
+    free_aligned_buffer_16(dst_u_opt)
+    free_aligned_buffer_16(dst_v_opt)
+  }
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, I420ToARGBAnyWidth) {
+  int err = 0;
+  for (size_t i = 0; i < sizeof(kAnyWidths) / sizeof(kAnyWidths[0]); ++i) {
+    const int width = kAnyWidths[i];
+    const int height = 9;
+    const int halfwidth = (width + 1) >> 1;
+    const int halfheight = (height + 1) >> 1;
+    const int stride_y = (width + 15) & ~15;
+    const int stride_uv = (halfwidth + 15) & ~15;
+    const int stride_argb = stride_y * 4;
+    const int argb_size = stride_argb * height;
+
+    align_buffer_16(src_y, stride_y * height)
+    align_buffer_16(src_u, stride_uv * halfheight)
+    align_buffer_16(src_v, stride_uv * halfheight)
+    align_buffer_16(dst_argb_c, argb_size)
+    align_buffer_16(dst_argb_opt, argb_size)
+
+    srandom(time(NULL));
+    for (int j = 0; j < stride_y * height; ++j) {
+      src_y[j] = (random() & 0xff);
+    }
+    for (int j = 0; j < stride_uv * halfheight; ++j) {
+      src_u[j] = (random() & 0xff);
+      src_v[j] = (random() & 0xff);
+    }
+    memset(dst_argb_c, 1, argb_size);
+    memset(dst_argb_opt, 1, argb_size);
+
+    MaskCpuFlags(kCpuInitialized);
+    I420ToARGB(src_y, stride_y, src_u, stride_uv, src_v, stride_uv,
+               dst_argb_c, stride_argb, width, height);
+    MaskCpuFlags(-1);
+    I420ToARGB(src_y, stride_y, src_u, stride_uv, src_v, stride_uv,
+               dst_argb_opt, stride_argb, width, height);
+
+    err += MaxDiff(dst_argb_c, dst_argb_opt, argb_size);
+
+    free_aligned_buffer_16(src_y)
+    free_aligned_buffer_16(src_u)
+    free_aligned_buffer_16(src_v)
+    free_aligned_buffer_16(dst_argb_c)
+    free_aligned_buffer_16(dst_argb_opt)
+  }
+  EXPECT_EQ(0, err);
+}
+
+// Mirrors an I420 frame with each CPU level, from a separate frame and in
+// place, and checks it against mirroring one pixel at a time.  Negative
+// height flips the frame too.
+static int TestI420Mirror(int width, int height, int runs) {
+  const int abs_height = (height < 0) ? -height : height;
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (abs_height + 1) >> 1;
+  const int stride_y = width + 5;
+  const int stride_uv = halfwidth + 3;
+  const int y_size = stride_y * abs_height;
+  const int uv_size = stride_uv * halfheight;
+  const int kCpuFlags[4] = {
+    kCpuInitialized, kCpuInitialized | kCpuHasMMX | kCpuHasSSE,
+    kCpuInitialized | kCpuHasMMX | kCpuHasSSE | kCpuHasSSE2, -1
+  };
+  double times[4];
+  int err = 0;
+
+  align_buffer_16(src_y, y_size)
+  align_buffer_16(src_u, uv_size)
+  align_buffer_16(src_v, uv_size)
+  align_buffer_16(ref_y, y_size)
+  align_buffer_16(ref_u, uv_size)
+  align_buffer_16(ref_v, uv_size)
+  align_buffer_16(dst_y, y_size)
+  align_buffer_16(dst_u, uv_size)
+  align_buffer_16(dst_v, uv_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < y_size; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < uv_size; ++i) {
+    src_u[i] = (random() & 0xff);
+    src_v[i] = (random() & 0xff);
+  }
+  // Padding is copied, so mirroring in place must leave it alone too.
+  memcpy(ref_y, src_y, y_size);
+  memcpy(ref_u, src_u, uv_size);
+  memcpy(ref_v, src_v, uv_size);
+  for (int y = 0; y < abs_height; ++y) {
+    const int sy = (height < 0) ? abs_height - 1 - y : y;
+    for (int x = 0; x < width; ++x) {
+      ref_y[y * stride_y + x] = src_y[sy * stride_y + width - 1 - x];
+    }
+  }
+  for (int y = 0; y < halfheight; ++y) {
+    const int sy = (height < 0) ? halfheight - 1 - y : y;
+    for (int x = 0; x < halfwidth; ++x) {
+      ref_u[y * stride_uv + x] = src_u[sy * stride_uv + halfwidth - 1 - x];
+      ref_v[y * stride_uv + x] = src_v[sy * stride_uv + halfwidth - 1 - x];
+    }
+  }
+
+  for (int f = 0; f < 4; ++f) {
+    MaskCpuFlags(kCpuFlags[f]);
+    memcpy(dst_y, src_y, y_size);
+    memcpy(dst_u, src_u, uv_size);
+    memcpy(dst_v, src_v, uv_size);
+    I420Mirror(dst_y, stride_y, dst_u, stride_uv, dst_v, stride_uv,
+               dst_y, stride_y, dst_u, stride_uv, dst_v, stride_uv,
+               width, height);
+    if (memcmp(ref_y, dst_y, y_size) || memcmp(ref_u, dst_u, uv_size) ||
+        memcmp(ref_v, dst_v, uv_size)) {
+      printf("mirror in place %dx%d cpu %d differs\n", width, height,
+             kCpuFlags[f]);
+      ++err;
+    }
+
+    memcpy(dst_y, src_y, y_size);
+    memcpy(dst_u, src_u, uv_size);
+    memcpy(dst_v, src_v, uv_size);
+    times[f] = get_time();
+    for (int i = 0; i < runs; ++i) {
+      I420Mirror(src_y, stride_y, src_u, stride_uv, src_v, stride_uv,
+                 dst_y, stride_y, dst_u, stride_uv, dst_v, stride_uv,
+                 width, height);
+    }
+    times[f] = (get_time() - times[f]) / runs;
+    if (memcmp(ref_y, dst_y, y_size) || memcmp(ref_u, dst_u, uv_size) ||
+        memcmp(ref_v, dst_v, uv_size)) {
+      printf("mirror %dx%d cpu %d differs\n", width, height, kCpuFlags[f]);
+      ++err;
+    }
+  }
+  MaskCpuFlags(-1);
+  if (runs > 1) {
+    printf("mirror %dx%d - %8d us c - %8d us sse - %8d us sse2 - "
+           "%8d us opt\n", width, height,
+           static_cast<int>(times[0] * 1e6),
+           static_cast<int>(times[1] * 1e6),
+           static_cast<int>(times[2] * 1e6),
+           static_cast<int>(times[3] * 1e6));
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(ref_y)
+  free_aligned_buffer_16(ref_u)
+  free_aligned_buffer_16(ref_v)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_u)
+  free_aligned_buffer_16(dst_v)
+
+  return err;
+}
+
+TEST_F(libyuvTest, I420Mirror) {
+  int err = 0;
+  for (size_t i = 0; i < sizeof(kAnyWidths) / sizeof(kAnyWidths[0]); ++i) {
+    err += TestI420Mirror(kAnyWidths[i], 9, 1);
+    err += TestI420Mirror(kAnyWidths[i], -9, 1);
+    err += TestI420Mirror(kAnyWidths[i], -10, 1);
+  }
+  err += TestI420Mirror(1280, 720, 8);
+  err += TestI420Mirror(1280, -720, 8);
+  EXPECT_EQ(0, err);
+}
+
+// Copies an I420 frame with streaming stores, with SSE and with all
+// optimizations, and checks it against the cached copy.  Streaming needs
+// 16 byte aligned rows, and the padding after each row must be left
+// alone.  A frame the same size through ScalePlane takes the copy path of
+// the scaler.
+static int TestI420CopyNonTemporal(int width, int height, int runs) {
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (height + 1) >> 1;
+  const int stride_y = (width + 31) & ~15;
+  const int stride_uv = (halfwidth + 31) & ~15;
+  const int y_size = stride_y * height;
+  const int uv_size = stride_uv * halfheight;
+  const int kCpuFlags[2] = {
+    kCpuInitialized | kCpuHasMMX | kCpuHasSSE, -1
+  };
+  double cached_time;
+  double streamed_time = 0.0;
+  int err = 0;
+
+  align_buffer_16(src_y, y_size)
+  align_buffer_16(src_u, uv_size)
+  align_buffer_16(src_v, uv_size)
+  align_buffer_16(ref_y, y_size)
+  align_buffer_16(ref_u, uv_size)
+  align_buffer_16(ref_v, uv_size)
+  align_buffer_16(dst_y, y_size)
+  align_buffer_16(dst_u, uv_size)
+  align_buffer_16(dst_v, uv_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < y_size; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < uv_size; ++i) {
+    src_u[i] = (random() & 0xff);
+    src_v[i] = (random() & 0xff);
+  }
+  memset(ref_y, 0, y_size);
+  memset(ref_u, 0, uv_size);
+  memset(ref_v, 0, uv_size);
+
+  SetNonTemporalThreshold(INT_MAX);
+  cached_time = get_time();
+  for (int i = 0; i < runs; ++i) {
+    I420Copy(src_y, stride_y, src_u, stride_uv, src_v, stride_uv,
+             ref_y, stride_y, ref_u, stride_uv, ref_v, stride_uv,
+             width, height);
+  }
+  cached_time = (get_time() - cached_time) / runs;
+
+  SetNonTemporalThreshold(0);
+  for (int f = 0; f < 2; ++f) {
+    MaskCpuFlags(kCpuFlags[f]);
+    memset(dst_y, 0, y_size);
+    memset(dst_u, 0, uv_size);
+    memset(dst_v, 0, uv_size);
+    streamed_time = get_time();
+    for (int i = 0; i < runs; ++i) {
+      I420Copy(src_y, stride_y, src_u, stride_uv, src_v, stride_uv,
+               dst_y, stride_y, dst_u, stride_uv, dst_v, stride_uv,
+               width, height);
+    }
+    streamed_time = (get_time() - streamed_time) / runs;
+    if (memcmp(ref_y, dst_y, y_size) || memcmp(ref_u, dst_u, uv_size) ||
+        memcmp(ref_v, dst_v, uv_size)) {
+      printf("streamed copy %dx%d cpu %d differs\n", width, height,
+             kCpuFlags[f]);
+      ++err;
+    }
+
+    memset(dst_y, 0, y_size);
+    ScalePlane(src_y, stride_y, width, height, dst_y, stride_y,
+               width, height, kFilterNone);
+    if (memcmp(ref_y, dst_y, y_size)) {
+      printf("streamed scale copy %dx%d cpu %d differs\n", width, height,
+             kCpuFlags[f]);
+      ++err;
+    }
+  }
+  MaskCpuFlags(-1);
+  SetNonTemporalThreshold(256 * 1024);
+  if (runs > 1) {
+    printf("copy %dx%d - %8d us cached - %8d us streamed\n", width, height,
+           static_cast<int>(cached_time * 1e6),
+           static_cast<int>(streamed_time * 1e6));
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(ref_y)
+  free_aligned_buffer_16(ref_u)
+  free_aligned_buffer_16(ref_v)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_u)
+  free_aligned_buffer_16(dst_v)
+
+  return err;
+}
+
+TEST_F(libyuvTest, I420CopyNonTemporal) {
+  int err = 0;
+  for (size_t i = 0; i < sizeof(kAnyWidths) / sizeof(kAnyWidths[0]); ++i) {
+    err += TestI420CopyNonTemporal(kAnyWidths[i], 9, 1);
+  }
+  err += TestI420CopyNonTemporal(1920, 1080, 16);
+  err += TestI420CopyNonTemporal(3840, 2160, 8);
+  EXPECT_EQ(0, err);
+}
+
+}  // namespace libyuv
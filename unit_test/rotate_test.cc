@@ -10,9 +10,13 @@
 
 #include "unit_test.h"
 
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "libyuv/cpu_id.h"
+#include "libyuv/planar_functions.h"
 #include "libyuv/rotate.h"
 #include "../source/rotate_priv.h"
 
@@ -1448,4 +1452,852 @@ TEST_F(libyuvTest, NV12ToI420RotateNegHeight180) {
   EXPECT_EQ(0, y_err + uv_err);
 }
 
+// Rotates with C, with only MMX and with all optimizations.  The source
+// and destination are offset by a byte so they are not aligned.
+static int TestRotatePlaneOpt(int width, int height, int runs) {
+  const int src_stride = width + 1;
+  const int dst_stride = height + 3;
+  const int src_size = src_stride * height + 1;
+  const int dst_size = dst_stride * width + 1;
+  const int kCpuFlags[3] = { kCpuInitialized, kCpuInitialized | kCpuHasMMX,
+                             -1 };
+  double times[3];
+  int err = 0;
+
+  align_buffer_16(src, src_size)
+  align_buffer_16(dst_c, dst_size)
+  align_buffer_16(dst_opt, dst_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_size; ++i) {
+    src[i] = (random() & 0xff);
+  }
+  for (int rotate = 0; rotate < 2; ++rotate) {
+    for (int f = 0; f < 3; ++f) {
+      uint8* dst = f ? dst_opt : dst_c;
+      memset(dst, 1, dst_size);
+      MaskCpuFlags(kCpuFlags[f]);
+      times[f] = get_time();
+      for (int i = 0; i < runs; ++i) {
+        if (rotate) {
+          RotatePlane270(src + 1, src_stride, dst + 1, dst_stride,
+                         width, height);
+        } else {
+          RotatePlane90(src + 1, src_stride, dst + 1, dst_stride,
+                        width, height);
+        }
+      }
+      times[f] = (get_time() - times[f]) / runs;
+      if (f && memcmp(dst_c, dst_opt, dst_size)) {
+        printf("rotate %d %dx%d cpu %d differs\n", rotate ? 270 : 90,
+               width, height, kCpuFlags[f]);
+        ++err;
+      }
+    }
+    if (runs > 1) {
+      printf("rotate %d %dx%d - %8d us c - %8d us mmx - %8d us opt\n",
+             rotate ? 270 : 90, width, height,
+             static_cast<int>(times[0] * 1e6),
+             static_cast<int>(times[1] * 1e6),
+             static_cast<int>(times[2] * 1e6));
+    }
+  }
+  MaskCpuFlags(-1);
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_c)
+  free_aligned_buffer_16(dst_opt)
+
+  return err;
+}
+
+TEST_F(libyuvTest, RotatePlaneOpt) {
+  static const int kSizes[][2] = {
+    { 8, 8 }, { 9, 15 }, { 33, 17 }, { 100, 71 }, { 135, 250 },
+    { 1366, 9 }, { 7, 500 },
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    err += TestRotatePlaneOpt(kSizes[i][0], kSizes[i][1], 1);
+  }
+  err += TestRotatePlaneOpt(_benchmark_width, _benchmark_height, 16);
+
+  EXPECT_EQ(0, err);
+}
+
+// Runs the jobs serially in reverse order, to check that bands do not
+// depend on each other.
+static void ReverseExecutor(void* opaque, ParallelJob job, void* job_opaque,
+                            int count) {
+  int* num_jobs = static_cast<int*>(opaque);
+  for (int i = count - 1; i >= 0; --i) {
+    job(job_opaque, i);
+    ++*num_jobs;
+  }
+}
+
+// Rotates an I420 and an NV12 frame serially and in parallel.
+static int TestRotateParallel(int width, int height, RotationMode mode,
+                              int num_threads, bool use_executor) {
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (height + 1) >> 1;
+  const int y_size = width * height;
+  const int uv_size = halfwidth * halfheight;
+  // Destination strides are the rotated widths.
+  const bool transpose = (mode == kRotate90 || mode == kRotate270);
+  const int dst_stride_y = transpose ? height : width;
+  const int dst_stride_uv = transpose ? halfheight : halfwidth;
+  int err = 0;
+
+  align_buffer_16(src_y, y_size)
+  align_buffer_16(src_u, uv_size)
+  align_buffer_16(src_v, uv_size)
+  align_buffer_16(src_uv, uv_size * 2)
+  align_buffer_16(dst_y_1, y_size)
+  align_buffer_16(dst_u_1, uv_size)
+  align_buffer_16(dst_v_1, uv_size)
+  align_buffer_16(dst_y_n, y_size)
+  align_buffer_16(dst_u_n, uv_size)
+  align_buffer_16(dst_v_n, uv_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < y_size; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < uv_size; ++i) {
+    src_u[i] = (random() & 0xff);
+    src_v[i] = (random() & 0xff);
+    src_uv[i * 2] = src_u[i];
+    src_uv[i * 2 + 1] = src_v[i];
+  }
+
+  // NV12ToI420 copies Y rows in pairs and reads past frames with an odd
+  // height, so kRotate0 is only checked for I420.
+  const int num_formats = (mode == kRotate0) ? 1 : 2;
+  for (int nv12 = 0; nv12 < num_formats; ++nv12) {
+    int num_jobs = 0;
+    memset(dst_y_n, 1, y_size);
+    memset(dst_u_n, 1, uv_size);
+    memset(dst_v_n, 1, uv_size);
+    if (nv12) {
+      NV12ToI420Rotate(src_y, width, src_uv, halfwidth * 2,
+                       dst_y_1, dst_stride_y,
+                       dst_u_1, dst_stride_uv,
+                       dst_v_1, dst_stride_uv,
+                       width, height, mode);
+      NV12ToI420RotateParallel(src_y, width, src_uv, halfwidth * 2,
+                               dst_y_n, dst_stride_y,
+                               dst_u_n, dst_stride_uv,
+                               dst_v_n, dst_stride_uv,
+                               width, height, mode, num_threads,
+                               use_executor ? ReverseExecutor : NULL,
+                               &num_jobs);
+    } else {
+      I420Rotate(src_y, width, src_u, halfwidth, src_v, halfwidth,
+                 dst_y_1, dst_stride_y,
+                 dst_u_1, dst_stride_uv,
+                 dst_v_1, dst_stride_uv,
+                 width, height, mode);
+      I420RotateParallel(src_y, width, src_u, halfwidth, src_v, halfwidth,
+                         dst_y_n, dst_stride_y,
+                         dst_u_n, dst_stride_uv,
+                         dst_v_n, dst_stride_uv,
+                         width, height, mode, num_threads,
+                         use_executor ? ReverseExecutor : NULL, &num_jobs);
+    }
+    if (use_executor && mode != kRotate0 && num_jobs < 2) {
+      err++;
+    }
+    if (memcmp(dst_y_1, dst_y_n, y_size) ||
+        memcmp(dst_u_1, dst_u_n, uv_size) ||
+        memcmp(dst_v_1, dst_v_n, uv_size)) {
+      printf("%s %dx%d rotate %d threads %d differs\n",
+             nv12 ? "nv12" : "i420", width, height, mode, num_threads);
+      err++;
+    }
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(src_uv)
+  free_aligned_buffer_16(dst_y_1)
+  free_aligned_buffer_16(dst_u_1)
+  free_aligned_buffer_16(dst_v_1)
+  free_aligned_buffer_16(dst_y_n)
+  free_aligned_buffer_16(dst_u_n)
+  free_aligned_buffer_16(dst_v_n)
+
+  return err;
+}
+
+TEST_F(libyuvTest, RotateParallel) {
+  static const int kSizes[][2] = {
+    { 1280, 720 }, { 720, 1280 }, { 642, 483 }, { 33, 17 }, { 16, 2 },
+  };
+  static const RotationMode kModes[] = {
+    kRotate0, kRotate90, kRotate180, kRotate270
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    for (size_t m = 0; m < sizeof(kModes) / sizeof(kModes[0]); ++m) {
+      for (int t = 1; t <= 7; t += 3) {
+        err += TestRotateParallel(kSizes[i][0], kSizes[i][1], kModes[m],
+                                  t, false);
+      }
+      err += TestRotateParallel(kSizes[i][0], kSizes[i][1], kModes[m],
+                                5, true);
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, BenchmarkRotateParallel) {
+  const int width = 1280;
+  const int height = 720;
+  const int runs = 64;
+
+  align_buffer_16(src_y, width * height)
+  align_buffer_16(src_u, width * height / 4)
+  align_buffer_16(src_v, width * height / 4)
+  align_buffer_16(dst_y, width * height)
+  align_buffer_16(dst_u, width * height / 4)
+  align_buffer_16(dst_v, width * height / 4)
+
+  for (int t = 1; t <= 4; t *= 2) {
+    double time = get_time();
+    for (int i = 0; i < runs; ++i) {
+      I420RotateParallel(src_y, width,
+                         src_u, width / 2,
+                         src_v, width / 2,
+                         dst_y, height,
+                         dst_u, height / 2,
+                         dst_v, height / 2,
+                         width, height, kRotate90, t, NULL, NULL);
+    }
+    time = (get_time() - time) / runs;
+    printf("threads %d - %8d us\n", t, static_cast<int>(time * 1e6));
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_u)
+  free_aligned_buffer_16(dst_v)
+}
+
+// Rotates ARGB with C, with only MMX and with all optimizations, and
+// compares each with rotating one pixel at a time.  The source and
+// destination are offset by a pixel so they are not 16 byte aligned.
+static int TestARGBRotate(int width, int height, RotationMode mode,
+                          int runs) {
+  const bool transpose = (mode == kRotate90 || mode == kRotate270);
+  const int dst_width = transpose ? height : width;
+  const int dst_height = transpose ? width : height;
+  const int src_stride = width * 4 + 4;
+  const int dst_stride = dst_width * 4 + 12;
+  const int src_size = src_stride * height + 4;
+  const int dst_size = dst_stride * dst_height + 4;
+  const int kCpuFlags[3] = { kCpuInitialized, kCpuInitialized | kCpuHasMMX,
+                             -1 };
+  double times[3];
+  int err = 0;
+
+  align_buffer_16(src, src_size)
+  align_buffer_16(dst_ref, dst_size)
+  align_buffer_16(dst, dst_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_size; ++i) {
+    src[i] = (random() & 0xff);
+  }
+  memset(dst_ref, 1, dst_size);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int dx = x, dy = y;
+      if (mode == kRotate90) {
+        dx = height - 1 - y;
+        dy = x;
+      } else if (mode == kRotate180) {
+        dx = width - 1 - x;
+        dy = height - 1 - y;
+      } else if (mode == kRotate270) {
+        dx = y;
+        dy = width - 1 - x;
+      }
+      memcpy(dst_ref + 4 + dy * dst_stride + dx * 4,
+             src + 4 + y * src_stride + x * 4, 4);
+    }
+  }
+
+  for (int f = 0; f < 3; ++f) {
+    memset(dst, 1, dst_size);
+    MaskCpuFlags(kCpuFlags[f]);
+    times[f] = get_time();
+    for (int i = 0; i < runs; ++i) {
+      ARGBRotate(src + 4, src_stride, dst + 4, dst_stride,
+                 width, height, mode);
+    }
+    times[f] = (get_time() - times[f]) / runs;
+    if (memcmp(dst_ref, dst, dst_size)) {
+      printf("argb rotate %d %dx%d cpu %d differs\n", mode, width, height,
+             kCpuFlags[f]);
+      ++err;
+    }
+  }
+  MaskCpuFlags(-1);
+  if (runs > 1) {
+    printf("argb rotate %d %dx%d - %8d us c - %8d us mmx - %8d us opt\n",
+           mode, width, height,
+           static_cast<int>(times[0] * 1e6),
+           static_cast<int>(times[1] * 1e6),
+           static_cast<int>(times[2] * 1e6));
+  }
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_ref)
+  free_aligned_buffer_16(dst)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ARGBRotate) {
+  static const int kSizes[][2] = {
+    { 4, 4 }, { 1, 1 }, { 5, 3 }, { 33, 17 }, { 100, 71 }, { 7, 130 },
+  };
+  static const RotationMode kModes[] = {
+    kRotate0, kRotate90, kRotate180, kRotate270
+  };
+  int err = 0;
+
+  for (size_t m = 0; m < sizeof(kModes) / sizeof(kModes[0]); ++m) {
+    for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+      err += TestARGBRotate(kSizes[i][0], kSizes[i][1], kModes[m], 1);
+    }
+    err += TestARGBRotate(_benchmark_width, _benchmark_height, kModes[m], 8);
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Rotates a plane of 'bpp' byte pixels one pixel at a time.  Negative
+// height means invert the image.
+static void RotatePixels(const uint8* src, int src_stride,
+                         uint8* dst, int dst_stride,
+                         int width, int height, int bpp, RotationMode mode) {
+  const bool invert = height < 0;
+  if (invert) {
+    height = -height;
+  }
+  for (int y = 0; y < height; ++y) {
+    const int sy = invert ? height - 1 - y : y;
+    for (int x = 0; x < width; ++x) {
+      int dx = x, dy = y;
+      if (mode == kRotate90) {
+        dx = height - 1 - y;
+        dy = x;
+      } else if (mode == kRotate180) {
+        dx = width - 1 - x;
+        dy = height - 1 - y;
+      } else if (mode == kRotate270) {
+        dx = y;
+        dy = width - 1 - x;
+      }
+      memcpy(dst + dy * dst_stride + dx * bpp,
+             src + sy * src_stride + x * bpp, bpp);
+    }
+  }
+}
+
+static int TestNV12Rotate(int width, int height, RotationMode mode,
+                          int runs) {
+  const int abs_height = (height < 0) ? -height : height;
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (abs_height + 1) >> 1;
+  const bool transpose = (mode == kRotate90 || mode == kRotate270);
+  const int dst_width = transpose ? abs_height : width;
+  const int dst_height = transpose ? width : abs_height;
+  const int dst_halfwidth = (dst_width + 1) >> 1;
+  const int dst_halfheight = (dst_height + 1) >> 1;
+  const int src_stride_y = width + 4;
+  const int src_stride_uv = halfwidth * 2 + 6;
+  const int dst_stride_y = dst_width + 12;
+  const int dst_stride_uv = dst_halfwidth * 2 + 10;
+  const int src_y_size = src_stride_y * abs_height;
+  const int src_uv_size = src_stride_uv * halfheight;
+  const int dst_y_size = dst_stride_y * dst_height;
+  const int dst_uv_size = dst_stride_uv * dst_halfheight;
+  const int kCpuFlags[3] = { kCpuInitialized, kCpuInitialized | kCpuHasMMX,
+                             -1 };
+  double times[3];
+  double i420_time;
+  int err = 0;
+
+  align_buffer_16(src_y, src_y_size)
+  align_buffer_16(src_uv, src_uv_size)
+  align_buffer_16(dst_y_ref, dst_y_size)
+  align_buffer_16(dst_uv_ref, dst_uv_size)
+  align_buffer_16(dst_y, dst_y_size)
+  align_buffer_16(dst_uv, dst_uv_size)
+  align_buffer_16(dst_u, dst_halfwidth * dst_halfheight)
+  align_buffer_16(dst_v, dst_halfwidth * dst_halfheight)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_y_size; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < src_uv_size; ++i) {
+    src_uv[i] = (random() & 0xff);
+  }
+  memset(dst_y_ref, 1, dst_y_size);
+  memset(dst_uv_ref, 1, dst_uv_size);
+  RotatePixels(src_y, src_stride_y, dst_y_ref, dst_stride_y,
+               width, height, 1, mode);
+  RotatePixels(src_uv, src_stride_uv, dst_uv_ref, dst_stride_uv,
+               halfwidth, (height < 0) ? -halfheight : halfheight, 2, mode);
+
+  for (int f = 0; f < 3; ++f) {
+    memset(dst_y, 1, dst_y_size);
+    memset(dst_uv, 1, dst_uv_size);
+    MaskCpuFlags(kCpuFlags[f]);
+    times[f] = get_time();
+    for (int i = 0; i < runs; ++i) {
+      NV12Rotate(src_y, src_stride_y, src_uv, src_stride_uv,
+                 dst_y, dst_stride_y, dst_uv, dst_stride_uv,
+                 width, height, mode);
+    }
+    times[f] = (get_time() - times[f]) / runs;
+    if (memcmp(dst_y_ref, dst_y, dst_y_size) ||
+        memcmp(dst_uv_ref, dst_uv, dst_uv_size)) {
+      printf("nv12 rotate %d %dx%d cpu %d differs\n", mode, width, height,
+             kCpuFlags[f]);
+      ++err;
+    }
+  }
+  MaskCpuFlags(-1);
+  if (runs > 1) {
+    i420_time = get_time();
+    for (int i = 0; i < runs; ++i) {
+      NV12ToI420Rotate(src_y, src_stride_y, src_uv, src_stride_uv,
+                       dst_y, dst_stride_y, dst_u, dst_halfwidth,
+                       dst_v, dst_halfwidth, width, height, mode);
+    }
+    i420_time = (get_time() - i420_time) / runs;
+    printf("nv12 rotate %d %dx%d - %8d us c - %8d us mmx - %8d us opt - "
+           "%8d us to i420\n", mode, width, height,
+           static_cast<int>(times[0] * 1e6),
+           static_cast<int>(times[1] * 1e6),
+           static_cast<int>(times[2] * 1e6),
+           static_cast<int>(i420_time * 1e6));
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_uv)
+  free_aligned_buffer_16(dst_y_ref)
+  free_aligned_buffer_16(dst_uv_ref)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_uv)
+  free_aligned_buffer_16(dst_u)
+  free_aligned_buffer_16(dst_v)
+
+  return err;
+}
+
+TEST_F(libyuvTest, NV12Rotate) {
+  static const int kSizes[][2] = {
+    { 8, 8 }, { 1, 1 }, { 5, 3 }, { 33, 17 }, { 100, -71 }, { 7, 130 },
+    { 202, 34 },
+  };
+  static const RotationMode kModes[] = {
+    kRotate0, kRotate90, kRotate180, kRotate270
+  };
+  int err = 0;
+
+  for (size_t m = 0; m < sizeof(kModes) / sizeof(kModes[0]); ++m) {
+    for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+      err += TestNV12Rotate(kSizes[i][0], kSizes[i][1], kModes[m], 1);
+    }
+    if (kModes[m] != kRotate0) {
+      err += TestNV12Rotate(_benchmark_width, _benchmark_height, kModes[m],
+                            8);
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Rotates I420, NV12 and ARGB frames by 180 degrees in place, and checks
+// them against rotating into a second frame.
+static int TestRotate180InPlace(int width, int height, int runs) {
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (height + 1) >> 1;
+  const int stride_y = width + 3;
+  const int stride_uv = halfwidth + 5;
+  const int stride_nv = halfwidth * 2 + 2;
+  const int stride_argb = width * 4 + 4;
+  const int y_size = stride_y * height;
+  const int uv_size = stride_uv * halfheight;
+  const int nv_size = stride_nv * halfheight;
+  const int argb_size = stride_argb * height;
+  const int kCpuFlags[3] = { kCpuInitialized, kCpuInitialized | kCpuHasMMX |
+                             kCpuHasSSE, -1 };
+  double in_place_time = 0.0;
+  double separate_time = 0.0;
+  int err = 0;
+
+  align_buffer_16(src_y, y_size)
+  align_buffer_16(src_u, uv_size)
+  align_buffer_16(src_v, uv_size)
+  align_buffer_16(src_uv, nv_size)
+  align_buffer_16(src_argb, argb_size)
+  align_buffer_16(ref_y, y_size)
+  align_buffer_16(ref_u, uv_size)
+  align_buffer_16(ref_v, uv_size)
+  align_buffer_16(ref_uv, nv_size)
+  align_buffer_16(ref_argb, argb_size)
+  align_buffer_16(dst_y, y_size)
+  align_buffer_16(dst_u, uv_size)
+  align_buffer_16(dst_v, uv_size)
+  align_buffer_16(dst_uv, nv_size)
+  align_buffer_16(dst_argb, argb_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < y_size; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < uv_size; ++i) {
+    src_u[i] = (random() & 0xff);
+    src_v[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < nv_size; ++i) {
+    src_uv[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < argb_size; ++i) {
+    src_argb[i] = (random() & 0xff);
+  }
+  // Padding is copied, so rotating in place must leave it alone too.
+  memcpy(ref_y, src_y, y_size);
+  memcpy(ref_u, src_u, uv_size);
+  memcpy(ref_v, src_v, uv_size);
+  memcpy(ref_uv, src_uv, nv_size);
+  memcpy(ref_argb, src_argb, argb_size);
+  MaskCpuFlags(kCpuInitialized);
+  separate_time = get_time();
+  for (int i = 0; i < runs; ++i) {
+    I420Rotate(src_y, stride_y, src_u, stride_uv, src_v, stride_uv,
+               ref_y, stride_y, ref_u, stride_uv, ref_v, stride_uv,
+               width, height, kRotate180);
+  }
+  separate_time = (get_time() - separate_time) / runs;
+  NV12Rotate(src_y, stride_y, src_uv, stride_nv,
+             ref_y, stride_y, ref_uv, stride_nv, width, height, kRotate180);
+  ARGBRotate(src_argb, stride_argb, ref_argb, stride_argb,
+             width, height, kRotate180);
+
+  for (int f = 0; f < 3; ++f) {
+    MaskCpuFlags(kCpuFlags[f]);
+    memcpy(dst_y, src_y, y_size);
+    memcpy(dst_u, src_u, uv_size);
+    memcpy(dst_v, src_v, uv_size);
+    I420Rotate(dst_y, stride_y, dst_u, stride_uv, dst_v, stride_uv,
+               dst_y, stride_y, dst_u, stride_uv, dst_v, stride_uv,
+               width, height, kRotate180);
+    if (memcmp(ref_y, dst_y, y_size) || memcmp(ref_u, dst_u, uv_size) ||
+        memcmp(ref_v, dst_v, uv_size)) {
+      printf("i420 rotate 180 in place %dx%d cpu %d differs\n",
+             width, height, kCpuFlags[f]);
+      ++err;
+    }
+
+    memcpy(dst_y, src_y, y_size);
+    memcpy(dst_uv, src_uv, nv_size);
+    NV12Rotate(dst_y, stride_y, dst_uv, stride_nv,
+               dst_y, stride_y, dst_uv, stride_nv,
+               width, height, kRotate180);
+    if (memcmp(ref_y, dst_y, y_size) || memcmp(ref_uv, dst_uv, nv_size)) {
+      printf("nv12 rotate 180 in place %dx%d cpu %d differs\n",
+             width, height, kCpuFlags[f]);
+      ++err;
+    }
+
+    memcpy(dst_argb, src_argb, argb_size);
+    ARGBRotate(dst_argb, stride_argb, dst_argb, stride_argb,
+               width, height, kRotate180);
+    if (memcmp(ref_argb, dst_argb, argb_size)) {
+      printf("argb rotate 180 in place %dx%d cpu %d differs\n",
+             width, height, kCpuFlags[f]);
+      ++err;
+    }
+  }
+
+  // Rotating in place an even number of times gives back the source.
+  MaskCpuFlags(kCpuInitialized);
+  memcpy(dst_y, src_y, y_size);
+  memcpy(dst_u, src_u, uv_size);
+  memcpy(dst_v, src_v, uv_size);
+  in_place_time = get_time();
+  for (int i = 0; i < runs; ++i) {
+    I420Rotate(dst_y, stride_y, dst_u, stride_uv, dst_v, stride_uv,
+               dst_y, stride_y, dst_u, stride_uv, dst_v, stride_uv,
+               width, height, kRotate180);
+  }
+  in_place_time = (get_time() - in_place_time) / runs;
+  if ((runs & 1) == 0 &&
+      (memcmp(src_y, dst_y, y_size) || memcmp(src_u, dst_u, uv_size) ||
+       memcmp(src_v, dst_v, uv_size))) {
+    printf("i420 rotate 180 in place %dx%d twice differs\n", width, height);
+    ++err;
+  }
+  MaskCpuFlags(-1);
+  if (runs > 1) {
+    printf("i420 rotate 180 %dx%d - %8d us c separate - "
+           "%8d us c in place\n", width, height,
+           static_cast<int>(separate_time * 1e6),
+           static_cast<int>(in_place_time * 1e6));
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(src_uv)
+  free_aligned_buffer_16(src_argb)
+  free_aligned_buffer_16(ref_y)
+  free_aligned_buffer_16(ref_u)
+  free_aligned_buffer_16(ref_v)
+  free_aligned_buffer_16(ref_uv)
+  free_aligned_buffer_16(ref_argb)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_u)
+  free_aligned_buffer_16(dst_v)
+  free_aligned_buffer_16(dst_uv)
+  free_aligned_buffer_16(dst_argb)
+
+  return err;
+}
+
+TEST_F(libyuvTest, Rotate180InPlace) {
+  static const int kSizes[][2] = {
+    { 1, 1 }, { 2, 2 }, { 5, 3 }, { 33, 17 }, { 100, 71 }, { 7, 130 },
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    err += TestRotate180InPlace(kSizes[i][0], kSizes[i][1], 1);
+  }
+  err += TestRotate180InPlace(_benchmark_width, _benchmark_height, 8);
+
+  EXPECT_EQ(0, err);
+}
+
+typedef int (*I420ToRGBFunc)(const uint8* src_y, int src_stride_y,
+                             const uint8* src_u, int src_stride_u,
+                             const uint8* src_v, int src_stride_v,
+                             uint8* dst_rgb, int dst_stride_rgb,
+                             int width, int height);
+typedef int (*I420ToRGBRotateFunc)(const uint8* src_y, int src_stride_y,
+                                   const uint8* src_u, int src_stride_u,
+                                   const uint8* src_v, int src_stride_v,
+                                   uint8* dst_rgb, int dst_stride_rgb,
+                                   int width, int height, RotationMode mode);
+
+// Converts with the fused rotation, and with I420Rotate followed by the
+// conversion.
+static int TestI420ToRGBRotate(I420ToRGBFunc convert,
+                               I420ToRGBRotateFunc convert_rotate, int bpp,
+                               int width, int height, RotationMode mode,
+                               int runs) {
+  const int abs_height = (height < 0) ? -height : height;
+  const int halfwidth = (width + 1) >> 1;
+  const int halfheight = (abs_height + 1) >> 1;
+  const bool transpose = (mode == kRotate90 || mode == kRotate270);
+  const int dst_width = transpose ? abs_height : width;
+  const int dst_height = transpose ? width : abs_height;
+  const int dst_halfwidth = (dst_width + 1) >> 1;
+  const int rgb_stride = dst_width * bpp + 4;
+  const int rgb_size = rgb_stride * dst_height;
+
+  align_buffer_16(src_y, width * abs_height)
+  align_buffer_16(src_u, halfwidth * halfheight)
+  align_buffer_16(src_v, halfwidth * halfheight)
+  align_buffer_16(rot_y, width * abs_height)
+  align_buffer_16(rot_u, halfwidth * halfheight)
+  align_buffer_16(rot_v, halfwidth * halfheight)
+  align_buffer_16(dst_2pass, rgb_size)
+  align_buffer_16(dst_fused, rgb_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < width * abs_height; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < halfwidth * halfheight; ++i) {
+    src_u[i] = (random() & 0xff);
+    src_v[i] = (random() & 0xff);
+  }
+  memset(dst_2pass, 1, rgb_size);
+  memset(dst_fused, 1, rgb_size);
+
+  double time_2pass = get_time();
+  for (int i = 0; i < runs; ++i) {
+    I420Rotate(src_y, width, src_u, halfwidth, src_v, halfwidth,
+               rot_y, dst_width, rot_u, dst_halfwidth, rot_v, dst_halfwidth,
+               width, height, mode);
+    convert(rot_y, dst_width, rot_u, dst_halfwidth, rot_v, dst_halfwidth,
+            dst_2pass, rgb_stride, dst_width, dst_height);
+  }
+  time_2pass = (get_time() - time_2pass) / runs;
+
+  double time_fused = get_time();
+  for (int i = 0; i < runs; ++i) {
+    convert_rotate(src_y, width, src_u, halfwidth, src_v, halfwidth,
+                   dst_fused, rgb_stride, width, height, mode);
+  }
+  time_fused = (get_time() - time_fused) / runs;
+
+  if (runs > 1) {
+    printf("rgb%d rotate %d %dx%d - %8d us 2 pass - %8d us fused\n",
+           bpp * 8, mode, width, height,
+           static_cast<int>(time_2pass * 1e6),
+           static_cast<int>(time_fused * 1e6));
+  }
+  int err = 0;
+  if (memcmp(dst_2pass, dst_fused, rgb_size)) {
+    printf("rgb%d rotate %d %dx%d differs\n", bpp * 8, mode, width, height);
+    err = 1;
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(rot_y)
+  free_aligned_buffer_16(rot_u)
+  free_aligned_buffer_16(rot_v)
+  free_aligned_buffer_16(dst_2pass)
+  free_aligned_buffer_16(dst_fused)
+
+  return err;
+}
+
+TEST_F(libyuvTest, I420ToRGBRotate) {
+  static const int kSizes[][2] = {
+    { 16, 16 }, { 1, 1 }, { 7, 5 }, { 33, 17 }, { 100, 71 }, { 71, 100 },
+    { 34, -18 },
+  };
+  static const RotationMode kModes[] = {
+    kRotate0, kRotate90, kRotate180, kRotate270
+  };
+  int err = 0;
+
+  for (size_t m = 0; m < sizeof(kModes) / sizeof(kModes[0]); ++m) {
+    for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+      err += TestI420ToRGBRotate(I420ToARGB, I420ToARGBRotate, 4,
+                                 kSizes[i][0], kSizes[i][1], kModes[m], 1);
+      err += TestI420ToRGBRotate(I420ToRGB565_, I420ToRGB565Rotate, 2,
+                                 kSizes[i][0], kSizes[i][1], kModes[m], 1);
+    }
+    err += TestI420ToRGBRotate(I420ToARGB, I420ToARGBRotate, 4,
+                               _benchmark_width, _benchmark_height,
+                               kModes[m], 8);
+    err += TestI420ToRGBRotate(I420ToRGB565_, I420ToRGB565Rotate, 2,
+                               _benchmark_width, _benchmark_height,
+                               kModes[m], 8);
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Rotates a plane by 90 and 270 degrees with streaming stores, with SSE and
+// with all optimizations, and checks it against the cached rotation.
+// Streaming needs 64 byte aligned destination rows, and the padding after
+// each row must be left alone.
+static int TestRotateNonTemporal(int width, int height, int runs) {
+  const int src_stride = width + 3;
+  const int dst_stride = (height + 127) & ~63;
+  const int src_size = src_stride * height;
+  const int dst_size = dst_stride * width;
+  const int kCpuFlags[2] = {
+    kCpuInitialized | kCpuHasMMX | kCpuHasSSE, -1
+  };
+  double cached_time;
+  double streamed_time = 0.0;
+  int err = 0;
+
+  align_buffer_16(src, src_size)
+  align_buffer_16(dst_ref, dst_size)
+  align_buffer_16(dst_mem, dst_size + 48)
+  uint8* dst = ALIGNP(dst_mem, 64);
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_size; ++i) {
+    src[i] = (random() & 0xff);
+  }
+
+  for (int rotate270 = 0; rotate270 < 2; ++rotate270) {
+    memset(dst_ref, 0, dst_size);
+    SetNonTemporalThreshold(INT_MAX);
+    cached_time = get_time();
+    for (int i = 0; i < runs; ++i) {
+      if (rotate270) {
+        RotatePlane270(src, src_stride, dst_ref, dst_stride, width, height);
+      } else {
+        RotatePlane90(src, src_stride, dst_ref, dst_stride, width, height);
+      }
+    }
+    cached_time = (get_time() - cached_time) / runs;
+
+    SetNonTemporalThreshold(0);
+    for (int f = 0; f < 2; ++f) {
+      MaskCpuFlags(kCpuFlags[f]);
+      memset(dst, 0, dst_size);
+      streamed_time = get_time();
+      for (int i = 0; i < runs; ++i) {
+        if (rotate270) {
+          RotatePlane270(src, src_stride, dst, dst_stride, width, height);
+        } else {
+          RotatePlane90(src, src_stride, dst, dst_stride, width, height);
+        }
+      }
+      streamed_time = (get_time() - streamed_time) / runs;
+      if (memcmp(dst_ref, dst, dst_size)) {
+        printf("streamed rotate %d %dx%d cpu %d differs\n",
+               rotate270 ? 270 : 90, width, height, kCpuFlags[f]);
+        ++err;
+      }
+    }
+    MaskCpuFlags(-1);
+    if (runs > 1) {
+      printf("rotate %d %dx%d - %8d us cached - %8d us streamed\n",
+             rotate270 ? 270 : 90, width, height,
+             static_cast<int>(cached_time * 1e6),
+             static_cast<int>(streamed_time * 1e6));
+    }
+  }
+  SetNonTemporalThreshold(256 * 1024);
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_ref)
+  free_aligned_buffer_16(dst_mem)
+
+  return err;
+}
+
+TEST_F(libyuvTest, RotateNonTemporal) {
+  static const int kSizes[][2] = {
+    { 8, 8 }, { 1, 1 }, { 7, 5 }, { 33, 17 }, { 100, 71 }, { 71, 100 },
+    { 130, 67 },
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    err += TestRotateNonTemporal(kSizes[i][0], kSizes[i][1], 1);
+  }
+  err += TestRotateNonTemporal(1920, 1080, 8);
+  err += TestRotateNonTemporal(3840, 2160, 4);
+
+  EXPECT_EQ(0, err);
+}
+
 }  // namespace libyuv
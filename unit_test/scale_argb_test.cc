@@ -0,0 +1,174 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "unit_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libyuv/cpu_id.h"
+#include "libyuv/scale_argb.h"
+
+namespace libyuv {
+
+static int ARGBTestFilter(int src_width, int src_height,
+                          int dst_width, int dst_height,
+                          FilterMode f) {
+  const int b = 128;
+  const int src_stride = (b * 2 + src_width) * 4;
+  const int dst_stride = (b * 2 + dst_width) * 4;
+  const int src_size = src_stride * (src_height + b * 2);
+  const int dst_size = dst_stride * (dst_height + b * 2);
+
+  align_buffer_16(src_argb, src_size)
+  align_buffer_16(dst_argb_c, dst_size)
+  align_buffer_16(dst_argb_opt, dst_size)
+
+  srandom(time(NULL));
+  for (int i = b; i < (src_height + b); ++i) {
+    for (int j = b * 4; j < (src_width + b) * 4; ++j) {
+      src_argb[(i * src_stride) + j] = (random() & 0xff);
+    }
+  }
+
+  const int runs = 64;
+  MaskCpuFlags(kCpuInitialized);
+  double c_time = get_time();
+  for (int i = 0; i < runs; ++i) {
+    ARGBScale(src_argb + (src_stride * b) + b * 4, src_stride,
+              src_width, src_height,
+              dst_argb_c + (dst_stride * b) + b * 4, dst_stride,
+              dst_width, dst_height, f);
+  }
+  c_time = (get_time() - c_time) / runs;
+
+  MaskCpuFlags(-1);
+  double opt_time = get_time();
+  for (int i = 0; i < runs; ++i) {
+    ARGBScale(src_argb + (src_stride * b) + b * 4, src_stride,
+              src_width, src_height,
+              dst_argb_opt + (dst_stride * b) + b * 4, dst_stride,
+              dst_width, dst_height, f);
+  }
+  opt_time = (get_time() - opt_time) / runs;
+
+  printf("filter %d - %8d us c - %8d us opt\n",
+         f, static_cast<int>(c_time * 1e6), static_cast<int>(opt_time * 1e6));
+
+  // ScaleARGBRowDown2Int_SSE2 rounds up in each of its two pavgb steps,
+  // where C rounds the sum of 4 pixels once, so a channel may come out 1
+  // higher.  Every other scale matches exactly.  Nothing is written
+  // outside the image, in any row.
+  const int max_allowed = (f && dst_width * 2 == src_width &&
+                           dst_height * 2 == src_height) ? 1 : 0;
+  int max_diff = 0;
+  for (int i = 0; i < dst_height + b * 2; ++i) {
+    const bool row_inside = (i >= b && i < dst_height + b);
+    for (int j = 0; j < dst_stride; ++j) {
+      const int c = dst_argb_c[(i * dst_stride) + j];
+      const int opt = dst_argb_opt[(i * dst_stride) + j];
+      if (!row_inside || j < b * 4 || j >= (dst_width + b) * 4) {
+        if (c || opt) {
+          max_diff = 255;
+        }
+      } else if (abs(c - opt) > max_diff) {
+        max_diff = abs(c - opt);
+      }
+    }
+  }
+
+  free_aligned_buffer_16(dst_argb_c)
+  free_aligned_buffer_16(dst_argb_opt)
+  free_aligned_buffer_16(src_argb)
+
+  if (max_diff > max_allowed) {
+    printf("%dx%d -> %dx%d filter %d max diff %d\n", src_width, src_height,
+           dst_width, dst_height, f, max_diff);
+  }
+  return (max_diff > max_allowed) ? 1 : 0;
+}
+
+TEST_F(libyuvTest, ARGBScaleDownBy2) {
+  const int src_width = 1280;
+  const int src_height = 720;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f) {
+    err += ARGBTestFilter(src_width, src_height,
+                          src_width >> 1, src_height >> 1,
+                          static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, ARGBScaleDownBox) {
+  const int src_width = 1280;
+  const int src_height = 720;
+  int err = 0;
+
+  err += ARGBTestFilter(src_width, src_height, 320, 180, kFilterBox);
+  err += ARGBTestFilter(src_width, src_height, 214, 121, kFilterBox);
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, ARGBScaleAnySize) {
+  const int src_width = 640;
+  const int src_height = 360;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f) {
+    err += ARGBTestFilter(src_width, src_height, 1280, 720,
+                          static_cast<FilterMode>(f));
+    err += ARGBTestFilter(src_width, src_height, 853, 481,
+                          static_cast<FilterMode>(f));
+    err += ARGBTestFilter(src_width, src_height, 480, 270,
+                          static_cast<FilterMode>(f));
+    err += ARGBTestFilter(src_width - 2, src_height, 401, 1,
+                          static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Every channel of a flat image must stay flat, and bilinear scaling of a
+// single row must not read past it.
+TEST_F(libyuvTest, ARGBScaleFlat) {
+  const int src_width = 97;
+  const int src_height = 1;
+  const int dst_width = 300;
+  const int dst_height = 5;
+  uint32 src_argb[src_width * src_height];
+  uint32 dst_argb[dst_width * dst_height];
+  for (int i = 0; i < src_width * src_height; ++i) {
+    src_argb[i] = 0x80ff4001u;
+  }
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f) {
+    memset(dst_argb, 0, sizeof(dst_argb));
+    ARGBScale(reinterpret_cast<uint8*>(src_argb), src_width * 4,
+              src_width, src_height,
+              reinterpret_cast<uint8*>(dst_argb), dst_width * 4,
+              dst_width, dst_height, static_cast<FilterMode>(f));
+    for (int i = 0; i < dst_width * dst_height; ++i) {
+      if (dst_argb[i] != 0x80ff4001u) {
+        ++err;
+        break;
+      }
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+}  // namespace libyuv
@@ -11,16 +11,19 @@
 #include "unit_test.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "libyuv/cpu_id.h"
+#include "libyuv/planar_functions.h"
 #include "libyuv/scale.h"
 
 namespace libyuv {
 
-static int TestFilter(int src_width, int src_height,
-                      int dst_width, int dst_height,
-                      FilterMode f) {
+// Scales with C and with the row functions allowed by cpu_flags.
+static int TestFilterCpu(int src_width, int src_height,
+                         int dst_width, int dst_height,
+                         FilterMode f, int cpu_flags) {
 
   int b = 128;
   int src_width_uv = (src_width + 1) >> 1;
@@ -85,7 +88,7 @@ static int TestFilter(int src_width, int src_height,
 
   c_time = (get_time() - c_time) / runs;
 
-  MaskCpuFlags(-1);
+  MaskCpuFlags(cpu_flags);
   double opt_time = get_time();
 
   for (i = 0; i < runs; ++i)
@@ -99,6 +102,7 @@ static int TestFilter(int src_width, int src_height,
               dst_width, dst_height, f);
 
   opt_time = (get_time() - opt_time) / runs;
+  MaskCpuFlags(-1);
 
   printf ("filter %d - %8d us c - %8d us opt\n",
           f, (int)(c_time*1e6), (int)(opt_time*1e6));
@@ -149,6 +153,12 @@ static int TestFilter(int src_width, int src_height,
   return err;
 }
 
+static int TestFilter(int src_width, int src_height,
+                      int dst_width, int dst_height,
+                      FilterMode f) {
+  return TestFilterCpu(src_width, src_height, dst_width, dst_height, f, -1);
+}
+
 TEST_F(libyuvTest, ScaleDownBy2) {
 
   const int src_width = 1280;
@@ -165,6 +175,79 @@ TEST_F(libyuvTest, ScaleDownBy2) {
   EXPECT_EQ(0, err);
 }
 
+// Scales planes with no padding, so the stride is the width and rows
+// after the first are not 16 byte aligned, with C and with all
+// optimizations.
+static int TestScaleContiguous(int src_width, int src_height,
+                               int dst_width, int dst_height, FilterMode f) {
+  const int src_width_uv = (src_width + 1) >> 1;
+  const int src_height_uv = (src_height + 1) >> 1;
+  const int dst_width_uv = (dst_width + 1) >> 1;
+  const int dst_height_uv = (dst_height + 1) >> 1;
+  const int src_y_size = src_width * src_height;
+  const int src_uv_size = src_width_uv * src_height_uv;
+  const int dst_y_size = dst_width * dst_height;
+  const int dst_uv_size = dst_width_uv * dst_height_uv;
+  const int dst_size = dst_y_size + dst_uv_size * 2;
+
+  align_buffer_16(src, src_y_size + src_uv_size * 2)
+  align_buffer_16(dst_c, dst_size)
+  align_buffer_16(dst_opt, dst_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_y_size + src_uv_size * 2; ++i) {
+    src[i] = (random() & 0xff);
+  }
+  const uint8* src_u = src + src_y_size;
+  const uint8* src_v = src_u + src_uv_size;
+
+  uint8* const dst[2] = { dst_c, dst_opt };
+  const int cpu_flags[2] = { kCpuInitialized, -1 };
+  for (int i = 0; i < 2; ++i) {
+    MaskCpuFlags(cpu_flags[i]);
+    I420Scale(src, src_width, src_u, src_width_uv, src_v, src_width_uv,
+              src_width, src_height,
+              dst[i], dst_width,
+              dst[i] + dst_y_size, dst_width_uv,
+              dst[i] + dst_y_size + dst_uv_size, dst_width_uv,
+              dst_width, dst_height, f);
+  }
+  MaskCpuFlags(-1);
+
+  int err = 0;
+  for (int i = 0; i < dst_size; ++i) {
+    if (abs(dst_c[i] - dst_opt[i]) > 2) {
+      printf("contiguous %dx%d -> %dx%d filter %d differs\n",
+             src_width, src_height, dst_width, dst_height, f);
+      err++;
+      break;
+    }
+  }
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_c)
+  free_aligned_buffer_16(dst_opt)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ScaleDownBy2Contiguous) {
+  static const int kSizes[][2] = {
+    { 720, 480 }, { 176, 144 }, { 352, 288 }, { 1366, 768 }, { 100, 100 },
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    for (int f = 0; f < 3; ++f) {
+      err += TestScaleContiguous(kSizes[i][0], kSizes[i][1],
+                                 kSizes[i][0] / 2, kSizes[i][1] / 2,
+                                 static_cast<FilterMode>(f));
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
 TEST_F(libyuvTest, ScaleDownBy4) {
 
   const int src_width = 1280;
@@ -213,4 +296,1393 @@ TEST_F(libyuvTest, ScaleDownBy38) {
   EXPECT_EQ(0, err);
 }
 
+TEST_F(libyuvTest, ScaleUpBy2) {
+  const int src_width = 640;
+  const int src_height = 360;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f)
+    err += TestFilter (src_width, src_height,
+                       src_width * 2, src_height * 2,
+                       static_cast<FilterMode>(f));
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, ScaleUpBy32) {
+  const int src_width = 640;
+  const int src_height = 480;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f)
+    err += TestFilter (src_width, src_height,
+                       (src_width * 3) >> 1, (src_height * 3) >> 1,
+                       static_cast<FilterMode>(f));
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, ScaleUpBy43) {
+  const int src_width = 960;
+  const int src_height = 540;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f)
+    err += TestFilter (src_width, src_height,
+                       (src_width * 4) / 3, (src_height * 4) / 3,
+                       static_cast<FilterMode>(f));
+
+  EXPECT_EQ(0, err);
+}
+
+// Returns the largest difference between the upscaling path and the
+// reference path that SetUseReferenceImpl selects.
+static int TestUpReferenceDiff(int src_width, int src_height,
+                               int dst_width, int dst_height,
+                               FilterMode f) {
+  const int src_size = src_width * src_height;
+  const int dst_size = dst_width * dst_height;
+  align_buffer_16(src, src_size)
+  align_buffer_16(dst_ref, dst_size)
+  align_buffer_16(dst_up, dst_size)
+  srandom(time(NULL));
+  for (int i = 0; i < src_size; ++i) {
+    src[i] = (random() & 0xff);
+  }
+
+  SetUseReferenceImpl(true);
+  ScalePlane(src, src_width, src_width, src_height,
+             dst_ref, dst_width, dst_width, dst_height, f);
+  SetUseReferenceImpl(false);
+  ScalePlane(src, src_width, src_width, src_height,
+             dst_up, dst_width, dst_width, dst_height, f);
+
+  int max_diff = 0;
+  for (int i = 0; i < dst_size; ++i) {
+    int abs_diff = abs(dst_ref[i] - dst_up[i]);
+    if (abs_diff > max_diff) {
+      max_diff = abs_diff;
+    }
+  }
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_ref)
+  free_aligned_buffer_16(dst_up)
+  return max_diff;
+}
+
+// Point sampling up matches the reference exactly.  Filtered, the upscaling
+// path rounds where the reference truncates, places each pixel exactly
+// where the reference adds a truncated 16.16 step that drifts by up to
+// dst_size / 65536 pixels, and uses 64ths for the 3/2 and 4/3 phases, such
+// as 21/64 for 1/3.  On random pixels, where neighbours differ by up to
+// 255, that bounds the difference by the amounts below.
+TEST_F(libyuvTest, ScaleUpReference) {
+  const int sizes[][5] = {
+    { 640, 360, 1280, 720, 2 },
+    { 640, 480, 960, 720, 6 },
+    { 960, 540, 1280, 720, 3 },
+    { 640, 480, 1918, 1082, 4 },
+    { 176, 144, 353, 289, 3 },
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    for (int f = 0; f < 3; ++f) {
+      int max_diff = TestUpReferenceDiff(sizes[i][0], sizes[i][1],
+                                         sizes[i][2], sizes[i][3],
+                                         static_cast<FilterMode>(f));
+      int max_allowed = f ? sizes[i][4] : 0;
+      if (max_diff > max_allowed) {
+        printf("%dx%d -> %dx%d filter %d max diff %d\n", sizes[i][0],
+               sizes[i][1], sizes[i][2], sizes[i][3], f, max_diff);
+        ++err;
+      }
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, ScaleUpAnySize) {
+  const int src_width = 640;
+  const int src_height = 480;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f) {
+    err += TestFilter (src_width, src_height,
+                       1280, 720,
+                       static_cast<FilterMode>(f));
+    err += TestFilter (src_width, src_height,
+                       1918, 1082,
+                       static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Sources wider than the 2560 pixel stack row buffers.
+TEST_F(libyuvTest, ScaleDownWide) {
+  const int src_width = 3840;
+  const int src_height = 256;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f) {
+    err += TestFilter (src_width, src_height,
+                       1000, 100,
+                       static_cast<FilterMode>(f));
+    err += TestFilter (src_width, src_height,
+                       (src_width*3) >> 2, (src_height*3) >> 2,
+                       static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, ScalePolyphase) {
+  const int src_width = 640;
+  const int src_height = 360;
+  int err = 0;
+
+  for (int f = kFilterBicubic; f <= kFilterLanczos; ++f) {
+    err += TestFilter (src_width, src_height,
+                       src_width >> 1, src_height >> 1,
+                       static_cast<FilterMode>(f));
+    err += TestFilter (src_width, src_height,
+                       (src_width * 3) >> 3, (src_height * 3) >> 3,
+                       static_cast<FilterMode>(f));
+    err += TestFilter (src_width, src_height,
+                       src_width >> 3, src_height >> 3,
+                       static_cast<FilterMode>(f));
+    err += TestFilter (src_width, src_height,
+                       1280, 720,
+                       static_cast<FilterMode>(f));
+    err += TestFilter (src_width, src_height,
+                       1002, 566,
+                       static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Every phase of a polyphase filter sums to 1, so a flat image must stay
+// exactly flat, including at the edges.
+TEST_F(libyuvTest, ScalePolyphaseFlat) {
+  const int src_width = 160;
+  const int src_height = 120;
+  const int dst_sizes[][2] = { { 53, 41 }, { 320, 240 }, { 250, 97 } };
+  const int src_size = src_width * src_height;
+  const int src_size_uv = ((src_width + 1) >> 1) * ((src_height + 1) >> 1);
+  int err = 0;
+
+  align_buffer_16(src, src_size + src_size_uv * 2)
+  memset(src, 77, src_size + src_size_uv * 2);
+  for (size_t i = 0; i < sizeof(dst_sizes) / sizeof(dst_sizes[0]); ++i) {
+    for (int f = kFilterBicubic; f <= kFilterLanczos; ++f) {
+      const int dst_width = dst_sizes[i][0];
+      const int dst_height = dst_sizes[i][1];
+      const int dst_width_uv = (dst_width + 1) >> 1;
+      const int dst_size = dst_width * dst_height;
+      const int dst_size_uv = dst_width_uv * ((dst_height + 1) >> 1);
+      align_buffer_16(dst, dst_size + dst_size_uv * 2)
+      I420Scale(src, src_width,
+                src + src_size, (src_width + 1) >> 1,
+                src + src_size + src_size_uv, (src_width + 1) >> 1,
+                src_width, src_height,
+                dst, dst_width,
+                dst + dst_size, dst_width_uv,
+                dst + dst_size + dst_size_uv, dst_width_uv,
+                dst_width, dst_height, static_cast<FilterMode>(f));
+      for (int j = 0; j < dst_size + dst_size_uv * 2; ++j) {
+        if (dst[j] != 77) {
+          ++err;
+          break;
+        }
+      }
+      free_aligned_buffer_16(dst)
+    }
+  }
+  free_aligned_buffer_16(src)
+
+  EXPECT_EQ(0, err);
+}
+
+// Reductions that need more than 16 taps are box filtered, rather than run
+// a wide polyphase filter in C.
+TEST_F(libyuvTest, ScalePolyphaseWideIsBox) {
+  const int src_width = 640;
+  const int src_height = 360;
+  const int dst_sizes[][2] = { { 80, 45 }, { 150, 90 }, { 639, 60 } };
+  const int src_size = src_width * src_height;
+  int err = 0;
+
+  align_buffer_16(src, src_size)
+  align_buffer_16(dst_box, src_size)
+  align_buffer_16(dst, src_size)
+  srandom(time(NULL));
+  for (int i = 0; i < src_size; ++i) {
+    src[i] = (random() & 0xff);
+  }
+  for (size_t i = 0; i < sizeof(dst_sizes) / sizeof(dst_sizes[0]); ++i) {
+    const int dst_width = dst_sizes[i][0];
+    const int dst_height = dst_sizes[i][1];
+    ScalePlane(src, src_width, src_width, src_height,
+               dst_box, dst_width, dst_width, dst_height, kFilterBox);
+    for (int f = kFilterBicubic; f <= kFilterLanczos; ++f) {
+      ScalePlane(src, src_width, src_width, src_height,
+                 dst, dst_width, dst_width, dst_height,
+                 static_cast<FilterMode>(f));
+      if (memcmp(dst, dst_box, dst_width * dst_height)) {
+        printf("%dx%d filter %d differs from box\n", dst_width, dst_height, f);
+        ++err;
+      }
+    }
+  }
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_box)
+  free_aligned_buffer_16(dst)
+
+  EXPECT_EQ(0, err);
+}
+
+// With the height unchanged the bilinear scaler filters rows with a
+// fraction of 0, except for the last row, so the output of every column
+// filter must match the C version exactly.
+static int TestFilterCols(int src_width, int dst_width, int cpu_flags) {
+  const int height = 16;
+  const int src_width_uv = (src_width + 1) >> 1;
+  const int dst_width_uv = (dst_width + 1) >> 1;
+  const int height_uv = (height + 1) >> 1;
+  const int src_y_size = src_width * height;
+  const int src_uv_size = src_width_uv * height_uv;
+  const int dst_y_size = dst_width * height;
+  const int dst_uv_size = dst_width_uv * height_uv;
+
+  align_buffer_16(src_y, src_y_size)
+  align_buffer_16(src_u, src_uv_size)
+  align_buffer_16(src_v, src_uv_size)
+  align_buffer_16(dst_c, dst_y_size + dst_uv_size * 2)
+  align_buffer_16(dst_opt, dst_y_size + dst_uv_size * 2)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_y_size; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < src_uv_size; ++i) {
+    src_u[i] = (random() & 0xff);
+    src_v[i] = (random() & 0xff);
+  }
+
+  MaskCpuFlags(kCpuInitialized);
+  I420Scale(src_y, src_width, src_u, src_width_uv, src_v, src_width_uv,
+            src_width, height,
+            dst_c, dst_width,
+            dst_c + dst_y_size, dst_width_uv,
+            dst_c + dst_y_size + dst_uv_size, dst_width_uv,
+            dst_width, height, kFilterBilinear);
+
+  MaskCpuFlags(cpu_flags);
+  I420Scale(src_y, src_width, src_u, src_width_uv, src_v, src_width_uv,
+            src_width, height,
+            dst_opt, dst_width,
+            dst_opt + dst_y_size, dst_width_uv,
+            dst_opt + dst_y_size + dst_uv_size, dst_width_uv,
+            dst_width, height, kFilterBilinear);
+  MaskCpuFlags(-1);
+
+  int err = 0;
+  if (memcmp(dst_c, dst_opt, dst_y_size + dst_uv_size * 2) != 0) {
+    printf("filter cols %d -> %d with cpu flags %x differs from C\n",
+           src_width, dst_width, cpu_flags);
+    err++;
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(dst_c)
+  free_aligned_buffer_16(dst_opt)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ScaleFilterColsExact) {
+  const int src_width = 1280;
+  const int dst_widths[] = { 1000, 872, 632, 424, 1696, 2560, 1234 };
+  // SSSE3 is left out because its row filter uses 7 bit fractions for the
+  // last row, which is clamped to filter the last 2 source rows.
+  const int cpu_flags[] = {
+    kCpuInitialized | kCpuHasMMX | kCpuHasSSE,
+    kCpuInitialized | kCpuHasMMX | kCpuHasSSE | kCpuHasSSE2
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(dst_widths) / sizeof(dst_widths[0]); ++i) {
+    for (size_t j = 0; j < sizeof(cpu_flags) / sizeof(cpu_flags[0]); ++j) {
+      err += TestFilterCols(src_width, dst_widths[i], cpu_flags[j]);
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Processors without SSE2 use the MMX and SSE row functions.
+TEST_F(libyuvTest, ScaleDownMMX) {
+  const int src_width = 1280;
+  const int src_height = 720;
+  const int dst_sizes[][2] = {
+    { 640, 360 }, { 320, 180 }, { 160, 90 }, { 960, 540 }, { 480, 270 },
+    { 400, 200 }, { 853, 481 }
+  };
+  const int cpu_flags = kCpuInitialized | kCpuHasMMX | kCpuHasSSE;
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(dst_sizes) / sizeof(dst_sizes[0]); ++i) {
+    for (int f = 0; f < 3; ++f) {
+      err += TestFilterCpu(src_width, src_height,
+                           dst_sizes[i][0], dst_sizes[i][1],
+                           static_cast<FilterMode>(f), cpu_flags);
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// The MMX and SSE 3/4 point sampler and 3/8 row functions match C exactly.
+// The 3/4 filter blends rows with ScaleBlendRows_MMX and is checked within
+// a tolerance by ScaleDownMMX.  The planes are 2 pixels wider than the
+// scaled rows, so writes past a row show up.
+TEST_F(libyuvTest, ScaleDown34And38SSE) {
+  // Source and destination sizes and the number of filters to check.
+  const int sizes[][5] = {
+    { 1280, 720, 960, 540, 1 }, { 8, 4, 6, 3, 1 }, { 1280, 720, 480, 270, 3 },
+    { 16, 8, 6, 3, 3 }, { 176, 144, 66, 54, 3 }
+  };
+  const FilterMode filters[] = { kFilterNone, kFilterBilinear, kFilterBox };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    const int src_width = sizes[i][0];
+    const int src_height = sizes[i][1];
+    const int dst_width = sizes[i][2];
+    const int dst_height = sizes[i][3];
+    const int dst_stride = dst_width + 2;
+    const int src_size = src_width * src_height;
+    const int dst_size = dst_stride * dst_height;
+    align_buffer_16(src, src_size)
+    align_buffer_16(dst_c, dst_size)
+    align_buffer_16(dst_opt, dst_size)
+
+    srandom(time(NULL));
+    for (int j = 0; j < src_size; ++j) {
+      src[j] = (random() & 0xff);
+    }
+
+    for (int f = 0; f < sizes[i][4]; ++f) {
+      memset(dst_c, 0, dst_size);
+      memset(dst_opt, 0, dst_size);
+      MaskCpuFlags(kCpuInitialized);
+      ScalePlane(src, src_width, src_width, src_height,
+                 dst_c, dst_stride, dst_width, dst_height, filters[f]);
+      MaskCpuFlags(kCpuInitialized | kCpuHasMMX | kCpuHasSSE);
+      ScalePlane(src, src_width, src_width, src_height,
+                 dst_opt, dst_stride, dst_width, dst_height, filters[f]);
+      MaskCpuFlags(-1);
+      if (memcmp(dst_c, dst_opt, dst_size)) {
+        printf("%dx%d -> %dx%d filter %d differs\n",
+               src_width, src_height, dst_width, dst_height, filters[f]);
+        ++err;
+      }
+    }
+
+    free_aligned_buffer_16(src)
+    free_aligned_buffer_16(dst_c)
+    free_aligned_buffer_16(dst_opt)
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Box filters any width and ratio, checked against the average of each box
+// of source pixels.  Boxes of up to 4096 pixels are exact.
+static int TestScaleBox(int src_width, int src_height,
+                        int dst_width, int dst_height, int cpu_flags) {
+  const int src_size = src_width * src_height;
+  const int dst_size = dst_width * dst_height;
+  align_buffer_16(src, src_size)
+  align_buffer_16(dst, dst_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_size; ++i) {
+    src[i] = (random() & 0xff);
+  }
+
+  MaskCpuFlags(cpu_flags);
+  ScalePlane(src, src_width, src_width, src_height,
+             dst, dst_width, dst_width, dst_height, kFilterBox);
+  MaskCpuFlags(-1);
+
+  const int dx = (src_width << 16) / dst_width;
+  const int dy = (src_height << 16) / dst_height;
+  int err = 0;
+  for (int j = 0; j < dst_height; ++j) {
+    const int y0 = (j * dy) >> 16;
+    const int y1 = ((j + 1) * dy) >> 16;
+    for (int i = 0; i < dst_width; ++i) {
+      const int x0 = (i * dx) >> 16;
+      const int x1 = ((i + 1) * dx) >> 16;
+      int sum = 0;
+      for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+          sum += src[y * src_width + x];
+        }
+      }
+      const int area = (x1 - x0) * (y1 - y0);
+      const int diff = dst[j * dst_width + i] - sum / area;
+      if (diff < 0 || diff > (area <= 4096 ? 0 : 1)) {
+        ++err;
+      }
+    }
+  }
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst)
+
+  if (err) {
+    printf("box %dx%d -> %dx%d with cpu flags %x differs in %d pixels\n",
+           src_width, src_height, dst_width, dst_height, cpu_flags, err);
+    return 1;
+  }
+  return 0;
+}
+
+TEST_F(libyuvTest, ScaleBoxAnySize) {
+  const int sizes[][4] = {
+    { 1280, 720, 400, 200 }, { 1278, 721, 301, 97 }, { 97, 53, 13, 7 },
+    { 640, 480, 37, 1 }, { 1000, 300, 3, 2 }, { 642, 600, 641, 2 }
+  };
+  const int cpu_flags[] = {
+    kCpuInitialized,
+    kCpuInitialized | kCpuHasMMX | kCpuHasSSE,
+    -1
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    for (size_t j = 0; j < sizeof(cpu_flags) / sizeof(cpu_flags[0]); ++j) {
+      err += TestScaleBox(sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3],
+                          cpu_flags[j]);
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Runs the jobs serially in reverse order, to check that bands do not
+// depend on each other.
+static void ReverseExecutor(void* opaque, ParallelJob job, void* job_opaque,
+                            int count) {
+  int* num_jobs = static_cast<int*>(opaque);
+  for (int i = count - 1; i >= 0; --i) {
+    job(job_opaque, i);
+    ++*num_jobs;
+  }
+}
+
+static int TestParallel(int src_width, int src_height,
+                        int dst_width, int dst_height,
+                        FilterMode f, int num_threads, bool use_executor) {
+  int src_width_uv = (src_width + 1) >> 1;
+  int src_height_uv = (src_height + 1) >> 1;
+  int dst_width_uv = (dst_width + 1) >> 1;
+  int dst_height_uv = (dst_height + 1) >> 1;
+
+  int src_y_plane_size = src_width * src_height;
+  int src_uv_plane_size = src_width_uv * src_height_uv;
+  int dst_y_plane_size = dst_width * dst_height;
+  int dst_uv_plane_size = dst_width_uv * dst_height_uv;
+
+  align_buffer_16(src_y, src_y_plane_size)
+  align_buffer_16(src_u, src_uv_plane_size)
+  align_buffer_16(src_v, src_uv_plane_size)
+  align_buffer_16(dst_y_1, dst_y_plane_size)
+  align_buffer_16(dst_u_1, dst_uv_plane_size)
+  align_buffer_16(dst_v_1, dst_uv_plane_size)
+  align_buffer_16(dst_y_n, dst_y_plane_size)
+  align_buffer_16(dst_u_n, dst_uv_plane_size)
+  align_buffer_16(dst_v_n, dst_uv_plane_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_y_plane_size; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < src_uv_plane_size; ++i) {
+    src_u[i] = (random() & 0xff);
+    src_v[i] = (random() & 0xff);
+  }
+
+  I420Scale(src_y, src_width,
+            src_u, src_width_uv,
+            src_v, src_width_uv,
+            src_width, src_height,
+            dst_y_1, dst_width,
+            dst_u_1, dst_width_uv,
+            dst_v_1, dst_width_uv,
+            dst_width, dst_height, f);
+
+  int num_jobs = 0;
+  I420ScaleParallel(src_y, src_width,
+                    src_u, src_width_uv,
+                    src_v, src_width_uv,
+                    src_width, src_height,
+                    dst_y_n, dst_width,
+                    dst_u_n, dst_width_uv,
+                    dst_v_n, dst_width_uv,
+                    dst_width, dst_height, f, num_threads,
+                    use_executor ? ReverseExecutor : NULL, &num_jobs);
+
+  int err = 0;
+  if (use_executor && num_jobs < 3) {
+    err++;
+  }
+  if (memcmp(dst_y_1, dst_y_n, dst_y_plane_size) ||
+      memcmp(dst_u_1, dst_u_n, dst_uv_plane_size) ||
+      memcmp(dst_v_1, dst_v_n, dst_uv_plane_size)) {
+    printf("%dx%d -> %dx%d filter %d threads %d differs\n",
+           src_width, src_height, dst_width, dst_height, f, num_threads);
+    err++;
+  }
+
+  free_aligned_buffer_16(dst_y_1)
+  free_aligned_buffer_16(dst_u_1)
+  free_aligned_buffer_16(dst_v_1)
+  free_aligned_buffer_16(dst_y_n)
+  free_aligned_buffer_16(dst_u_n)
+  free_aligned_buffer_16(dst_v_n)
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ScaleParallel) {
+  static const int kSizes[][4] = {
+    { 1280, 720, 640, 360 },   // 1/2
+    { 1280, 720, 320, 180 },   // 1/4
+    { 1280, 720, 960, 540 },   // 3/4
+    { 1280, 720, 480, 270 },   // 3/8
+    { 1280, 720, 160, 90 },    // 1/8
+    { 1920, 1080, 1280, 720 }, // arbitrary down
+    { 1280, 720, 300, 170 },   // box
+    { 640, 480, 1280, 720 },   // up
+    { 642, 483, 641, 481 },    // odd sizes
+    { 320, 240, 320, 240 },    // copy
+  };
+  int err = 0;
+
+  for (int i = 0; i < static_cast<int>(sizeof(kSizes) / sizeof(kSizes[0]));
+       ++i) {
+    for (int f = 0; f < 3; ++f) {
+      for (int t = 1; t <= 7; t += 3) {
+        err += TestParallel(kSizes[i][0], kSizes[i][1],
+                            kSizes[i][2], kSizes[i][3],
+                            static_cast<FilterMode>(f), t, false);
+      }
+      err += TestParallel(kSizes[i][0], kSizes[i][1],
+                          kSizes[i][2], kSizes[i][3],
+                          static_cast<FilterMode>(f), 5, true);
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, BenchmarkScaleParallel) {
+  const int src_width = 1920;
+  const int src_height = 1080;
+  const int dst_width = 1280;
+  const int dst_height = 720;
+  const int runs = 64;
+
+  align_buffer_16(src_y, src_width * src_height)
+  align_buffer_16(src_u, src_width * src_height / 4)
+  align_buffer_16(src_v, src_width * src_height / 4)
+  align_buffer_16(dst_y, dst_width * dst_height)
+  align_buffer_16(dst_u, dst_width * dst_height / 4)
+  align_buffer_16(dst_v, dst_width * dst_height / 4)
+
+  for (int t = 1; t <= 4; t *= 2) {
+    double time = get_time();
+    for (int i = 0; i < runs; ++i) {
+      I420ScaleParallel(src_y, src_width,
+                        src_u, src_width / 2,
+                        src_v, src_width / 2,
+                        src_width, src_height,
+                        dst_y, dst_width,
+                        dst_u, dst_width / 2,
+                        dst_v, dst_width / 2,
+                        dst_width, dst_height, kFilterBox, t, NULL, NULL);
+    }
+    time = (get_time() - time) / runs;
+    printf("threads %d - %8d us\n", t, static_cast<int>(time * 1e6));
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_u)
+  free_aligned_buffer_16(dst_v)
+}
+
+// Scales 2 frames with one plan, with an offset of 'offset' bytes on the
+// source planes, and compares them with I420Scale.
+static int TestScalePlan(int src_width, int src_height,
+                         int dst_width, int dst_height,
+                         FilterMode f, int offset) {
+  const int abs_src_height = src_height < 0 ? -src_height : src_height;
+  const int src_width_uv = (src_width + 1) >> 1;
+  const int src_height_uv = (abs_src_height + 1) >> 1;
+  const int dst_width_uv = (dst_width + 1) >> 1;
+  const int dst_height_uv = (dst_height + 1) >> 1;
+  const int src_y_size = src_width * abs_src_height;
+  const int src_uv_size = src_width_uv * src_height_uv;
+  const int dst_size = dst_width * dst_height +
+                       dst_width_uv * dst_height_uv * 2;
+
+  align_buffer_16(src, (src_y_size + src_uv_size * 2 + 16) * 2)
+  align_buffer_16(dst_1, dst_size)
+  align_buffer_16(dst_plan, dst_size)
+
+  ScalePlan* plan = ScalePlanCreate(src_width, src_height,
+                                    src_width, src_width_uv, src_width_uv,
+                                    dst_width, dst_height,
+                                    dst_width, dst_width_uv, dst_width_uv,
+                                    f);
+  int err = plan ? 0 : 1;
+  srandom(time(NULL));
+  for (int frame = 0; frame < 2 && plan; ++frame) {
+    uint8* src_y = src + frame * (src_y_size + src_uv_size * 2 + 16) + offset;
+    uint8* src_u = src_y + src_y_size;
+    uint8* src_v = src_u + src_uv_size;
+    for (int i = 0; i < src_y_size + src_uv_size * 2; ++i) {
+      src_y[i] = (random() & 0xff);
+    }
+    uint8* dst_u_1 = dst_1 + dst_width * dst_height;
+    uint8* dst_u_plan = dst_plan + dst_width * dst_height;
+    I420Scale(src_y, src_width, src_u, src_width_uv, src_v, src_width_uv,
+              src_width, src_height,
+              dst_1, dst_width,
+              dst_u_1, dst_width_uv,
+              dst_u_1 + dst_width_uv * dst_height_uv, dst_width_uv,
+              dst_width, dst_height, f);
+    ScalePlanExecute(plan, src_y, src_u, src_v,
+                     dst_plan, dst_u_plan,
+                     dst_u_plan + dst_width_uv * dst_height_uv);
+    if (memcmp(dst_1, dst_plan, dst_size)) {
+      printf("plan %dx%d -> %dx%d filter %d offset %d differs\n",
+             src_width, src_height, dst_width, dst_height, f, offset);
+      err++;
+    }
+  }
+  ScalePlanDestroy(plan);
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_1)
+  free_aligned_buffer_16(dst_plan)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ScalePlan) {
+  static const int kSizes[][4] = {
+    { 640, 480, 320, 240 },    // 1/2
+    { 640, 480, 480, 360 },    // 3/4
+    { 640, 480, 240, 180 },    // 3/8
+    { 640, 480, 100, 75 },     // box
+    { 640, 480, 600, 450 },    // bilinear
+    { 640, 480, 1280, 960 },   // 2x
+    { 640, 480, 1000, 400 },   // up and down
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    for (int f = 0; f <= kFilterLanczos; ++f) {
+      err += TestScalePlan(kSizes[i][0], kSizes[i][1],
+                           kSizes[i][2], kSizes[i][3],
+                           static_cast<FilterMode>(f), 0);
+    }
+    err += TestScalePlan(kSizes[i][0], -kSizes[i][1],
+                         kSizes[i][2], kSizes[i][3], kFilterBox, 0);
+    err += TestScalePlan(kSizes[i][0], kSizes[i][1],
+                         kSizes[i][2], kSizes[i][3], kFilterBilinear, 1);
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, BenchmarkScalePlan) {
+  const int src_width = 176;
+  const int src_height = 144;
+  const int dst_width = 128;
+  const int dst_height = 96;
+  const int runs = 1000;
+
+  align_buffer_16(src_y, src_width * src_height)
+  align_buffer_16(src_u, src_width * src_height / 4)
+  align_buffer_16(src_v, src_width * src_height / 4)
+  align_buffer_16(dst_y, dst_width * dst_height)
+  align_buffer_16(dst_u, dst_width * dst_height / 4)
+  align_buffer_16(dst_v, dst_width * dst_height / 4)
+
+  for (int f = kFilterBilinear; f <= kFilterLanczos; ++f) {
+    double scale_time = get_time();
+    for (int i = 0; i < runs; ++i) {
+      I420Scale(src_y, src_width,
+                src_u, src_width / 2,
+                src_v, src_width / 2,
+                src_width, src_height,
+                dst_y, dst_width,
+                dst_u, dst_width / 2,
+                dst_v, dst_width / 2,
+                dst_width, dst_height, static_cast<FilterMode>(f));
+    }
+    scale_time = (get_time() - scale_time) / runs;
+
+    ScalePlan* plan = ScalePlanCreate(src_width, src_height,
+                                      src_width, src_width / 2,
+                                      src_width / 2,
+                                      dst_width, dst_height,
+                                      dst_width, dst_width / 2,
+                                      dst_width / 2,
+                                      static_cast<FilterMode>(f));
+    double plan_time = get_time();
+    for (int i = 0; i < runs; ++i) {
+      ScalePlanExecute(plan, src_y, src_u, src_v, dst_y, dst_u, dst_v);
+    }
+    plan_time = (get_time() - plan_time) / runs;
+    ScalePlanDestroy(plan);
+
+    printf("filter %d - %8.2f us scale - %8.2f us plan\n",
+           f, scale_time * 1e6, plan_time * 1e6);
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_u)
+  free_aligned_buffer_16(dst_v)
+}
+
+// A rectangle on whole pixels must match I420Scale of the cropped image,
+// whose chroma starts at crop_x / 2 and is (crop_width + 1) / 2 wide.
+static int TestScaleRectWholePixels(int src_width, int src_height,
+                                    int crop_x, int crop_y,
+                                    int crop_width, int crop_height,
+                                    int dst_width, int dst_height) {
+  const int src_width_uv = (src_width + 1) >> 1;
+  const int src_height_uv = (src_height + 1) >> 1;
+  const int dst_width_uv = (dst_width + 1) >> 1;
+  const int dst_height_uv = (dst_height + 1) >> 1;
+  const int src_y_size = src_width * src_height;
+  const int src_uv_size = src_width_uv * src_height_uv;
+  const int dst_y_size = dst_width * dst_height;
+  const int dst_uv_size = dst_width_uv * dst_height_uv;
+
+  align_buffer_16(src, src_y_size + src_uv_size * 2)
+  align_buffer_16(dst_crop, dst_y_size + dst_uv_size * 2)
+  align_buffer_16(dst_rect, dst_y_size + dst_uv_size * 2)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_y_size + src_uv_size * 2; ++i) {
+    src[i] = (random() & 0xff);
+  }
+  const uint8* src_u = src + src_y_size;
+  const uint8* src_v = src_u + src_uv_size;
+  const int crop_uv = (crop_y / 2) * src_width_uv + crop_x / 2;
+  int err = 0;
+
+  for (int f = 0; f <= kFilterLanczos; ++f) {
+    I420Scale(src + crop_y * src_width + crop_x, src_width,
+              src_u + crop_uv, src_width_uv,
+              src_v + crop_uv, src_width_uv,
+              crop_width, crop_height,
+              dst_crop, dst_width,
+              dst_crop + dst_y_size, dst_width_uv,
+              dst_crop + dst_y_size + dst_uv_size, dst_width_uv,
+              dst_width, dst_height, static_cast<FilterMode>(f));
+    I420ScaleRect(src, src_width, src_u, src_width_uv, src_v, src_width_uv,
+                  src_width, src_height,
+                  crop_x << 16, crop_y << 16,
+                  crop_width << 16, crop_height << 16,
+                  dst_rect, dst_width,
+                  dst_rect + dst_y_size, dst_width_uv,
+                  dst_rect + dst_y_size + dst_uv_size, dst_width_uv,
+                  dst_width, dst_height, static_cast<FilterMode>(f));
+    if (memcmp(dst_crop, dst_rect, dst_y_size + dst_uv_size * 2)) {
+      printf("rect %dx%d crop %d,%d %dx%d -> %dx%d filter %d differs\n",
+             src_width, src_height, crop_x, crop_y, crop_width, crop_height,
+             dst_width, dst_height, f);
+      err++;
+    }
+  }
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_crop)
+  free_aligned_buffer_16(dst_rect)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ScaleRectWholePixels) {
+  // Source size, crop x, y, width and height, and destination size.
+  static const int kRects[][8] = {
+    { 640, 480, 64, 40, 480, 360, 320, 240 },
+    { 108, 83, 0, 0, 108, 83, 33, 25 },      // odd full frame
+    { 25, 17, 0, 0, 25, 17, 12, 9 },
+    { 25, 17, 0, 0, 25, 17, 25, 17 },
+    { 640, 480, 64, 40, 481, 359, 321, 241 },  // odd crop
+    { 640, 480, 63, 41, 480, 360, 320, 240 },  // odd corner
+    { 101, 77, 3, 5, 77, 51, 151, 99 },
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kRects) / sizeof(kRects[0]); ++i) {
+    err += TestScaleRectWholePixels(kRects[i][0], kRects[i][1],
+                                    kRects[i][2], kRects[i][3],
+                                    kRects[i][4], kRects[i][5],
+                                    kRects[i][6], kRects[i][7]);
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// A ramp of 2 per pixel, cropped half a pixel in, must come out 1 higher,
+// horizontally and vertically, with every row function.
+TEST_F(libyuvTest, ScaleRectSubPixel) {
+  const int width = 96;
+  const int height = 64;
+  const int dst_width = 64;
+  const int dst_height = 32;
+  align_buffer_16(src_h, width * height)
+  align_buffer_16(src_v, width * height)
+  align_buffer_16(dst, dst_width * dst_height)
+  for (int i = 0; i < height; ++i) {
+    for (int j = 0; j < width; ++j) {
+      src_h[i * width + j] = j * 2;
+      src_v[i * width + j] = i * 2;
+    }
+  }
+  const int cpu_flags[] = { kCpuInitialized, -1 };
+  int err = 0;
+
+  for (size_t c = 0; c < sizeof(cpu_flags) / sizeof(cpu_flags[0]); ++c) {
+    MaskCpuFlags(cpu_flags[c]);
+    ScalePlaneRect(src_h, width, width, height,
+                   (20 << 16) + 0x8000, 10 << 16,
+                   dst_width << 16, dst_height << 16,
+                   dst, dst_width, dst_width, dst_height, kFilterBilinear);
+    for (int i = 0; i < dst_height; ++i) {
+      for (int j = 0; j < dst_width; ++j) {
+        if (dst[i * dst_width + j] != (20 + j) * 2 + 1) {
+          err++;
+        }
+      }
+    }
+    ScalePlaneRect(src_v, width, width, height,
+                   10 << 16, (20 << 16) + 0x8000,
+                   dst_width << 16, dst_height << 16,
+                   dst, dst_width, dst_width, dst_height, kFilterBilinear);
+    for (int i = 0; i < dst_height; ++i) {
+      for (int j = 0; j < dst_width; ++j) {
+        if (dst[i * dst_width + j] != (20 + i) * 2 + 1) {
+          err++;
+        }
+      }
+    }
+  }
+  MaskCpuFlags(-1);
+
+  // Rectangles outside the image are rejected.
+  err += ScalePlaneRect(src_h, width, width, height,
+                        (width - 8) << 16, 0, (8 << 16) + 1, height << 16,
+                        dst, dst_width, dst_width, dst_height,
+                        kFilterBilinear) == 0;
+
+  free_aligned_buffer_16(src_h)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(dst)
+
+  EXPECT_EQ(0, err);
+}
+
+// Scales and converts in one pass, and checks against I420Scale into
+// aligned planes followed by I420ToARGB.  RGB565 is checked against the
+// same ARGB, packed.
+static int TestScaleToRGB(int src_width, int src_height,
+                          int dst_width, int dst_height, FilterMode f) {
+  const int src_width_uv = (src_width + 1) >> 1;
+  const int src_height_uv = (src_height + 1) >> 1;
+  const int dst_width_uv = (dst_width + 1) >> 1;
+  const int dst_height_uv = (dst_height + 1) >> 1;
+  const int src_y_size = src_width * src_height;
+  const int src_uv_size = src_width_uv * src_height_uv;
+  const int dst_stride_y = (dst_width + 15) & ~15;
+  const int dst_stride_uv = (dst_width_uv + 15) & ~15;
+  const int dst_y_size = dst_stride_y * dst_height;
+  const int dst_uv_size = dst_stride_uv * dst_height_uv;
+  const int dst_argb_size = dst_width * 4 * dst_height;
+
+  align_buffer_16(src, src_y_size + src_uv_size * 2)
+  align_buffer_16(dst_i420, dst_y_size + dst_uv_size * 2)
+  align_buffer_16(dst_argb_2, dst_argb_size)
+  align_buffer_16(dst_argb_1, dst_argb_size)
+  align_buffer_16(dst_rgb565_1, dst_argb_size / 2)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_y_size + src_uv_size * 2; ++i) {
+    src[i] = (random() & 0xff);
+  }
+  const uint8* src_u = src + src_y_size;
+  const uint8* src_v = src_u + src_uv_size;
+  uint8* dst_u = dst_i420 + dst_y_size;
+  uint8* dst_v = dst_u + dst_uv_size;
+
+  I420Scale(src, src_width, src_u, src_width_uv, src_v, src_width_uv,
+            src_width, src_height,
+            dst_i420, dst_stride_y, dst_u, dst_stride_uv,
+            dst_v, dst_stride_uv, dst_width, dst_height, f);
+  I420ToARGB(dst_i420, dst_stride_y, dst_u, dst_stride_uv,
+             dst_v, dst_stride_uv, dst_argb_2, dst_width * 4,
+             dst_width, dst_height);
+  I420ScaleToARGB(src, src_width, src_u, src_width_uv, src_v, src_width_uv,
+                  src_width, src_height, dst_argb_1, dst_width * 4,
+                  dst_width, dst_height, f);
+  I420ScaleToRGB565(src, src_width, src_u, src_width_uv,
+                    src_v, src_width_uv, src_width, src_height,
+                    dst_rgb565_1, dst_width * 2, dst_width, dst_height, f);
+
+  int err = 0;
+  if (memcmp(dst_argb_1, dst_argb_2, dst_argb_size)) {
+    printf("argb %dx%d -> %dx%d filter %d differs\n",
+           src_width, src_height, dst_width, dst_height, f);
+    err++;
+  }
+  const uint32* argb = reinterpret_cast<const uint32*>(dst_argb_2);
+  const uint16* rgb565 = reinterpret_cast<const uint16*>(dst_rgb565_1);
+  for (int i = 0; i < dst_width * dst_height; ++i) {
+    const uint16 expected = ((argb[i] >> 8) & 0xf800) |
+                            ((argb[i] >> 5) & 0x07e0) |
+                            ((argb[i] >> 3) & 0x001f);
+    if (rgb565[i] != expected) {
+      printf("rgb565 %dx%d -> %dx%d filter %d differs\n",
+             src_width, src_height, dst_width, dst_height, f);
+      err++;
+      break;
+    }
+  }
+
+  free_aligned_buffer_16(src)
+  free_aligned_buffer_16(dst_i420)
+  free_aligned_buffer_16(dst_argb_2)
+  free_aligned_buffer_16(dst_argb_1)
+  free_aligned_buffer_16(dst_rgb565_1)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ScaleToARGB) {
+  static const int kSizes[][4] = {
+    { 640, 480, 320, 240 },    // 1/2
+    { 640, 480, 480, 360 },    // 3/4
+    { 640, 480, 100, 75 },     // box
+    { 640, 480, 640, 480 },    // copy
+    { 320, 240, 640, 480 },    // 2x
+    { 352, 288, 853, 481 },    // odd sizes
+    { 640, 480, 37, 1 },       // 1 row
+    { 720, 480, 360, 240 },    // 1/2 with rows not 16 byte aligned
+    { 176, 144, 88, 72 },
+    { 1366, 768, 683, 384 },
+    { 100, 100, 50, 50 },
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    for (int f = 0; f <= kFilterLanczos; ++f) {
+      err += TestScaleToRGB(kSizes[i][0], kSizes[i][1],
+                            kSizes[i][2], kSizes[i][3],
+                            static_cast<FilterMode>(f));
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Pushes 2 frames to a ScaleStream in slices of 16 to 64 rows, and checks
+// that the rows reported complete after each slice match I420Scale.  The
+// frames are also pushed to a second stream that scales into a window of
+// ScaleStreamWindowRows rows, which is copied out after each slice.
+static int TestScaleStream(int src_width, int src_height,
+                           int dst_width, int dst_height, FilterMode f) {
+  const int src_width_uv = (src_width + 1) >> 1;
+  const int src_height_uv = (src_height + 1) >> 1;
+  const int dst_width_uv = (dst_width + 1) >> 1;
+  const int dst_height_uv = (dst_height + 1) >> 1;
+
+  align_buffer_16(src_y, src_width * src_height)
+  align_buffer_16(src_u, src_width_uv * src_height_uv)
+  align_buffer_16(src_v, src_width_uv * src_height_uv)
+  align_buffer_16(dst_y_1, dst_width * dst_height)
+  align_buffer_16(dst_u_1, dst_width_uv * dst_height_uv)
+  align_buffer_16(dst_v_1, dst_width_uv * dst_height_uv)
+  align_buffer_16(dst_y_2, dst_width * dst_height)
+  align_buffer_16(dst_u_2, dst_width_uv * dst_height_uv)
+  align_buffer_16(dst_v_2, dst_width_uv * dst_height_uv)
+
+  ScaleStream* stream = ScaleStreamCreate(src_width, src_height,
+                                          dst_width, dst_height,
+                                          dst_width, dst_width_uv,
+                                          dst_width_uv, f);
+  ScaleStream* window_stream = ScaleStreamCreate(src_width, src_height,
+                                                 dst_width, dst_height,
+                                                 dst_width, dst_width_uv,
+                                                 dst_width_uv, f);
+  int err = (stream && window_stream) ? 0 : 1;
+  // The window starts on a chroma row, so it keeps up to 1 complete row.
+  const int window_rows = ScaleStreamWindowRows(window_stream, 64) + 1;
+  const int window_rows_uv = (window_rows + 1) / 2;
+  align_buffer_16(window_y, dst_width * window_rows)
+  align_buffer_16(window_u, dst_width_uv * window_rows_uv)
+  align_buffer_16(window_v, dst_width_uv * window_rows_uv)
+  align_buffer_16(dst_y_3, dst_width * dst_height)
+  align_buffer_16(dst_u_3, dst_width_uv * dst_height_uv)
+  align_buffer_16(dst_v_3, dst_width_uv * dst_height_uv)
+  srandom(time(NULL));
+  for (int frame = 0; frame < 2 && err == 0; ++frame) {
+    for (int i = 0; i < src_width * src_height; ++i) {
+      src_y[i] = (random() & 0xff);
+    }
+    for (int i = 0; i < src_width_uv * src_height_uv; ++i) {
+      src_u[i] = (random() & 0xff);
+      src_v[i] = (random() & 0xff);
+    }
+    I420Scale(src_y, src_width, src_u, src_width_uv, src_v, src_width_uv,
+              src_width, src_height,
+              dst_y_1, dst_width, dst_u_1, dst_width_uv,
+              dst_v_1, dst_width_uv,
+              dst_width, dst_height, f);
+    int done = 0;
+    int window_start = 0;
+    for (int y = 0; y < src_height; ) {
+      int rows = 16 + (random() % 25) * 2;
+      if (rows > src_height - y) {
+        rows = src_height - y;
+      }
+      int n = ScaleStreamPush(stream,
+                              src_y + y * src_width, src_width,
+                              src_u + (y / 2) * src_width_uv, src_width_uv,
+                              src_v + (y / 2) * src_width_uv, src_width_uv,
+                              rows, dst_y_2, dst_u_2, dst_v_2);
+      const int uv_start = window_start / 2;
+      int m = ScaleStreamPush(window_stream,
+                              src_y + y * src_width, src_width,
+                              src_u + (y / 2) * src_width_uv, src_width_uv,
+                              src_v + (y / 2) * src_width_uv, src_width_uv,
+                              rows, window_y - window_start * dst_width,
+                              window_u - uv_start * dst_width_uv,
+                              window_v - uv_start * dst_width_uv);
+      if (m != n) {
+        err++;
+        break;
+      }
+      // Copy out the complete rows, and move the window to the chroma row
+      // of the first incomplete row.
+      const int uv_end = (m + 1) / 2;
+      memcpy(dst_y_3 + window_start * dst_width, window_y,
+             (m - window_start) * dst_width);
+      memcpy(dst_u_3 + uv_start * dst_width_uv, window_u,
+             (uv_end - uv_start) * dst_width_uv);
+      memcpy(dst_v_3 + uv_start * dst_width_uv, window_v,
+             (uv_end - uv_start) * dst_width_uv);
+      const int shift = (m & ~1) - window_start;
+      memmove(window_y, window_y + shift * dst_width,
+              (window_rows - shift) * dst_width);
+      memmove(window_u, window_u + (shift / 2) * dst_width_uv,
+              (window_rows_uv - shift / 2) * dst_width_uv);
+      memmove(window_v, window_v + (shift / 2) * dst_width_uv,
+              (window_rows_uv - shift / 2) * dst_width_uv);
+      window_start += shift;
+      y += rows;
+      if (n < done || (y == src_height && n != dst_height) ||
+          memcmp(dst_y_1, dst_y_2, n * dst_width) ||
+          memcmp(dst_u_1, dst_u_2, ((n + 1) / 2) * dst_width_uv) ||
+          memcmp(dst_v_1, dst_v_2, ((n + 1) / 2) * dst_width_uv)) {
+        printf("stream %dx%d -> %dx%d filter %d differs at row %d\n",
+               src_width, src_height, dst_width, dst_height, f, y);
+        err++;
+        break;
+      }
+      done = n;
+    }
+    if (err == 0 &&
+        (memcmp(dst_y_1, dst_y_3, dst_width * dst_height) ||
+         memcmp(dst_u_1, dst_u_3, dst_width_uv * dst_height_uv) ||
+         memcmp(dst_v_1, dst_v_3, dst_width_uv * dst_height_uv))) {
+      printf("stream window %dx%d -> %dx%d filter %d differs\n",
+             src_width, src_height, dst_width, dst_height, f);
+      err++;
+    }
+  }
+  ScaleStreamDestroy(stream);
+  ScaleStreamDestroy(window_stream);
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(dst_y_1)
+  free_aligned_buffer_16(dst_u_1)
+  free_aligned_buffer_16(dst_v_1)
+  free_aligned_buffer_16(dst_y_2)
+  free_aligned_buffer_16(dst_u_2)
+  free_aligned_buffer_16(dst_v_2)
+  free_aligned_buffer_16(window_y)
+  free_aligned_buffer_16(window_u)
+  free_aligned_buffer_16(window_v)
+  free_aligned_buffer_16(dst_y_3)
+  free_aligned_buffer_16(dst_u_3)
+  free_aligned_buffer_16(dst_v_3)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ScaleStream) {
+  static const int kSizes[][4] = {
+    { 640, 480, 640, 480 },    // copy
+    { 640, 480, 320, 240 },    // 1/2
+    { 640, 480, 480, 360 },    // 3/4
+    { 640, 480, 240, 180 },    // 3/8
+    { 640, 480, 160, 120 },    // 1/4
+    { 640, 480, 80, 60 },      // 1/8
+    { 640, 480, 100, 75 },     // box
+    { 640, 480, 600, 450 },    // bilinear
+    { 320, 240, 640, 480 },    // 2x
+    { 352, 288, 853, 481 },    // odd sizes
+    { 640, 480, 1000, 400 },   // up and down
+    { 640, 480, 37, 1 },       // 1 row
+  };
+  int err = 0;
+
+  for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+    for (int f = 0; f <= kFilterLanczos; ++f) {
+      err += TestScaleStream(kSizes[i][0], kSizes[i][1],
+                             kSizes[i][2], kSizes[i][3],
+                             static_cast<FilterMode>(f));
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Scales a pyramid and compares each level with I420Scale of the source,
+// or of the level it is expected to be scaled from.
+static int TestScalePyramid(int src_width, int src_height,
+                            const int (*sizes)[3], int num_levels,
+                            FilterMode f) {
+  const int src_width_uv = (src_width + 1) >> 1;
+  const int src_height_uv = (src_height + 1) >> 1;
+  align_buffer_16(src_y, src_width * src_height)
+  align_buffer_16(src_u, src_width_uv * src_height_uv)
+  align_buffer_16(src_v, src_width_uv * src_height_uv)
+  srandom(time(NULL));
+  for (int i = 0; i < src_width * src_height; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < src_width_uv * src_height_uv; ++i) {
+    src_u[i] = (random() & 0xff);
+    src_v[i] = (random() & 0xff);
+  }
+
+  ScalePyramidLevel levels[kMaxPyramidLevels];
+  uint8* level_mem[kMaxPyramidLevels];
+  uint8* ref_mem[kMaxPyramidLevels];
+  int sizes_uv[kMaxPyramidLevels];
+  for (int i = 0; i < num_levels; ++i) {
+    const int w = sizes[i][0];
+    const int h = sizes[i][1];
+    const int w_uv = (w + 1) >> 1;
+    const int h_uv = (h + 1) >> 1;
+    sizes_uv[i] = w_uv * h_uv;
+    level_mem[i] = new uint8[w * h + sizes_uv[i] * 2];
+    ref_mem[i] = new uint8[w * h + sizes_uv[i] * 2];
+    ScalePyramidLevel level = {
+      level_mem[i], w,
+      level_mem[i] + w * h, w_uv,
+      level_mem[i] + w * h + sizes_uv[i], w_uv,
+      w, h
+    };
+    levels[i] = level;
+  }
+
+  int err = I420ScalePyramid(src_y, src_width, src_u, src_width_uv,
+                             src_v, src_width_uv, src_width, src_height,
+                             levels, num_levels, f) ? 1 : 0;
+  for (int i = 0; i < num_levels && !err; ++i) {
+    const ScalePyramidLevel& level = levels[i];
+    const int p = sizes[i][2];
+    uint8* ref_y = ref_mem[i];
+    uint8* ref_u = ref_y + level.dst_width * level.dst_height;
+    uint8* ref_v = ref_u + sizes_uv[i];
+    if (p < 0) {
+      I420Scale(src_y, src_width, src_u, src_width_uv, src_v, src_width_uv,
+                src_width, src_height,
+                ref_y, level.dst_stride_y, ref_u, level.dst_stride_u,
+                ref_v, level.dst_stride_v,
+                level.dst_width, level.dst_height, f);
+    } else {
+      const ScalePyramidLevel& from = levels[p];
+      I420Scale(from.dst_y, from.dst_stride_y, from.dst_u, from.dst_stride_u,
+                from.dst_v, from.dst_stride_v,
+                from.dst_width, from.dst_height,
+                ref_y, level.dst_stride_y, ref_u, level.dst_stride_u,
+                ref_v, level.dst_stride_v,
+                level.dst_width, level.dst_height, f);
+    }
+    if (memcmp(ref_mem[i], level_mem[i],
+               level.dst_width * level.dst_height + sizes_uv[i] * 2)) {
+      printf("pyramid %dx%d -> %dx%d filter %d differs\n",
+             src_width, src_height, level.dst_width, level.dst_height, f);
+      err++;
+    }
+  }
+  for (int i = 0; i < num_levels; ++i) {
+    delete[] level_mem[i];
+    delete[] ref_mem[i];
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+
+  return err;
+}
+
+TEST_F(libyuvTest, ScalePyramid) {
+  // Width, height and the level each is scaled from, or -1 for the source.
+  static const int kLevels[][3] = {
+    { 160, 90, 2 },
+    { 853, 480, -1 },
+    { 320, 180, 3 },
+    { 640, 360, 5 },
+    { 426, 240, -1 },
+    { 1280, 720, -1 },
+  };
+  static const int kNumLevels =
+      static_cast<int>(sizeof(kLevels) / sizeof(kLevels[0]));
+  int err = 0;
+
+  for (int f = 0; f <= kFilterLanczos; ++f) {
+    err += TestScalePyramid(1280, 720, kLevels, kNumLevels,
+                            static_cast<FilterMode>(f));
+    err += TestScalePyramid(1280, 720, kLevels + 1, 1,
+                            static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// Odd level sizes cascade only when the chroma size divides exactly too.
+TEST_F(libyuvTest, ScalePyramidOddWidths) {
+  static const int kLevels1080[][3] = {
+    { 854, 480, -1 },
+    { 427, 240, -1 },    // chroma 214 is not 428 / 2
+  };
+  static const int kLevels768[][3] = {
+    { 683, 384, -1 },
+    { 341, 192, -1 },    // luma 341 is not 683 / 2
+  };
+  static const int kLevels720[][3] = {
+    { 636, 356, -1 },
+    { 318, 178, 0 },     // odd chroma 159x89 is 318x178 / 2
+    { 159, 89, -1 },     // chroma 80 is not 159 / 2
+  };
+  int err = 0;
+
+  for (int f = 0; f <= kFilterLanczos; ++f) {
+    err += TestScalePyramid(1920, 1080, kLevels1080, 2,
+                            static_cast<FilterMode>(f));
+    err += TestScalePyramid(1366, 768, kLevels768, 2,
+                            static_cast<FilterMode>(f));
+    err += TestScalePyramid(1280, 720, kLevels720, 3,
+                            static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, BenchmarkScalePyramid) {
+  const int src_width = 1920;
+  const int src_height = 1080;
+  static const int kSizes[][2] = {
+    { 1280, 720 }, { 960, 540 }, { 640, 360 }, { 320, 180 },
+  };
+  const int num_levels = static_cast<int>(sizeof(kSizes) / sizeof(kSizes[0]));
+  const int runs = 20;
+
+  align_buffer_16(src_y, src_width * src_height)
+  align_buffer_16(src_u, src_width * src_height / 4)
+  align_buffer_16(src_v, src_width * src_height / 4)
+  align_buffer_16(dst, 1280 * 720 * 3)
+  memset(src_y, 128, src_width * src_height);
+  memset(src_u, 128, src_width * src_height / 4);
+  memset(src_v, 128, src_width * src_height / 4);
+
+  ScalePyramidLevel levels[4];
+  uint8* level_dst = dst;
+  for (int i = 0; i < num_levels; ++i) {
+    const int w = kSizes[i][0];
+    const int h = kSizes[i][1];
+    ScalePyramidLevel level = {
+      level_dst, w,
+      level_dst + w * h, w / 2,
+      level_dst + w * h * 5 / 4, w / 2,
+      w, h
+    };
+    levels[i] = level;
+    level_dst += w * h * 3 / 2;
+  }
+
+  for (int f = kFilterBilinear; f <= kFilterBox; ++f) {
+    double scale_time = get_time();
+    for (int r = 0; r < runs; ++r) {
+      for (int i = 0; i < num_levels; ++i) {
+        I420Scale(src_y, src_width, src_u, src_width / 2,
+                  src_v, src_width / 2, src_width, src_height,
+                  levels[i].dst_y, levels[i].dst_stride_y,
+                  levels[i].dst_u, levels[i].dst_stride_u,
+                  levels[i].dst_v, levels[i].dst_stride_v,
+                  levels[i].dst_width, levels[i].dst_height,
+                  static_cast<FilterMode>(f));
+      }
+    }
+    scale_time = (get_time() - scale_time) / runs;
+
+    double pyramid_time = get_time();
+    for (int r = 0; r < runs; ++r) {
+      I420ScalePyramid(src_y, src_width, src_u, src_width / 2,
+                       src_v, src_width / 2, src_width, src_height,
+                       levels, num_levels, static_cast<FilterMode>(f));
+    }
+    pyramid_time = (get_time() - pyramid_time) / runs;
+
+    printf("filter %d - %8.2f us scale - %8.2f us pyramid\n",
+           f, scale_time * 1e6, pyramid_time * 1e6);
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_u)
+  free_aligned_buffer_16(src_v)
+  free_aligned_buffer_16(dst)
+}
+
 }  // namespace libyuv
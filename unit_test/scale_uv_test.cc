@@ -0,0 +1,297 @@
+/*
+ *  Copyright (c) 2011 The LibYuv project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "unit_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libyuv/cpu_id.h"
+#include "libyuv/scale_uv.h"
+
+namespace libyuv {
+
+// Returns the largest difference between the images in two planes, or
+// 255 if either has a byte written in the border of b rows above and below
+// and x_offset bytes left of each row, or to the right of the image.
+static int PlaneDiff(const uint8* c, const uint8* opt, int stride,
+                     int x_offset, int width_bytes, int b, int height) {
+  int max_diff = 0;
+  for (int i = 0; i < height + b * 2; ++i) {
+    const bool row_inside = (i >= b && i < height + b);
+    for (int j = 0; j < stride; ++j) {
+      const int a = c[i * stride + j];
+      const int o = opt[i * stride + j];
+      if (!row_inside || j < x_offset || j >= x_offset + width_bytes) {
+        if (a || o) {
+          return 255;
+        }
+      } else if (abs(a - o) > max_diff) {
+        max_diff = abs(a - o);
+      }
+    }
+  }
+  return max_diff;
+}
+
+// Scales with C and with the optimized row functions, and checks that
+// NV12ToI420Scale writes the same chroma as NV12Scale.
+static int NV12TestFilter(int src_width, int src_height,
+                          int dst_width, int dst_height,
+                          FilterMode f) {
+  const int b = 128;
+  const int src_width_uv = (src_width + 1) >> 1;
+  const int src_height_uv = (src_height + 1) >> 1;
+  const int dst_width_uv = (dst_width + 1) >> 1;
+  const int dst_height_uv = (dst_height + 1) >> 1;
+
+  const int src_stride_y = b * 2 + src_width;
+  const int src_stride_uv = (b + src_width_uv) * 2;
+  const int src_y_size = src_stride_y * (src_height + b * 2);
+  const int src_uv_size = src_stride_uv * (src_height_uv + b * 2);
+  const int dst_stride_y = b * 2 + dst_width;
+  const int dst_stride_uv = (b + dst_width_uv) * 2;
+  const int dst_stride_u = b * 2 + dst_width_uv;
+  const int dst_y_size = dst_stride_y * (dst_height + b * 2);
+  const int dst_uv_size = dst_stride_uv * (dst_height_uv + b * 2);
+  const int dst_u_size = dst_stride_u * (dst_height_uv + b * 2);
+
+  align_buffer_16(src_y, src_y_size)
+  align_buffer_16(src_uv, src_uv_size)
+  align_buffer_16(dst_y_c, dst_y_size)
+  align_buffer_16(dst_uv_c, dst_uv_size)
+  align_buffer_16(dst_y_opt, dst_y_size)
+  align_buffer_16(dst_uv_opt, dst_uv_size)
+  align_buffer_16(dst_y_i420, dst_y_size)
+  align_buffer_16(dst_u_i420, dst_u_size)
+  align_buffer_16(dst_v_i420, dst_u_size)
+
+  srandom(time(NULL));
+  for (int i = 0; i < src_y_size; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < src_uv_size; ++i) {
+    src_uv[i] = (random() & 0xff);
+  }
+
+  const uint8* src_y_image = src_y + src_stride_y * b + b;
+  const uint8* src_uv_image = src_uv + src_stride_uv * b + b;
+  const int dst_y_offset = dst_stride_y * b + b;
+  const int dst_uv_offset = dst_stride_uv * b + b;
+  const int dst_u_offset = dst_stride_u * b + b;
+
+  const int runs = 16;
+  MaskCpuFlags(kCpuInitialized);
+  double c_time = get_time();
+  for (int i = 0; i < runs; ++i) {
+    NV12Scale(src_y_image, src_stride_y, src_uv_image, src_stride_uv,
+              src_width, src_height,
+              dst_y_c + dst_y_offset, dst_stride_y,
+              dst_uv_c + dst_uv_offset, dst_stride_uv,
+              dst_width, dst_height, f);
+  }
+  c_time = (get_time() - c_time) / runs;
+
+  MaskCpuFlags(-1);
+  double opt_time = get_time();
+  for (int i = 0; i < runs; ++i) {
+    NV12Scale(src_y_image, src_stride_y, src_uv_image, src_stride_uv,
+              src_width, src_height,
+              dst_y_opt + dst_y_offset, dst_stride_y,
+              dst_uv_opt + dst_uv_offset, dst_stride_uv,
+              dst_width, dst_height, f);
+  }
+  opt_time = (get_time() - opt_time) / runs;
+
+  NV12ToI420Scale(src_y_image, src_stride_y, src_uv_image, src_stride_uv,
+                  src_width, src_height,
+                  dst_y_i420 + dst_y_offset, dst_stride_y,
+                  dst_u_i420 + dst_u_offset, dst_stride_u,
+                  dst_v_i420 + dst_u_offset, dst_stride_u,
+                  dst_width, dst_height, f);
+
+  printf("filter %d - %8d us c - %8d us opt\n",
+         f, static_cast<int>(c_time * 1e6), static_cast<int>(opt_time * 1e6));
+
+  // ScaleUVRowDown2Int_SSE2 averages the U and V of two rows with pavgb
+  // before averaging neighbouring pairs, so it may round a sample 1 higher
+  // than C, as ScaleRowDown2Int_SSE2 does for luma.  The luma 1/4 kernel
+  // rounds in 4 pavgb steps, so may be 2 higher.  Every other scale
+  // matches exactly, and the NV12ToI420Scale planes match the optimized
+  // NV12Scale exactly.  Nothing is written outside the image, in any row.
+  int max_allowed = 0;
+  if (f && dst_width * 2 == src_width && dst_height * 2 == src_height) {
+    max_allowed = 1;
+  } else if (f && dst_width * 4 == src_width &&
+             dst_height * 4 == src_height) {
+    max_allowed = 2;
+  }
+  int max_diff = PlaneDiff(dst_y_c, dst_y_opt, dst_stride_y, b, dst_width,
+                           b, dst_height);
+  int max_diff_uv = PlaneDiff(dst_uv_c, dst_uv_opt, dst_stride_uv, b,
+                              dst_width_uv * 2, b, dst_height_uv);
+  if (max_diff_uv > max_diff) {
+    max_diff = max_diff_uv;
+  }
+  if (memcmp(dst_y_opt, dst_y_i420, dst_y_size)) {
+    max_diff = 255;
+  }
+  for (int i = 0; i < dst_height_uv; ++i) {
+    const uint8* uv = dst_uv_opt + dst_uv_offset + i * dst_stride_uv;
+    const uint8* u = dst_u_i420 + dst_u_offset + i * dst_stride_u;
+    const uint8* v = dst_v_i420 + dst_u_offset + i * dst_stride_u;
+    for (int j = 0; j < dst_width_uv; ++j) {
+      if (uv[j * 2] != u[j] || uv[j * 2 + 1] != v[j]) {
+        max_diff = 255;
+      }
+    }
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_uv)
+  free_aligned_buffer_16(dst_y_c)
+  free_aligned_buffer_16(dst_uv_c)
+  free_aligned_buffer_16(dst_y_opt)
+  free_aligned_buffer_16(dst_uv_opt)
+  free_aligned_buffer_16(dst_y_i420)
+  free_aligned_buffer_16(dst_u_i420)
+  free_aligned_buffer_16(dst_v_i420)
+
+  if (max_diff > max_allowed) {
+    printf("%dx%d -> %dx%d filter %d max diff %d\n", src_width, src_height,
+           dst_width, dst_height, f, max_diff);
+  }
+  return (max_diff > max_allowed) ? 1 : 0;
+}
+
+TEST_F(libyuvTest, NV12ScaleDownBy2) {
+  const int src_width = 1280;
+  const int src_height = 720;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f) {
+    err += NV12TestFilter(src_width, src_height,
+                          src_width >> 1, src_height >> 1,
+                          static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+TEST_F(libyuvTest, NV12ScaleAnySize) {
+  const int src_width = 640;
+  const int src_height = 360;
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f) {
+    err += NV12TestFilter(src_width, src_height, 640, 360,
+                          static_cast<FilterMode>(f));
+    err += NV12TestFilter(src_width, src_height, 1280, 720,
+                          static_cast<FilterMode>(f));
+    err += NV12TestFilter(src_width, src_height, 853, 481,
+                          static_cast<FilterMode>(f));
+    err += NV12TestFilter(src_width, src_height, 160, 90,
+                          static_cast<FilterMode>(f));
+    err += NV12TestFilter(src_width - 2, src_height, 401, 1,
+                          static_cast<FilterMode>(f));
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+// A flat chroma plane must stay flat with every filter.
+TEST_F(libyuvTest, NV12ScaleFlat) {
+  const int src_width = 194;
+  const int src_height = 2;
+  const int dst_width = 600;
+  const int dst_height = 10;
+  uint8 src_y[src_width * src_height];
+  uint8 src_uv[src_width * src_height / 2];
+  uint8 dst_y[dst_width * dst_height];
+  uint8 dst_uv[dst_width * dst_height / 2];
+  memset(src_y, 16, sizeof(src_y));
+  for (int i = 0; i < src_width / 2; ++i) {
+    src_uv[i * 2] = 64;
+    src_uv[i * 2 + 1] = 192;
+  }
+  int err = 0;
+
+  for (int f = 0; f < 3; ++f) {
+    memset(dst_uv, 0, sizeof(dst_uv));
+    NV12Scale(src_y, src_width, src_uv, src_width, src_width, src_height,
+              dst_y, dst_width, dst_uv, dst_width, dst_width, dst_height,
+              static_cast<FilterMode>(f));
+    for (int i = 0; i < dst_width * dst_height / 4; ++i) {
+      if (dst_uv[i * 2] != 64 || dst_uv[i * 2 + 1] != 192) {
+        ++err;
+        break;
+      }
+    }
+  }
+
+  EXPECT_EQ(0, err);
+}
+
+
+// UV has no polyphase filter, so kFilterBicubic and kFilterLanczos scale
+// both Y and UV as kFilterBox does.
+TEST_F(libyuvTest, NV12ScaleBicubicIsBox) {
+  const int src_width = 320;
+  const int src_height = 180;
+  const int src_uv_size = src_width * ((src_height + 1) >> 1);
+  static const int kSizes[][2] = { {101, 57}, {640, 360}, {853, 481} };
+  align_buffer_16(src_y, src_width * src_height)
+  align_buffer_16(src_uv, src_uv_size)
+  align_buffer_16(dst_y_box, 854 * 482)
+  align_buffer_16(dst_uv_box, 854 * 241)
+  align_buffer_16(dst_y, 854 * 482)
+  align_buffer_16(dst_uv, 854 * 241)
+  srandom(time(NULL));
+  for (int i = 0; i < src_width * src_height; ++i) {
+    src_y[i] = (random() & 0xff);
+  }
+  for (int i = 0; i < src_uv_size; ++i) {
+    src_uv[i] = (random() & 0xff);
+  }
+  int err = 0;
+
+  for (int s = 0; s < 3; ++s) {
+    const int dst_width = kSizes[s][0];
+    const int dst_height = kSizes[s][1];
+    const int dst_stride_uv = (dst_width + 1) & ~1;
+    const int dst_y_size = dst_width * dst_height;
+    const int dst_uv_size = dst_stride_uv * ((dst_height + 1) >> 1);
+    NV12Scale(src_y, src_width, src_uv, src_width, src_width, src_height,
+              dst_y_box, dst_width, dst_uv_box, dst_stride_uv,
+              dst_width, dst_height, kFilterBox);
+    for (int f = kFilterBicubic; f <= kFilterLanczos; ++f) {
+      NV12Scale(src_y, src_width, src_uv, src_width, src_width, src_height,
+                dst_y, dst_width, dst_uv, dst_stride_uv,
+                dst_width, dst_height, static_cast<FilterMode>(f));
+      if (memcmp(dst_y, dst_y_box, dst_y_size) ||
+          memcmp(dst_uv, dst_uv_box, dst_uv_size)) {
+        printf("%dx%d filter %d differs from box\n", dst_width, dst_height, f);
+        ++err;
+      }
+    }
+  }
+
+  free_aligned_buffer_16(src_y)
+  free_aligned_buffer_16(src_uv)
+  free_aligned_buffer_16(dst_y_box)
+  free_aligned_buffer_16(dst_uv_box)
+  free_aligned_buffer_16(dst_y)
+  free_aligned_buffer_16(dst_uv)
+
+  EXPECT_EQ(0, err);
+}
+
+}  // namespace libyuv